@@ -241,6 +241,19 @@ enum DW_SECT
   DW_SECT_MAX = DW_SECT_MACRO,
 };
 
+// Index attributes used in the .debug_names section.
+
+enum DW_IDX
+{
+  DW_IDX_compile_unit = 1,
+  DW_IDX_type_unit = 2,
+  DW_IDX_die_offset = 3,
+  DW_IDX_parent = 4,
+  DW_IDX_type_hash = 5,
+  DW_IDX_lo_user = 0x2000,
+  DW_IDX_hi_user = 0x3fff
+};
+
 } // End namespace elfcpp.
 
 #endif // !defined(ELFCPP_DWARF_H)
@@ -1812,6 +1812,11 @@ class AArch64_relobj : public Sized_relobj_file<size, big_endian>
       const unsigned char* pshdrs, Output_file* of,
       typename Sized_relobj_file<size, big_endian>::Views* pviews);
 
+  // The stubs are relocated along with the sections.
+  virtual bool
+  do_can_relocate_in_parts() const
+  { return false; }
+
   // Count local symbols and (optionally) record mapping info.
   virtual void
   do_count_local_symbols(Stringpool_template<char>*,
@@ -23,12 +23,23 @@
 #include "gold.h"
 
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <climits>
+#include <set>
 #include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "libiberty.h"
 #include "filenames.h"
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include "binary-io.h"
+
 #include "elfcpp.h"
 #include "options.h"
 #include "mapfile.h"
@@ -41,6 +52,40 @@
 #include "plugin.h"
 #include "incremental.h"
 
+// For systems without mmap support.
+#ifndef HAVE_MMAP
+# define mmap gold_mmap
+# define munmap gold_munmap
+# ifndef MAP_FAILED
+#  define MAP_FAILED (reinterpret_cast<void*>(-1))
+# endif
+# ifndef PROT_READ
+#  define PROT_READ 0
+# endif
+# ifndef MAP_PRIVATE
+#  define MAP_PRIVATE 0
+# endif
+
+# ifndef ENOSYS
+#  define ENOSYS EINVAL
+# endif
+
+static void *
+gold_mmap(void *, size_t, int, int, int, off_t)
+{
+  errno = ENOSYS;
+  return MAP_FAILED;
+}
+
+static int
+gold_munmap(void *, size_t)
+{
+  errno = ENOSYS;
+  return -1;
+}
+
+#endif
+
 namespace gold
 {
 
@@ -174,10 +219,112 @@ struct Archive::Archive_header
   char ar_fmag[2];
 };
 
+// The archive index cache.  With --archive-index-cache=DIR, we save
+// the symbol map of each archive we read in a file in DIR, along with
+// a hash table of the symbol names and the offsets of the members.
+// When we see the same archive again, as identified by its name,
+// device, inode, size and modification time, we map the file and use
+// it directly instead of reading the archive symbol map.
+
+// The header of an archive index cache file.  A cache file is only
+// meant to be read by the same build of gold on the same host, so we
+// write everything in host byte order.  The header is followed by the
+// name of the archive, the archive map entries, the archive map
+// names, the extended name table, the hash table buckets and chains,
+// and the member offsets, each padded to a multiple of 8 bytes.
+
+struct Archive_index_cache_header
+{
+  // The magic string, index_cache_magic.
+  char magic[8];
+  // The version of the format, index_cache_version.  This also
+  // rejects a file written in the other byte order.
+  uint32_t version;
+  // The size of an archive map entry.
+  uint32_t entry_size;
+  // The device, inode, size and modification time of the archive.
+  uint64_t dev;
+  uint64_t ino;
+  uint64_t size;
+  int64_t mtime_seconds;
+  int64_t mtime_nanoseconds;
+  // The number of archive members counted by read_armap.
+  uint64_t num_members;
+  // The sizes of the parts which follow the header.
+  uint64_t name_size;
+  uint64_t armap_size;
+  uint64_t names_size;
+  uint64_t extended_names_size;
+  uint64_t bucket_count;
+  uint64_t member_count;
+};
+
+static const char index_cache_magic[8] =
+{
+  'G', 'O', 'L', 'D', 'A', 'I', 'D', 'X'
+};
+
+static const uint32_t index_cache_version = 1;
+
+// The file offsets of the parts of an archive index cache file.
+
+struct Archive_index_cache_layout
+{
+  uint64_t name;
+  uint64_t armap;
+  uint64_t names;
+  uint64_t extended_names;
+  uint64_t buckets;
+  uint64_t chains;
+  uint64_t members;
+  uint64_t total;
+};
+
+static inline uint64_t
+index_cache_align(uint64_t off)
+{
+  return (off + 7) & ~static_cast<uint64_t>(7);
+}
+
+// Set *LAYOUT to the layout of an archive index cache file with
+// header HDR.  MEMBER_SIZE is the size of a member offset.
+
+static void
+set_index_cache_layout(const Archive_index_cache_header& hdr,
+		       size_t member_size, Archive_index_cache_layout* layout)
+{
+  uint64_t off = sizeof(Archive_index_cache_header);
+  layout->name = off;
+  off = index_cache_align(off + hdr.name_size);
+  layout->armap = off;
+  off = index_cache_align(off + hdr.armap_size * hdr.entry_size);
+  layout->names = off;
+  off = index_cache_align(off + hdr.names_size);
+  layout->extended_names = off;
+  off = index_cache_align(off + hdr.extended_names_size);
+  layout->buckets = off;
+  off = index_cache_align(off + hdr.bucket_count * sizeof(uint32_t));
+  layout->chains = off;
+  off = index_cache_align(off + hdr.armap_size * sizeof(uint32_t));
+  layout->members = off;
+  off += hdr.member_count * member_size;
+  layout->total = off;
+}
+
+// Return the hash code in the archive index cache of the symbol name
+// NAME of length LEN, not including any version.
+
+static inline uint32_t
+armap_name_hash(const char* name, size_t len)
+{
+  return static_cast<uint32_t>(string_hash<char>(name, len));
+}
+
 // Class Archive static variables.
 unsigned int Archive::total_archives;
 unsigned int Archive::total_members;
 unsigned int Archive::total_members_loaded;
+unsigned int Archive::total_index_cache_hits;
 
 // Archive methods.
 
@@ -197,9 +344,14 @@ const char Archive::sym64name[7] = { '/', 'S', 'Y', 'M', '6', '4', '/' };
 
 Archive::Archive(const std::string& name, Input_file* input_file,
                  bool is_thin_archive, Dirsearch* dirpath, Task* task)
-  : Library_base(task), name_(name), input_file_(input_file), armap_(),
-    armap_names_(), extended_names_(), armap_checked_(), seen_offsets_(),
-    members_(), is_thin_archive_(is_thin_archive), included_member_(false),
+  : Library_base(task), name_(name), input_file_(input_file), armap_(NULL),
+    armap_size_(0), armap_names_(NULL), armap_storage_(),
+    armap_names_storage_(), armap_buckets_(NULL), armap_bucket_count_(0),
+    armap_chains_(NULL), armap_bucket_storage_(), armap_chain_storage_(),
+    member_offsets_(NULL), member_count_(0),
+    index_cache_view_(NULL), index_cache_size_(0), extended_names_(),
+    armap_checked_(), seen_offsets_(), members_(),
+    is_thin_archive_(is_thin_archive), included_member_(false),
     nested_archives_(), dirpath_(dirpath), num_members_(0),
     included_all_members_(false)
 {
@@ -207,8 +359,14 @@ Archive::Archive(const std::string& name, Input_file* input_file,
     parameters->options().check_excluded_libs(input_file->found_name());
 }
 
+Archive::~Archive()
+{
+  if (this->index_cache_view_ != NULL)
+    ::munmap(this->index_cache_view_, this->index_cache_size_);
+}
+
 // Set up the archive: read the symbol map and the extended name
-// table.
+// table, from the index cache if we can.
 
 void
 Archive::setup()
@@ -217,11 +375,37 @@ Archive::setup()
   if (this->input_file_->file().filesize() == sarmag)
     return;
 
+  const char* cache_dir = parameters->options().archive_index_cache();
+  if (cache_dir == NULL || !this->read_index_cache(cache_dir))
+    {
+      if (!this->read_maps())
+	return;
+      if (cache_dir != NULL)
+	this->write_index_cache(cache_dir);
+    }
+
+  bool preread_syms = (parameters->options().threads()
+                       && parameters->options().preread_archive_symbols());
+#ifndef ENABLE_THREADS
+  preread_syms = false;
+#else
+  if (parameters->options().has_plugins())
+    preread_syms = false;
+#endif
+  if (preread_syms)
+    this->read_all_symbols();
+}
+
+// Read the archive symbol map and the extended name table.
+
+bool
+Archive::read_maps()
+{
   // The first member of the archive should be the symbol table.
   std::string armap_name;
   off_t header_size = this->read_header(sarmag, false, &armap_name, NULL);
   if (header_size == -1)
-    return;
+    return false;
 
   section_size_type armap_size = convert_to_section_size_type(header_size);
   off_t off = sarmag;
@@ -247,7 +431,7 @@ Archive::setup()
   std::string xname;
   header_size = this->read_header(off, true, &xname, NULL);
   if (header_size == -1)
-    return;
+    return false;
 
   section_size_type extended_size = convert_to_section_size_type(header_size);
   if (xname == "/")
@@ -257,16 +441,7 @@ Archive::setup()
       const char* px = reinterpret_cast<const char*>(p);
       this->extended_names_.assign(px, extended_size);
     }
-  bool preread_syms = (parameters->options().threads()
-                       && parameters->options().preread_archive_symbols());
-#ifndef ENABLE_THREADS
-  preread_syms = false;
-#else
-  if (parameters->options().has_plugins())
-    preread_syms = false;
-#endif
-  if (preread_syms)
-    this->read_all_symbols();
+  return true;
 }
 
 // Unlock any nested archives.
@@ -308,25 +483,30 @@ Archive::read_armap(off_t start, section_size_type size)
   const char* pnames = reinterpret_cast<const char*>(pword + nsyms);
   section_size_type names_size =
     reinterpret_cast<const char*>(p) + size - pnames;
-  this->armap_names_.assign(pnames, names_size);
+  this->armap_names_storage_.assign(pnames, names_size);
+  this->armap_names_ = this->armap_names_storage_.data();
 
-  this->armap_.resize(nsyms);
+  this->armap_storage_.resize(nsyms);
 
   section_offset_type name_offset = 0;
   for (unsigned long i = 0; i < nsyms; ++i)
     {
-      this->armap_[i].name_offset = name_offset;
-      this->armap_[i].file_offset = convert_types<off_t, Entry_type>(
+      Armap_entry& entry(this->armap_storage_[i]);
+      entry.name_offset = name_offset;
+      entry.file_offset = convert_types<off_t, Entry_type>(
         elfcpp::Swap<mapsize, true>::readval(pword));
       name_offset += strlen(pnames + name_offset) + 1;
       ++pword;
-      if (this->armap_[i].file_offset != last_seen_offset)
+      if (entry.file_offset != last_seen_offset)
         {
-          last_seen_offset = this->armap_[i].file_offset;
+          last_seen_offset = entry.file_offset;
           ++this->num_members_;
         }
     }
 
+  this->armap_ = nsyms > 0 ? &this->armap_storage_[0] : NULL;
+  this->armap_size_ = nsyms;
+
   if (static_cast<section_size_type>(name_offset) > names_size)
     gold_error(_("%s: bad archive symbol table names"),
 	       this->name().c_str());
@@ -587,6 +767,294 @@ Archive::end()
   return Archive::const_iterator(this, this->input_file_->file().filesize());
 }
 
+// Set *HDR to the key which identifies this archive in the index
+// cache, and set *PATH to the canonical name of the archive.  Return
+// false if we can not identify the archive.
+
+bool
+Archive::get_index_cache_key(Archive_index_cache_header* hdr,
+			     std::string* path)
+{
+  struct stat st;
+  if (::fstat(this->input_file_->file().descriptor(), &st) < 0)
+    return false;
+
+  char* real = lrealpath(this->input_file_->filename().c_str());
+  if (real == NULL)
+    return false;
+  *path = real;
+  free(real);
+
+  memset(hdr, 0, sizeof *hdr);
+  memcpy(hdr->magic, index_cache_magic, sizeof hdr->magic);
+  hdr->version = index_cache_version;
+  hdr->entry_size = sizeof(Armap_entry);
+  hdr->dev = st.st_dev;
+  hdr->ino = st.st_ino;
+  hdr->size = st.st_size;
+  hdr->mtime_seconds = st.st_mtime;
+#ifdef HAVE_STAT_ST_MTIM
+  hdr->mtime_nanoseconds = st.st_mtim.tv_nsec;
+#endif
+  hdr->num_members = 0;
+  hdr->name_size = path->length() + 1;
+  return true;
+}
+
+// Return the name of the index cache file in CACHE_DIR for the
+// archive whose canonical name is PATH.
+
+std::string
+Archive::index_cache_filename(const char* cache_dir, const std::string& path)
+{
+  const char* base = lbasename(path.c_str());
+  char buf[20];
+  snprintf(buf, sizeof buf, "-%08x.idx",
+	   static_cast<unsigned int>(string_hash<char>(path.data(),
+						       path.length())));
+  std::string ret(cache_dir);
+  ret += '/';
+  ret += base;
+  ret += buf;
+  return ret;
+}
+
+// Try to read the archive maps from the index cache in CACHE_DIR.
+// Return true if we found a valid entry for this archive.
+
+bool
+Archive::read_index_cache(const char* cache_dir)
+{
+  Archive_index_cache_header key;
+  std::string path;
+  if (!this->get_index_cache_key(&key, &path))
+    return false;
+
+  std::string filename = Archive::index_cache_filename(cache_dir, path);
+  int o = ::open(filename.c_str(), O_RDONLY | O_BINARY);
+  if (o < 0)
+    return false;
+  struct stat st;
+  if (::fstat(o, &st) < 0
+      || static_cast<size_t>(st.st_size) < sizeof(Archive_index_cache_header))
+    {
+      ::close(o);
+      return false;
+    }
+  size_t filesize = st.st_size;
+  void* view = ::mmap(NULL, filesize, PROT_READ, MAP_PRIVATE, o, 0);
+  ::close(o);
+  if (view == MAP_FAILED)
+    return false;
+
+  const unsigned char* base = static_cast<const unsigned char*>(view);
+  Archive_index_cache_header hdr;
+  memcpy(&hdr, base, sizeof hdr);
+
+  // Check that this is the entry for this archive, and that all the
+  // sizes are sane before we compute the layout.
+  Archive_index_cache_layout layout;
+  bool ok = (memcmp(hdr.magic, key.magic, sizeof hdr.magic) == 0
+	     && hdr.version == key.version
+	     && hdr.entry_size == key.entry_size
+	     && hdr.dev == key.dev
+	     && hdr.ino == key.ino
+	     && hdr.size == key.size
+	     && hdr.mtime_seconds == key.mtime_seconds
+	     && hdr.mtime_nanoseconds == key.mtime_nanoseconds
+	     && hdr.name_size == key.name_size
+	     && hdr.armap_size <= filesize
+	     && hdr.names_size <= filesize
+	     && hdr.extended_names_size <= filesize
+	     && hdr.bucket_count <= filesize
+	     && hdr.member_count <= filesize);
+  if (ok)
+    {
+      set_index_cache_layout(hdr, sizeof(off_t), &layout);
+      ok = (layout.total == filesize
+	    && memcmp(base + layout.name, path.c_str(), hdr.name_size) == 0
+	    && (hdr.names_size == 0
+		|| base[layout.names + hdr.names_size - 1] == '\0')
+	    && (hdr.bucket_count & (hdr.bucket_count - 1)) == 0
+	    && (hdr.bucket_count > 0 || hdr.armap_size == 0));
+    }
+
+  // Check that every index in the maps is in range, so that we can
+  // use them without checking them again; a damaged file then makes
+  // us read the archive instead.  The hash chains must only lead to
+  // later entries, so that a lookup always ends.  The members are in
+  // file order.
+  if (ok)
+    {
+      const Armap_entry* armap =
+	reinterpret_cast<const Armap_entry*>(base + layout.armap);
+      const uint32_t* chains =
+	reinterpret_cast<const uint32_t*>(base + layout.chains);
+      for (uint64_t i = 0; ok && i < hdr.armap_size; ++i)
+	ok = (armap[i].name_offset >= 0
+	      && static_cast<uint64_t>(armap[i].name_offset) < hdr.names_size
+	      && armap[i].file_offset >= 0
+	      && static_cast<uint64_t>(armap[i].file_offset) < hdr.size
+	      && (chains[i] == 0
+		  || (chains[i] > i + 1 && chains[i] <= hdr.armap_size)));
+
+      const uint32_t* buckets =
+	reinterpret_cast<const uint32_t*>(base + layout.buckets);
+      for (uint64_t i = 0; ok && i < hdr.bucket_count; ++i)
+	ok = buckets[i] <= hdr.armap_size;
+
+      const off_t* members =
+	reinterpret_cast<const off_t*>(base + layout.members);
+      off_t prev = 0;
+      for (uint64_t i = 0; ok && i < hdr.member_count; ++i)
+	{
+	  ok = (members[i] > prev
+		&& static_cast<uint64_t>(members[i]) < hdr.size);
+	  prev = members[i];
+	}
+    }
+
+  if (!ok)
+    {
+      ::munmap(view, filesize);
+      return false;
+    }
+
+  this->index_cache_view_ = view;
+  this->index_cache_size_ = filesize;
+  this->num_members_ = hdr.num_members;
+  this->armap_size_ = hdr.armap_size;
+  if (hdr.armap_size > 0)
+    {
+      this->armap_ = reinterpret_cast<const Armap_entry*>(base + layout.armap);
+      this->armap_names_ = reinterpret_cast<const char*>(base + layout.names);
+      this->armap_bucket_count_ = hdr.bucket_count;
+      this->armap_buckets_ =
+	reinterpret_cast<const uint32_t*>(base + layout.buckets);
+      this->armap_chains_ =
+	reinterpret_cast<const uint32_t*>(base + layout.chains);
+    }
+  this->armap_checked_.resize(hdr.armap_size);
+  this->extended_names_.assign(reinterpret_cast<const char*>(base
+							     + layout.extended_names),
+			       hdr.extended_names_size);
+  this->member_count_ = hdr.member_count;
+  this->member_offsets_ = reinterpret_cast<const off_t*>(base + layout.members);
+  return true;
+}
+
+// Build the hash table of the archive map names, ignoring any
+// version.  The chains are in archive map order, so that a lookup
+// sees the entries in the same order as a scan of the archive map.
+// Indexes are biased by one so that zero ends a chain.
+
+void
+Archive::build_armap_hash()
+{
+  if (this->armap_buckets_ != NULL)
+    return;
+
+  size_t nsyms = this->armap_size_;
+  size_t bucket_count = 1;
+  while (bucket_count < nsyms)
+    bucket_count <<= 1;
+  this->armap_bucket_storage_.assign(bucket_count, 0);
+  this->armap_chain_storage_.assign(nsyms, 0);
+  for (size_t i = nsyms; i > 0; --i)
+    {
+      const char* name = this->armap_names_ + this->armap_[i - 1].name_offset;
+      const char* at = strchr(name, '@');
+      size_t len = at != NULL ? at - name : strlen(name);
+      uint32_t h = armap_name_hash(name, len) & (bucket_count - 1);
+      this->armap_chain_storage_[i - 1] = this->armap_bucket_storage_[h];
+      this->armap_bucket_storage_[h] = i;
+    }
+
+  this->armap_bucket_count_ = bucket_count;
+  this->armap_buckets_ = &this->armap_bucket_storage_[0];
+  this->armap_chains_ = nsyms > 0 ? &this->armap_chain_storage_[0] : NULL;
+}
+
+// Write the archive maps we just read to the index cache in
+// CACHE_DIR.  The cache is only an optimization, so we quietly give
+// up if anything goes wrong.
+
+void
+Archive::write_index_cache(const char* cache_dir)
+{
+  Archive_index_cache_header hdr;
+  std::string path;
+  if (!this->get_index_cache_key(&hdr, &path))
+    return;
+
+  // Don't save anything if there was a problem reading the archive.
+  int errors = parameters->errors()->error_count();
+
+  size_t nsyms = this->armap_size_;
+  if (nsyms > 0)
+    this->build_armap_hash();
+  size_t bucket_count = this->armap_bucket_count_;
+
+  std::vector<off_t> members;
+  for (Archive::const_iterator p = this->begin(); p != this->end(); ++p)
+    members.push_back(p->off);
+
+  if (parameters->errors()->error_count() != errors)
+    return;
+
+  hdr.num_members = this->num_members_;
+  hdr.armap_size = nsyms;
+  hdr.names_size = this->armap_names_storage_.length();
+  hdr.extended_names_size = this->extended_names_.length();
+  hdr.bucket_count = bucket_count;
+  hdr.member_count = members.size();
+  Archive_index_cache_layout layout;
+  set_index_cache_layout(hdr, sizeof(off_t), &layout);
+
+  std::string contents(layout.total, '\0');
+  char* base = &contents[0];
+  memcpy(base, &hdr, sizeof hdr);
+  memcpy(base + layout.name, path.c_str(), hdr.name_size);
+  if (nsyms > 0)
+    {
+      memcpy(base + layout.armap, this->armap_, nsyms * sizeof(Armap_entry));
+      memcpy(base + layout.buckets, this->armap_buckets_,
+	     bucket_count * sizeof(uint32_t));
+      memcpy(base + layout.chains, this->armap_chains_,
+	     nsyms * sizeof(uint32_t));
+    }
+  memcpy(base + layout.names, this->armap_names_storage_.data(),
+	 hdr.names_size);
+  memcpy(base + layout.extended_names, this->extended_names_.data(),
+	 hdr.extended_names_size);
+  if (!members.empty())
+    memcpy(base + layout.members, &members[0],
+	   members.size() * sizeof(off_t));
+
+  // Write to a temporary file and rename it, so that a concurrent
+  // link never sees a partial entry.
+  ::mkdir(cache_dir, 0777);
+  std::string filename = Archive::index_cache_filename(cache_dir, path);
+  std::string tmpname = filename + ".XXXXXX";
+  int o = ::mkstemp(&tmpname[0]);
+  if (o < 0)
+    return;
+  const char* p = contents.data();
+  size_t remaining = contents.length();
+  while (remaining > 0)
+    {
+      ssize_t len = ::write(o, p, remaining);
+      if (len <= 0)
+	break;
+      p += len;
+      remaining -= len;
+    }
+  if (::close(o) < 0
+      || remaining > 0
+      || ::rename(tmpname.c_str(), filename.c_str()) < 0)
+    ::unlink(tmpname.c_str());
+}
+
 // Get the file and offset for an archive member, which may be an
 // external member of a thin archive.  Set *INPUT_FILE to the
 // file containing the actual member, *MEMOFF to the offset
@@ -736,6 +1204,13 @@ Archive::get_elf_object_for_member(off_t off, bool* punconfigured)
 void
 Archive::read_all_symbols()
 {
+  if (this->member_offsets_ != NULL)
+    {
+      for (size_t i = 0; i < this->member_count_; ++i)
+	this->read_symbols(this->member_offsets_[i]);
+      return;
+    }
+
   for (Archive::const_iterator p = this->begin();
        p != this->end();
        ++p)
@@ -761,9 +1236,10 @@ Archive::read_symbols(off_t off)
 // Select members from the archive and add them to the link.  We walk
 // through the elements in the archive map, and look each one up in
 // the symbol table.  If it exists as a strong undefined symbol, we
-// pull in the corresponding element.  We have to do this in a loop,
-// since pulling in one element may create new undefined symbols which
-// may be satisfied by other objects in the archive.  Return true in
+// pull in the corresponding element.  Pulling in one element may
+// create new undefined symbols which may be satisfied by other
+// objects in the archive, so we then look up those symbols in the
+// archive map hash table to find more elements.  Return true in
 // the normal case, false if the first member we tried to add from
 // this archive had an incompatible target.
 
@@ -778,79 +1254,135 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
 				     mapfile);
 
   Archive::total_members += this->num_members_;
+  if (this->index_cache_view_ != NULL)
+    ++Archive::total_index_cache_hits;
 
   input_objects->archive_start(this);
 
-  const size_t armap_size = this->armap_.size();
+  const size_t armap_size = this->armap_size_;
+  if (armap_size > 0)
+    this->build_armap_hash();
 
   // This is a quick optimization, since we usually see many symbols
   // in a row with the same offset.  last_seen_offset holds the last
   // offset we saw that was present in the seen_offsets_ set.
   off_t last_seen_offset = -1;
 
-  // Track which symbols in the symbol table we've already found to be
-  // defined.
+  // We walk through the whole archive map once.  After that, an
+  // entry we did not include can only be needed if a member we
+  // include adds a strong undefined reference to its symbol, so we
+  // only look at those entries, which we find using the hash table.
+  // To include the members in the same order as repeated walks
+  // through the archive map would, PENDING holds the entries later
+  // in the archive map to look at in this walk, and NEXT holds the
+  // entries to look at in the next walk.
+  std::vector<const char*> undefs;
+  std::set<size_t> pending;
+  std::set<size_t> next;
+  bool full_walk = true;
+  size_t full_walk_index = 0;
+
+  symtab->set_undefined_references(&undefs);
 
   char* tmpbuf = NULL;
   size_t tmpbuflen = 0;
-  bool added_new_object;
-  do
+  bool ret = true;
+  while (true)
     {
-      added_new_object = false;
-      for (size_t i = 0; i < armap_size; ++i)
+      size_t i;
+      if (full_walk && full_walk_index < armap_size)
+	i = full_walk_index++;
+      else
 	{
-          if (this->armap_checked_[i])
-            continue;
-	  if (this->armap_[i].file_offset == last_seen_offset)
-            {
-              this->armap_checked_[i] = true;
-              continue;
-            }
-	  if (this->seen_offsets_.find(this->armap_[i].file_offset)
-              != this->seen_offsets_.end())
+	  full_walk = false;
+	  if (pending.empty())
 	    {
-              this->armap_checked_[i] = true;
-	      last_seen_offset = this->armap_[i].file_offset;
-	      continue;
+	      if (next.empty())
+		break;
+	      pending.swap(next);
 	    }
+	  i = *pending.begin();
+	  pending.erase(pending.begin());
+	}
 
-	  const char* sym_name = (this->armap_names_.data()
-				  + this->armap_[i].name_offset);
+      if (this->armap_checked_[i])
+	continue;
+      if (this->armap_[i].file_offset == last_seen_offset)
+	{
+	  this->armap_checked_[i] = true;
+	  continue;
+	}
+      if (this->seen_offsets_.find(this->armap_[i].file_offset)
+	  != this->seen_offsets_.end())
+	{
+	  this->armap_checked_[i] = true;
+	  last_seen_offset = this->armap_[i].file_offset;
+	  continue;
+	}
 
-          Symbol* sym;
-          std::string why;
-          Archive::Should_include t =
-	    Archive::should_include_member(symtab, layout, sym_name, &sym,
-					   &why, &tmpbuf, &tmpbuflen);
+      const char* sym_name = (this->armap_names_
+			      + this->armap_[i].name_offset);
 
-	  if (t == Archive::SHOULD_INCLUDE_NO
-              || t == Archive::SHOULD_INCLUDE_YES)
-	    this->armap_checked_[i] = true;
+      Symbol* sym;
+      std::string why;
+      Archive::Should_include t =
+	Archive::should_include_member(symtab, layout, sym_name, &sym,
+				       &why, &tmpbuf, &tmpbuflen);
 
-	  if (t != Archive::SHOULD_INCLUDE_YES)
-	    continue;
+      if (t == Archive::SHOULD_INCLUDE_NO
+	  || t == Archive::SHOULD_INCLUDE_YES)
+	this->armap_checked_[i] = true;
 
-	  // We want to include this object in the link.
-	  last_seen_offset = this->armap_[i].file_offset;
-	  this->seen_offsets_.insert(last_seen_offset);
+      if (t != Archive::SHOULD_INCLUDE_YES)
+	continue;
 
-	  if (!this->include_member(symtab, layout, input_objects,
-				    last_seen_offset, mapfile, sym,
-				    why.c_str()))
+      // We want to include this object in the link.
+      last_seen_offset = this->armap_[i].file_offset;
+      this->seen_offsets_.insert(last_seen_offset);
+
+      undefs.clear();
+      if (!this->include_member(symtab, layout, input_objects,
+				last_seen_offset, mapfile, sym,
+				why.c_str()))
+	{
+	  ret = false;
+	  break;
+	}
+
+      // Queue the entries for the new undefined references.
+      for (std::vector<const char*>::const_iterator p = undefs.begin();
+	   p != undefs.end();
+	   ++p)
+	{
+	  size_t len = strlen(*p);
+	  uint32_t hash = armap_name_hash(*p, len);
+	  uint32_t j = this->armap_buckets_[hash
+					    & (this->armap_bucket_count_ - 1)];
+	  for (; j != 0; j = this->armap_chains_[j - 1])
 	    {
-	      if (tmpbuf != NULL)
-		free(tmpbuf);
-	      return false;
+	      size_t k = j - 1;
+	      if (this->armap_checked_[k])
+		continue;
+	      const char* name = this->armap_names_ + this->armap_[k].name_offset;
+	      if (strncmp(name, *p, len) != 0
+		  || (name[len] != '\0' && name[len] != '@'))
+		continue;
+	      if (k <= i)
+		next.insert(k);
+	      else if (!full_walk)
+		pending.insert(k);
 	    }
-
-	  added_new_object = true;
 	}
     }
-  while (added_new_object);
+
+  symtab->set_undefined_references(NULL);
 
   if (tmpbuf != NULL)
     free(tmpbuf);
 
+  if (!ret)
+    return false;
+
   input_objects->archive_stop(this);
 
   return true;
@@ -864,30 +1396,57 @@ Archive::defines_symbol(Symbol* sym) const
 {
   const char* symname = sym->name();
   size_t symname_len = strlen(symname);
-  size_t armap_size = this->armap_.size();
+
+  // If we have a hash table from the index cache, only look at the
+  // entries with the same name.
+  if (this->armap_buckets_ != NULL)
+    {
+      uint32_t hash = armap_name_hash(symname, symname_len);
+      uint32_t i = this->armap_buckets_[hash & (this->armap_bucket_count_ - 1)];
+      while (i != 0)
+	{
+	  if (this->armap_entry_defines(i - 1, sym, symname, symname_len))
+	    return true;
+	  i = this->armap_chains_[i - 1];
+	}
+      return false;
+    }
+
+  size_t armap_size = this->armap_size_;
   for (size_t i = 0; i < armap_size; ++i)
+    if (this->armap_entry_defines(i, sym, symname, symname_len))
+      return true;
+  return false;
+}
+
+// Return whether the archive map entry I, which we have not yet
+// checked, defines the symbol SYM, whose name is SYMNAME of length
+// SYMNAME_LEN.
+
+bool
+Archive::armap_entry_defines(size_t i, const Symbol* sym, const char* symname,
+			     size_t symname_len) const
+{
+  if (this->armap_checked_[i])
+    return false;
+  const char* archive_symname = (this->armap_names_
+				 + this->armap_[i].name_offset);
+  if (strncmp(archive_symname, symname, symname_len) != 0)
+    return false;
+  char c = archive_symname[symname_len];
+  if (c == '\0' && sym->version() == NULL)
+    return true;
+  if (c == '@')
     {
-      if (this->armap_checked_[i])
-	continue;
-      const char* archive_symname = (this->armap_names_.data()
-				     + this->armap_[i].name_offset);
-      if (strncmp(archive_symname, symname, symname_len) != 0)
-	continue;
-      char c = archive_symname[symname_len];
-      if (c == '\0' && sym->version() == NULL)
-	return true;
-      if (c == '@')
+      const char* ver = archive_symname + symname_len + 1;
+      if (*ver == '@')
 	{
-	  const char* ver = archive_symname + symname_len + 1;
-	  if (*ver == '@')
-	    {
-	      if (sym->version() == NULL)
-		return true;
-	      ++ver;
-	    }
-	  if (sym->version() != NULL && strcmp(sym->version(), ver) == 0)
+	  if (sym->version() == NULL)
 	    return true;
+	  ++ver;
 	}
+      if (sym->version() != NULL && strcmp(sym->version(), ver) == 0)
+	return true;
     }
   return false;
 }
@@ -920,6 +1479,17 @@ Archive::include_all_members(Symbol_table* symtab, Layout* layout,
           ++Archive::total_members;
         }
     }
+  else if (this->member_offsets_ != NULL)
+    {
+      for (size_t i = 0; i < this->member_count_; ++i)
+        {
+          if (!this->include_member(symtab, layout, input_objects,
+				    this->member_offsets_[i], mapfile, NULL,
+				    "--whole-archive"))
+	    return false;
+          ++Archive::total_members;
+        }
+    }
   else
     {
       for (Archive::const_iterator p = this->begin();
@@ -944,6 +1514,9 @@ Archive::include_all_members(Symbol_table* symtab, Layout* layout,
 size_t
 Archive::count_members()
 {
+  if (this->member_offsets_ != NULL)
+    return this->member_count_;
+
   size_t ret = 0;
   for (Archive::const_iterator p = this->begin();
        p != this->end();
@@ -1066,13 +1639,12 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
 void
 Archive::do_for_all_unused_symbols(Symbol_visitor_base* v) const
 {
-  for (std::vector<Armap_entry>::const_iterator p = this->armap_.begin();
-       p != this->armap_.end();
-       ++p)
+  for (size_t i = 0; i < this->armap_size_; ++i)
     {
+      const Armap_entry* p = &this->armap_[i];
       if (this->seen_offsets_.find(p->file_offset)
           == this->seen_offsets_.end())
-        v->visit(this->armap_names_.data() + p->name_offset);
+        v->visit(this->armap_names_ + p->name_offset);
     }
 }
 
@@ -1087,6 +1659,9 @@ Archive::print_stats()
           program_name, Archive::total_members);
   fprintf(stderr, _("%s: loaded archive members: %u\n"),
           program_name, Archive::total_members_loaded);
+  if (parameters->options().archive_index_cache() != NULL)
+    fprintf(stderr, _("%s: archive index cache hits: %u\n"),
+	    program_name, Archive::total_index_cache_hits);
 }
 
 // Add_archive_symbols methods.
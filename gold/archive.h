@@ -43,6 +43,7 @@ class Object;
 struct Read_symbols_data;
 class Input_file_lib;
 class Incremental_archive_entry;
+struct Archive_index_cache_header;
 
 // An entry in the archive map of offsets to members.
 struct Archive_member
@@ -165,6 +166,8 @@ class Archive : public Library_base
   Archive(const std::string& name, Input_file* input_file,
           bool is_thin_archive, Dirsearch* dirpath, Task* task);
 
+  ~Archive();
+
   // The length of the magic string at the start of an archive.
   static const int sarmag = 8;
 
@@ -286,17 +289,55 @@ class Archive : public Library_base
   static unsigned int total_members;
   // Number of archive members loaded.
   static unsigned int total_members_loaded;
+  // Number of archives whose symbol map we found in the index cache.
+  static unsigned int total_index_cache_hits;
 
   // Get a view into the underlying file.
   const unsigned char*
   get_view(off_t start, section_size_type size, bool aligned, bool cache)
   { return this->input_file_->file().get_view(0, start, size, aligned, cache); }
 
+  // Read the archive symbol map and the extended name table.  Return
+  // false if something went wrong.
+  bool
+  read_maps();
+
   // Read the archive symbol map.
   template<int mapsize>
   void
   read_armap(off_t start, section_size_type size);
 
+  // Fill in the fields of *HDR which identify this version of the
+  // archive in the index cache, and set *PATH to the canonical name
+  // of the archive.  Return false if we can't.
+  bool
+  get_index_cache_key(Archive_index_cache_header* hdr, std::string* path);
+
+  // Return the name of the index cache file in CACHE_DIR for the
+  // archive PATH.
+  static std::string
+  index_cache_filename(const char* cache_dir, const std::string& path);
+
+  // Use the index cache file in CACHE_DIR for this archive, if there
+  // is one which is up to date.  Return true if we did.
+  bool
+  read_index_cache(const char* cache_dir);
+
+  // Write an index cache file for this archive in CACHE_DIR.
+  void
+  write_index_cache(const char* cache_dir);
+
+  // Build the hash table of the names in the archive map, if we
+  // don't have one from the index cache.
+  void
+  build_armap_hash();
+
+  // Return whether the archive map entry I defines SYM, whose name
+  // is SYMNAME of length SYMNAME_LEN.
+  bool
+  armap_entry_defines(size_t i, const Symbol* sym, const char* symname,
+		      size_t symname_len) const;
+
   // Read an archive member header at OFF.  CACHE is whether to cache
   // the file view.  Return the size of the member, and set *PNAME to
   // the name.
@@ -384,10 +425,35 @@ class Archive : public Library_base
   std::string name_;
   // For reading the file.
   Input_file* input_file_;
-  // The archive map.
-  std::vector<Armap_entry> armap_;
-  // The names in the archive map.
-  std::string armap_names_;
+  // The archive map.  This points into ARMAP_STORAGE_, or into the
+  // index cache file.
+  const Armap_entry* armap_;
+  // The number of entries in the archive map.
+  size_t armap_size_;
+  // The names in the archive map.  This points into
+  // ARMAP_NAMES_STORAGE_, or into the index cache file.
+  const char* armap_names_;
+  // The archive map and names when we read them from the archive.
+  std::vector<Armap_entry> armap_storage_;
+  std::string armap_names_storage_;
+  // A hash table of the names in the archive map, without any
+  // version, or NULL if we have not built it yet.  ARMAP_BUCKETS_
+  // holds the index plus one of the first entry for each hash code,
+  // and ARMAP_CHAINS_ holds the index plus one of the next entry with
+  // the same hash code.  These point into the index cache file, or
+  // into ARMAP_BUCKET_STORAGE_ and ARMAP_CHAIN_STORAGE_.
+  const uint32_t* armap_buckets_;
+  size_t armap_bucket_count_;
+  const uint32_t* armap_chains_;
+  std::vector<uint32_t> armap_bucket_storage_;
+  std::vector<uint32_t> armap_chain_storage_;
+  // The file offsets of the archive members, from the index cache
+  // file, or NULL.
+  const off_t* member_offsets_;
+  size_t member_count_;
+  // The mapped index cache file, or NULL.
+  void* index_cache_view_;
+  size_t index_cache_size_;
   // The extended name table.
   std::string extended_names_;
   // Track which symbols in the archive map are for elements which are
@@ -1682,6 +1682,11 @@ class Arm_relobj : public Sized_relobj_file<32, big_endian>
       const unsigned char* pshdrs, Output_file* of,
       typename Sized_relobj_file<32, big_endian>::Views* pivews);
 
+  // The stubs are relocated along with the sections.
+  bool
+  do_can_relocate_in_parts() const
+  { return false; }
+
   // Read the symbol information.
   void
   do_read_symbols(Read_symbols_data* sd);
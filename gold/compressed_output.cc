@@ -21,14 +21,61 @@
 // MA 02110-1301, USA.
 
 #include "gold.h"
+#include <algorithm>
 #include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 #include "parameters.h"
 #include "options.h"
+#include "workqueue.h"
 #include "compressed_output.h"
 
 namespace gold
 {
 
+// Sections larger than this are compressed in chunks of this size,
+// in parallel.  The chunks are joined into a single zlib stream, or
+// with zstd are simply concatenated frames, so the result can be
+// read by any decompressor.  The chunking depends only on the
+// section size, not on the number of threads, so the output is the
+// same however many threads are used.
+
+static const section_size_type compress_chunk_size = 1 << 20;
+
+// The size of the deflate window.  Each chunk after the first uses
+// this much of the end of the previous chunk as a preset dictionary,
+// so that chunking costs very little in compression ratio.
+
+static const section_size_type deflate_window_size = 1 << MAX_WBITS;
+
+// Return the zlib compression level to use.
+
+static int
+compress_level()
+{
+  if (parameters->options().optimize() >= 1)
+    return 9;
+  else
+    return 1;
+}
+
+#ifdef HAVE_ZSTD
+
+// Return the zstd compression level to use.  Higher levels than this
+// cost far more time than they save space.
+
+static int
+zstd_compress_level()
+{
+  if (parameters->options().optimize() >= 1)
+    return 9;
+  else
+    return 1;
+}
+
+#endif // defined(HAVE_ZSTD)
+
 // Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns true
 // if it successfully compressed, false if it failed for any reason
 // (including not having zlib support in the library).  If it returns
@@ -48,17 +95,11 @@ zlib_compress(int header_size,
   *compressed_size = uncompressed_size + uncompressed_size / 1000 + 128;
   *compressed_data = new unsigned char[*compressed_size + header_size];
 
-  int compress_level;
-  if (parameters->options().optimize() >= 1)
-    compress_level = 9;
-  else
-    compress_level = 1;
-
   int rc = compress2(reinterpret_cast<Bytef*>(*compressed_data) + header_size,
                      compressed_size,
                      reinterpret_cast<const Bytef*>(uncompressed_data),
                      uncompressed_size,
-                     compress_level);
+                     compress_level());
   if (rc == Z_OK)
     {
       *compressed_size += header_size;
@@ -72,6 +113,133 @@ zlib_compress(int header_size,
     }
 }
 
+// Compress one chunk of a section, UNCOMPRESSED_DATA of size
+// UNCOMPRESSED_SIZE, as raw deflate data with no zlib header or
+// trailer.  The DICT_SIZE bytes before UNCOMPRESSED_DATA are the end
+// of the previous chunk, and are used as a preset dictionary.  If
+// IS_LAST, this finishes the deflate stream.  Otherwise this ends
+// with a sync flush, which leaves the output on a byte boundary
+// without marking the last block, so that the next chunk can simply
+// be appended.  Returns true on success, and sets *COMPRESSED_DATA,
+// allocated using new, and *COMPRESSED_SIZE.
+
+static bool
+zlib_compress_chunk(const unsigned char* uncompressed_data,
+		    unsigned long uncompressed_size,
+		    unsigned long dict_size,
+		    bool is_last,
+		    unsigned char** compressed_data,
+		    unsigned long* compressed_size)
+{
+  z_stream strm;
+  memset(&strm, 0, sizeof strm);
+  if (deflateInit2(&strm, compress_level(), Z_DEFLATED, -MAX_WBITS, 8,
+		   Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+  if (dict_size > 0
+      && deflateSetDictionary(&strm, uncompressed_data - dict_size,
+			      dict_size) != Z_OK)
+    {
+      deflateEnd(&strm);
+      return false;
+    }
+
+  // Leave room for the sync flush.
+  unsigned long bound = deflateBound(&strm, uncompressed_size) + 16;
+  *compressed_data = new unsigned char[bound];
+  strm.next_in = const_cast<Bytef*>(uncompressed_data);
+  strm.avail_in = uncompressed_size;
+  strm.next_out = *compressed_data;
+  strm.avail_out = bound;
+
+  int rc = deflate(&strm, is_last ? Z_FINISH : Z_SYNC_FLUSH);
+  bool ok;
+  if (is_last)
+    ok = rc == Z_STREAM_END;
+  else
+    ok = rc == Z_OK && strm.avail_in == 0 && strm.avail_out > 0;
+  *compressed_size = strm.total_out;
+  deflateEnd(&strm);
+
+  if (!ok)
+    {
+      delete[] *compressed_data;
+      *compressed_data = NULL;
+    }
+  return ok;
+}
+
+// Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE as a zstd
+// frame, leaving HEADER_SIZE bytes before it.  Returns true on
+// success, and sets *COMPRESSED_DATA, allocated using new, and
+// *COMPRESSED_SIZE, which includes the header.  Returns false if
+// zstd fails or if we were built without zstd.
+
+#ifdef HAVE_ZSTD
+
+static bool
+zstd_compress(int header_size,
+	      const unsigned char* uncompressed_data,
+	      unsigned long uncompressed_size,
+	      unsigned char** compressed_data,
+	      unsigned long* compressed_size)
+{
+  size_t bound = ZSTD_compressBound(uncompressed_size);
+  *compressed_data = new unsigned char[bound + header_size];
+  size_t rc = ZSTD_compress(*compressed_data + header_size, bound,
+			    uncompressed_data, uncompressed_size,
+			    zstd_compress_level());
+  if (!ZSTD_isError(rc))
+    {
+      *compressed_size = rc + header_size;
+      return true;
+    }
+  delete[] *compressed_data;
+  *compressed_data = NULL;
+  return false;
+}
+
+#else // !defined(HAVE_ZSTD)
+
+static bool
+zstd_compress(int, const unsigned char*, unsigned long,
+	      unsigned char** compressed_data, unsigned long*)
+{
+  *compressed_data = NULL;
+  return false;
+}
+
+#endif // !defined(HAVE_ZSTD)
+
+// Decompress the zstd frames in COMPRESSED_DATA of size
+// COMPRESSED_SIZE into UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.
+// Returns true on success.  ZSTD_decompress handles any number of
+// frames, so this also reads what we write for large sections.
+
+#ifdef HAVE_ZSTD
+
+static bool
+zstd_decompress(const unsigned char* compressed_data,
+		unsigned long compressed_size,
+		unsigned char* uncompressed_data,
+		unsigned long uncompressed_size)
+{
+  size_t rc = ZSTD_decompress(uncompressed_data, uncompressed_size,
+			      compressed_data, compressed_size);
+  return !ZSTD_isError(rc) && rc == uncompressed_size;
+}
+
+#else // !defined(HAVE_ZSTD)
+
+static bool
+zstd_decompress(const unsigned char*, unsigned long, unsigned char*,
+		unsigned long)
+{
+  return false;
+}
+
+#endif // !defined(HAVE_ZSTD)
+
 // Decompress COMPRESSED_DATA of size COMPRESSED_SIZE, into a buffer
 // UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns TRUE if it
 // decompressed successfully, false if it failed.  The buffer, of
@@ -148,45 +316,39 @@ decompress_input_section(const unsigned char* compressed_data,
   if ((sh_flags & elfcpp::SHF_COMPRESSED) != 0)
     {
       unsigned int compression_header_size;
+      elfcpp::Elf_Word ch_type;
       if (size == 32)
 	{
 	  compression_header_size = elfcpp::Elf_sizes<32>::chdr_size;
 	  if (big_endian)
-	    {
-	      elfcpp::Chdr<32, true> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
-	    }
+	    ch_type = elfcpp::Chdr<32, true>(compressed_data).get_ch_type();
 	  else
-	    {
-	      elfcpp::Chdr<32, false> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
-	    }
+	    ch_type = elfcpp::Chdr<32, false>(compressed_data).get_ch_type();
 	}
       else if (size == 64)
 	{
 	  compression_header_size = elfcpp::Elf_sizes<64>::chdr_size;
 	  if (big_endian)
-	    {
-	      elfcpp::Chdr<64, true> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
-	    }
+	    ch_type = elfcpp::Chdr<64, true>(compressed_data).get_ch_type();
 	  else
-	    {
-	      elfcpp::Chdr<64, false> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
-	    }
+	    ch_type = elfcpp::Chdr<64, false>(compressed_data).get_ch_type();
 	}
       else
 	gold_unreachable();
 
-      return zlib_decompress(compressed_data + compression_header_size,
-			     compressed_size - compression_header_size,
-			     uncompressed_data,
-			     uncompressed_size);
+      if (compressed_size < compression_header_size)
+	return false;
+      if (ch_type == elfcpp::ELFCOMPRESS_ZLIB)
+	return zlib_decompress(compressed_data + compression_header_size,
+			       compressed_size - compression_header_size,
+			       uncompressed_data,
+			       uncompressed_size);
+      if (ch_type == elfcpp::ELFCOMPRESS_ZSTD)
+	return zstd_decompress(compressed_data + compression_header_size,
+			       compressed_size - compression_header_size,
+			       uncompressed_data,
+			       uncompressed_size);
+      return false;
     }
 
   const unsigned int zlib_header_size = 12;
@@ -209,19 +371,49 @@ decompress_input_section(const unsigned char* compressed_data,
   return false;
 }
 
+// A Compress_chunk_task compresses one chunk of an
+// Output_compressed_section.
+
+class Compress_chunk_task : public Task
+{
+ public:
+  Compress_chunk_task(Output_compressed_section* os, unsigned int chunk,
+		      Task_token* final_blocker)
+    : os_(os), chunk_(chunk), final_blocker_(final_blocker)
+  { }
+
+  void
+  run(Workqueue*)
+  { this->os_->compress_chunk(this->chunk_); }
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  // Unblock FINAL_BLOCKER_ when done.
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  std::string
+  get_name() const
+  { return std::string("Compress_chunk_task ") + this->os_->name(); }
+
+ private:
+  Output_compressed_section* os_;
+  const unsigned int chunk_;
+  Task_token* const final_blocker_;
+};
+
 // Class Output_compressed_section.
 
-// Set the final data size of a compressed section.  This is where
-// we actually compress the section data.
+// Copy everything into the postprocessing buffer, decide how to
+// compress the section, and split it into chunks.
 
 void
-Output_compressed_section::set_final_data_size()
+Output_compressed_section::prepare_compression()
 {
-  off_t uncompressed_size = this->postprocessing_buffer_size();
-
-  // (Try to) compress the data.
-  unsigned long compressed_size;
-  unsigned char* uncompressed_data = this->postprocessing_buffer();
+  gold_assert(this->compress_ == NOT_PREPARED);
 
   // At this point the contents of all regular input sections will
   // have been copied into the postprocessing buffer, and relocations
@@ -229,51 +421,365 @@ Output_compressed_section::set_final_data_size()
   // anything other than a regular input section.
   this->write_to_postprocessing_buffer();
 
-  bool success = false;
-  enum { none, gnu_zlib, gabi_zlib } compress;
-  int compression_header_size = 12;
+  this->header_size_ = 12;
   const int size = parameters->target().get_size();
   if (strcmp(this->options_->compress_debug_sections(), "zlib-gnu") == 0)
-    compress = gnu_zlib;
+    this->compress_ = GNU_ZLIB;
   else if (strcmp(this->options_->compress_debug_sections(), "zlib-gabi") == 0
-	   || strcmp(this->options_->compress_debug_sections(), "zlib") == 0)
+	   || strcmp(this->options_->compress_debug_sections(), "zlib") == 0
+	   || strcmp(this->options_->compress_debug_sections(), "zstd") == 0)
     {
-      compress = gabi_zlib;
+      if (strcmp(this->options_->compress_debug_sections(), "zstd") == 0)
+	this->compress_ = GABI_ZSTD;
+      else
+	this->compress_ = GABI_ZLIB;
       if (size == 32)
-	compression_header_size = elfcpp::Elf_sizes<32>::chdr_size;
+	this->header_size_ = elfcpp::Elf_sizes<32>::chdr_size;
       else if (size == 64)
-	compression_header_size = elfcpp::Elf_sizes<64>::chdr_size;
+	this->header_size_ = elfcpp::Elf_sizes<64>::chdr_size;
       else
 	gold_unreachable();
     }
   else
-    compress = none;
-  if (compress != none)
-    success = zlib_compress(compression_header_size, uncompressed_data,
-			    uncompressed_size, &this->data_,
-			    &compressed_size);
+    {
+      this->compress_ = NONE;
+      return;
+    }
+
+  // Split the contents into chunks, around the input sections whose
+  // compressed contents we are using as they are.
+  std::sort(this->precompressed_.begin(), this->precompressed_.end(),
+	    Chunk_compare());
+  section_size_type pos = 0;
+  for (std::vector<Chunk>::const_iterator p = this->precompressed_.begin();
+       p != this->precompressed_.end();
+       ++p)
+    {
+      this->add_chunks(pos, p->offset);
+      this->chunks_.push_back(*p);
+      pos = p->offset + p->len;
+    }
+  std::vector<Chunk>().swap(this->precompressed_);
+  this->add_chunks(pos, this->postprocessing_buffer_size());
+
+  // An empty section is compressed too.
+  if (this->chunks_.empty())
+    this->chunks_.push_back(Chunk(0, 0));
+}
+
+// Add chunks to compress for the contents from START to END.
+
+void
+Output_compressed_section::add_chunks(section_size_type start,
+				      section_size_type end)
+{
+  while (start < end)
+    {
+      section_size_type len = std::min(compress_chunk_size, end - start);
+      this->chunks_.push_back(Chunk(start, len));
+      start += len;
+    }
+}
+
+// Use the compressed contents of an input section as they are, if
+// they are zstd frames and we are writing zstd.  zstd frames can
+// simply be concatenated, but there is no cheap way to splice a zlib
+// stream into another.
+
+#ifdef HAVE_ZSTD
+
+bool
+Output_compressed_section::do_add_compressed_input_section(
+    section_offset_type offset,
+    section_size_type uncompressed_size,
+    elfcpp::Elf_Xword sh_flags,
+    const unsigned char* contents,
+    section_size_type len)
+{
+  if ((sh_flags & elfcpp::SHF_COMPRESSED) == 0
+      || strcmp(this->options_->compress_debug_sections(), "zstd") != 0)
+    return false;
+
+  const int size = parameters->target().get_size();
+  const bool is_big_endian = parameters->target().is_big_endian();
+  section_size_type header_size;
+  elfcpp::Elf_Word ch_type;
+  if (size == 32)
+    {
+      header_size = elfcpp::Elf_sizes<32>::chdr_size;
+      if (len < header_size)
+	return false;
+      if (is_big_endian)
+	ch_type = elfcpp::Chdr<32, true>(contents).get_ch_type();
+      else
+	ch_type = elfcpp::Chdr<32, false>(contents).get_ch_type();
+    }
+  else if (size == 64)
+    {
+      header_size = elfcpp::Elf_sizes<64>::chdr_size;
+      if (len < header_size)
+	return false;
+      if (is_big_endian)
+	ch_type = elfcpp::Chdr<64, true>(contents).get_ch_type();
+      else
+	ch_type = elfcpp::Chdr<64, false>(contents).get_ch_type();
+    }
+  else
+    gold_unreachable();
+  if (ch_type != elfcpp::ELFCOMPRESS_ZSTD)
+    return false;
+
+  // The frames must record their sizes, which must add up to the
+  // size of the section, and must not need a dictionary.
+  const unsigned char* frames = contents + header_size;
+  section_size_type frames_size = len - header_size;
+  unsigned long long total = 0;
+  section_size_type pos = 0;
+  while (pos < frames_size)
+    {
+      const unsigned char* frame = frames + pos;
+      size_t frame_size = ZSTD_findFrameCompressedSize(frame,
+						       frames_size - pos);
+      if (ZSTD_isError(frame_size))
+	return false;
+      unsigned long long content_size =
+	ZSTD_getFrameContentSize(frame, frame_size);
+      if (content_size == ZSTD_CONTENTSIZE_UNKNOWN
+	  || content_size == ZSTD_CONTENTSIZE_ERROR
+	  || ZSTD_getDictID_fromFrame(frame, frame_size) != 0)
+	return false;
+      total += content_size;
+      pos += frame_size;
+    }
+  if (total != uncompressed_size)
+    return false;
+
+  Chunk chunk(offset, uncompressed_size);
+  chunk.data = new unsigned char[frames_size];
+  memcpy(chunk.data, frames, frames_size);
+  chunk.size = frames_size;
+  chunk.ok = true;
+  chunk.precompressed = true;
+
+  Hold_lock hl(this->lock_);
+  this->precompressed_.push_back(chunk);
+  return true;
+}
+
+#else // !defined(HAVE_ZSTD)
+
+bool
+Output_compressed_section::do_add_compressed_input_section(
+    section_offset_type,
+    section_size_type,
+    elfcpp::Elf_Xword,
+    const unsigned char*,
+    section_size_type)
+{
+  return false;
+}
+
+#endif // !defined(HAVE_ZSTD)
+
+// Queue tasks to compress the section.
+
+bool
+Output_compressed_section::do_queue_postprocessing(Workqueue* workqueue,
+						   Task_token* blocker)
+{
+  this->prepare_compression();
+  bool any = false;
+  for (unsigned int i = 0; i < this->chunks_.size(); ++i)
+    {
+      if (this->chunks_[i].ok)
+	continue;
+      blocker->add_blocker();
+      workqueue->queue(new Compress_chunk_task(this, i, blocker));
+      any = true;
+    }
+  return any;
+}
+
+// Compress chunk I.  A section which fits in one chunk is compressed
+// with compress2, which gives exactly what we generated before we
+// used chunks.  With zstd each chunk is a separate frame.
+
+void
+Output_compressed_section::compress_chunk(unsigned int i)
+{
+  const unsigned char* buffer = this->postprocessing_buffer();
+  Chunk* chunk = &this->chunks_[i];
+
+  if (chunk->ok)
+    return;
+
+  if (this->compress_ == GABI_ZSTD)
+    {
+      chunk->ok = zstd_compress(0, buffer + chunk->offset, chunk->len,
+				&chunk->data, &chunk->size);
+      return;
+    }
+
+  if (this->chunks_.size() == 1)
+    {
+      chunk->ok = zlib_compress(this->header_size_, buffer, chunk->len,
+				&chunk->data, &chunk->size);
+      return;
+    }
+
+  section_size_type start = chunk->offset;
+  section_size_type dict_size = std::min(start, deflate_window_size);
+  chunk->ok = zlib_compress_chunk(buffer + start, chunk->len, dict_size,
+				  i + 1 == this->chunks_.size(),
+				  &chunk->data, &chunk->size);
+  if (chunk->ok)
+    chunk->adler = adler32(adler32(0L, Z_NULL, 0), buffer + start,
+			   chunk->len);
+}
+
+// Join the compressed chunks into data_, leaving room for the
+// header.  For zlib the result is a zlib header, the raw deflate data
+// of each chunk in order, and the Adler-32 checksum of the whole
+// section.  For zstd it is just the frames in order.
+
+unsigned long
+Output_compressed_section::finish_compression()
+{
+  bool ok = true;
+  unsigned long total = 0;
+  for (std::vector<Chunk>::const_iterator p = this->chunks_.begin();
+       p != this->chunks_.end();
+       ++p)
+    {
+      ok = ok && p->ok;
+      total += p->size;
+    }
+
+  if (!ok)
+    {
+      // We will write the section uncompressed, so we need the
+      // contents of the input sections which we did not decompress.
+      total = 0;
+      for (std::vector<Chunk>::const_iterator p = this->chunks_.begin();
+	   p != this->chunks_.end();
+	   ++p)
+	if (p->precompressed
+	    && !zstd_decompress(p->data, p->size,
+				this->postprocessing_buffer() + p->offset,
+				p->len))
+	  gold_error(_("%s: could not decompress input section contents"),
+		     this->name());
+    }
+  else if (this->chunks_.size() == 1 && this->compress_ != GABI_ZSTD)
+    {
+      this->data_ = this->chunks_[0].data;
+      this->chunks_[0].data = NULL;
+    }
+  else if (this->compress_ == GABI_ZSTD)
+    {
+      total += this->header_size_;
+      this->data_ = new unsigned char[total];
+      unsigned char* p = this->data_ + this->header_size_;
+      for (std::vector<Chunk>::const_iterator c = this->chunks_.begin();
+	   c != this->chunks_.end();
+	   ++c)
+	{
+	  memcpy(p, c->data, c->size);
+	  p += c->size;
+	}
+    }
+  else
+    {
+      total += this->header_size_ + 2 + 4;
+      this->data_ = new unsigned char[total];
+      unsigned char* p = this->data_ + this->header_size_;
+
+      // This is the zlib header which deflate would write for a 32K
+      // window at this compression level.
+      int level = compress_level();
+      unsigned int level_flags;
+      if (level < 2)
+	level_flags = 0;
+      else if (level < 6)
+	level_flags = 1;
+      else if (level == 6)
+	level_flags = 2;
+      else
+	level_flags = 3;
+      unsigned int zlib_header = (((Z_DEFLATED + ((MAX_WBITS - 8) << 4)) << 8)
+				  | (level_flags << 6));
+      zlib_header += 31 - (zlib_header % 31);
+      elfcpp::Swap_unaligned<16, true>::writeval(p, zlib_header);
+      p += 2;
+
+      unsigned long adler = adler32(0L, Z_NULL, 0);
+      for (std::vector<Chunk>::const_iterator c = this->chunks_.begin();
+	   c != this->chunks_.end();
+	   ++c)
+	{
+	  memcpy(p, c->data, c->size);
+	  p += c->size;
+	  adler = adler32_combine(adler, c->adler, c->len);
+	}
+      elfcpp::Swap_unaligned<32, true>::writeval(p, adler);
+    }
+
+  for (std::vector<Chunk>::iterator p = this->chunks_.begin();
+       p != this->chunks_.end();
+       ++p)
+    delete[] p->data;
+  std::vector<Chunk>().swap(this->chunks_);
+
+  return total;
+}
+
+// Set the final data size of a compressed section.  This is where
+// we finish compressing the section data.  Normally the chunks have
+// already been compressed by Compress_chunk_tasks; if not, we
+// compress them here.
+
+void
+Output_compressed_section::set_final_data_size()
+{
+  off_t uncompressed_size = this->postprocessing_buffer_size();
+
+  if (this->compress_ == NOT_PREPARED)
+    {
+      this->prepare_compression();
+      for (unsigned int i = 0; i < this->chunks_.size(); ++i)
+	this->compress_chunk(i);
+    }
+
+  unsigned long compressed_size = 0;
+  if (this->compress_ != NONE)
+    compressed_size = this->finish_compression();
+  bool success = compressed_size != 0;
+  const int size = parameters->target().get_size();
   if (success)
     {
       elfcpp::Elf_Xword flags = this->flags();
-      if (compress == gabi_zlib)
+      if (this->compress_ != GNU_ZLIB)
 	{
 	  // Set the SHF_COMPRESSED bit.
 	  flags |= elfcpp::SHF_COMPRESSED;
 	  const bool is_big_endian = parameters->target().is_big_endian();
 	  uint64_t addralign = this->addralign();
+	  elfcpp::Elf_Word ch_type = (this->compress_ == GABI_ZSTD
+				      ? elfcpp::ELFCOMPRESS_ZSTD
+				      : elfcpp::ELFCOMPRESS_ZLIB);
 	  if (size == 32)
 	    {
 	      if (is_big_endian)
 		{
 		  elfcpp::Chdr_write<32, true> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
 	      else
 		{
 		  elfcpp::Chdr_write<32, false> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
@@ -283,14 +789,14 @@ Output_compressed_section::set_final_data_size()
 	      if (is_big_endian)
 		{
 		  elfcpp::Chdr_write<64, true> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
 	      else
 		{
 		  elfcpp::Chdr_write<64, false> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
@@ -313,7 +819,10 @@ Output_compressed_section::set_final_data_size()
     }
   else
     {
-      gold_warning(_("not compressing section data: zlib error"));
+      if (this->compress_ == GABI_ZSTD)
+	gold_warning(_("not compressing section data: zstd error"));
+      else
+	gold_warning(_("not compressing section data: zlib error"));
       gold_assert(this->data_ == NULL);
       this->set_data_size(uncompressed_size);
     }
@@ -29,13 +29,17 @@
 #define GOLD_COMPRESSED_OUTPUT_H
 
 #include <string>
+#include <vector>
 
 #include "output.h"
+#include "gold-threads.h"
 
 namespace gold
 {
 
 class General_options;
+class Workqueue;
+class Task_token;
 
 // Read the compression header of a compressed debug section and return
 // the uncompressed size.
@@ -60,23 +64,123 @@ class Output_compressed_section : public Output_section
 			    const char* name, elfcpp::Elf_Word flags,
 			    elfcpp::Elf_Xword type)
     : Output_section(name, flags, type),
-      options_(options)
+      options_(options), data_(NULL), compress_(NOT_PREPARED),
+      header_size_(0), chunks_(), precompressed_(), lock_()
   { this->set_requires_postprocessing(); }
 
+  // Compress chunk I of the section contents.  This is called by
+  // Compress_chunk_task, or by set_final_data_size if the tasks were
+  // not queued.
+  void
+  compress_chunk(unsigned int i);
+
  protected:
   // Set the final data size.
   void
   set_final_data_size();
 
+  // Queue tasks to compress the section contents, each of which
+  // unblocks BLOCKER when done.  Large sections are compressed in
+  // several chunks at once.
+  bool
+  do_queue_postprocessing(Workqueue*, Task_token* blocker);
+
+  // Take the compressed contents of an input section as they are,
+  // if they can be copied into the output.
+  bool
+  do_add_compressed_input_section(section_offset_type offset,
+				  section_size_type uncompressed_size,
+				  elfcpp::Elf_Xword sh_flags,
+				  const unsigned char* contents,
+				  section_size_type len);
+
   // Write out the compressed contents.
   void
   do_write(Output_file*);
 
  private:
+  // The type of compression.
+  enum Compression
+  {
+    // prepare_compression has not been called.
+    NOT_PREPARED,
+    // Don't compress.
+    NONE,
+    // The .zdebug format: a "ZLIB" header and a zlib stream.
+    GNU_ZLIB,
+    // The SHF_COMPRESSED format: an ELF Chdr and a zlib stream.
+    GABI_ZLIB,
+    // The SHF_COMPRESSED format: an ELF Chdr and zstd frames.
+    GABI_ZSTD
+  };
+
+  // One chunk of the section contents, and the result of compressing
+  // it.
+  struct Chunk
+  {
+    Chunk(section_size_type a_offset, section_size_type a_len)
+      : offset(a_offset), len(a_len), data(NULL), size(0), adler(0),
+	ok(false), precompressed(false)
+    { }
+
+    // The offset of the chunk in the uncompressed contents.
+    section_size_type offset;
+    // The uncompressed size of the chunk.
+    section_size_type len;
+    // The compressed data, allocated with new[].
+    unsigned char* data;
+    // The size of the compressed data.
+    unsigned long size;
+    // The Adler-32 checksum of the uncompressed chunk.
+    unsigned long adler;
+    // Whether the chunk was compressed successfully.
+    bool ok;
+    // Whether the data was copied from an input section, whose
+    // contents are not in the postprocessing buffer.
+    bool precompressed;
+  };
+
+  // Sort chunks by offset.
+  struct Chunk_compare
+  {
+    bool
+    operator()(const Chunk& c1, const Chunk& c2) const
+    { return c1.offset < c2.offset; }
+  };
+
+  // Copy the data which are not from input sections into the
+  // postprocessing buffer, and decide how to compress it.
+  void
+  prepare_compression();
+
+  // Add chunks covering the contents from START to END.
+  void
+  add_chunks(section_size_type start, section_size_type end);
+
+  // Combine the compressed chunks into data_.  Return the size of
+  // data_, or 0 on failure.
+  unsigned long
+  finish_compression();
+
   // The options--this includes the compression type.
   const General_options* options_;
   // The compressed data.
   unsigned char* data_;
+  // The type of compression.
+  Compression compress_;
+  // The size of the header before the compressed data.
+  int header_size_;
+  // The compressed chunks of the section contents.  With zlib, if
+  // there is only one, it holds the header and the whole zlib stream;
+  // otherwise each holds a raw deflate stream, which
+  // finish_compression joins into a single zlib stream.  With zstd
+  // each holds zstd frames, which are simply concatenated.
+  std::vector<Chunk> chunks_;
+  // The compressed contents of input sections which we copy as they
+  // are, added by Relocate_tasks.
+  std::vector<Chunk> precompressed_;
+  // Lock held while adding to precompressed_.
+  Lock lock_;
   // The new section name if we do compress.
   std::string new_section_name_;
 };
@@ -187,7 +187,9 @@ Dwarf_abbrev_table::do_read_abbrevs(
 	      // Correct the offset.  For incremental update links, we have a
 	      // relocated offset that is relative to the output section, but
 	      // here we need an offset relative to the input section.
-	      abbrev_offset -= object->output_section_offset(i);
+	      // Otherwise the offset was never relocated.
+	      if (parameters->incremental_update())
+		abbrev_offset -= object->output_section_offset(i);
 	      break;
 	    }
 	}
@@ -321,7 +323,9 @@ Dwarf_ranges_table::read_ranges_table(
 	  if (name == ".debug_ranges" || name == ".zdebug_ranges")
 	    {
 	      ranges_shndx = i;
-	      this->output_section_offset_ = object->output_section_offset(i);
+	      if (parameters->incremental_update())
+		this->output_section_offset_ =
+		    object->output_section_offset(i);
 	      break;
 	    }
 	}
@@ -1391,8 +1395,9 @@ Dwarf_info_reader::do_read_string_table(unsigned int string_shndx)
 	  if (name == ".debug_str" || name == ".zdebug_str")
 	    {
 	      string_shndx = i;
-	      this->string_output_section_offset_ =
-		  object->output_section_offset(i);
+	      if (parameters->incremental_update())
+		this->string_output_section_offset_ =
+		    object->output_section_offset(i);
 	      break;
 	    }
 	}
@@ -28,6 +28,8 @@
 #include <cstdlib>
 #include <cstring>
 #include <cerrno>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include <vector>
 #include <algorithm>
@@ -45,6 +47,7 @@
 #include "compressed_output.h"
 #include "stringpool.h"
 #include "dwarf_reader.h"
+#include "workqueue.h"
 
 static void
 usage(FILE* fd, int) ATTRIBUTE_NORETURN;
@@ -99,29 +102,89 @@ struct Unit_set
   { }
 };
 
+// A compilation unit or type unit in a .debug_info.dwo or
+// .debug_types.dwo input section.
+
+struct Input_unit
+{
+  // The DWO ID or type signature.
+  uint64_t signature;
+  // The offset and length of the unit in the input section.
+  Section_bounds bounds;
+
+  Input_unit(uint64_t sig, section_offset_type o, section_size_type s)
+    : signature(sig), bounds(o, s)
+  { }
+};
+
 // An input file.
 // This class may represent a .dwo file, a .dwp file
 // produced by an earlier run, or an executable file whose
 // debug section identifies a set of .dwo files to read.
 
+// A .dwo or .dwp file is added to the output file in four steps:
+// read_input, add_strings, remap_strings and add_sections.  The
+// first and third steps only look at this input file, so they may
+// run in parallel with the steps for other input files.  The second
+// and fourth steps update the output file, and must be done for each
+// input file in turn.
+
 class Dwo_file
 {
  public:
   Dwo_file(const char* name)
     : name_(name), obj_(NULL), input_file_(NULL), is_compressed_(),
-      sect_offsets_(), str_offset_map_()
-  { }
+      sect_offsets_(), str_offset_map_(), machine_(0), size_(0),
+      big_endian_(false), osabi_(0), abiversion_(0), debug_types_(),
+      debug_str_(0), debug_cu_index_(0), debug_tu_index_(0),
+      str_contents_(NULL), str_len_(0), str_is_new_(false),
+      str_offsets_is_new_(false), str_offsets_unchanged_(false),
+      reuse_offsets_(false), unit_sections_()
+  {
+    for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
+      {
+	this->debug_shndx_[i] = 0;
+	this->sect_contents_[i] = NULL;
+	this->sect_len_[i] = 0;
+      }
+  }
 
   ~Dwo_file();
 
+  // Return the filename.
+  const char*
+  name() const
+  { return this->name_; }
+
+  // Add the sections of this .dwp file to the output file whole, so
+  // that the units keep their offsets within each section.  This is
+  // used for the package given to --update.
+  void
+  set_reuse_offsets()
+  { this->reuse_offsets_ = true; }
+
   // Read the input executable file and extract the list of .dwo files
   // that it references.
   void
   read_executable(File_list* files);
 
-  // Read the input file and send its contents to OUTPUT_FILE.
+  // Open the input file, find the debug sections, and read the
+  // sections and units to be added to the output file.
+  void
+  read_input();
+
+  // Merge the input string table section into the output file.
   void
-  read(Dwp_output_file* output_file);
+  add_strings(Dwp_output_file* output_file);
+
+  // Remap the string offsets in the .debug_str_offsets.dwo section,
+  // now that add_strings has given us the output string offsets.
+  void
+  remap_strings();
+
+  // Add the sections and units read by read_input to OUTPUT_FILE.
+  void
+  add_sections(Dwp_output_file* output_file);
 
   // Verify a .dwp file given a list of .dwo files referenced by the
   // corresponding executable file.  Returns true if no problems
@@ -144,16 +207,38 @@ class Dwo_file
     { return i1.first < i2.first; }
   };
 
+  // A .debug_info.dwo or .debug_types.dwo input section, with the
+  // units found in it by read_input.
+  struct Unit_section
+  {
+    Unit_section(bool is_tu, const unsigned char* c, bool n)
+      : is_type_unit(is_tu), contents(c), is_new(n), units()
+    { }
+    bool is_type_unit;
+    const unsigned char* contents;
+    bool is_new;
+    std::vector<Input_unit> units;
+  };
+
   // Create a Sized_relobj_dwo of the given size and endianness,
-  // and record the target info.  P is a pointer to the ELF header
+  // and save the target info.  P is a pointer to the ELF header
   // in memory.
   Relobj*
-  make_object(Dwp_output_file* output_file);
+  make_object();
 
   template <int size, bool big_endian>
   Relobj*
-  sized_make_object(const unsigned char* p, Input_file* input_file,
-		    Dwp_output_file* output_file);
+  sized_make_object(const unsigned char* p, Input_file* input_file);
+
+  // Return whether this is a .dwp file, with index sections.
+  bool
+  is_dwp() const
+  { return this->debug_cu_index_ > 0 || this->debug_tu_index_ > 0; }
+
+  // Read the contents of a .debug_info.dwo or .debug_types.dwo
+  // section, and find the units in it.
+  void
+  read_units(unsigned int shndx, bool is_debug_types);
 
   // Return the number of sections in the input object file.
   unsigned int
@@ -198,10 +283,6 @@ class Dwo_file
   bool
   sized_verify_dwo_list(unsigned int, const File_list& files);
 
-  // Merge the input string table section into the output file.
-  void
-  add_strings(Dwp_output_file*, unsigned int);
-
   // Copy a section from the input file to the output file.
   Section_bounds
   copy_section(Dwp_output_file* output_file, unsigned int shndx,
@@ -220,12 +301,6 @@ class Dwo_file
   unsigned int
   remap_str_offset(section_offset_type val);
 
-  // Add a set of .debug_info.dwo or .debug_types.dwo and related sections
-  // to OUTPUT_FILE.
-  void
-  add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
-	       bool is_debug_types);
-
   // The filename.
   const char* name_;
   // The ELF file, represented as a gold Relobj instance.
@@ -238,6 +313,38 @@ class Dwo_file
   std::vector<Section_bounds> sect_offsets_;
   // Map input string offsets to output string offsets.
   Str_offset_map str_offset_map_;
+  // The target info from the ELF header, recorded in the output file
+  // by add_sections.
+  int machine_;
+  int size_;
+  bool big_endian_;
+  int osabi_;
+  int abiversion_;
+  // The debug sections found by read_input.
+  unsigned int debug_shndx_[elfcpp::DW_SECT_MAX + 1];
+  std::vector<unsigned int> debug_types_;
+  unsigned int debug_str_;
+  unsigned int debug_cu_index_;
+  unsigned int debug_tu_index_;
+  // The contents of the .debug_str.dwo section.
+  const unsigned char* str_contents_;
+  section_size_type str_len_;
+  bool str_is_new_;
+  // The contents of the sections related to the units of a .dwo file,
+  // indexed by DW_SECT.  These are allocated via new, and ownership
+  // passes to the output file in add_sections.
+  const unsigned char* sect_contents_[elfcpp::DW_SECT_MAX + 1];
+  section_size_type sect_len_[elfcpp::DW_SECT_MAX + 1];
+  // Whether the .debug_str_offsets.dwo contents were allocated via
+  // new.  They are replaced by remap_strings.
+  bool str_offsets_is_new_;
+  // Whether add_strings found every string at the same offset in the
+  // output string table, so the string offsets need no remapping.
+  bool str_offsets_unchanged_;
+  // Whether to keep the offsets of the units; see set_reuse_offsets.
+  bool reuse_offsets_;
+  // The .debug_info.dwo and .debug_types.dwo sections of a .dwo file.
+  std::vector<Unit_section> unit_sections_;
 };
 
 // An ELF input file.
@@ -452,12 +559,20 @@ class Dwp_output_file
       abiversion_(0), fd_(NULL), next_file_offset_(0), shnum_(1), sections_(),
       section_id_map_(), shoff_(0), shstrndx_(0), have_strings_(false),
       stringpool_(), shstrtab_(), cu_index_(), tu_index_(), last_type_sig_(0),
-      last_tu_slot_(0)
+      last_tu_slot_(0), keep_memory_(true), replaceable_cus_()
   {
     this->section_id_map_.resize(elfcpp::DW_SECT_MAX + 1);
     this->stringpool_.set_no_zero_null();
   }
 
+  // Don't keep the contributions to the output sections in memory
+  // until finalize.  Instead, write each contribution when it is
+  // added, to a temporary file for each section, and copy the
+  // temporary files to the output file in finalize.
+  void
+  set_no_keep_memory()
+  { this->keep_memory_ = false; }
+
   // Record the target info from an input file.
   void
   record_target_info(const char* name, int machine, int size, bool big_endian,
@@ -476,6 +591,12 @@ class Dwp_output_file
   void
   add_cu_set(Unit_set* cu_set);
 
+  // Add a set of .debug_info and related sections to the output file,
+  // which a later set for the same CU replaces, rather than being
+  // reported as a duplicate.
+  void
+  add_replaceable_cu_set(Unit_set* cu_set);
+
   // Lookup a type signature and return TRUE if we have already seen it.
   bool
   lookup_tu(uint64_t type_sig);
@@ -506,9 +627,12 @@ class Dwp_output_file
     section_size_type size;
     int align;
     std::vector<Contribution> contributions;
+    // With set_no_keep_memory, the contributions written so far.
+    FILE* temp_file;
 
     Section(const char* n, int a)
-      : name(n), offset(0), size(0), align(a), contributions()
+      : name(n), offset(0), size(0), align(a), contributions(),
+	temp_file(NULL)
     { }
   };
 
@@ -536,6 +660,10 @@ class Dwp_output_file
     void
     enter_set(unsigned int slot, const Unit_set* set);
 
+    // Replace the CU or TU set at the given SLOT in the hash table.
+    void
+    replace_set(unsigned int slot, const Unit_set* set);
+
     // Return the contents of the given SLOT in the hash table of signatures.
     uint64_t
     hash_table(unsigned int slot) const
@@ -632,6 +760,12 @@ class Dwp_output_file
 		   unsigned int link, unsigned int info,
 		   unsigned int align, unsigned int ent_size);
 
+  // Write a contribution to the temporary file for an output section.
+  void
+  write_temp_contribution(Section* sect, section_offset_type output_offset,
+			  const unsigned char* contents,
+			  section_size_type len);
+
   // Write the contributions to an output section.
   void
   write_contributions(const Section& sect);
@@ -677,6 +811,11 @@ class Dwp_output_file
   uint64_t last_type_sig_;
   // Cache of the slot index for the last type signature.
   unsigned int last_tu_slot_;
+  // Whether to keep the contributions in memory until finalize.
+  bool keep_memory_;
+  // The DWO IDs of the CUs added by add_replaceable_cu_set which have
+  // not been replaced.
+  Unordered_set<uint64_t> replaceable_cus_;
 };
 
 // A specialization of Dwarf_info_reader, for reading dwo_names from
@@ -711,23 +850,24 @@ class Dwo_name_info_reader : public Dwarf_info_reader
   File_list* files_;
 };
 
-// A specialization of Dwarf_info_reader, for reading DWARF CUs and TUs
-// and adding them to the output file.
+// A specialization of Dwarf_info_reader, for finding the DWARF CUs
+// and TUs to add to the output file.
 
 class Unit_reader : public Dwarf_info_reader
 {
  public:
   Unit_reader(bool is_type_unit, Relobj* object, unsigned int shndx)
     : Dwarf_info_reader(is_type_unit, object, NULL, 0, shndx, 0, 0),
-      output_file_(NULL), sections_(NULL)
+      units_(NULL)
   { }
 
   ~Unit_reader()
   { }
 
-  // Read the CUs or TUs and add them to the output file.
+  // Read the CUs or TUs and add their signatures, offsets and
+  // lengths to UNITS.
   void
-  add_units(Dwp_output_file*, unsigned int debug_abbrev, Section_bounds*);
+  read_units(unsigned int debug_abbrev, std::vector<Input_unit>* units);
 
  protected:
   // Visit a compilation unit.
@@ -740,8 +880,126 @@ class Unit_reader : public Dwarf_info_reader
 		  uint64_t signature, Dwarf_die*);
 
  private:
+  std::vector<Input_unit>* units_;
+};
+
+// The input files to add to the output file, and the tasks which add
+// them.  Each input file is read by a Dwo_task for the READ step,
+// which queues a task for the next step, and so on.  The READ and
+// REMAP_STRINGS steps for different input files may run in parallel.
+// The ADD_STRINGS and ADD_SECTIONS steps change the output file, so
+// they run for one input file at a time, in the order of the list,
+// using a blocker for each input file to wait for the previous one.
+// This makes the output the same however many threads we use.
+
+class Dwo_inputs
+{
+ public:
+  Dwo_inputs(const File_list& files, Dwp_output_file* output_file,
+	     unsigned int max_open_files, bool verbose);
+
+  ~Dwo_inputs();
+
+  // Treat the first input file as a package to update: see
+  // Dwo_file::set_reuse_offsets.
+  void
+  set_update()
+  { this->update_ = true; }
+
+  // Queue the tasks to read the first input files.
+  void
+  queue_initial_tasks(Workqueue*);
+
+  // The steps for input file I.  Each step queues the task for the
+  // next one.
+  void
+  read(Workqueue*, unsigned int i);
+
+  void
+  add_strings(Workqueue*, unsigned int i);
+
+  void
+  remap_strings(Workqueue*, unsigned int i);
+
+  void
+  add_sections(Workqueue*, unsigned int i);
+
+  // Return the name of input file I.
+  const char*
+  name(unsigned int i) const
+  { return this->files_[i].dwo_name.c_str(); }
+
+  // Return the blocker which the ADD_STRINGS step for input file I
+  // waits for, or NULL for the first file.
+  Task_token*
+  strings_blocker(unsigned int i) const
+  { return this->strings_blockers_[i]; }
+
+  // Return the blocker which the ADD_SECTIONS step for input file I
+  // waits for, or NULL for the first file.
+  Task_token*
+  sections_blocker(unsigned int i) const
+  { return this->sections_blockers_[i]; }
+
+ private:
+  Dwo_inputs(const Dwo_inputs&);
+  Dwo_inputs& operator=(const Dwo_inputs&);
+
+  // The list of input files.
+  const File_list& files_;
+  // The output file.
   Dwp_output_file* output_file_;
-  Section_bounds* sections_;
+  // The number of input files we read ahead of the one being added
+  // to the output file.  This limits the memory and file descriptors
+  // we use.
+  unsigned int max_open_files_;
+  // Whether to print the name of each input file.
+  bool verbose_;
+  // Whether the first input file is a package to update.
+  bool update_;
+  // The input files which have been read, indexed like FILES_.
+  std::vector<Dwo_file*> dwo_files_;
+  // The blockers for the ADD_STRINGS and ADD_SECTIONS steps, indexed
+  // like FILES_, with an extra entry at the end.
+  std::vector<Task_token*> strings_blockers_;
+  std::vector<Task_token*> sections_blockers_;
+};
+
+// A task to run one step of adding an input file to the output file.
+
+class Dwo_task : public Task
+{
+ public:
+  enum Step
+  {
+    READ,
+    ADD_STRINGS,
+    REMAP_STRINGS,
+    ADD_SECTIONS
+  };
+
+  Dwo_task(Dwo_inputs* inputs, unsigned int index, Step step)
+    : inputs_(inputs), index_(index), step_(step)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable();
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const;
+
+ private:
+  Dwo_inputs* inputs_;
+  unsigned int index_;
+  Step step_;
 };
 
 // Return the name of a DWARF .dwo section.
@@ -840,7 +1098,7 @@ Dwo_file::~Dwo_file()
 void
 Dwo_file::read_executable(File_list* files)
 {
-  this->obj_ = this->make_object(NULL);
+  this->obj_ = this->make_object();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
@@ -880,25 +1138,21 @@ Dwo_file::read_executable(File_list* files)
     }
 }
 
-// Read the input file and send its contents to OUTPUT_FILE.
+// Open the input file, find the debug sections, and read the
+// sections and units to be added to the output file.  This does not
+// touch the output file, so it may run in parallel for several input
+// files.
 
 void
-Dwo_file::read(Dwp_output_file* output_file)
+Dwo_file::read_input()
 {
-  this->obj_ = this->make_object(output_file);
+  this->obj_ = this->make_object();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
   this->sect_offsets_.resize(shnum);
 
-  typedef std::vector<unsigned int> Types_list;
-  Types_list debug_types;
-  unsigned int debug_shndx[elfcpp::DW_SECT_MAX + 1];
-  for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
-    debug_shndx[i] = 0;
-  unsigned int debug_str = 0;
-  unsigned int debug_cu_index = 0;
-  unsigned int debug_tu_index = 0;
+  unsigned int* debug_shndx = this->debug_shndx_;
 
   // Scan the section table and collect debug sections.
   // (Section index 0 is a dummy section; skip it.)
@@ -920,7 +1174,7 @@ Dwo_file::read(Dwp_output_file* output_file)
       if (strcmp(suffix, "info.dwo") == 0)
 	debug_shndx[elfcpp::DW_SECT_INFO] = i;
       else if (strcmp(suffix, "types.dwo") == 0)
-	debug_types.push_back(i);
+	this->debug_types_.push_back(i);
       else if (strcmp(suffix, "abbrev.dwo") == 0)
 	debug_shndx[elfcpp::DW_SECT_ABBREV] = i;
       else if (strcmp(suffix, "line.dwo") == 0)
@@ -928,7 +1182,7 @@ Dwo_file::read(Dwp_output_file* output_file)
       else if (strcmp(suffix, "loc.dwo") == 0)
 	debug_shndx[elfcpp::DW_SECT_LOC] = i;
       else if (strcmp(suffix, "str.dwo") == 0)
-	debug_str = i;
+	this->debug_str_ = i;
       else if (strcmp(suffix, "str_offsets.dwo") == 0)
 	debug_shndx[elfcpp::DW_SECT_STR_OFFSETS] = i;
       else if (strcmp(suffix, "macinfo.dwo") == 0)
@@ -936,46 +1190,209 @@ Dwo_file::read(Dwp_output_file* output_file)
       else if (strcmp(suffix, "macro.dwo") == 0)
 	debug_shndx[elfcpp::DW_SECT_MACRO] = i;
       else if (strcmp(suffix, "cu_index") == 0)
-	debug_cu_index = i;
+	this->debug_cu_index_ = i;
       else if (strcmp(suffix, "tu_index") == 0)
-	debug_tu_index = i;
+	this->debug_tu_index_ = i;
+    }
+
+  // Read the string table section.
+  this->str_contents_ = this->section_contents(this->debug_str_,
+					       &this->str_len_,
+					       &this->str_is_new_);
+  const char* p = reinterpret_cast<const char*>(this->str_contents_);
+  const char* pend = p + this->str_len_;
+
+  // Check that the last string is null terminated.
+  if (pend[-1] != '\0')
+    gold_fatal(_("%s: last entry in string section '%s' "
+		 "is not null terminated"),
+	       this->name_,
+	       this->section_name(this->debug_str_).c_str());
+
+  // Count the number of strings in the section, and size the map.
+  size_t count = 0;
+  for (const char* pt = p; pt < pend; pt += strlen(pt) + 1)
+    ++count;
+  this->str_offset_map_.reserve(count + 1);
+
+  // The sections of a .dwp file are copied by add_sections, following
+  // the index sections.
+  if (this->is_dwp())
+    return;
+
+  // If we found no index sections, this is a .dwo file.
+  if (debug_shndx[elfcpp::DW_SECT_INFO] > 0)
+    this->read_units(debug_shndx[elfcpp::DW_SECT_INFO], false);
+  for (std::vector<unsigned int>::const_iterator tp =
+	 this->debug_types_.begin();
+       tp != this->debug_types_.end();
+       ++tp)
+    this->read_units(*tp, true);
+
+  if (this->unit_sections_.empty())
+    return;
+
+  // Read the related sections.  We will need to duplicate the contents
+  // of a mapped input file, so that they persist after we close the
+  // input file.  The string offsets are copied by remap_strings.
+  for (int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
+    {
+      if (debug_shndx[i] == 0)
+	continue;
+      bool is_new;
+      const unsigned char* contents =
+	  this->section_contents(debug_shndx[i], &this->sect_len_[i], &is_new);
+      if (i == elfcpp::DW_SECT_STR_OFFSETS)
+	this->str_offsets_is_new_ = is_new;
+      else if (!is_new)
+	{
+	  unsigned char* copy = new unsigned char[this->sect_len_[i]];
+	  memcpy(copy, contents, this->sect_len_[i]);
+	  contents = copy;
+	}
+      this->sect_contents_[i] = contents;
     }
+}
+
+// Read the contents of the .debug_info.dwo or .debug_types.dwo section
+// SHNDX, and find the units in it.
+
+void
+Dwo_file::read_units(unsigned int shndx, bool is_debug_types)
+{
+  if (this->debug_shndx_[elfcpp::DW_SECT_ABBREV] == 0)
+    gold_fatal(_("%s: no .debug_abbrev.dwo section found"), this->name_);
+
+  section_size_type len;
+  bool is_new;
+  const unsigned char* contents = this->section_contents(shndx, &len, &is_new);
+  this->unit_sections_.push_back(Unit_section(is_debug_types, contents,
+					      is_new));
+
+  Unit_reader reader(is_debug_types, this->obj_, shndx);
+  reader.read_units(this->debug_shndx_[elfcpp::DW_SECT_ABBREV],
+		    &this->unit_sections_.back().units);
+}
 
-  // Merge the input string table into the output string table.
-  this->add_strings(output_file, debug_str);
+// Remap the string offsets in the .debug_str_offsets.dwo section read
+// by read_input.  This may run in parallel for several input files.
+
+void
+Dwo_file::remap_strings()
+{
+  const unsigned char* contents =
+      this->sect_contents_[elfcpp::DW_SECT_STR_OFFSETS];
+  if (contents == NULL)
+    return;
+  const unsigned char* remapped =
+      this->remap_str_offsets(contents,
+			      this->sect_len_[elfcpp::DW_SECT_STR_OFFSETS]);
+  if (this->str_offsets_is_new_)
+    delete[] contents;
+  this->sect_contents_[elfcpp::DW_SECT_STR_OFFSETS] = remapped;
+  this->str_offsets_is_new_ = true;
+}
+
+// Add the sections and units read by read_input to OUTPUT_FILE.
+
+void
+Dwo_file::add_sections(Dwp_output_file* output_file)
+{
+  output_file->record_target_info(this->name_, this->machine_, this->size_,
+				  this->big_endian_, this->osabi_,
+				  this->abiversion_);
+
+  unsigned int* debug_shndx = this->debug_shndx_;
 
   // If we found any .dwp index sections, read those and add the section
   // sets to the output file.
-  if (debug_cu_index > 0 || debug_tu_index > 0)
+  if (this->is_dwp())
     {
-      if (debug_cu_index > 0)
-	this->read_unit_index(debug_cu_index, debug_shndx, output_file, false);
-      if (debug_tu_index > 0)
+      if (this->debug_cu_index_ > 0)
+	this->read_unit_index(this->debug_cu_index_, debug_shndx, output_file,
+			      false);
+      if (this->debug_tu_index_ > 0)
         {
-	  if (debug_types.size() > 1)
+	  if (this->debug_types_.size() > 1)
 	    gold_fatal(_("%s: .dwp file must have no more than one "
 			 ".debug_types.dwo section"), this->name_);
-          if (debug_types.size() == 1)
-            debug_shndx[elfcpp::DW_SECT_TYPES] = debug_types[0];
+          if (this->debug_types_.size() == 1)
+            debug_shndx[elfcpp::DW_SECT_TYPES] = this->debug_types_[0];
           else
             debug_shndx[elfcpp::DW_SECT_TYPES] = 0;
-	  this->read_unit_index(debug_tu_index, debug_shndx, output_file, true);
+	  this->read_unit_index(this->debug_tu_index_, debug_shndx,
+				output_file, true);
 	}
       return;
     }
 
-  // If we found no index sections, this is a .dwo file.
-  if (debug_shndx[elfcpp::DW_SECT_INFO] > 0)
-    this->add_unit_set(output_file, debug_shndx, false);
+  if (this->unit_sections_.empty())
+    return;
 
-  debug_shndx[elfcpp::DW_SECT_INFO] = 0;
-  for (Types_list::const_iterator tp = debug_types.begin();
-       tp != debug_types.end();
-       ++tp)
+  // Add the related sections and track the section offsets and sizes.
+  // The output file takes ownership of the memory.
+  Section_bounds sections[elfcpp::DW_SECT_MAX + 1];
+  for (int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
+    {
+      if (this->sect_contents_[i] == NULL)
+	continue;
+      section_size_type len = this->sect_len_[i];
+      section_offset_type off =
+	  output_file->add_contribution(static_cast<elfcpp::DW_SECT>(i),
+					this->sect_contents_[i], len, 1);
+      sections[i] = Section_bounds(off, len);
+      this->sect_contents_[i] = NULL;
+    }
+
+  // Add each compilation or type unit to the output file, along with
+  // the contributions to the related sections.
+  for (std::vector<Unit_section>::iterator p = this->unit_sections_.begin();
+       p != this->unit_sections_.end();
+       ++p)
     {
-      debug_shndx[elfcpp::DW_SECT_TYPES] = *tp;
-      this->add_unit_set(output_file, debug_shndx, true);
+      elfcpp::DW_SECT info_sect = (p->is_type_unit
+				   ? elfcpp::DW_SECT_TYPES
+				   : elfcpp::DW_SECT_INFO);
+      for (std::vector<Input_unit>::const_iterator u = p->units.begin();
+	   u != p->units.end();
+	   ++u)
+	{
+	  if (p->is_type_unit && output_file->lookup_tu(u->signature))
+	    continue;
+
+	  Unit_set* unit_set = new Unit_set();
+	  unit_set->signature = u->signature;
+	  for (unsigned int i = elfcpp::DW_SECT_ABBREV;
+	       i <= elfcpp::DW_SECT_MAX;
+	       ++i)
+	    unit_set->sections[i] = sections[i];
+
+	  // Dwp_output_file::add_contribution writes the .debug_info.dwo
+	  // section directly to the output file, so we only need to
+	  // duplicate contributions for .debug_types.dwo section.
+	  const unsigned char* unit_start = p->contents + u->bounds.offset;
+	  section_size_type unit_length = u->bounds.size;
+	  if (p->is_type_unit)
+	    {
+	      unsigned char* copy = new unsigned char[unit_length];
+	      memcpy(copy, unit_start, unit_length);
+	      unit_start = copy;
+	    }
+	  section_offset_type off =
+	      output_file->add_contribution(info_sect, unit_start,
+					    unit_length, 1);
+	  unit_set->sections[info_sect] = Section_bounds(off, unit_length);
+	  if (p->is_type_unit)
+	    output_file->add_tu_set(unit_set);
+	  else
+	    output_file->add_cu_set(unit_set);
+	}
+
+      if (p->is_new)
+	delete[] p->contents;
+      p->contents = NULL;
     }
+  this->unit_sections_.clear();
 }
 
 // Verify a .dwp file given a list of .dwo files referenced by the
@@ -985,7 +1402,7 @@ Dwo_file::read(Dwp_output_file* output_file)
 bool
 Dwo_file::verify(const File_list& files)
 {
-  this->obj_ = this->make_object(NULL);
+  this->obj_ = this->make_object();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
@@ -1021,10 +1438,10 @@ Dwo_file::verify(const File_list& files)
 }
 
 // Create a Sized_relobj_dwo of the given size and endianness,
-// and record the target info.
+// and save the target info.
 
 Relobj*
-Dwo_file::make_object(Dwp_output_file* output_file)
+Dwo_file::make_object()
 {
   // Open the input file.
   Input_file* input_file = new Input_file(this->name_);
@@ -1045,8 +1462,7 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     gold_fatal(_("%s: not an ELF object file"), this->name_);
   
   // Get the size, endianness, machine, etc. info from the header,
-  // make an appropriately-sized Relobj, and pass the target info
-  // to the output object.
+  // and make an appropriately-sized Relobj.
   int size;
   bool big_endian;
   std::string error;
@@ -1058,15 +1474,13 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     {
       if (big_endian)
 #ifdef HAVE_TARGET_32_BIG
-	return this->sized_make_object<32, true>(elf_header, input_file,
-						 output_file);
+	return this->sized_make_object<32, true>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
       else
 #ifdef HAVE_TARGET_32_LITTLE
-	return this->sized_make_object<32, false>(elf_header, input_file,
-						  output_file);
+	return this->sized_make_object<32, false>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
@@ -1075,15 +1489,13 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     {
       if (big_endian)
 #ifdef HAVE_TARGET_64_BIG
-	return this->sized_make_object<64, true>(elf_header, input_file,
-						 output_file);
+	return this->sized_make_object<64, true>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
       else
 #ifdef HAVE_TARGET_64_LITTLE
-	return this->sized_make_object<64, false>(elf_header, input_file,
-						  output_file);
+	return this->sized_make_object<64, false>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
@@ -1092,23 +1504,22 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     gold_unreachable();
 }
 
-// Function template to create a Sized_relobj_dwo and record the target info.
-// P is a pointer to the ELF header in memory.
+// Function template to create a Sized_relobj_dwo and save the target info
+// for add_sections.  P is a pointer to the ELF header in memory.
 
 template <int size, bool big_endian>
 Relobj*
-Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file,
-			    Dwp_output_file* output_file)
+Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file)
 {
   elfcpp::Ehdr<size, big_endian> ehdr(p);
   Sized_relobj_dwo<size, big_endian>* obj =
       new Sized_relobj_dwo<size, big_endian>(this->name_, input_file, ehdr);
   obj->setup();
-  if (output_file != NULL)
-    output_file->record_target_info(
-	this->name_, ehdr.get_e_machine(), size, big_endian,
-	ehdr.get_e_ident()[elfcpp::EI_OSABI],
-	ehdr.get_e_ident()[elfcpp::EI_ABIVERSION]);
+  this->machine_ = ehdr.get_e_machine();
+  this->size_ = size;
+  this->big_endian_ = big_endian;
+  this->osabi_ = ehdr.get_e_ident()[elfcpp::EI_OSABI];
+  this->abiversion_ = ehdr.get_e_ident()[elfcpp::EI_ABIVERSION];
   return obj;
 }
 
@@ -1197,6 +1608,24 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
   const unsigned char* info_contents =
       this->section_contents(info_shndx, &info_len, &info_is_new);
 
+  // If we are reusing the offsets, add the whole section, as we did
+  // the related sections.  As below, we only need to duplicate the
+  // .debug_types.dwo section.  Otherwise, we add each unit in turn,
+  // and the offset of the section is 0.
+  if (this->reuse_offsets_)
+    {
+      const unsigned char* section_start = info_contents;
+      if (is_tu_index)
+	{
+	  unsigned char* copy = new unsigned char[info_len];
+	  memcpy(copy, info_contents, info_len);
+	  section_start = copy;
+	}
+      section_offset_type off =
+	  output_file->add_contribution(info_sect, section_start, info_len, 1);
+      sections[info_sect] = Section_bounds(off, info_len);
+    }
+
   // Loop over the slots of the hash table.
   for (unsigned int i = 0; i < nslots; ++i)
     {
@@ -1232,25 +1661,32 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
 	      psrow += sizeof(uint32_t);
 	    }
 
-	  const unsigned char* unit_start =
-	      info_contents + unit_set->sections[info_sect].offset;
-	  section_size_type unit_length = unit_set->sections[info_sect].size;
-
-	  // Dwp_output_file::add_contribution writes the .debug_info.dwo
-	  // section directly to the output file, so we only need to
-	  // duplicate contributions for .debug_types.dwo section.
-	  if (is_tu_index)
+	  if (!this->reuse_offsets_)
 	    {
-	      unsigned char *copy = new unsigned char[unit_length];
-	      memcpy(copy, unit_start, unit_length);
-	      unit_start = copy;
+	      const unsigned char* unit_start =
+		  info_contents + unit_set->sections[info_sect].offset;
+	      section_size_type unit_length =
+		  unit_set->sections[info_sect].size;
+
+	      // Dwp_output_file::add_contribution writes the
+	      // .debug_info.dwo section directly to the output file, so
+	      // we only need to duplicate contributions for
+	      // .debug_types.dwo section.
+	      if (is_tu_index)
+		{
+		  unsigned char *copy = new unsigned char[unit_length];
+		  memcpy(copy, unit_start, unit_length);
+		  unit_start = copy;
+		}
+	      section_offset_type off =
+		  output_file->add_contribution(info_sect, unit_start,
+						unit_length, 1);
+	      unit_set->sections[info_sect].offset = off;
 	    }
-	  section_offset_type off =
-	      output_file->add_contribution(info_sect, unit_start,
-					    unit_length, 1);
-	  unit_set->sections[info_sect].offset = off;
 	  if (is_tu_index)
 	    output_file->add_tu_set(unit_set);
+	  else if (this->reuse_offsets_)
+	    output_file->add_replaceable_cu_set(unit_set);
 	  else
 	    output_file->add_cu_set(unit_set);
 	}
@@ -1360,52 +1796,44 @@ Dwo_file::sized_verify_dwo_list(unsigned int shndx, const File_list& files)
   return nmissing == 0;
 }
 
-// Merge the input string table section into the output file.
+// Merge the input string table section read by read_input into the
+// output file.
 
 void
-Dwo_file::add_strings(Dwp_output_file* output_file, unsigned int debug_str)
+Dwo_file::add_strings(Dwp_output_file* output_file)
 {
-  section_size_type len;
-  bool is_new;
-  const unsigned char* pdata = this->section_contents(debug_str, &len, &is_new);
+  const unsigned char* pdata = this->str_contents_;
   const char* p = reinterpret_cast<const char*>(pdata);
-  const char* pend = p + len;
-
-  // Check that the last string is null terminated.
-  if (pend[-1] != '\0')
-    gold_fatal(_("%s: last entry in string section '%s' "
-		 "is not null terminated"),
-	       this->name_,
-	       this->section_name(debug_str).c_str());
-
-  // Count the number of strings in the section, and size the map.
-  size_t count = 0;
-  for (const char* pt = p; pt < pend; pt += strlen(pt) + 1)
-    ++count;
-  this->str_offset_map_.reserve(count + 1);
+  const char* pend = p + this->str_len_;
 
   // Add the strings to the output string table, and record the new offsets
   // in the map.
   section_offset_type i = 0;
   section_offset_type new_offset;
+  bool unchanged = true;
   while (p < pend)
     {
       size_t len = strlen(p);
       new_offset = output_file->add_string(p, len);
       this->str_offset_map_.push_back(std::make_pair(i, new_offset));
+      if (new_offset != i)
+	unchanged = false;
       p += len + 1;
       i += len + 1;
     }
+  this->str_offsets_unchanged_ = unchanged;
   new_offset = 0;
   this->str_offset_map_.push_back(std::make_pair(i, new_offset));
-  if (is_new)
+  if (this->str_is_new_)
     delete[] pdata;
+  this->str_contents_ = NULL;
 }
 
 // Copy a section from the input file to the output file.
 // Return the offset and length of this input section's contribution
 // in the output section.  If copying .debug_str_offsets.dwo, remap
-// the string offsets for the output string table.
+// the string offsets for the output string table, unless they are
+// unchanged, as when this is the first input file.
 
 Section_bounds
 Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
@@ -1424,7 +1852,8 @@ Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
   bool is_new;
   const unsigned char* contents = this->section_contents(shndx, &len, &is_new);
 
-  if (section_id == elfcpp::DW_SECT_STR_OFFSETS)
+  if (section_id == elfcpp::DW_SECT_STR_OFFSETS
+      && !this->str_offsets_unchanged_)
     {
       const unsigned char* remapped = this->remap_str_offsets(contents, len);
       if (is_new)
@@ -1507,38 +1936,6 @@ Dwo_file::remap_str_offset(section_offset_type val)
   return p->second + (val - p->first);
 }
 
-// Add a set of .debug_info.dwo or .debug_types.dwo and related sections
-// to OUTPUT_FILE.
-
-void
-Dwo_file::add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
-		       bool is_debug_types)
-{
-  unsigned int shndx = (is_debug_types
-			? debug_shndx[elfcpp::DW_SECT_TYPES]
-			: debug_shndx[elfcpp::DW_SECT_INFO]);
-
-  gold_assert(shndx != 0);
-
-  if (debug_shndx[elfcpp::DW_SECT_ABBREV] == 0)
-    gold_fatal(_("%s: no .debug_abbrev.dwo section found"), this->name_);
-
-  // Copy the related sections and track the section offsets and sizes.
-  Section_bounds sections[elfcpp::DW_SECT_MAX + 1];
-  for (int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
-    {
-      if (debug_shndx[i] > 0)
-	sections[i] = this->copy_section(output_file, debug_shndx[i],
-					 static_cast<elfcpp::DW_SECT>(i));
-    }
-
-  // Parse the .debug_info or .debug_types section and add each compilation
-  // or type unit to the output file, along with the contributions to the
-  // related sections.
-  Unit_reader reader(is_debug_types, this->obj_, shndx);
-  reader.add_units(output_file, debug_shndx[elfcpp::DW_SECT_ABBREV], sections);
-}
-
 // Class Dwp_output_file.
 
 // Record the target info from an input file.  On first call, we
@@ -1616,7 +2013,8 @@ Dwp_output_file::add_output_section(const char* section_name, int align)
 // is expected to be the largest one, so we will write the contents of this
 // section directly to the output file as we receive contributions, allowing
 // us to free that memory as soon as possible. We will save the remaining
-// contributions until we finalize the layout of the output file.
+// contributions until we finalize the layout of the output file, either in
+// memory or, with set_no_keep_memory, in a temporary file for each section.
 
 section_offset_type
 Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
@@ -1681,8 +2079,17 @@ Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
 	section.align = align;
       section_offset = align_offset(section.size, align);
       section.size = section_offset + len;
-      Contribution contrib = { section_offset, len, contents };
-      section.contributions.push_back(contrib);
+      if (this->keep_memory_)
+	{
+	  Contribution contrib = { section_offset, len, contents };
+	  section.contributions.push_back(contrib);
+	}
+      else
+	{
+	  this->write_temp_contribution(&section, section_offset, contents,
+					len);
+	  delete[] contents;
+	}
     }
 
   return section_offset;
@@ -1697,6 +2104,28 @@ Dwp_output_file::add_cu_set(Unit_set* cu_set)
   unsigned int slot;
   if (!this->cu_index_.find_or_add(dwo_id, &slot))
     this->cu_index_.enter_set(slot, cu_set);
+  else if (this->replaceable_cus_.erase(dwo_id) > 0)
+    this->cu_index_.replace_set(slot, cu_set);
+  else
+    gold_warning(_("%s: duplicate entry for CU (dwo_id 0x%llx)"),
+		 this->name_, (unsigned long long)dwo_id);
+}
+
+// Add a set of .debug_info and related sections from the package we
+// are updating.  If a later input file has the same CU, we use that
+// one instead.  The contributions of this set stay in the output
+// file, but nothing refers to them.
+
+void
+Dwp_output_file::add_replaceable_cu_set(Unit_set* cu_set)
+{
+  uint64_t dwo_id = cu_set->signature;
+  unsigned int slot;
+  if (!this->cu_index_.find_or_add(dwo_id, &slot))
+    {
+      this->cu_index_.enter_set(slot, cu_set);
+      this->replaceable_cus_.insert(dwo_id);
+    }
   else
     gold_warning(_("%s: duplicate entry for CU (dwo_id 0x%llx)"),
 		 this->name_, (unsigned long long)dwo_id);
@@ -1781,6 +2210,24 @@ Dwp_output_file::Dwp_index::enter_set(unsigned int slot,
     this->grow();
 }
 
+// Replace the CU or TU set at the given SLOT in the hash table.  The
+// new set takes the row of the old one.
+
+void
+Dwp_output_file::Dwp_index::replace_set(unsigned int slot,
+					const Unit_set* set)
+{
+  gold_assert(slot < this->capacity_);
+  uint32_t row_index = this->index_table_[slot];
+  gold_assert(row_index != 0 && this->hash_table_[slot] == set->signature);
+  this->section_table_[row_index - 1] = set;
+
+  // Mark the sections used in this set.
+  for (unsigned int i = 1; i <= elfcpp::DW_SECT_MAX; i++)
+    if (set->sections[i].size > 0)
+      this->section_mask_ |= 1 << i;
+}
+
 // Initialize the hash table.
 
 void
@@ -1927,6 +2374,35 @@ Dwp_output_file::finalize()
   this->fd_ = NULL;
 }
 
+// Write a contribution to the temporary file for an output section,
+// creating the file if necessary.  We remove the file as soon as it
+// is open, so that it goes away when we close it.
+
+void
+Dwp_output_file::write_temp_contribution(Section* sect,
+					 section_offset_type output_offset,
+					 const unsigned char* contents,
+					 section_size_type len)
+{
+  if (sect->temp_file == NULL)
+    {
+      char* temp_name = make_temp_file(NULL);
+      sect->temp_file = ::fopen(temp_name, "w+b");
+      if (sect->temp_file == NULL)
+	gold_fatal(_("%s: %s"), temp_name, strerror(errno));
+      ::unlink(temp_name);
+      free(temp_name);
+    }
+
+  // The temporary file holds the section from offset 0, so it matches
+  // the layout of the section in the output file.  Seeking past the
+  // end leaves zeroes for any alignment padding.
+  ::fseek(sect->temp_file, output_offset, SEEK_SET);
+  if (::fwrite(contents, 1, len, sect->temp_file) < len)
+    gold_fatal(_("%s: error writing temporary file for section '%s'"),
+	       this->name_, sect->name);
+}
+
 // Write the contributions to an output section.
 
 void
@@ -1940,6 +2416,28 @@ Dwp_output_file::write_contributions(const Section& sect)
 	gold_fatal(_("%s: error writing section '%s'"), this->name_, sect.name);
       delete[] c.contents;
     }
+
+  if (sect.temp_file == NULL)
+    return;
+
+  // Copy the temporary file to the output file.
+  ::fflush(sect.temp_file);
+  ::fseek(sect.temp_file, 0, SEEK_SET);
+  ::fseek(this->fd_, sect.offset, SEEK_SET);
+  unsigned char buf[65536];
+  section_size_type remaining = sect.size;
+  while (remaining > 0)
+    {
+      section_size_type n = std::min(remaining,
+				     static_cast<section_size_type>(sizeof buf));
+      if (::fread(buf, 1, n, sect.temp_file) < n)
+	gold_fatal(_("%s: error reading temporary file for section '%s'"),
+		   this->name_, sect.name);
+      if (::fwrite(buf, 1, n, this->fd_) < n)
+	gold_fatal(_("%s: error writing section '%s'"), this->name_, sect.name);
+      remaining -= n;
+    }
+  ::fclose(sect.temp_file);
 }
 
 // Write a new section to the output file.
@@ -2220,15 +2718,14 @@ Dwo_name_info_reader::visit_compilation_unit(off_t, off_t, Dwarf_die* die)
 
 // Class Unit_reader.
 
-// Read the CUs or TUs and add them to the output file.
+// Read the CUs or TUs and add their signatures, offsets and lengths
+// to UNITS.
 
 void
-Unit_reader::add_units(Dwp_output_file* output_file,
-		       unsigned int debug_abbrev,
-		       Section_bounds* sections)
+Unit_reader::read_units(unsigned int debug_abbrev,
+			std::vector<Input_unit>* units)
 {
-  this->output_file_ = output_file;
-  this->sections_ = sections;
+  this->units_ = units;
   this->set_abbrev_shndx(debug_abbrev);
   this->parse();
 }
@@ -2236,52 +2733,187 @@ Unit_reader::add_units(Dwp_output_file* output_file,
 // Visit a compilation unit.
 
 void
-Unit_reader::visit_compilation_unit(off_t, off_t cu_length, Dwarf_die* die)
+Unit_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
+				    Dwarf_die* die)
 {
   if (cu_length == 0)
     return;
 
-  Unit_set* unit_set = new Unit_set();
-  unit_set->signature = die->uint_attribute(elfcpp::DW_AT_GNU_dwo_id);
-  for (unsigned int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
-    unit_set->sections[i] = this->sections_[i];
-
-  // Dwp_output_file::add_contribution writes the .debug_info.dwo section
-  // directly to the output file, so we do not need to duplicate the
-  // section contents, and add_contribution does not need to free the memory.
-  section_offset_type off =
-      this->output_file_->add_contribution(elfcpp::DW_SECT_INFO,
-					   this->buffer_at_offset(0),
-					   cu_length, 1);
-  Section_bounds bounds(off, cu_length);
-  unit_set->sections[elfcpp::DW_SECT_INFO] = bounds;
-  this->output_file_->add_cu_set(unit_set);
+  uint64_t dwo_id = die->uint_attribute(elfcpp::DW_AT_GNU_dwo_id);
+  this->units_->push_back(Input_unit(dwo_id, cu_offset, cu_length));
 }
 
 // Visit a type unit.
 
 void
-Unit_reader::visit_type_unit(off_t, off_t tu_length, off_t,
+Unit_reader::visit_type_unit(off_t tu_offset, off_t tu_length, off_t,
 			     uint64_t signature, Dwarf_die*)
 {
   if (tu_length == 0)
     return;
-  if (this->output_file_->lookup_tu(signature))
-    return;
 
-  Unit_set* unit_set = new Unit_set();
-  unit_set->signature = signature;
-  for (unsigned int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
-    unit_set->sections[i] = this->sections_[i];
-
-  unsigned char* contents = new unsigned char[tu_length];
-  memcpy(contents, this->buffer_at_offset(0), tu_length);
-  section_offset_type off =
-      this->output_file_->add_contribution(elfcpp::DW_SECT_TYPES, contents,
-					   tu_length, 1);
-  Section_bounds bounds(off, tu_length);
-  unit_set->sections[elfcpp::DW_SECT_TYPES] = bounds;
-  this->output_file_->add_tu_set(unit_set);
+  this->units_->push_back(Input_unit(signature, tu_offset, tu_length));
+}
+
+// Class Dwo_inputs.
+
+Dwo_inputs::Dwo_inputs(const File_list& files, Dwp_output_file* output_file,
+		       unsigned int max_open_files, bool verbose)
+  : files_(files), output_file_(output_file),
+    max_open_files_(max_open_files), verbose_(verbose), update_(false),
+    dwo_files_(files.size()), strings_blockers_(files.size() + 1),
+    sections_blockers_(files.size() + 1)
+{
+  gold_assert(max_open_files > 0);
+  // The first file does not wait for anything.  The blocker for each
+  // later file is released when the step is done for the file before.
+  for (unsigned int i = 1; i <= files.size(); ++i)
+    {
+      this->strings_blockers_[i] = new Task_token(true);
+      this->strings_blockers_[i]->add_blocker();
+      this->sections_blockers_[i] = new Task_token(true);
+      this->sections_blockers_[i]->add_blocker();
+    }
+}
+
+Dwo_inputs::~Dwo_inputs()
+{
+  for (unsigned int i = 0; i < this->dwo_files_.size(); ++i)
+    delete this->dwo_files_[i];
+  for (unsigned int i = 1; i < this->strings_blockers_.size(); ++i)
+    {
+      delete this->strings_blockers_[i];
+      delete this->sections_blockers_[i];
+    }
+}
+
+// Queue the tasks to read the first input files.  The ADD_SECTIONS
+// step for each file queues the task to read a later one.
+
+void
+Dwo_inputs::queue_initial_tasks(Workqueue* workqueue)
+{
+  for (unsigned int i = 0;
+       i < this->files_.size() && i < this->max_open_files_;
+       ++i)
+    workqueue->queue(new Dwo_task(this, i, Dwo_task::READ));
+}
+
+// Read input file I.
+
+void
+Dwo_inputs::read(Workqueue* workqueue, unsigned int i)
+{
+  Dwo_file* dwo_file = new Dwo_file(this->name(i));
+  if (i == 0 && this->update_)
+    dwo_file->set_reuse_offsets();
+  dwo_file->read_input();
+  this->dwo_files_[i] = dwo_file;
+  workqueue->queue(new Dwo_task(this, i, Dwo_task::ADD_STRINGS));
+}
+
+// Add the strings of input file I to the output file.
+
+void
+Dwo_inputs::add_strings(Workqueue* workqueue, unsigned int i)
+{
+  this->dwo_files_[i]->add_strings(this->output_file_);
+  workqueue->queue(new Dwo_task(this, i, Dwo_task::REMAP_STRINGS));
+}
+
+// Remap the string offsets of input file I.
+
+void
+Dwo_inputs::remap_strings(Workqueue* workqueue, unsigned int i)
+{
+  this->dwo_files_[i]->remap_strings();
+  workqueue->queue(new Dwo_task(this, i, Dwo_task::ADD_SECTIONS));
+}
+
+// Add the sections of input file I to the output file, and close it.
+
+void
+Dwo_inputs::add_sections(Workqueue* workqueue, unsigned int i)
+{
+  if (this->verbose_)
+    fprintf(stderr, "%s\n", this->name(i));
+  this->dwo_files_[i]->add_sections(this->output_file_);
+  delete this->dwo_files_[i];
+  this->dwo_files_[i] = NULL;
+
+  unsigned int next = i + this->max_open_files_;
+  if (next < this->files_.size())
+    workqueue->queue(new Dwo_task(this, next, Dwo_task::READ));
+}
+
+// Class Dwo_task.
+
+// The ADD_STRINGS and ADD_SECTIONS steps wait for the same step for
+// the previous input file.
+
+Task_token*
+Dwo_task::is_runnable()
+{
+  Task_token* blocker = NULL;
+  if (this->step_ == ADD_STRINGS)
+    blocker = this->inputs_->strings_blocker(this->index_);
+  else if (this->step_ == ADD_SECTIONS)
+    blocker = this->inputs_->sections_blocker(this->index_);
+  if (blocker != NULL && blocker->is_blocked())
+    return blocker;
+  return NULL;
+}
+
+// The ADD_STRINGS and ADD_SECTIONS steps hold the blocker for the
+// next input file until they are done.
+
+void
+Dwo_task::locks(Task_locker* tl)
+{
+  if (this->step_ == ADD_STRINGS)
+    tl->add(this, this->inputs_->strings_blocker(this->index_ + 1));
+  else if (this->step_ == ADD_SECTIONS)
+    tl->add(this, this->inputs_->sections_blocker(this->index_ + 1));
+}
+
+// Run the step.
+
+void
+Dwo_task::run(Workqueue* workqueue)
+{
+  switch (this->step_)
+    {
+    case READ:
+      this->inputs_->read(workqueue, this->index_);
+      break;
+    case ADD_STRINGS:
+      this->inputs_->add_strings(workqueue, this->index_);
+      break;
+    case REMAP_STRINGS:
+      this->inputs_->remap_strings(workqueue, this->index_);
+      break;
+    case ADD_SECTIONS:
+      this->inputs_->add_sections(workqueue, this->index_);
+      break;
+    default:
+      gold_unreachable();
+    }
+}
+
+// Return the name of the task, for debugging.
+
+std::string
+Dwo_task::get_name() const
+{
+  static const char* step_names[] =
+  {
+    "READ", "ADD_STRINGS", "REMAP_STRINGS", "ADD_SECTIONS"
+  };
+  std::string ret("Dwo_task ");
+  ret += step_names[this->step_];
+  ret += " ";
+  ret += this->inputs_->name(this->index_);
+  return ret;
 }
 
 }; // End namespace gold
@@ -2292,19 +2924,39 @@ using namespace gold;
 
 enum Dwp_options {
   VERIFY_ONLY = 0x101,
+  THREADS,
+  NO_THREADS,
+  THREAD_COUNT,
+  NO_KEEP_MEMORY,
+  UPDATE,
 };
 
 struct option dwp_options[] =
   {
     { "exec", required_argument, NULL, 'e' },
     { "help", no_argument, NULL, 'h' },
+    { "no-keep-memory", no_argument, NULL, NO_KEEP_MEMORY },
+    { "no-threads", no_argument, NULL, NO_THREADS },
     { "output", required_argument, NULL, 'o' },
+    { "thread-count", required_argument, NULL, THREAD_COUNT },
+    { "threads", no_argument, NULL, THREADS },
+    { "update", required_argument, NULL, UPDATE },
     { "verbose", no_argument, NULL, 'v' },
     { "verify-only", no_argument, NULL, VERIFY_ONLY },
     { "version", no_argument, NULL, 'V' },
     { NULL, 0, NULL, 0 }
   };
 
+// The number of input files to read ahead of the one being added to
+// the output file, per thread, when running with threads.
+
+static const unsigned int dwp_files_per_thread = 4;
+
+// The number of input files to read ahead when running with threads,
+// if we don't know the number of threads.
+
+static const unsigned int dwp_max_open_files = 64;
+
 // Print usage message and exit.
 
 static void
@@ -2315,6 +2967,15 @@ usage(FILE* fd, int exit_status)
   fprintf(fd, _("  -e EXE, --exec EXE       Get list of dwo files from EXE"
 					   " (defaults output to EXE.dwp)\n"));
   fprintf(fd, _("  -o FILE, --output FILE   Set output dwp file name\n"));
+  fprintf(fd, _("  --no-keep-memory         Use less memory and more disk I/O"
+					   "\n"));
+  fprintf(fd, _("  --threads                Read input files in parallel\n"));
+  fprintf(fd, _("  --no-threads             Read input files one at a time"
+					   " (default)\n"));
+  fprintf(fd, _("  --thread-count COUNT     Number of threads to use"
+					   " (default: number of CPUs)\n"));
+  fprintf(fd, _("  --update PACKAGE         Add changed files to an existing"
+					   " dwp file\n"));
   fprintf(fd, _("  -v, --verbose            Verbose output\n"));
   fprintf(fd, _("  --verify-only            Verify output file against"
 					   " exec file\n"));
@@ -2363,11 +3024,11 @@ main(int argc, char** argv)
   Errors errors(program_name);
   set_parameters_errors(&errors);
 
-  // Initialize gold's global options.  We don't use these in
-  // this program, but they need to be initialized so that
-  // functions we call from libgold work properly.
-  General_options options;
-  set_parameters_options(&options);
+  // Initialize gold's global options.  We only set the thread
+  // options, but they need to be initialized so that functions we
+  // call from libgold work properly.
+  Command_line command_line;
+  set_parameters_options(&command_line.options());
 
   // In libiberty; expands @filename to the args in "filename".
   expandargv(&argc, &argv);
@@ -2378,6 +3039,10 @@ main(int argc, char** argv)
   const char* exe_filename = NULL;
   bool verbose = false;
   bool verify_only = false;
+  bool threads = false;
+  std::string thread_count;
+  bool keep_memory = true;
+  const char* update_filename = NULL;
   int c;
   while ((c = getopt_long(argc, argv, "e:ho:vV", dwp_options, NULL)) != -1)
     {
@@ -2397,6 +3062,21 @@ main(int argc, char** argv)
 	  case VERIFY_ONLY:
 	    verify_only = true;
 	    break;
+	  case THREADS:
+	    threads = true;
+	    break;
+	  case NO_THREADS:
+	    threads = false;
+	    break;
+	  case THREAD_COUNT:
+	    thread_count.assign(optarg);
+	    break;
+	  case NO_KEEP_MEMORY:
+	    keep_memory = false;
+	    break;
+	  case UPDATE:
+	    update_filename = optarg;
+	    break;
 	  case 'V':
 	    print_version();
 	  case '?':
@@ -2405,6 +3085,29 @@ main(int argc, char** argv)
 	}
     }
 
+  // Pass the thread options on to libgold, which parses and checks
+  // them.  Without --thread-count, we use --adaptive-threads so that
+  // we run about as many threads as there are CPUs.  This must be
+  // done before we open any file, since the locks which libgold
+  // creates on first use only work if the threads option is set.
+  if (threads)
+    {
+      std::vector<std::string> thread_args;
+      thread_args.push_back("--threads");
+      if (!thread_count.empty())
+	thread_args.push_back("--thread-count=" + thread_count);
+      else
+	thread_args.push_back("--adaptive-threads");
+      std::vector<const char*> args;
+      for (unsigned int i = 0; i < thread_args.size(); ++i)
+	args.push_back(thread_args[i].c_str());
+      bool no_more_options = false;
+      int i = 0;
+      while (i < static_cast<int>(args.size()))
+	i = command_line.process_one_option(args.size(), &args[0], i,
+					    &no_more_options);
+    }
+
   if (output_filename.empty())
     {
       if (exe_filename == NULL)
@@ -2424,6 +3127,24 @@ main(int argc, char** argv)
   for (int i = optind; i < argc; ++i)
     files.push_back(Dwo_file_entry(0, argv[i]));
 
+  // With --update, the package to update is the first input file, and
+  // the units of the other input files replace its units for the same
+  // CUs.  We read the package while we write the output file, so they
+  // must be different files.
+  if (update_filename != NULL && !verify_only)
+    {
+      struct stat update_st;
+      struct stat output_st;
+      if (::stat(update_filename, &update_st) < 0)
+	gold_fatal(_("%s: %s"), update_filename, strerror(errno));
+      if (::stat(output_filename.c_str(), &output_st) == 0
+	  && output_st.st_dev == update_st.st_dev
+	  && output_st.st_ino == update_st.st_ino)
+	gold_fatal(_("%s: cannot update a dwp file in place"),
+		   update_filename);
+      files.insert(files.begin(), Dwo_file_entry(0, update_filename));
+    }
+
   if (exe_filename == NULL && files.empty())
     gold_fatal(_("no input files and no executable specified"));
 
@@ -2436,15 +3157,38 @@ main(int argc, char** argv)
       return ok ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-  // Process each file, adding its contents to the output file.
+  const General_options& options(command_line.options());
+
+  // Process each file, adding its contents to the output file.  As
+  // in gold, we never delete the workqueue, since its threads may
+  // still be exiting when we are done.
   Dwp_output_file output_file(output_filename.c_str());
-  for (File_list::const_iterator f = files.begin(); f != files.end(); ++f)
+  if (!keep_memory)
+    output_file.set_no_keep_memory();
+  Workqueue* workqueue = new Workqueue(options);
+  unsigned int max_open_files = 1;
+  if (options.threads())
     {
-      if (verbose)
-	fprintf(stderr, "%s\n", f->dwo_name.c_str());
-      Dwo_file dwo_file(f->dwo_name.c_str());
-      dwo_file.read(&output_file);
+      if (options.thread_count() > 0)
+	{
+	  workqueue->set_thread_count(options.thread_count());
+	  max_open_files = dwp_files_per_thread * options.thread_count();
+	}
+      else
+	{
+	  workqueue->set_thread_count(std::max(files.size(),
+					       static_cast<size_t>(1)));
+	  max_open_files = dwp_max_open_files;
+	}
     }
+  else
+    workqueue->set_thread_count(1);
+
+  Dwo_inputs inputs(files, &output_file, max_open_files, verbose);
+  if (update_filename != NULL)
+    inputs.set_update();
+  inputs.queue_initial_tasks(workqueue);
+  workqueue->process(0);
   output_file.finalize();
 
   return EXIT_SUCCESS;
@@ -44,6 +44,7 @@
 #include "options.h"
 #include "dirsearch.h"
 #include "target.h"
+#include "archive.h"
 #include "binary.h"
 #include "descriptors.h"
 #include "gold-threads.h"
@@ -124,6 +125,8 @@ static Initialize_lock file_counts_initialize_lock(&file_counts_lock);
 unsigned long long File_read::total_mapped_bytes;
 unsigned long long File_read::current_mapped_bytes;
 unsigned long long File_read::maximum_mapped_bytes;
+unsigned long long File_read::total_view_hits;
+unsigned long long File_read::total_view_misses;
 
 // Class File_read::View.
 
@@ -152,25 +155,6 @@ File_read::View::~View()
     }
 }
 
-void
-File_read::View::lock()
-{
-  ++this->lock_count_;
-}
-
-void
-File_read::View::unlock()
-{
-  gold_assert(this->lock_count_ > 0);
-  --this->lock_count_;
-}
-
-bool
-File_read::View::is_locked()
-{
-  return this->lock_count_ > 0;
-}
-
 // Class File_read.
 
 File_read::~File_read()
@@ -267,9 +251,13 @@ File_read::release()
       File_read::current_mapped_bytes += this->mapped_bytes_;
       if (File_read::current_mapped_bytes > File_read::maximum_mapped_bytes)
 	File_read::maximum_mapped_bytes = File_read::current_mapped_bytes;
+      File_read::total_view_hits += this->view_hits_;
+      File_read::total_view_misses += this->view_misses_;
     }
 
   this->mapped_bytes_ = 0;
+  this->view_hits_ = 0;
+  this->view_misses_ = 0;
 
   // Only clear views if there is only one attached object.  Otherwise
   // we waste time trying to clear cached archive views.  Similarly
@@ -342,33 +330,43 @@ File_read::find_view(off_t start, section_size_type size,
   // we can return it.
   if (this->whole_file_view_)
     if (byteshift == -1U || byteshift == 0)
-      return this->whole_file_view_;
-
-  off_t page = File_read::page_offset(start);
-
-  unsigned int bszero = 0;
-  Views::const_iterator p = this->views_.upper_bound(std::make_pair(page - 1,
-								    bszero));
+      {
+	++this->view_hits_;
+	return this->whole_file_view_;
+      }
+
+  File_read::View* v = this->last_view_;
+  if (v != NULL
+      && v->contains(start, size)
+      && (byteshift == -1U || byteshift == v->byteshift()))
+    {
+      ++this->view_hits_;
+      v->set_accessed();
+      return v;
+    }
 
-  while (p != this->views_.end() && p->first.first <= page)
+  Views::const_iterator p = this->views_.find(File_read::page_offset(start));
+  if (p != this->views_.end())
     {
-      if (p->second->start() <= start
-	  && (p->second->start() + static_cast<off_t>(p->second->size())
-	      >= start + static_cast<off_t>(size)))
+      for (v = p->second; v != NULL; v = v->next())
 	{
-	  if (byteshift == -1U || byteshift == p->second->byteshift())
+	  if (!v->contains(start, size))
+	    continue;
+
+	  if (byteshift == -1U || byteshift == v->byteshift())
 	    {
-	      p->second->set_accessed();
-	      return p->second;
+	      ++this->view_hits_;
+	      v->set_accessed();
+	      this->last_view_ = v;
+	      return v;
 	    }
 
 	  if (vshifted != NULL && *vshifted == NULL)
-	    *vshifted = p->second;
+	    *vshifted = v;
 	}
-
-      ++p;
     }
 
+  ++this->view_misses_;
   return NULL;
 }
 
@@ -435,6 +433,24 @@ File_read::read(off_t start, section_size_type size, void* p)
   this->do_read(start, size, p);
 }
 
+// Ask the system to start reading data we will need soon.
+
+void
+File_read::prefetch(off_t start ATTRIBUTE_UNUSED, off_t size ATTRIBUTE_UNUSED)
+{
+#ifdef HAVE_POSIX_FADVISE
+  if (!this->is_descriptor_opened_ || start >= this->size_)
+    return;
+  if (size > this->size_ - start)
+    size = this->size_ - start;
+  gold_debug(DEBUG_FILES, "Prefetch %lld bytes at %lld of \"%s\"",
+	     static_cast<long long>(size), static_cast<long long>(start),
+	     this->name_.c_str());
+  // This is only advice, so ignore any error.
+  ::posix_fadvise(this->descriptor_, start, size, POSIX_FADV_WILLNEED);
+#endif
+}
+
 // Add a new view.  There may already be an existing view at this
 // offset.  If there is, the new view will be larger, and should
 // replace the old view.
@@ -442,26 +458,45 @@ File_read::read(off_t start, section_size_type size, void* p)
 void
 File_read::add_view(File_read::View* v)
 {
+  gold_assert(v->next() == NULL);
   std::pair<Views::iterator, bool> ins =
-    this->views_.insert(std::make_pair(std::make_pair(v->start(),
-						      v->byteshift()),
-				       v));
+    this->views_.insert(std::make_pair(v->start(), v));
   if (ins.second)
     return;
 
+  File_read::View* vprev = NULL;
+  File_read::View* vold = ins.first->second;
+  while (vold != NULL && vold->byteshift() != v->byteshift())
+    {
+      vprev = vold;
+      vold = vold->next();
+    }
+  if (vold == NULL)
+    {
+      v->set_next(ins.first->second);
+      ins.first->second = v;
+      return;
+    }
+
   // There was an existing view at this offset.  It must not be large
   // enough.  We can't delete it here, since something might be using
   // it; we put it on a list to be deleted when the file is unlocked.
-  File_read::View* vold = ins.first->second;
   gold_assert(vold->size() < v->size());
   if (vold->should_cache())
     {
       v->set_cache();
       vold->clear_cache();
     }
+  v->set_next(vold->next());
+  vold->set_next(NULL);
   this->saved_views_.push_back(vold);
+  if (this->last_view_ == vold)
+    this->last_view_ = v;
 
-  ins.first->second = v;
+  if (vprev == NULL)
+    ins.first->second = v;
+  else
+    vprev->set_next(v);
 }
 
 // Make a new view with a specified byteshift, reading the data from
@@ -542,6 +577,8 @@ File_read::find_or_make_view(off_t offset, off_t start,
 		   static_cast<long long>(size),
 		   static_cast<long long>(start));
 
+  Hold_optional_lock hl(this->view_lock_);
+
   unsigned int byteshift;
   if (offset == 0)
     byteshift = 0;
@@ -776,7 +813,8 @@ File_read::clear_view_cache_marks()
   for (Views::iterator p = this->views_.begin();
        p != this->views_.end();
        ++p)
-    p->second->clear_cache();
+    for (File_read::View* v = p->second; v != NULL; v = v->next())
+      v->clear_cache();
   for (Saved_views::iterator p = this->saved_views_.begin();
        p != this->saved_views_.end();
        ++p)
@@ -793,42 +831,58 @@ File_read::clear_views(Clear_views_mode mode)
 {
   bool keep_files_mapped = (parameters->options_valid()
 			    && parameters->options().keep_files_mapped());
+  this->last_view_ = NULL;
   Views::iterator p = this->views_.begin();
   while (p != this->views_.end())
     {
-      bool should_delete;
-      if (p->second->is_locked() || p->second->is_permanent_view())
-	should_delete = false;
-      else if (mode == CLEAR_VIEWS_ALL)
-	should_delete = true;
-      else if ((p->second->should_cache()
-		|| p->second == this->whole_file_view_)
-	       && keep_files_mapped)
-	should_delete = false;
-      else if (this->object_count_ > 1
-	       && p->second->accessed()
-	       && mode != CLEAR_VIEWS_ARCHIVE)
-	should_delete = false;
-      else
-	should_delete = true;
-
-      if (should_delete)
+      File_read::View* vprev = NULL;
+      File_read::View* v = p->second;
+      while (v != NULL)
 	{
-	  if (p->second == this->whole_file_view_)
-	    this->whole_file_view_ = NULL;
-	  delete p->second;
+	  bool should_delete;
+	  if (v->is_locked() || v->is_permanent_view())
+	    should_delete = false;
+	  else if (mode == CLEAR_VIEWS_ALL)
+	    should_delete = true;
+	  else if ((v->should_cache() || v == this->whole_file_view_)
+		   && keep_files_mapped)
+	    should_delete = false;
+	  else if (this->object_count_ > 1
+		   && v->accessed()
+		   && mode != CLEAR_VIEWS_ARCHIVE)
+	    should_delete = false;
+	  else
+	    should_delete = true;
+
+	  File_read::View* vnext = v->next();
+	  if (should_delete)
+	    {
+	      if (v == this->whole_file_view_)
+		this->whole_file_view_ = NULL;
+	      delete v;
+	      if (vprev == NULL)
+		p->second = vnext;
+	      else
+		vprev->set_next(vnext);
+	    }
+	  else
+	    {
+	      v->clear_accessed();
+	      vprev = v;
+	    }
+	  v = vnext;
+	}
 
-	  // map::erase invalidates only the iterator to the deleted
+      if (p->second == NULL)
+	{
+	  // erase invalidates only the iterator to the deleted
 	  // element.
 	  Views::iterator pe = p;
 	  ++p;
 	  this->views_.erase(pe);
 	}
       else
-	{
-	  p->second->clear_accessed();
-	  ++p;
-	}
+	++p;
     }
 
   Saved_views::iterator q = this->saved_views_.begin();
@@ -856,6 +910,10 @@ File_read::print_stats()
 	  program_name, File_read::total_mapped_bytes);
   fprintf(stderr, _("%s: maximum bytes mapped for read at one time: %llu\n"),
 	  program_name, File_read::maximum_mapped_bytes);
+  fprintf(stderr, _("%s: file view cache hits: %llu\n"),
+	  program_name, File_read::total_view_hits);
+  fprintf(stderr, _("%s: file view cache misses: %llu\n"),
+	  program_name, File_read::total_view_misses);
 }
 
 // Class File_view.
@@ -1114,9 +1172,80 @@ Input_file::open(const Dirsearch& dirpath, const Task* task, int* pindex)
       return false;
     }
 
+  if (this->format_ == FORMAT_ELF && parameters->options().prefetch_inputs())
+    this->prefetch();
+
   return true;
 }
 
+// Ask the system to start reading the file named by INPUT_ARGUMENT,
+// so that on a cold cache or a network file system the reads overlap
+// with the work done on the files before it.  Only the start of the
+// file is prefetched, since we do not know yet whether it is an
+// object or an archive; both begin with what we read first, the ELF
+// header or the archive symbol table.  A file which must be searched
+// for is prefetched when it is opened.
+
+void
+Input_file::prefetch_argument(
+    const Input_file_argument* input_argument ATTRIBUTE_UNUSED)
+{
+#ifdef HAVE_POSIX_FADVISE
+  if (input_argument->is_lib()
+      || input_argument->is_searched_file()
+      || input_argument->extra_search_path() != NULL
+      || (input_argument->options().format_enum()
+	  != General_options::OBJECT_FORMAT_ELF))
+    return;
+
+  int o = open_descriptor(-1, input_argument->name(), O_RDONLY);
+  if (o < 0)
+    return;
+  struct stat s;
+  if (::fstat(o, &s) == 0)
+    {
+      off_t size = s.st_size;
+      if (size > Input_file::prefetch_whole_file_size)
+	size = Input_file::prefetch_whole_file_size;
+      gold_debug(DEBUG_FILES, "Prefetch %lld bytes at 0 of \"%s\"",
+		 static_cast<long long>(size), input_argument->name());
+      // This is only advice, so ignore any error.
+      ::posix_fadvise(o, 0, size, POSIX_FADV_WILLNEED);
+    }
+  release_descriptor(o, true);
+#endif
+}
+
+// Start reading the parts of the file we will need after the file
+// headers.  Small files are read entirely, since the section contents
+// are read by later tasks anyway.  The symbols of a larger object are
+// normally at the end, where the assembler puts the symbol table, the
+// string tables and the section headers, after the section contents.
+// The members of a larger archive are read as the symbols they define
+// are needed, so we can not tell which parts of it to prefetch beyond
+// the start, which was prefetched by prefetch_argument.
+
+void
+Input_file::prefetch()
+{
+  const off_t tail_size = 1024 * 1024;
+
+  off_t filesize = this->file_.filesize();
+  if (filesize <= Input_file::prefetch_whole_file_size)
+    {
+      this->file_.prefetch(0, filesize);
+      return;
+    }
+
+  unsigned char magic[Archive::sarmag];
+  this->file_.read(0, sizeof magic, magic);
+  if (memcmp(magic, Archive::armag, Archive::sarmag) == 0
+      || memcmp(magic, Archive::armagt, Archive::sarmag) == 0)
+    return;
+
+  this->file_.prefetch(filesize - tail_size, tail_size);
+}
+
 // Open a file for --format binary.
 
 bool
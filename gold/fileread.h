@@ -62,6 +62,7 @@ class Position_dependent_options;
 class Input_file_argument;
 class Dirsearch;
 class File_view;
+class Lock;
 
 // File_read manages a file descriptor and mappings for a file we are
 // reading.
@@ -71,8 +72,9 @@ class File_read
  public:
   File_read()
     : name_(), descriptor_(-1), is_descriptor_opened_(false), object_count_(0),
-      size_(0), token_(false), views_(), saved_views_(), mapped_bytes_(0),
-      released_(true), whole_file_view_(NULL)
+      size_(0), token_(false), views_(), saved_views_(), last_view_(NULL),
+      mapped_bytes_(0), view_hits_(0), view_misses_(0),
+      released_(true), whole_file_view_(NULL), view_lock_(NULL)
   { }
 
   ~File_read();
@@ -132,6 +134,15 @@ class File_read
   void
   release();
 
+  // Let tasks which do not hold the lock on the file get views of
+  // it, with LOCK held while looking up or making the view.  This is
+  // used when several tasks work on one object at the same time.
+  // The file may not be locked by another task until this is called
+  // again with a NULL LOCK.
+  void
+  set_view_lock(Lock* lock)
+  { this->view_lock_ = lock; }
+
   // Return the size of the file.
   off_t
   filesize() const
@@ -158,6 +169,13 @@ class File_read
   void
   read(off_t start, section_size_type size, void* p);
 
+  // Tell the system that we are going to read SIZE bytes at file
+  // offset START, so that it can start reading them now.  This does
+  // not wait for the data, and does nothing if the system does not
+  // support it.
+  void
+  prefetch(off_t start, off_t size);
+
   // Return a lasting view into the file starting at file offset START
   // for SIZE bytes.  This is allocated with new, and the caller is
   // responsible for deleting it when done.  The data associated with
@@ -247,6 +265,12 @@ class File_read
   // --stats.
   static unsigned long long maximum_mapped_bytes;
 
+  // Number of lookups which found an existing view if --stats.
+  static unsigned long long total_view_hits;
+
+  // Number of lookups which did not find an existing view if --stats.
+  static unsigned long long total_view_misses;
+
   // A view into the file.
   class View
   {
@@ -265,9 +289,9 @@ class File_read
 
     View(off_t start, section_size_type size, const unsigned char* data,
 	 unsigned int byteshift, bool cache, Data_ownership data_ownership)
-      : start_(start), size_(size), data_(data), lock_count_(0),
-	byteshift_(byteshift), cache_(cache), data_ownership_(data_ownership),
-	accessed_(true)
+      : start_(start), size_(size), data_(data), next_(NULL),
+	lock_count_(0), byteshift_(byteshift), cache_(cache),
+	data_ownership_(data_ownership), accessed_(true)
     { }
 
     ~View();
@@ -284,14 +308,38 @@ class File_read
     data() const
     { return this->data_; }
 
+    // Whether the view holds SIZE bytes at file offset START.
+    bool
+    contains(off_t start, section_size_type size) const
+    {
+      return (this->start_ <= start
+	      && (this->start_ + static_cast<off_t>(this->size_)
+		  >= start + static_cast<off_t>(size)));
+    }
+
     void
-    lock();
+    lock()
+    { ++this->lock_count_; }
 
     void
-    unlock();
+    unlock()
+    {
+      gold_assert(this->lock_count_ > 0);
+      --this->lock_count_;
+    }
 
     bool
-    is_locked();
+    is_locked() const
+    { return this->lock_count_ > 0; }
+
+    // The next view starting at the same page.
+    View*
+    next() const
+    { return this->next_; }
+
+    void
+    set_next(View* next)
+    { this->next_ = next; }
 
     unsigned int
     byteshift() const
@@ -337,6 +385,8 @@ class File_read
     section_size_type size_;
     // A pointer to the actual bytes.
     const unsigned char* data_;
+    // The next view in views_ which starts at the same page.
+    View* next_;
     // The number of locks on this view.
     int lock_count_;
     // The number of bytes that the view is shifted relative to the
@@ -355,8 +405,10 @@ class File_read
   friend class View;
   friend class File_view;
 
-  // The type of a mapping from page start and byte shift to views.
-  typedef std::map<std::pair<off_t, unsigned int>, View*> Views;
+  // The type of a mapping from page start to views.  Each entry is a
+  // list of views with different byte shifts, linked through
+  // View::next.
+  typedef Unordered_map<off_t, View*> Views;
 
   // A simple list of Views.
   typedef std::list<View*> Saved_views;
@@ -430,10 +482,18 @@ class File_read
   // List of views which were locked but had to be removed from views_
   // because they were not large enough.
   Saved_views saved_views_;
+  // The view most recently found by find_view.  Successive lookups
+  // are usually for nearby data, so we check this first.
+  mutable View* last_view_;
   // Total amount of space mapped into memory.  This is only changed
   // while the file is locked.  When we unlock the file, we transfer
   // the total to total_mapped_bytes, and reset this to zero.
   size_t mapped_bytes_;
+  // The number of lookups which did and did not find a view.  These
+  // are transferred to total_view_hits and total_view_misses like
+  // mapped_bytes_.
+  mutable unsigned long long view_hits_;
+  mutable unsigned long long view_misses_;
   // Whether the file was released.
   bool released_;
   // A view containing the whole file.  May be NULL if we mmap only
@@ -442,6 +502,9 @@ class File_read
   // - The contents was specified in the constructor.  Used only for
   //   testing purposes).
   View* whole_file_view_;
+  // If not NULL, a lock to hold while finding or making a view; see
+  // set_view_lock.
+  Lock* view_lock_;
 };
 
 // A view of file data that persists even when the file is unlocked.
@@ -521,6 +584,13 @@ class Input_file
   bool
   open(const Dirsearch&, const Task*, int* pindex);
 
+  // Ask the system to start reading the start of the file named by
+  // INPUT_ARGUMENT, if it is named by its path.  This is called when
+  // the tasks to read the input files are queued, before any of them
+  // is opened.
+  static void
+  prefetch_argument(const Input_file_argument* input_argument);
+
   // Return the name given by the user.  For -lc this will return "c".
   const char*
   name() const;
@@ -591,6 +661,14 @@ class Input_file
   bool
   open_binary(const Task* task, const std::string& name);
 
+  // Start reading the parts of the file we will need after the file
+  // headers.
+  void
+  prefetch();
+
+  // Files up to this size are prefetched entirely.
+  static const off_t prefetch_whole_file_size = 1024 * 1024;
+
   // The argument from the command line.
   const Input_file_argument* input_argument_;
   // The name under which we opened the file.  This is like the name
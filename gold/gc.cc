@@ -22,47 +22,504 @@
 
 
 #include "gold.h"
+
+#include <deque>
+
 #include "object.h"
 #include "gc.h"
 #include "symtab.h"
+#include "gold-threads.h"
+#include "workqueue.h"
 
 namespace gold
 {
 
+// The marks are set with an atomic compare and swap when several
+// threads mark at once.  If the compiler does not provide one, only
+// one thread marks.
+
+#if defined(ENABLE_THREADS) \
+    && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_1) \
+    && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+#define GC_PARALLEL_MARK 1
+#endif
+
+// The number of threads which mark in parallel if --thread-count-middle
+// is not used.
+
+static const unsigned int default_mark_workers = 8;
+
+// Allocate a mark for each section of each relocatable object.
+
+void
+Garbage_collection::setup_marks(const Input_objects* input_objects)
+{
+  unsigned int count = 0;
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      this->mark_index_[*p] = count;
+      count += (*p)->shnum();
+    }
+  this->section_marks_.assign(count, 0);
+
+  if (parameters->options().stats())
+    {
+      this->mark_timer_ = new Timer();
+      this->mark_timer_->start();
+    }
+}
+
+// Mark SECN.  When several threads are marking, this uses a compare
+// and swap, so that exactly one of them sees that the section was
+// not marked, and scans it.  A malformed relocation may refer to a
+// section which does not exist; report it, and do not mark it.
+
+bool
+Garbage_collection::mark_section(const Section_id& secn)
+{
+  Mark_index::const_iterator p = this->mark_index_.find(secn.first);
+  gold_assert(p != this->mark_index_.end());
+  if (secn.second >= secn.first->shnum())
+    {
+      secn.first->error(_("garbage collection reference to "
+			  "invalid section index %u"),
+			secn.second);
+      return false;
+    }
+  unsigned char* mark = &this->section_marks_[p->second + secn.second];
+  if (*mark != 0)
+    return false;
+#ifdef GC_PARALLEL_MARK
+  if (this->mark_workers_ > 1)
+    return __sync_bool_compare_and_swap(mark, 0, 1);
+#endif
+  *mark = 1;
+  return true;
+}
+
+// Push the unmarked sections which SECN references onto STACK.  The
+// section reloc map is not changed while marking, so several threads
+// may look at it at once.
+
+void
+Garbage_collection::scan_section(const Section_id& secn,
+				 Worklist_type* stack)
+{
+  Garbage_collection::Section_ref::const_iterator find_it =
+    this->section_reloc_map_.find(secn);
+  if (find_it == this->section_reloc_map_.end())
+    return;
+  const Garbage_collection::Sections_reachable &v = find_it->second;
+  // Scan the vector of references for each work_list entry.
+  for (Garbage_collection::Sections_reachable::const_iterator it_v =
+	 v.begin();
+       it_v != v.end();
+       ++it_v)
+    {
+      // Do not add already processed sections to the work_list.
+      if (this->mark_section(*it_v))
+	stack->push_back(*it_v);
+    }
+}
+
 // Garbage collection uses a worklist style algorithm to determine the 
 // transitive closure of all referenced sections.
 void 
-Garbage_collection::do_transitive_closure()
+Garbage_collection::do_transitive_closure(const Input_objects* input_objects)
 {
-  while (!this->worklist().empty())
+  this->setup_marks(input_objects);
+  this->mark_workers_ = 1;
+
+  Worklist_type stack;
+  for (Worklist_type::const_iterator p = this->worklist().begin();
+       p != this->worklist().end();
+       ++p)
+    if (this->mark_section(*p))
+      stack.push_back(*p);
+  Worklist_type().swap(this->worklist());
+
+  while (!stack.empty())
     {
-      // Add elements from the work list to the referenced list
-      // one by one.
-      Section_id entry = this->worklist().back();
-      this->worklist().pop_back();
-      if (!this->referenced_list().insert(entry).second)
-        continue;
-      Garbage_collection::Section_ref::iterator find_it = 
-                this->section_reloc_map().find(entry);
-      if (find_it == this->section_reloc_map().end()) 
-          continue;
-      const Garbage_collection::Sections_reachable &v = find_it->second;
-      // Scan the vector of references for each work_list entry. 
-      for (Garbage_collection::Sections_reachable::const_iterator it_v =
-               v.begin();
-           it_v != v.end();
-           ++it_v)
-        {
-          // Do not add already processed sections to the work_list. 
-          if (this->referenced_list().find(*it_v)
-              == this->referenced_list().end())
-            {
-              this->worklist().push_back(*it_v);
-            }
-        }
+      Section_id entry = stack.back();
+      stack.pop_back();
+      this->scan_section(entry, &stack);
     }
+
+  this->finish_transitive_closure();
+}
+
+// Record the statistics, and mark the worklist ready.
+
+void
+Garbage_collection::finish_transitive_closure()
+{
+  if (this->mark_timer_ != NULL)
+    {
+      this->mark_time_ = this->mark_timer_->get_elapsed_time();
+      delete this->mark_timer_;
+      this->mark_timer_ = NULL;
+
+      for (std::vector<unsigned char>::const_iterator p =
+	     this->section_marks_.begin();
+	   p != this->section_marks_.end();
+	   ++p)
+	if (*p != 0)
+	  ++this->marked_count_;
+    }
+
   this->worklist_ready();
 }
 
-} // End namespace gold.
+// Print statistics about the marking.
+
+void
+Garbage_collection::print_stats() const
+{
+  if (!this->is_worklist_ready_)
+    return;
+  fprintf(stderr,
+	  _("%s: gc mark time: " \
+	    "(user: %ld.%06ld sys: %ld.%06ld wall: %ld.%06ld)\n"),
+	  program_name,
+	  this->mark_time_.user / 1000, (this->mark_time_.user % 1000) * 1000,
+	  this->mark_time_.sys / 1000, (this->mark_time_.sys % 1000) * 1000,
+	  this->mark_time_.wall / 1000, (this->mark_time_.wall % 1000) * 1000);
+  fprintf(stderr, _("%s: gc sections marked: %u\n"),
+	  program_name, this->marked_count_);
+  fprintf(stderr, _("%s: gc mark threads: %u\n"),
+	  program_name, this->mark_workers_);
+  fprintf(stderr, _("%s: gc mark steals: %u\n"),
+	  program_name, this->mark_steals_);
+}
+
+// The state shared by the threads which mark sections in parallel.
+// Each thread marks from a private stack.  When the stack grows, the
+// thread moves its oldest entries to its deque, from which other
+// threads which have run out of work steal them.  A thread which has
+// run out of work sleeps until another thread publishes some, or
+// until no thread is marking.  A thread only finishes when its own
+// stack and deque are empty, so every section which is pushed is
+// scanned.
+
+class Gc_marker
+{
+ public:
+  Gc_marker(Garbage_collection* gc, unsigned int worker_count);
+
+  ~Gc_marker();
+
+  // Mark the sections on the worklist, and give them to the threads.
+  void
+  seed();
+
+  // Run the marking thread WORKER.
+  void
+  run_worker(unsigned int worker);
+
+ private:
+  // The number of entries which move between a stack and a deque at
+  // once.
+  static const unsigned int batch_size = 64;
+
+  // The deque of one thread.
+  struct Mark_deque
+  {
+    Mark_deque()
+      : lock(), items()
+    { }
+
+    Lock lock;
+    std::deque<Section_id> items;
+  };
+
+  // Move some entries from the back of DEQUE to STACK.  Return false
+  // if there were none.
+  bool
+  take(Mark_deque* deque, Garbage_collection::Worklist_type* stack);
+
+  // Steal half the entries of the deque of some other thread.
+  // Return false if there were none.
+  bool
+  steal(unsigned int worker, Garbage_collection::Worklist_type* stack);
+
+  // Move the oldest entries of STACK to DEQUE, if it is short, and
+  // wake up any threads waiting for work.
+  void
+  publish(Mark_deque* deque, Garbage_collection::Worklist_type* stack);
+
+  // Wait until some other thread publishes work, and steal it for
+  // thread WORKER.  Return false if every thread has run out of work.
+  bool
+  wait_for_work(unsigned int worker,
+		Garbage_collection::Worklist_type* stack);
+
+  Garbage_collection* gc_;
+  std::vector<Mark_deque*> deques_;
+  // Protects active_ and waiting_.
+  Lock idle_lock_;
+  // Signalled when work is published, or when active_ drops to 0.
+  Condvar idle_condvar_;
+  // The number of threads which are marking.
+  int active_;
+  // The number of threads waiting on idle_condvar_.
+  int waiting_;
+  // The number of successful steals.
+  volatile unsigned int steals_;
+};
+
+Gc_marker::Gc_marker(Garbage_collection* gc, unsigned int worker_count)
+  : gc_(gc), deques_(), idle_lock_(), idle_condvar_(this->idle_lock_),
+    active_(0), waiting_(0), steals_(0)
+{
+  this->deques_.reserve(worker_count);
+  for (unsigned int i = 0; i < worker_count; ++i)
+    this->deques_.push_back(new Mark_deque());
+}
+
+Gc_marker::~Gc_marker()
+{
+  for (std::vector<Mark_deque*>::iterator p = this->deques_.begin();
+       p != this->deques_.end();
+       ++p)
+    delete *p;
+  this->gc_->mark_steals_ = this->steals_;
+}
+
+// Mark the worklist, and deal the entries out to the threads in turn.
 
+void
+Gc_marker::seed()
+{
+  Garbage_collection::Worklist_type& worklist(this->gc_->worklist());
+  unsigned int worker = 0;
+  for (Garbage_collection::Worklist_type::const_iterator p = worklist.begin();
+       p != worklist.end();
+       ++p)
+    {
+      if (!this->gc_->mark_section(*p))
+	continue;
+      this->deques_[worker]->items.push_back(*p);
+      worker = (worker + 1) % this->deques_.size();
+    }
+  Garbage_collection::Worklist_type().swap(worklist);
+}
+
+bool
+Gc_marker::take(Mark_deque* deque, Garbage_collection::Worklist_type* stack)
+{
+  Hold_lock hl(deque->lock);
+  if (deque->items.empty())
+    return false;
+  for (unsigned int i = 0; i < batch_size && !deque->items.empty(); ++i)
+    {
+      stack->push_back(deque->items.back());
+      deque->items.pop_back();
+    }
+  return true;
+}
+
+bool
+Gc_marker::steal(unsigned int worker,
+		 Garbage_collection::Worklist_type* stack)
+{
+  const unsigned int count = this->deques_.size();
+  for (unsigned int i = 1; i < count; ++i)
+    {
+      Mark_deque* victim = this->deques_[(worker + i) % count];
+      Hold_lock hl(victim->lock);
+      if (victim->items.empty())
+	continue;
+      size_t n = (victim->items.size() + 1) / 2;
+      stack->insert(stack->end(), victim->items.begin(),
+		    victim->items.begin() + n);
+      victim->items.erase(victim->items.begin(), victim->items.begin() + n);
+#ifdef GC_PARALLEL_MARK
+      __sync_fetch_and_add(&this->steals_, 1);
+#endif
+      return true;
+    }
+  return false;
+}
+
+// We do not hold the deque lock while taking idle_lock_, since
+// wait_for_work takes them in the other order.
+
+void
+Gc_marker::publish(Mark_deque* deque,
+		   Garbage_collection::Worklist_type* stack)
+{
+  {
+    Hold_lock hl(deque->lock);
+    if (deque->items.size() >= batch_size)
+      return;
+    size_t n = stack->size() / 2;
+    deque->items.insert(deque->items.end(), stack->begin(),
+			stack->begin() + n);
+    stack->erase(stack->begin(), stack->begin() + n);
+  }
+
+  Hold_lock hl(this->idle_lock_);
+  if (this->waiting_ > 0)
+    this->idle_condvar_.broadcast();
+}
+
+// A thread which has not started yet will scan its own deque, so
+// there is no need to wait for it.  We try to steal while holding
+// idle_lock_, so a thread which publishes after the attempt fails
+// can not signal before we are waiting.
+
+bool
+Gc_marker::wait_for_work(unsigned int worker,
+			 Garbage_collection::Worklist_type* stack)
+{
+  Hold_lock hl(this->idle_lock_);
+  --this->active_;
+  while (this->active_ > 0)
+    {
+      if (this->steal(worker, stack))
+	{
+	  ++this->active_;
+	  return true;
+	}
+      ++this->waiting_;
+      this->idle_condvar_.wait();
+      --this->waiting_;
+    }
+  // Wake up the other waiting threads, so that they finish too.
+  this->idle_condvar_.broadcast();
+  return false;
+}
+
+void
+Gc_marker::run_worker(unsigned int worker)
+{
+  Mark_deque* own = this->deques_[worker];
+  Garbage_collection::Worklist_type stack;
+  unsigned int scanned = 0;
+
+  {
+    Hold_lock hl(this->idle_lock_);
+    ++this->active_;
+  }
+
+  while (true)
+    {
+      if (stack.empty()
+	  && !this->take(own, &stack)
+	  && !this->steal(worker, &stack))
+	{
+	  if (this->deques_.size() == 1
+	      || !this->wait_for_work(worker, &stack))
+	    break;
+	}
+
+      Section_id entry = stack.back();
+      stack.pop_back();
+      this->gc_->scan_section(entry, &stack);
+
+      // Now and then give other threads a chance to help.
+      if (++scanned % batch_size == 0 && stack.size() >= 2 * batch_size)
+	this->publish(own, &stack);
+    }
+}
+
+// A task which runs one of the marking threads.
+
+class Gc_mark_task : public Task
+{
+ public:
+  Gc_mark_task(Gc_marker* marker, unsigned int worker,
+	       Task_token* final_blocker)
+    : marker_(marker), worker_(worker), final_blocker_(final_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->marker_->run_worker(this->worker_); }
+
+  std::string
+  get_name() const
+  { return "Gc_mark_task"; }
+
+ private:
+  Gc_marker* marker_;
+  unsigned int worker_;
+  Task_token* final_blocker_;
+};
+
+// This runs when all the marking tasks are done.
+
+class Gc_mark_finish_runner : public Task_function_runner
+{
+ public:
+  Gc_mark_finish_runner(Garbage_collection* gc, Gc_marker* marker,
+			Task_function_runner* next)
+    : gc_(gc), marker_(marker), next_(next)
+  { }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  Garbage_collection* gc_;
+  Gc_marker* marker_;
+  Task_function_runner* next_;
+};
+
+void
+Gc_mark_finish_runner::run(Workqueue* workqueue, const Task* task)
+{
+  delete this->marker_;
+  this->gc_->finish_transitive_closure();
+  this->next_->run(workqueue, task);
+  delete this->next_;
+}
+
+// Queue the tasks which do the transitive closure in parallel.  The
+// sections which are marked are the same as with
+// do_transitive_closure.
+
+void
+Garbage_collection::queue_transitive_closure(
+    Workqueue* workqueue,
+    const Input_objects* input_objects,
+    Task_function_runner* next)
+{
+  this->setup_marks(input_objects);
+
+  unsigned int worker_count = 1;
+#ifdef GC_PARALLEL_MARK
+  worker_count = parameters->options().thread_count_middle();
+  if (worker_count == 0)
+    worker_count = default_mark_workers;
+#endif
+  this->mark_workers_ = worker_count;
+
+  Gc_marker* marker = new Gc_marker(this, worker_count);
+  marker->seed();
+
+  Task_token* blocker = new Task_token(true);
+  for (unsigned int i = 0; i < worker_count; ++i)
+    {
+      blocker->add_blocker();
+      workqueue->queue(new Gc_mark_task(marker, i, blocker));
+    }
+  workqueue->queue(new Task_function(new Gc_mark_finish_runner(this, marker,
+							       next),
+				     blocker,
+				     "Task_function Gc_mark_finish_runner"));
+}
+
+} // End namespace gold.
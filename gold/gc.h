@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "elfcpp.h"
+#include "timer.h"
 #include "symtab.h"
 #include "object.h"
 #include "icf.h"
@@ -41,6 +42,9 @@ class Sized_relobj_file;
 class Output_section;
 class General_options;
 class Layout;
+class Input_objects;
+class Workqueue;
+class Task_function_runner;
 
 class Garbage_collection
 {
@@ -55,15 +59,13 @@ class Garbage_collection
   typedef std::map<std::string, Sections_reachable> Cident_section_map;
 
   Garbage_collection()
-  : is_worklist_ready_(false)
+  : is_worklist_ready_(false), section_marks_(), mark_index_(),
+    mark_timer_(NULL), mark_time_(), marked_count_(0), mark_workers_(0),
+    mark_steals_(0)
   { }
 
   // Accessor methods for the private members.
 
-  Sections_reachable&
-  referenced_list()
-  { return referenced_list_; }
-
   Section_ref&
   section_reloc_map()
   { return this->section_reloc_map_; }
@@ -80,13 +82,30 @@ class Garbage_collection
   worklist_ready()
   { this->is_worklist_ready_ = true; }
 
+  // Mark every section reachable from the worklist.  The objects
+  // in INPUT_OBJECTS are the ones whose sections may be marked.
+  void
+  do_transitive_closure(const Input_objects* input_objects);
+
+  // Queue tasks which mark the sections reachable from the worklist
+  // in parallel, and then run NEXT.
   void
-  do_transitive_closure();
+  queue_transitive_closure(Workqueue*, const Input_objects* input_objects,
+			   Task_function_runner* next);
 
   bool
-  is_section_garbage(Relobj* obj, unsigned int shndx)
-  { return (this->referenced_list().find(Section_id(obj, shndx))
-            == this->referenced_list().end()); }
+  is_section_garbage(Relobj* obj, unsigned int shndx) const
+  {
+    Mark_index::const_iterator p = this->mark_index_.find(obj);
+    if (p == this->mark_index_.end())
+      return true;
+    gold_assert(shndx < obj->shnum());
+    return this->section_marks_[p->second + shndx] == 0;
+  }
+
+  // Print statistics about the marking to stderr.
+  void
+  print_stats() const;
 
   Cident_section_map*
   cident_sections()
@@ -110,12 +129,49 @@ class Garbage_collection
   }
 
  private:
+  friend class Gc_marker;
+  friend class Gc_mark_finish_runner;
+
+  // Map each object to the index of the mark of its section 0 in
+  // section_marks_.
+  typedef Unordered_map<const Relobj*, unsigned int> Mark_index;
+
+  // Allocate the marks for the sections of INPUT_OBJECTS.
+  void
+  setup_marks(const Input_objects* input_objects);
+
+  // Mark SECN as referenced.  Return true if it was not marked
+  // before.  This may be called by several threads at once.
+  bool
+  mark_section(const Section_id& secn);
+
+  // Push onto STACK each section referenced by SECN which was not
+  // already marked, and mark it.
+  void
+  scan_section(const Section_id& secn, Worklist_type* stack);
+
+  // Finish marking: record the statistics and mark the worklist ready.
+  void
+  finish_transitive_closure();
 
   Worklist_type work_list_;
   bool is_worklist_ready_;
   Section_ref section_reloc_map_;
-  Sections_reachable referenced_list_;
   Cident_section_map cident_sections_;
+  // The mark of each section, nonzero if it is referenced.  These
+  // are bytes rather than a vector<bool> so that they may be set
+  // atomically.
+  std::vector<unsigned char> section_marks_;
+  Mark_index mark_index_;
+  // With --stats, the time taken by the marking.
+  Timer* mark_timer_;
+  Timer::TimeStats mark_time_;
+  // With --stats, the number of marked sections, the number of
+  // threads which marked them, and the number of times one stole
+  // work from another.
+  unsigned int marked_count_;
+  unsigned int mark_workers_;
+  unsigned int mark_steals_;
 };
 
 // Data to pass between successive invocations of do_layout
@@ -27,8 +27,9 @@
 #include "dwarf.h"
 #include "object.h"
 #include "output.h"
+#include "workqueue.h"
+#include "int_encoding.h"
 #include "demangle.h"
-
 namespace gold
 {
 
@@ -171,6 +172,340 @@ mapped_index_string_hash(const unsigned char* str)
   return r;
 }
 
+class Gdb_index_info_reader;
+
+// The compilation units, type units, address ranges and symbols
+// found in the .debug_info and .debug_types sections of one input
+// object.  CU indexes are local to the object, and are adjusted when
+// the scan is merged into the Gdb_index.  As in Gdb_index, a negative
+// index refers to a TU.
+
+class Gdb_index_scan
+{
+ public:
+  // A symbol, with the list of CUs and TUs that refer to it.
+  struct Symbol
+  {
+    Symbol(const char* n, unsigned int h)
+      : name(n), hashval(h), cu_vector()
+    { }
+    const char* name;
+    unsigned int hashval;
+    Gdb_index::Cu_vector cu_vector;
+  };
+
+  typedef std::vector<Symbol> Symbols;
+
+  // A .debug_names entry: the DIE at DIE_OFFSET within compilation
+  // unit CU_INDEX, whose tag is TAG.
+  struct Name_entry
+  {
+    Name_entry(unsigned int t, unsigned int cu, uint64_t off)
+      : tag(t), cu_index(cu), die_offset(off)
+    { }
+    unsigned int tag;
+    unsigned int cu_index;
+    uint64_t die_offset;
+  };
+
+  // A name for the .debug_names section, with the DIEs that define it.
+  struct Name
+  {
+    Name(const char* n)
+      : name(n), entries()
+    { }
+    const char* name;
+    std::vector<Name_entry> entries;
+  };
+
+  typedef std::vector<Name> Names;
+
+  Gdb_index_scan(Relobj* object)
+    : object_(object), sections_(), comp_units_(), type_units_(), ranges_(),
+      symbols_(), symbol_map_(), names_(), name_map_(), cu_pubname_map_(),
+      cu_pubtype_map_(), pubnames_table_(NULL), pubtypes_table_(NULL),
+      pubnames_mapped_(false), stmt_list_offset_(-1), is_done_(false),
+      cu_count_(0), cu_nopubnames_count_(0), tu_count_(0),
+      tu_nopubnames_count_(0)
+  { }
+
+  ~Gdb_index_scan()
+  {
+    delete this->pubnames_table_;
+    delete this->pubtypes_table_;
+  }
+
+  // Return the object being scanned.
+  Relobj*
+  object() const
+  { return this->object_; }
+
+  // Record a section to be scanned later by scan_sections.
+  void
+  add_section(bool is_type_unit, unsigned int shndx,
+	      unsigned int reloc_shndx, unsigned int reloc_type)
+  {
+    this->sections_.push_back(Section(is_type_unit, shndx, reloc_shndx,
+				      reloc_type));
+  }
+
+  // Return whether there are sections waiting for scan_sections.
+  bool
+  has_sections() const
+  { return !this->sections_.empty(); }
+
+  // Scan a .debug_info or .debug_types input section.
+  void
+  scan_section(bool is_type_unit, const unsigned char* symbols,
+	       off_t symbols_size, unsigned int shndx,
+	       unsigned int reloc_shndx, unsigned int reloc_type);
+
+  // Scan the sections recorded by add_section.  The object must be
+  // locked.
+  void
+  scan_sections();
+
+  // Return whether the scan is complete.
+  bool
+  is_done() const
+  { return this->is_done_; }
+
+  // Record that the scan is complete.
+  void
+  set_done()
+  { this->is_done_ = true; }
+
+  // Add a compilation unit.
+  int
+  add_comp_unit(off_t cu_offset, off_t cu_length)
+  {
+    this->comp_units_.push_back(Gdb_index::Comp_unit(cu_offset, cu_length));
+    return this->comp_units_.size() - 1;
+  }
+
+  // Add a type unit.
+  int
+  add_type_unit(off_t tu_offset, off_t type_offset, uint64_t signature)
+  {
+    this->type_units_.push_back(Gdb_index::Type_unit(tu_offset, type_offset,
+						     signature));
+    return this->type_units_.size() - 1;
+  }
+
+  // Add an address range.
+  void
+  add_address_range_list(unsigned int cu_index, Dwarf_range_list* ranges)
+  {
+    this->ranges_.push_back(Gdb_index::Per_cu_range_list(this->object_,
+							 cu_index, ranges));
+  }
+
+  // Add a symbol.  FLAGS are the gdb_index version 7 flags to be stored in
+  // the high-byte of the cu_index field.
+  void
+  add_symbol(int cu_index, const char* sym_name, uint8_t flags);
+
+  // Add a .debug_names entry for NAME.
+  void
+  add_name(const char* name, unsigned int tag, unsigned int cu_index,
+	   off_t die_offset);
+
+  // Return the offset into the pubnames table for the cu at the given
+  // offset.
+  off_t
+  find_pubname_offset(off_t cu_offset);
+
+  // Return the offset into the pubtypes table for the cu at the
+  // given offset.
+  off_t
+  find_pubtype_offset(off_t cu_offset);
+
+  // Return TRUE if we have already processed the pubnames and types
+  // set of the CUs and TUS associated with the statement list at
+  // OFFSET.
+  bool
+  pubnames_read(off_t offset) const
+  { return this->stmt_list_offset_ == offset; }
+
+  // Record that we have already read the pubnames associated with
+  // OFFSET.
+  void
+  set_pubnames_read(off_t offset)
+  { this->stmt_list_offset_ = offset; }
+
+  // Return a pointer to the given table.
+  Dwarf_pubnames_table*
+  pubnames_table()
+  { return pubnames_table_; }
+
+  Dwarf_pubnames_table*
+  pubtypes_table()
+  { return pubtypes_table_; }
+
+  // Count a CU or TU.
+  void
+  count_unit(bool is_type_unit)
+  {
+    if (is_type_unit)
+      ++this->tu_count_;
+    else
+      ++this->cu_count_;
+  }
+
+  // Count a CU or TU without pubnames or pubtypes.
+  void
+  count_unit_without_pubnames(bool is_type_unit)
+  {
+    if (is_type_unit)
+      ++this->tu_nopubnames_count_;
+    else
+      ++this->cu_nopubnames_count_;
+  }
+
+  // Accessors used when merging the scan into the Gdb_index.
+
+  const std::vector<Gdb_index::Comp_unit>&
+  comp_units() const
+  { return this->comp_units_; }
+
+  const std::vector<Gdb_index::Type_unit>&
+  type_units() const
+  { return this->type_units_; }
+
+  const std::vector<Gdb_index::Per_cu_range_list>&
+  ranges() const
+  { return this->ranges_; }
+
+  const Symbols&
+  symbols() const
+  { return this->symbols_; }
+
+  const Names&
+  names() const
+  { return this->names_; }
+
+  unsigned int
+  cu_count() const
+  { return this->cu_count_; }
+
+  unsigned int
+  cu_nopubnames_count() const
+  { return this->cu_nopubnames_count_; }
+
+  unsigned int
+  tu_count() const
+  { return this->tu_count_; }
+
+  unsigned int
+  tu_nopubnames_count() const
+  { return this->tu_nopubnames_count_; }
+
+ private:
+  // A section recorded by add_section.
+  struct Section
+  {
+    Section(bool is_tu, unsigned int sh, unsigned int reloc_sh,
+	    unsigned int rtype)
+      : is_type_unit(is_tu), shndx(sh), reloc_shndx(reloc_sh),
+	reloc_type(rtype)
+    { }
+    bool is_type_unit;
+    unsigned int shndx;
+    unsigned int reloc_shndx;
+    unsigned int reloc_type;
+  };
+
+  // Map from symbol name to index in SYMBOLS_.
+  typedef Unordered_map<std::string, unsigned int> Symbol_map;
+
+  typedef Unordered_map<off_t, off_t> Pubname_offset_map;
+
+  // Scan the pubnames or pubtypes section and build a map of the
+  // various dies it refers to, so we can process the entries when we
+  // encounter the die.
+  Dwarf_pubnames_table*
+  map_pubtable_to_dies(unsigned int attr,
+		       Gdb_index_info_reader* dwinfo,
+		       const unsigned char* symbols,
+		       off_t symbols_size);
+
+  // Wrapper for map_pubtable_to_dies
+  void
+  map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
+				 const unsigned char* symbols,
+				 off_t symbols_size);
+
+  // The object being scanned.
+  Relobj* object_;
+  // Sections waiting for scan_sections.
+  std::vector<Section> sections_;
+  // The list of DWARF compilation units.
+  std::vector<Gdb_index::Comp_unit> comp_units_;
+  // The list of DWARF type units.
+  std::vector<Gdb_index::Type_unit> type_units_;
+  // The list of address ranges.
+  std::vector<Gdb_index::Per_cu_range_list> ranges_;
+  // The symbols, in the order they were first seen.
+  Symbols symbols_;
+  // Map from symbol name to index in SYMBOLS_.  The names in
+  // SYMBOLS_ point to the keys of this map.
+  Symbol_map symbol_map_;
+  // The .debug_names names, in the order they were first seen.
+  Names names_;
+  // Map from name to index in NAMES_, as for SYMBOL_MAP_.
+  Symbol_map name_map_;
+  // Maps from CU offset to pubnames and pubtypes table offset.
+  Pubname_offset_map cu_pubname_map_;
+  Pubname_offset_map cu_pubtype_map_;
+  // Tables to store the pubnames sections of the object.
+  Dwarf_pubnames_table* pubnames_table_;
+  Dwarf_pubnames_table* pubtypes_table_;
+  // Whether the pubnames and pubtypes maps have been built.
+  bool pubnames_mapped_;
+  // The stmt list offset of the CUs and TUs associated with the last
+  // read pubnames and pubtypes sections.
+  off_t stmt_list_offset_;
+  // Whether the scan is complete.
+  bool is_done_;
+  // Statistics, added to the totals when the scan is merged.
+  unsigned int cu_count_;
+  unsigned int cu_nopubnames_count_;
+  unsigned int tu_count_;
+  unsigned int tu_nopubnames_count_;
+};
+
+// This task scans the .debug_info and .debug_types sections of one
+// input object for the .gdb_index section.
+
+class Gdb_index_scan_task : public Task
+{
+ public:
+  Gdb_index_scan_task(Gdb_index* gdb_index, Gdb_index_scan* scan,
+		      Task_token* blocker)
+    : gdb_index_(gdb_index), scan_(scan), blocker_(blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable();
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const
+  { return "Gdb_index_scan_task " + this->scan_->object()->name(); }
+
+ private:
+  Gdb_index* gdb_index_;
+  Gdb_index_scan* scan_;
+  Task_token* blocker_;
+};
+
 // A specialization of Dwarf_info_reader, for building the .gdb_index.
 
 class Gdb_index_info_reader : public Dwarf_info_reader
@@ -183,15 +518,19 @@ class Gdb_index_info_reader : public Dwarf_info_reader
 			unsigned int shndx,
 			unsigned int reloc_shndx,
 			unsigned int reloc_type,
-			Gdb_index* gdb_index)
+			Gdb_index_scan* scan)
     : Dwarf_info_reader(is_type_unit, object, symbols, symbols_size, shndx,
 			reloc_shndx, reloc_type),
-      gdb_index_(gdb_index), cu_index_(0), cu_language_(0)
+      scan_(scan), cu_index_(0), cu_language_(0)
   { }
 
   ~Gdb_index_info_reader()
   { this->clear_declarations(); }
 
+  // Add the statistics collected by SCAN to the totals.
+  static void
+  add_stats(const Gdb_index_scan* scan);
+
   // Print usage statistics.
   static void
   print_stats();
@@ -228,6 +567,29 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   };
   typedef Unordered_map<off_t, Declaration_pair> Declaration_map;
 
+  // The names of a subprogram or variable DIE, and the offset of the
+  // DIE it refers to with DW_AT_specification or DW_AT_abstract_origin,
+  // or 0.
+  struct Die_names
+  {
+    Die_names(const char* n, const char* ln, off_t r)
+      : name(n), linkage_name(ln), ref(r)
+    { }
+    Die_names()
+      : name(NULL), linkage_name(NULL), ref(0)
+    { }
+    const char* name;
+    const char* linkage_name;
+    off_t ref;
+  };
+  // A map from the offset of a DIE within the compile unit to its
+  // names.  A definition may refer to a DIE later in the compile unit,
+  // so we look up the names of definitions after walking the tree.
+  typedef Unordered_map<off_t, Die_names> Name_map;
+  // A definition to add to the .debug_names section: the DIE offset
+  // and the tag.
+  typedef std::vector<std::pair<off_t, unsigned int> > Definitions;
+
   // Visit a top-level DIE.
   void
   visit_top_die(Dwarf_die* die);
@@ -273,6 +635,32 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   void
   record_cu_ranges(Dwarf_die* die);
 
+  // Visit the children of a DIE, looking for .debug_names entries.
+  void
+  visit_children_for_names(Dwarf_die* parent);
+
+  // Visit a DIE, looking for .debug_names entries.
+  void
+  visit_die_for_names(Dwarf_die* die);
+
+  // Record the names of a subprogram, inlined subroutine, variable or
+  // member DIE, and whether it is a definition to index.
+  void
+  record_names(Dwarf_die* die, bool is_defined);
+
+  // Add the .debug_names entries for the recorded definitions.
+  void
+  add_definition_names();
+
+  // Return true if DIE has code in a section we are keeping.
+  bool
+  has_code_address(Dwarf_die* die);
+
+  // Return true if DIE is a variable with a static or thread-local
+  // address.
+  static bool
+  has_static_location(Dwarf_die* die);
+
   // Wrapper for read_pubtable.
   bool
   read_pubnames_and_pubtypes(Dwarf_die* die);
@@ -285,8 +673,8 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   void
   clear_declarations();
 
-  // The Gdb_index section.
-  Gdb_index* gdb_index_;
+  // The scan of the object, which collects what we find.
+  Gdb_index_scan* scan_;
   // The current CU index (negative for a TU).
   int cu_index_;
   // The language of the current CU or TU.
@@ -294,6 +682,10 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   // Map from DIE offset to (parent offset, name) pair,
   // for DW_AT_specification.
   Declaration_map declarations_;
+  // Map from DIE offset to names, for .debug_names.
+  Name_map names_;
+  // The definitions found by visit_die_for_names.
+  Definitions definitions_;
 
   // Statistics.
   // Total number of DWARF compilation units processed.
@@ -321,8 +713,8 @@ void
 Gdb_index_info_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
 					      Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_cu_count;
-  this->cu_index_ = this->gdb_index_->add_comp_unit(cu_offset, cu_length);
+  this->scan_->count_unit(false);
+  this->cu_index_ = this->scan_->add_comp_unit(cu_offset, cu_length);
   this->visit_top_die(root_die);
 }
 
@@ -333,10 +725,10 @@ Gdb_index_info_reader::visit_type_unit(off_t tu_offset, off_t,
 				       off_t type_offset, uint64_t signature,
 				       Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_tu_count;
+  this->scan_->count_unit(true);
   // Use a negative index to flag this as a TU instead of a CU.
-  this->cu_index_ = -1 - this->gdb_index_->add_type_unit(tu_offset, type_offset,
-							 signature);
+  this->cu_index_ = -1 - this->scan_->add_type_unit(tu_offset, type_offset,
+						    signature);
   this->visit_top_die(root_die);
 }
 
@@ -359,6 +751,18 @@ Gdb_index_info_reader::visit_top_die(Dwarf_die* die)
 	this->cu_language_ = die->int_attribute(elfcpp::DW_AT_language);
 	if (die->tag() == elfcpp::DW_TAG_compile_unit)
 	  this->record_cu_ranges(die);
+	// The .debug_names section can only refer to DIEs in the
+	// .debug_info section, and indexes the whole tree rather than
+	// the names gdb wants.  Walk the tree once for it here, and
+	// then rewind the relocation tracker.
+	if (parameters->options().debug_names()
+	    && die->tag() == elfcpp::DW_TAG_compile_unit)
+	  {
+	    uint64_t checkpoint = this->get_reloc_checkpoint();
+	    this->visit_children_for_names(die);
+	    this->reset_relocs(checkpoint);
+	    this->add_definition_names();
+	  }
 	// If there is a pubnames and/or pubtypes section for this
 	// compilation unit, use those; otherwise, parse the DWARF
 	// info to extract the names.
@@ -380,10 +784,8 @@ Gdb_index_info_reader::visit_top_die(Dwarf_die* die)
 			     this->object()->name().c_str());
 		return;
 	      }
-	    if (die->tag() == elfcpp::DW_TAG_compile_unit)
-	      ++Gdb_index_info_reader::dwarf_cu_nopubnames_count;
-	    else
-	      ++Gdb_index_info_reader::dwarf_tu_nopubnames_count;
+	    this->scan_->count_unit_without_pubnames(
+		die->tag() != elfcpp::DW_TAG_compile_unit);
 	    this->visit_children(die, NULL);
 	  }
 	break;
@@ -437,8 +839,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	    // If the DIE is not a declaration, add it to the index.
 	    std::string full_name = this->get_qualified_name(die, context);
 	    if (!full_name.empty())
-	      this->gdb_index_->add_symbol(this->cu_index_,
-                                           full_name.c_str(), 0);
+	      this->scan_->add_symbol(this->cu_index_, full_name.c_str(), 0);
 	  }
 	break;
       case elfcpp::DW_TAG_typedef:
@@ -477,8 +878,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	      if (full_name.empty())
 		full_name = this->get_qualified_name(die, context);
 	      if (!full_name.empty())
-		this->gdb_index_->add_symbol(this->cu_index_,
-					     full_name.c_str(), 0);
+		this->scan_->add_symbol(this->cu_index_, full_name.c_str(), 0);
 	    }
 
 	  // We're interested in the children only for namespaces and
@@ -825,8 +1225,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
     {
       Dwarf_range_list* ranges = this->read_range_list(shndx, ranges_offset);
       if (ranges != NULL)
-	this->gdb_index_->add_address_range_list(this->object(),
-						 this->cu_index_, ranges);
+	this->scan_->add_address_range_list(this->cu_index_, ranges);
       return;
     }
 
@@ -851,12 +1250,204 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
         {
 	  Dwarf_range_list* ranges = new Dwarf_range_list();
 	  ranges->add(shndx, low_pc, high_pc);
-	  this->gdb_index_->add_address_range_list(this->object(),
-						   this->cu_index_, ranges);
+	  this->scan_->add_address_range_list(this->cu_index_, ranges);
         }
     }
 }
 
+// Visit the children of PARENT, looking for .debug_names entries.
+
+void
+Gdb_index_info_reader::visit_children_for_names(Dwarf_die* parent)
+{
+  off_t next_offset = 0;
+  for (off_t die_offset = parent->child_offset();
+       die_offset != 0;
+       die_offset = next_offset)
+    {
+      Dwarf_die die(this, die_offset, parent);
+      if (die.tag() == 0)
+	break;
+      this->visit_die_for_names(&die);
+      next_offset = die.sibling_offset();
+    }
+}
+
+// Visit a DIE and its children, adding .debug_names entries for the
+// named types and namespaces.  Functions and variables are recorded,
+// and added by add_definition_names if they have addresses.
+
+void
+Gdb_index_info_reader::visit_die_for_names(Dwarf_die* die)
+{
+  switch (die->tag())
+    {
+      case elfcpp::DW_TAG_array_type:
+      case elfcpp::DW_TAG_atomic_type:
+      case elfcpp::DW_TAG_base_type:
+      case elfcpp::DW_TAG_class_type:
+      case elfcpp::DW_TAG_const_type:
+      case elfcpp::DW_TAG_constant:
+      case elfcpp::DW_TAG_enumeration_type:
+      case elfcpp::DW_TAG_file_type:
+      case elfcpp::DW_TAG_interface_type:
+      case elfcpp::DW_TAG_packed_type:
+      case elfcpp::DW_TAG_pointer_type:
+      case elfcpp::DW_TAG_ptr_to_member_type:
+      case elfcpp::DW_TAG_reference_type:
+      case elfcpp::DW_TAG_restrict_type:
+      case elfcpp::DW_TAG_rvalue_reference_type:
+      case elfcpp::DW_TAG_set_type:
+      case elfcpp::DW_TAG_string_type:
+      case elfcpp::DW_TAG_structure_type:
+      case elfcpp::DW_TAG_subrange_type:
+      case elfcpp::DW_TAG_subroutine_type:
+      case elfcpp::DW_TAG_typedef:
+      case elfcpp::DW_TAG_union_type:
+      case elfcpp::DW_TAG_unspecified_type:
+      case elfcpp::DW_TAG_volatile_type:
+	if (die->name() != NULL && !die->is_declaration())
+	  this->scan_->add_name(die->name(), die->tag(), this->cu_index_,
+				die->offset());
+	break;
+      case elfcpp::DW_TAG_namespace:
+	{
+	  const char* name = die->name();
+	  if (name == NULL)
+	    name = "(anonymous namespace)";
+	  this->scan_->add_name(name, die->tag(), this->cu_index_,
+				die->offset());
+	}
+	break;
+      case elfcpp::DW_TAG_subprogram:
+      case elfcpp::DW_TAG_inlined_subroutine:
+	this->record_names(die, this->has_code_address(die));
+	break;
+      case elfcpp::DW_TAG_variable:
+	this->record_names(die, has_static_location(die));
+	break;
+      case elfcpp::DW_TAG_member:
+	// A static data member is declared with DW_TAG_member in
+	// DWARF 4, and defined with DW_TAG_variable.
+	this->record_names(die, false);
+	break;
+      case elfcpp::DW_TAG_label:
+	if (die->name() != NULL && this->has_code_address(die))
+	  this->scan_->add_name(die->name(), die->tag(), this->cu_index_,
+				die->offset());
+	break;
+      default:
+	break;
+    }
+
+  if (die->has_children())
+    this->visit_children_for_names(die);
+}
+
+// Record the names of DIE, and the DIE it refers to for any names it
+// does not have.  IS_DEFINED is true if the DIE has an address.
+
+void
+Gdb_index_info_reader::record_names(Dwarf_die* die, bool is_defined)
+{
+  off_t ref = die->specification();
+  if (ref == 0)
+    ref = die->abstract_origin();
+  this->names_[die->offset()] = Die_names(die->name(), die->linkage_name(),
+					  ref);
+  if (is_defined && !die->is_declaration())
+    this->definitions_.push_back(std::make_pair(die->offset(), die->tag()));
+}
+
+// Add .debug_names entries for the name and linkage name of each
+// definition we found in the compile unit.  A definition may take its
+// names from the declaration or abstract instance it refers to, which
+// may in turn refer to another DIE.
+
+void
+Gdb_index_info_reader::add_definition_names()
+{
+  for (Definitions::const_iterator p = this->definitions_.begin();
+       p != this->definitions_.end();
+       ++p)
+    {
+      const char* name = NULL;
+      const char* linkage_name = NULL;
+      off_t offset = p->first;
+      // Limit the length of the chain, in case of bad DWARF.
+      for (int depth = 0;
+	   depth < 8 && (name == NULL || linkage_name == NULL);
+	   ++depth)
+	{
+	  Name_map::const_iterator q = this->names_.find(offset);
+	  if (q == this->names_.end())
+	    break;
+	  if (name == NULL)
+	    name = q->second.name;
+	  if (linkage_name == NULL)
+	    linkage_name = q->second.linkage_name;
+	  offset = q->second.ref;
+	  if (offset == 0)
+	    break;
+	}
+
+      if (name != NULL)
+	this->scan_->add_name(name, p->second, this->cu_index_, p->first);
+      if (linkage_name != NULL
+	  && (name == NULL || strcmp(name, linkage_name) != 0))
+	this->scan_->add_name(linkage_name, p->second, this->cu_index_,
+			      p->first);
+    }
+
+  this->names_.clear();
+  this->definitions_.clear();
+}
+
+// Return true if DIE has a DW_AT_ranges attribute, or a DW_AT_low_pc
+// attribute in a section that is included in the link.
+
+bool
+Gdb_index_info_reader::has_code_address(Dwarf_die* die)
+{
+  unsigned int shndx;
+  if (die->ref_attribute(elfcpp::DW_AT_ranges, &shndx) != -1)
+    return true;
+  off_t low_pc = die->address_attribute(elfcpp::DW_AT_low_pc, &shndx);
+  if (low_pc == -1)
+    return false;
+  return shndx == 0 || this->object()->is_section_included(shndx);
+}
+
+// Return true if the DW_AT_location of DIE is a DW_OP_addr, or a
+// thread-local address.
+
+bool
+Gdb_index_info_reader::has_static_location(Dwarf_die* die)
+{
+  const Dwarf_die::Attribute_value* loc =
+    die->attribute(elfcpp::DW_AT_location);
+  if (loc == NULL)
+    return false;
+  switch (loc->form)
+    {
+      case elfcpp::DW_FORM_block:
+      case elfcpp::DW_FORM_block1:
+      case elfcpp::DW_FORM_block2:
+      case elfcpp::DW_FORM_block4:
+      case elfcpp::DW_FORM_exprloc:
+	break;
+      default:
+	return false;
+    }
+  if (loc->aux.blocklen == 0)
+    return false;
+  const unsigned char* expr = loc->val.blockval;
+  unsigned char last = expr[loc->aux.blocklen - 1];
+  return (expr[0] == elfcpp::DW_OP_addr
+	  || last == elfcpp::DW_OP_form_tls_address
+	  || last == elfcpp::DW_OP_GNU_push_tls_address);
+}
+
 // Read table and add the relevant names to the index.  Returns true
 // if any names were added.
 
@@ -877,7 +1468,7 @@ Gdb_index_info_reader::read_pubtable(Dwarf_pubnames_table* table, off_t offset)
       if (name == NULL)
         break;
 
-      this->gdb_index_->add_symbol(this->cu_index_, name, flag_byte);
+      this->scan_->add_symbol(this->cu_index_, name, flag_byte);
     }
   return true;
 }
@@ -916,8 +1507,7 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
           // have read. If it does, then no need to read the pubnames.
           // If it doesn't, then the caller will have to parse the
           // dies manually to find the names.
-          return this->gdb_index_->pubnames_read(this->object(),
-                                                 stmt_list_off);
+          return this->scan_->pubnames_read(stmt_list_off);
         }
       else
         {
@@ -928,10 +1518,10 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
 
   // We found the attribute, so we can check if the corresponding
   // pubnames have been read.
-  if (this->gdb_index_->pubnames_read(this->object(), stmt_list_off))
+  if (this->scan_->pubnames_read(stmt_list_off))
     return true;
 
-  this->gdb_index_->set_pubnames_read(this->object(), stmt_list_off);
+  this->scan_->set_pubnames_read(stmt_list_off);
 
   // We have an attribute, and the pubnames haven't been read, so read
   // them.
@@ -939,12 +1529,12 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
   // In some of the cases, we could rely on the previous value of
   // offset here, but sorting out which cases complicates the logic
   // enough that it isn't worth it. So just look up the offset again.
-  offset = this->gdb_index_->find_pubname_offset(this->cu_offset());
-  names = this->read_pubtable(this->gdb_index_->pubnames_table(), offset);
+  offset = this->scan_->find_pubname_offset(this->cu_offset());
+  names = this->read_pubtable(this->scan_->pubnames_table(), offset);
 
   bool types = false;
-  offset = this->gdb_index_->find_pubtype_offset(this->cu_offset());
-  types = this->read_pubtable(this->gdb_index_->pubtypes_table(), offset);
+  offset = this->scan_->find_pubtype_offset(this->cu_offset());
+  types = this->read_pubtable(this->scan_->pubtypes_table(), offset);
   return names || types;
 }
 
@@ -964,6 +1554,19 @@ Gdb_index_info_reader::clear_declarations()
   this->declarations_.clear();
 }
 
+// Add the statistics collected by SCAN to the totals.
+
+void
+Gdb_index_info_reader::add_stats(const Gdb_index_scan* scan)
+{
+  Gdb_index_info_reader::dwarf_cu_count += scan->cu_count();
+  Gdb_index_info_reader::dwarf_cu_nopubnames_count
+    += scan->cu_nopubnames_count();
+  Gdb_index_info_reader::dwarf_tu_count += scan->tu_count();
+  Gdb_index_info_reader::dwarf_tu_nopubnames_count
+    += scan->tu_nopubnames_count();
+}
+
 // Print usage statistics.
 void
 Gdb_index_info_reader::print_stats()
@@ -978,41 +1581,7 @@ Gdb_index_info_reader::print_stats()
           program_name, Gdb_index_info_reader::dwarf_tu_nopubnames_count);
 }
 
-// Class Gdb_index.
-
-// Construct the .gdb_index section.
-
-Gdb_index::Gdb_index(Output_section* gdb_index_section)
-  : Output_section_data(4),
-    pubnames_table_(NULL),
-    pubtypes_table_(NULL),
-    gdb_index_section_(gdb_index_section),
-    comp_units_(),
-    type_units_(),
-    ranges_(),
-    cu_vector_list_(),
-    cu_vector_offsets_(NULL),
-    stringpool_(),
-    tu_offset_(0),
-    addr_offset_(0),
-    symtab_offset_(0),
-    cu_pool_offset_(0),
-    stringpool_offset_(0),
-    pubnames_object_(NULL),
-    stmt_list_offset_(-1)
-{
-  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
-}
-
-Gdb_index::~Gdb_index()
-{
-  // Free the memory used by the symbol table.
-  delete this->gdb_symtab_;
-  // Free the memory used by the CU vectors.
-  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
-    delete this->cu_vector_list_[i];
-}
-
+// Class Gdb_index_scan.
 
 // Scan the pubnames and pubtypes sections and build a map of the
 // various cus and tus they refer to, so we can process the entries
@@ -1020,11 +1589,10 @@ Gdb_index::~Gdb_index()
 // Return the just-read table so it can be cached.
 
 Dwarf_pubnames_table*
-Gdb_index::map_pubtable_to_dies(unsigned int attr,
-                                Gdb_index_info_reader* dwinfo,
-                                Relobj* object,
-                                const unsigned char* symbols,
-                                off_t symbols_size)
+Gdb_index_scan::map_pubtable_to_dies(unsigned int attr,
+				     Gdb_index_info_reader* dwinfo,
+				     const unsigned char* symbols,
+				     off_t symbols_size)
 {
   uint64_t section_offset = 0;
   Dwarf_pubnames_table* table;
@@ -1042,7 +1610,7 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
     }
 
   map->clear();
-  if (!table->read_section(object, symbols, symbols_size))
+  if (!table->read_section(this->object_, symbols, symbols_size))
     return NULL;
 
   while (table->read_header(section_offset))
@@ -1057,30 +1625,26 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
 // Wrapper for map_pubtable_to_dies
 
 void
-Gdb_index::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
-                                          Relobj* object,
-                                          const unsigned char* symbols,
-                                          off_t symbols_size)
+Gdb_index_scan::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
+					       const unsigned char* symbols,
+					       off_t symbols_size)
 {
-  // This is a new object, so reset the relevant variables.
-  this->pubnames_object_ = object;
+  this->pubnames_mapped_ = true;
   this->stmt_list_offset_ = -1;
 
-  delete this->pubnames_table_;
   this->pubnames_table_
       = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubnames, dwinfo,
-                                   object, symbols, symbols_size);
-  delete this->pubtypes_table_;
+				   symbols, symbols_size);
   this->pubtypes_table_
       = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubtypes, dwinfo,
-                                   object, symbols, symbols_size);
+				   symbols, symbols_size);
 }
 
 // Given a cu_offset, find the associated section of the pubnames
 // table.
 
 off_t
-Gdb_index::find_pubname_offset(off_t cu_offset)
+Gdb_index_scan::find_pubname_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubname_map_.find(cu_offset);
   if (it != this->cu_pubname_map_.end())
@@ -1092,7 +1656,7 @@ Gdb_index::find_pubname_offset(off_t cu_offset)
 // table.
 
 off_t
-Gdb_index::find_pubtype_offset(off_t cu_offset)
+Gdb_index_scan::find_pubtype_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubtype_map_.find(cu_offset);
   if (it != this->cu_pubtype_map_.end())
@@ -1102,6 +1666,169 @@ Gdb_index::find_pubtype_offset(off_t cu_offset)
 
 // Scan a .debug_info or .debug_types input section.
 
+void
+Gdb_index_scan::scan_section(bool is_type_unit,
+			     const unsigned char* symbols,
+			     off_t symbols_size,
+			     unsigned int shndx,
+			     unsigned int reloc_shndx,
+			     unsigned int reloc_type)
+{
+  Gdb_index_info_reader dwinfo(is_type_unit, this->object_,
+			       symbols, symbols_size,
+			       shndx, reloc_shndx,
+			       reloc_type, this);
+  if (!this->pubnames_mapped_)
+    this->map_pubnames_and_types_to_dies(&dwinfo, symbols, symbols_size);
+  dwinfo.parse();
+}
+
+// Scan the sections recorded by add_section.  We need the symbol
+// table to interpret the relocations, so find it again here.
+
+void
+Gdb_index_scan::scan_sections()
+{
+  Relobj* object = this->object_;
+  const unsigned char* symbols = NULL;
+  section_size_type symbols_size = 0;
+  for (unsigned int i = 0; i < object->shnum(); ++i)
+    {
+      if (object->section_type(i) == elfcpp::SHT_SYMTAB)
+	{
+	  symbols = object->section_contents(i, &symbols_size, false);
+	  break;
+	}
+    }
+
+  for (std::vector<Section>::const_iterator p = this->sections_.begin();
+       p != this->sections_.end();
+       ++p)
+    this->scan_section(p->is_type_unit, symbols, symbols_size, p->shndx,
+		       p->reloc_shndx, p->reloc_type);
+  this->sections_.clear();
+}
+
+// Add a symbol.
+
+void
+Gdb_index_scan::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
+{
+  std::pair<Symbol_map::iterator, bool> ins =
+    this->symbol_map_.insert(std::make_pair(std::string(sym_name),
+					    this->symbols_.size()));
+  if (ins.second)
+    {
+      // New symbol.  The name we keep is the key of the map entry,
+      // which does not move.
+      const char* name = ins.first->first.c_str();
+      unsigned int hash = mapped_index_string_hash(
+	  reinterpret_cast<const unsigned char*>(name));
+      this->symbols_.push_back(Symbol(name, hash));
+    }
+
+  // Add the CU index to the vector list for this symbol,
+  // if it's not already on the list.  We only need to
+  // check the last added entry.
+  Gdb_index::Cu_vector* cu_vec = &this->symbols_[ins.first->second].cu_vector;
+  if (cu_vec->size() == 0
+      || cu_vec->back().first != cu_index
+      || cu_vec->back().second != flags)
+    cu_vec->push_back(std::make_pair(cu_index, flags));
+}
+
+// Add a .debug_names entry.
+
+void
+Gdb_index_scan::add_name(const char* name, unsigned int tag,
+			 unsigned int cu_index, off_t die_offset)
+{
+  std::pair<Symbol_map::iterator, bool> ins =
+    this->name_map_.insert(std::make_pair(std::string(name),
+					  this->names_.size()));
+  if (ins.second)
+    this->names_.push_back(Name(ins.first->first.c_str()));
+  this->names_[ins.first->second].entries.push_back(
+      Name_entry(tag, cu_index, die_offset));
+}
+
+// Class Gdb_index_scan_task.
+
+// We can run when we can lock the object.
+
+Task_token*
+Gdb_index_scan_task::is_runnable()
+{
+  if (this->scan_->object()->is_locked())
+    return this->scan_->object()->token();
+  return NULL;
+}
+
+// We hold the blocker until we are done, and lock the object.
+
+void
+Gdb_index_scan_task::locks(Task_locker* tl)
+{
+  tl->add(this, this->blocker_);
+  Task_token* token = this->scan_->object()->token();
+  if (token != NULL)
+    tl->add(this, token);
+}
+
+// Scan the sections, and merge what we found into the index.
+
+void
+Gdb_index_scan_task::run(Workqueue*)
+{
+  this->scan_->scan_sections();
+  this->scan_->object()->release();
+  this->gdb_index_->scan_done(this->scan_);
+}
+
+// Class Gdb_index.
+
+// Construct the .gdb_index section.
+
+Gdb_index::Gdb_index(Output_section* gdb_index_section)
+  : Output_section_data(4),
+    gdb_index_section_(gdb_index_section),
+    comp_units_(),
+    type_units_(),
+    ranges_(),
+    cu_vector_list_(),
+    cu_vector_offsets_(NULL),
+    stringpool_(),
+    tu_offset_(0),
+    addr_offset_(0),
+    symtab_offset_(0),
+    cu_pool_offset_(0),
+    stringpool_offset_(0),
+    scans_(),
+    next_merge_(0),
+    merge_lock_(),
+    debug_names_(NULL)
+{
+  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+}
+
+Gdb_index::~Gdb_index()
+{
+  // Free the memory used by the symbol table.
+  delete this->gdb_symtab_;
+  // Free the memory used by the CU vectors.
+  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
+    delete this->cu_vector_list_[i];
+  // Free any scans we did not merge.
+  for (unsigned int i = this->next_merge_; i < this->scans_.size(); ++i)
+    delete this->scans_[i];
+}
+
+// Scan a .debug_info or .debug_types input section.  The sections of
+// an object are passed to us one after another, so they all go into
+// the last scan.  When running with threads, we only record the
+// section here, if we have a symbol table that the task can find
+// again.
+
 void
 Gdb_index::scan_debug_info(bool is_type_unit,
 			   Relobj* object,
@@ -1111,22 +1838,168 @@ Gdb_index::scan_debug_info(bool is_type_unit,
 			   unsigned int reloc_shndx,
 			   unsigned int reloc_type)
 {
-  Gdb_index_info_reader dwinfo(is_type_unit, object,
-			       symbols, symbols_size,
-			       shndx, reloc_shndx,
-			       reloc_type, this);
-  if (object != this->pubnames_object_)
-    map_pubnames_and_types_to_dies(&dwinfo, object, symbols, symbols_size);
-  dwinfo.parse();
+  Gdb_index_scan* scan;
+  if (this->next_merge_ < this->scans_.size()
+      && this->scans_.back()->object() == object)
+    scan = this->scans_.back();
+  else
+    {
+      // We are done with the previous object.  If we have already
+      // scanned it, merge it now to free the memory.
+      if (this->next_merge_ < this->scans_.size()
+	  && !this->scans_.back()->has_sections())
+	this->scan_done(this->scans_.back());
+      scan = new Gdb_index_scan(object);
+      this->scans_.push_back(scan);
+    }
+
+  if (parameters->options().threads()
+      && symbols != NULL
+      && !parameters->incremental())
+    scan->add_section(is_type_unit, shndx, reloc_shndx, reloc_type);
+  else
+    scan->scan_section(is_type_unit, symbols, symbols_size, shndx,
+		       reloc_shndx, reloc_type);
 }
 
-// Add a symbol.
+// Queue a task for each object with sections recorded by
+// scan_debug_info.
+
+void
+Gdb_index::queue_scan_tasks(Workqueue* workqueue, Task_token* blocker)
+{
+  // If the last object was scanned as it was laid out, we have not
+  // merged it yet.  Do that now, so that all the names are known
+  // before the .debug_str section is sized.
+  if (this->next_merge_ < this->scans_.size()
+      && !this->scans_.back()->has_sections())
+    this->scan_done(this->scans_.back());
+
+  // Once the first task runs, it may merge and free the scans after
+  // it, including those we scanned without a task.  So collect the
+  // scans to queue before queuing any of them.
+  std::vector<Gdb_index_scan*> to_queue;
+  {
+    Hold_lock hl(this->merge_lock_);
+    for (unsigned int i = this->next_merge_; i < this->scans_.size(); ++i)
+      if (this->scans_[i]->has_sections())
+	to_queue.push_back(this->scans_[i]);
+  }
+
+  for (std::vector<Gdb_index_scan*>::const_iterator p = to_queue.begin();
+       p != to_queue.end();
+       ++p)
+    {
+      workqueue->add_blocker(blocker);
+      workqueue->queue(new Gdb_index_scan_task(this, *p, blocker));
+    }
+}
+
+// Record that SCAN is complete, and merge the complete scans at the
+// front of the list.
 
 void
-Gdb_index::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
+Gdb_index::scan_done(Gdb_index_scan* scan)
+{
+  Hold_lock hl(this->merge_lock_);
+  scan->set_done();
+  while (this->next_merge_ < this->scans_.size()
+	 && this->scans_[this->next_merge_]->is_done())
+    {
+      Gdb_index_scan* next = this->scans_[this->next_merge_];
+      this->merge_scan(next);
+      delete next;
+      this->scans_[this->next_merge_] = NULL;
+      ++this->next_merge_;
+    }
+}
+
+// Add the units, address ranges and symbols found by SCAN, adjusting
+// the CU and TU indexes to follow those already in the index.  This
+// adds the symbols in the same order, with the same CU vectors, as
+// scanning the sections one after another would.
+
+void
+Gdb_index::merge_scan(Gdb_index_scan* scan)
+{
+  const int cu_base = this->comp_units_.size();
+  const int tu_base = this->type_units_.size();
+
+  this->comp_units_.insert(this->comp_units_.end(),
+			   scan->comp_units().begin(),
+			   scan->comp_units().end());
+  this->type_units_.insert(this->type_units_.end(),
+			   scan->type_units().begin(),
+			   scan->type_units().end());
+
+  for (std::vector<Per_cu_range_list>::const_iterator p =
+	 scan->ranges().begin();
+       p != scan->ranges().end();
+       ++p)
+    {
+      int cu_index = static_cast<int>(p->cu_index);
+      cu_index = cu_index < 0 ? cu_index - tu_base : cu_index + cu_base;
+      this->ranges_.push_back(Per_cu_range_list(p->object, cu_index,
+						p->ranges));
+    }
+
+  // The .debug_names section has the same list of CUs, so the same
+  // CU indexes.
+  if (this->debug_names_ != NULL)
+    {
+      for (std::vector<Comp_unit>::const_iterator p =
+	     scan->comp_units().begin();
+	   p != scan->comp_units().end();
+	   ++p)
+	this->debug_names_->add_comp_unit(p->cu_offset);
+
+      for (Gdb_index_scan::Names::const_iterator p = scan->names().begin();
+	   p != scan->names().end();
+	   ++p)
+	{
+	  for (std::vector<Gdb_index_scan::Name_entry>::const_iterator q =
+		 p->entries.begin();
+	       q != p->entries.end();
+	       ++q)
+	    this->debug_names_->add_entry(p->name, q->tag,
+					  q->cu_index + cu_base,
+					  q->die_offset);
+	}
+    }
+
+  // We do not need the symbols if we are only generating the
+  // .debug_names section.
+  if (this->gdb_index_section_ == NULL)
+    {
+      Gdb_index_info_reader::add_stats(scan);
+      return;
+    }
+
+  for (Gdb_index_scan::Symbols::const_iterator p = scan->symbols().begin();
+       p != scan->symbols().end();
+       ++p)
+    {
+      Cu_vector* cu_vec = this->add_symbol(p->name, p->hashval);
+      for (Cu_vector::const_iterator q = p->cu_vector.begin();
+	   q != p->cu_vector.end();
+	   ++q)
+	{
+	  int cu_index = q->first < 0 ? q->first - tu_base : q->first + cu_base;
+	  if (cu_vec->size() == 0
+	      || cu_vec->back().first != cu_index
+	      || cu_vec->back().second != q->second)
+	    cu_vec->push_back(std::make_pair(cu_index, q->second));
+	}
+    }
+
+  Gdb_index_info_reader::add_stats(scan);
+}
+
+// Add a symbol.
+
+Gdb_index::Cu_vector*
+Gdb_index::add_symbol(const char* sym_name, unsigned int hash)
 {
-  unsigned int hash = mapped_index_string_hash(
-      reinterpret_cast<const unsigned char*>(sym_name));
   Gdb_symbol* sym = new Gdb_symbol();
   this->stringpool_.add(sym_name, true, &sym->name_key);
   sym->hashval = hash;
@@ -1146,35 +2019,7 @@ Gdb_index::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
       delete sym;
     }
 
-  // Add the CU index to the vector list for this symbol,
-  // if it's not already on the list.  We only need to
-  // check the last added entry.
-  Cu_vector* cu_vec = this->cu_vector_list_[found->cu_vector_index];
-  if (cu_vec->size() == 0
-      || cu_vec->back().first != cu_index
-      || cu_vec->back().second != flags)
-    cu_vec->push_back(std::make_pair(cu_index, flags));
-}
-
-// Return TRUE if we have already processed the pubnames associated
-// with the statement list at the given OFFSET.
-
-bool
-Gdb_index::pubnames_read(const Relobj* object, off_t offset)
-{
-  bool ret = (this->pubnames_object_ == object
-	      && this->stmt_list_offset_ == offset);
-  return ret;
-}
-
-// Record that we have processed the pubnames associated with the
-// statement list for OBJECT at the given OFFSET.
-
-void
-Gdb_index::set_pubnames_read(const Relobj* object, off_t offset)
-{
-  this->pubnames_object_ = object;
-  this->stmt_list_offset_ = offset;
+  return this->cu_vector_list_[found->cu_vector_index];
 }
 
 // Set the size of the .gdb_index section.
@@ -1182,7 +2027,15 @@ Gdb_index::set_pubnames_read(const Relobj* object, off_t offset)
 void
 Gdb_index::set_final_data_size()
 {
-  // Finalize the string pool.
+  // Merge the last scan, if we scanned it without a task.  Any tasks
+  // have finished by now.
+  while (this->next_merge_ < this->scans_.size())
+    {
+      gold_assert(!this->scans_[this->next_merge_]->has_sections());
+      this->scan_done(this->scans_[this->next_merge_]);
+    }
+
+// Finalize the string pool.
   this->stringpool_.set_string_offsets();
 
   // Compute the total size of the CU vectors.
@@ -1348,11 +2201,277 @@ Gdb_index::do_write(Output_file* of)
   of->write_output_view(off, oview_size, oview);
 }
 
+// Class Debug_names.
+
+// The version of the .debug_names section.
+const int debug_names_version = 5;
+
+// The size of the .debug_names header, not counting the unit length
+// and the (empty) augmentation string.
+const int debug_names_hdr_size = 2 + 2 + 7 * 4;
+
+// The hash function for the .debug_names section, which is the DJB
+// hash function applied to the case-folded name.
+
+static uint32_t
+debug_names_hash(const char* name)
+{
+  uint32_t h = 5381;
+  for (const unsigned char* p = reinterpret_cast<const unsigned char*>(name);
+       *p != '\0';
+       ++p)
+    {
+      unsigned char c = *p;
+      if (c >= 'A' && c <= 'Z')
+	c += 'a' - 'A';
+      h = h * 33 + c;
+    }
+  return h;
+}
+
+Debug_names::Debug_names(Output_section* debug_str_section)
+  : Output_section_data(4),
+    debug_str_section_(debug_str_section),
+    stringpool_(),
+    debug_str_data_(NULL),
+    comp_units_(),
+    names_(),
+    name_map_(),
+    abbrev_tags_(),
+    abbrev_codes_(),
+    bucket_count_(0),
+    name_order_(),
+    abbrev_table_size_(0),
+    entry_offsets_(),
+    entry_pool_size_(0)
+{
+  this->debug_str_data_ = new Output_data_strtab(&this->stringpool_);
+}
+
+// Add an entry for NAME.
+
+void
+Debug_names::add_entry(const char* name, unsigned int tag,
+		       unsigned int cu_index, uint64_t die_offset)
+{
+  std::pair<Unordered_map<unsigned int, unsigned int>::iterator, bool> ins =
+    this->abbrev_codes_.insert(std::make_pair(tag,
+					      this->abbrev_tags_.size() + 1));
+  if (ins.second)
+    this->abbrev_tags_.push_back(tag);
+  unsigned int abbrev_code = ins.first->second;
+
+  Stringpool::Key key;
+  name = this->stringpool_.add(name, true, &key);
+  std::pair<Unordered_map<Stringpool::Key, unsigned int>::iterator, bool>
+    nins = this->name_map_.insert(std::make_pair(key, this->names_.size()));
+  if (nins.second)
+    this->names_.push_back(Name(key, debug_names_hash(name)));
+  this->names_[nins.first->second].entries.push_back(
+      Entry(abbrev_code, cu_index, die_offset));
+}
+
+// Sort names by bucket, then by hash value.  Names with the same
+// hash value stay in the order they were first seen.
+
+bool
+Debug_names::Name_less::operator()(unsigned int i, unsigned int j) const
+{
+  uint32_t hi = this->names_[i].hashval;
+  uint32_t hj = this->names_[j].hashval;
+  unsigned int bi = hi % this->bucket_count_;
+  unsigned int bj = hj % this->bucket_count_;
+  if (bi != bj)
+    return bi < bj;
+  if (hi != hj)
+    return hi < hj;
+  return i < j;
+}
+
+// Set the size of the section, and the layout of the entry pool.
+
+void
+Debug_names::set_final_data_size()
+{
+  const unsigned int name_count = this->names_.size();
+
+  // Use the same number of buckets as LLVM: one for each name in a
+  // small index, one for every two names in a medium one, and one for
+  // every four names above 1024 names.
+  if (name_count > 1024)
+    this->bucket_count_ = name_count / 4;
+  else if (name_count > 16)
+    this->bucket_count_ = name_count / 2;
+  else
+    this->bucket_count_ = name_count > 0 ? name_count : 1;
+
+  this->name_order_.resize(name_count);
+  for (unsigned int i = 0; i < name_count; ++i)
+    this->name_order_[i] = i;
+  std::sort(this->name_order_.begin(), this->name_order_.end(),
+	    Name_less(this->names_, this->bucket_count_));
+
+  // Each abbreviation is the code, the tag, the DW_IDX_compile_unit
+  // and DW_IDX_die_offset attributes and their forms, and two zeros.
+  // The table ends with a zero.
+  this->abbrev_table_size_ = 1;
+  for (unsigned int i = 0; i < this->abbrev_tags_.size(); ++i)
+    this->abbrev_table_size_ +=
+      (get_length_as_unsigned_LEB_128(i + 1)
+       + get_length_as_unsigned_LEB_128(this->abbrev_tags_[i])
+       + 4 + 2);
+
+  // Each entry is the abbreviation code, the CU index, and a 4-byte
+  // DIE offset.  The entries for each name end with a zero.
+  this->entry_offsets_.resize(name_count);
+  unsigned int entry_pool_size = 0;
+  for (unsigned int i = 0; i < name_count; ++i)
+    {
+      this->entry_offsets_[i] = entry_pool_size;
+      const Name& name(this->names_[this->name_order_[i]]);
+      for (std::vector<Entry>::const_iterator p = name.entries.begin();
+	   p != name.entries.end();
+	   ++p)
+	entry_pool_size += (get_length_as_unsigned_LEB_128(p->abbrev_code)
+			    + get_length_as_unsigned_LEB_128(p->cu_index)
+			    + 4);
+      ++entry_pool_size;
+    }
+  this->entry_pool_size_ = entry_pool_size;
+
+  off_t data_size = (4 + debug_names_hdr_size
+		     + 4 * this->comp_units_.size()
+		     + 4 * this->bucket_count_
+		     + 3 * 4 * name_count
+		     + this->abbrev_table_size_
+		     + this->entry_pool_size_);
+  this->set_data_size(data_size);
+}
+
+// Write the section.
+
+void
+Debug_names::do_write(Output_file* of)
+{
+  if (parameters->target().is_big_endian())
+    this->do_sized_write<true>(of);
+  else
+    this->do_sized_write<false>(of);
+}
+
+template<bool big_endian>
+void
+Debug_names::do_sized_write(Output_file* of)
+{
+  const off_t off = this->offset();
+  const off_t oview_size = this->data_size();
+  unsigned char* const oview = of->get_output_view(off, oview_size);
+  unsigned char* pov = oview;
+  const unsigned int name_count = this->names_.size();
+
+  // The names were added to the end of the .debug_str section.
+  gold_assert(this->debug_str_data_->is_offset_valid());
+  const off_t str_offset = (this->debug_str_data_->offset()
+			    - this->debug_str_section_->offset());
+
+  // Write the header.
+  elfcpp::Swap<32, big_endian>::writeval(pov, oview_size - 4);
+  elfcpp::Swap<16, big_endian>::writeval(pov + 4, debug_names_version);
+  elfcpp::Swap<16, big_endian>::writeval(pov + 6, 0);
+  elfcpp::Swap<32, big_endian>::writeval(pov + 8, this->comp_units_.size());
+  elfcpp::Swap<32, big_endian>::writeval(pov + 12, 0);
+  elfcpp::Swap<32, big_endian>::writeval(pov + 16, 0);
+  elfcpp::Swap<32, big_endian>::writeval(pov + 20, this->bucket_count_);
+  elfcpp::Swap<32, big_endian>::writeval(pov + 24, name_count);
+  elfcpp::Swap<32, big_endian>::writeval(pov + 28, this->abbrev_table_size_);
+  elfcpp::Swap<32, big_endian>::writeval(pov + 32, 0);
+  pov += 4 + debug_names_hdr_size;
+
+  // Write the list of CUs.
+  for (unsigned int i = 0; i < this->comp_units_.size(); ++i)
+    {
+      elfcpp::Swap<32, big_endian>::writeval(pov, this->comp_units_[i]);
+      pov += 4;
+    }
+
+  // Write the hash buckets.  Each holds the 1-based index of the
+  // first name in the bucket, or zero if the bucket is empty.
+  unsigned char* const buckets = pov;
+  memset(buckets, 0, 4 * this->bucket_count_);
+  pov += 4 * this->bucket_count_;
+  for (unsigned int i = name_count; i > 0; --i)
+    {
+      uint32_t hashval = this->names_[this->name_order_[i - 1]].hashval;
+      elfcpp::Swap<32, big_endian>::writeval(
+	  buckets + 4 * (hashval % this->bucket_count_), i);
+    }
+
+  // Write the hash values, the string offsets, and the entry offsets.
+  unsigned char* const hashes = pov;
+  unsigned char* const str_offsets = hashes + 4 * name_count;
+  unsigned char* const entry_offsets = str_offsets + 4 * name_count;
+  for (unsigned int i = 0; i < name_count; ++i)
+    {
+      const Name& name(this->names_[this->name_order_[i]]);
+      elfcpp::Swap<32, big_endian>::writeval(hashes + 4 * i, name.hashval);
+      elfcpp::Swap<32, big_endian>::writeval(
+	  str_offsets + 4 * i,
+	  str_offset + this->stringpool_.get_offset_from_key(name.name_key));
+      elfcpp::Swap<32, big_endian>::writeval(entry_offsets + 4 * i,
+					     this->entry_offsets_[i]);
+    }
+  pov += 3 * 4 * name_count;
+
+  // Write the abbreviation table and the entry pool.
+  std::vector<unsigned char> data;
+  data.reserve(this->abbrev_table_size_ + this->entry_pool_size_);
+  for (unsigned int i = 0; i < this->abbrev_tags_.size(); ++i)
+    {
+      write_unsigned_LEB_128(&data, i + 1);
+      write_unsigned_LEB_128(&data, this->abbrev_tags_[i]);
+      write_unsigned_LEB_128(&data, elfcpp::DW_IDX_compile_unit);
+      write_unsigned_LEB_128(&data, elfcpp::DW_FORM_udata);
+      write_unsigned_LEB_128(&data, elfcpp::DW_IDX_die_offset);
+      write_unsigned_LEB_128(&data, elfcpp::DW_FORM_ref4);
+      data.push_back(0);
+      data.push_back(0);
+    }
+  data.push_back(0);
+  gold_assert(data.size() == this->abbrev_table_size_);
+
+  for (unsigned int i = 0; i < name_count; ++i)
+    {
+      const Name& name(this->names_[this->name_order_[i]]);
+      gold_assert(data.size() - this->abbrev_table_size_
+		  == this->entry_offsets_[i]);
+      for (std::vector<Entry>::const_iterator p = name.entries.begin();
+	   p != name.entries.end();
+	   ++p)
+	{
+	  write_unsigned_LEB_128(&data, p->abbrev_code);
+	  write_unsigned_LEB_128(&data, p->cu_index);
+	  unsigned char buf[4];
+	  elfcpp::Swap_unaligned<32, big_endian>::writeval(buf, p->die_offset);
+	  data.insert(data.end(), buf, buf + 4);
+	}
+      data.push_back(0);
+    }
+  gold_assert(data.size()
+	      == this->abbrev_table_size_ + this->entry_pool_size_);
+  memcpy(pov, &data[0], data.size());
+  pov += data.size();
+
+  gold_assert(pov - oview == oview_size);
+
+  of->write_output_view(off, oview_size, oview);
+}
+
 // Print usage statistics.
 void
 Gdb_index::print_stats()
 {
-  if (parameters->options().gdb_index())
+  if (parameters->options().gdb_index()
+      || parameters->options().debug_names())
     Gdb_index_info_reader::print_stats();
 }
 
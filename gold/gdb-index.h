@@ -27,6 +27,7 @@
 #include "output.h"
 #include "mapfile.h"
 #include "stringpool.h"
+#include "gold-threads.h"
 
 #ifndef GOLD_GDB_INDEX_H
 #define GOLD_GDB_INDEX_H
@@ -42,12 +43,18 @@ class Sized_relobj;
 class Dwarf_range_list;
 template <typename T>
 class Gdb_hashtab;
-class Gdb_index_info_reader;
-class Dwarf_pubnames_table;
+class Gdb_index_scan;
+class Workqueue;
+class Task_token;
+class Debug_names;
 
 // This class manages the .gdb_index section, which is a fast
 // lookup table for DWARF information used by the gdb debugger.
 // The format of this section is described in gdb/doc/gdb.texinfo.
+// The same scan of the debug info also provides the entries of the
+// .debug_names section, when there is one.  If we are only
+// generating .debug_names, GDB_INDEX_SECTION is NULL and this is
+// not added to any output section.
 
 class Gdb_index : public Output_section_data
 {
@@ -56,7 +63,46 @@ class Gdb_index : public Output_section_data
 
   ~Gdb_index();
 
-  // Scan a .debug_info or .debug_types input section.
+  // An entry in the compilation unit list.
+  struct Comp_unit
+  {
+    Comp_unit(off_t off, off_t len)
+      : cu_offset(off), cu_length(len)
+    { }
+    uint64_t cu_offset;
+    uint64_t cu_length;
+  };
+
+  // An entry in the type unit list.
+  struct Type_unit
+  {
+    Type_unit(off_t off, off_t toff, uint64_t sig)
+      : tu_offset(off), type_offset(toff), type_signature(sig)
+    { }
+    uint64_t tu_offset;
+    uint64_t type_offset;
+    uint64_t type_signature;
+  };
+
+  // An entry in the address range list.
+  struct Per_cu_range_list
+  {
+    Per_cu_range_list(Relobj* obj, uint32_t index, Dwarf_range_list* r)
+      : object(obj), cu_index(index), ranges(r)
+    { }
+    Relobj* object;
+    uint32_t cu_index;
+    Dwarf_range_list* ranges;
+  };
+
+  // The list of CUs and TUs that refer to a symbol, with the
+  // gdb_index version 7 flags for each.  A negative index refers to
+  // a TU.
+  typedef std::vector<std::pair<int, uint8_t> > Cu_vector;
+
+  // Scan a .debug_info or .debug_types input section.  When running
+  // with threads, this only records the section, and the scan is done
+  // later by a task queued by queue_scan_tasks.
   void scan_debug_info(bool is_type_unit,
 		       Relobj* object,
 		       const unsigned char* symbols,
@@ -65,64 +111,22 @@ class Gdb_index : public Output_section_data
 		       unsigned int reloc_shndx,
 		       unsigned int reloc_type);
 
-  // Add a compilation unit.
-  int
-  add_comp_unit(off_t cu_offset, off_t cu_length)
-  {
-    this->comp_units_.push_back(Comp_unit(cu_offset, cu_length));
-    return this->comp_units_.size() - 1;
-  }
-
-  // Add a type unit.
-  int
-  add_type_unit(off_t tu_offset, off_t type_offset, uint64_t signature)
-  {
-    this->type_units_.push_back(Type_unit(tu_offset, type_offset, signature));
-    return this->type_units_.size() - 1;
-  }
-
-  // Add an address range.
+  // Queue a task for each input object whose sections were recorded
+  // by scan_debug_info.  BLOCKER is held until the tasks are done.
   void
-  add_address_range_list(Relobj* object, unsigned int cu_index,
-			 Dwarf_range_list* ranges)
-  {
-    this->ranges_.push_back(Per_cu_range_list(object, cu_index, ranges));
-  }
+  queue_scan_tasks(Workqueue* workqueue, Task_token* blocker);
 
-  // Add a symbol.  FLAGS are the gdb_index version 7 flags to be stored in
-  // the high-byte of the cu_index field.
+  // Record that SCAN is complete, and merge it and any following
+  // complete scans into the index.  Scans are merged in the order of
+  // the calls to scan_debug_info, so the output does not depend on
+  // the order in which the tasks run.
   void
-  add_symbol(int cu_index, const char* sym_name, uint8_t flags);
-
-  // Return the offset into the pubnames table for the cu at the given
-  // offset.
-  off_t
-  find_pubname_offset(off_t cu_offset);
-
-  // Return the offset into the pubtypes table for the cu at the
-  // given offset.
-  off_t
-  find_pubtype_offset(off_t cu_offset);
-
-  // Return TRUE if we have already processed the pubnames and types
-  // set for OBJECT of the CUs and TUS associated with the statement
-  // list at OFFSET.
-  bool
-  pubnames_read(const Relobj* object, off_t offset);
-
-  // Record that we have already read the pubnames associated with
-  // OBJECT and OFFSET.
-  void
-  set_pubnames_read(const Relobj* object, off_t offset);
-
-  // Return a pointer to the given table.
-  Dwarf_pubnames_table*
-  pubnames_table()
-  { return pubnames_table_; }
+  scan_done(Gdb_index_scan* scan);
 
-  Dwarf_pubnames_table*
-  pubtypes_table()
-  { return pubtypes_table_; }
+  // Set the .debug_names section data to fill in from the scans.
+  void
+  set_debug_names(Debug_names* debug_names)
+  { this->debug_names_ = debug_names; }
 
   // Print usage statistics.
   static void
@@ -148,54 +152,7 @@ class Gdb_index : public Output_section_data
   do_print_to_mapfile(Mapfile* mapfile) const
   { mapfile->print_output_data(this, _("** gdb_index")); }
 
-  // Create a map from dies to pubnames.
-  Dwarf_pubnames_table*
-  map_pubtable_to_dies(unsigned int attr,
-                       Gdb_index_info_reader* dwinfo,
-                       Relobj* object,
-                       const unsigned char* symbols,
-                       off_t symbols_size);
-
-  // Wrapper for map_pubtable_to_dies
-  void
-  map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
-                                 Relobj* object,
-                                 const unsigned char* symbols,
-                                 off_t symbols_size);
-
  private:
-  // An entry in the compilation unit list.
-  struct Comp_unit
-  {
-    Comp_unit(off_t off, off_t len)
-      : cu_offset(off), cu_length(len)
-    { }
-    uint64_t cu_offset;
-    uint64_t cu_length;
-  };
-
-  // An entry in the type unit list.
-  struct Type_unit
-  {
-    Type_unit(off_t off, off_t toff, uint64_t sig)
-      : tu_offset(off), type_offset(toff), type_signature(sig)
-    { }
-    uint64_t tu_offset;
-    uint64_t type_offset;
-    uint64_t type_signature;
-  };
-
-  // An entry in the address range list.
-  struct Per_cu_range_list
-  {
-    Per_cu_range_list(Relobj* obj, uint32_t index, Dwarf_range_list* r)
-      : object(obj), cu_index(index), ranges(r)
-    { }
-    Relobj* object;
-    uint32_t cu_index;
-    Dwarf_range_list* ranges;
-  };
-
   // A symbol table entry.
   struct Gdb_symbol
   {
@@ -214,22 +171,14 @@ class Gdb_index : public Output_section_data
     { return this->name_key == symbol->name_key; }
   };
 
-  typedef std::vector<std::pair<int, uint8_t> > Cu_vector;
-
-  typedef Unordered_map<off_t, off_t> Pubname_offset_map;
-  Pubname_offset_map cu_pubname_map_;
-  Pubname_offset_map cu_pubtype_map_;
+  // Add the symbol SYM_NAME, whose hash value is HASH, if it is not
+  // already in the symbol table, and return its CU vector.
+  Cu_vector*
+  add_symbol(const char* sym_name, unsigned int hash);
 
-  // Scan the given pubtable and build a map of the various dies it
-  // refers to, so we can process the entries when we encounter the
-  // die.
+  // Add the units, address ranges and symbols found by SCAN.
   void
-  map_pubtable_to_dies(Dwarf_pubnames_table* table,
-                       Pubname_offset_map* map);
-
-  // Tables to store the pubnames section of the current object.
-  Dwarf_pubnames_table* pubnames_table_;
-  Dwarf_pubnames_table* pubtypes_table_;
+  merge_scan(Gdb_index_scan* scan);
 
   // The .gdb_index section.
   Output_section* gdb_index_section_;
@@ -253,10 +202,136 @@ class Gdb_index : public Output_section_data
   off_t symtab_offset_;
   off_t cu_pool_offset_;
   off_t stringpool_offset_;
-  // Object, stmt list offset of the CUs and TUs associated with the
-  // last read pubnames and pubtypes sections.
-  const Relobj* pubnames_object_;
-  off_t stmt_list_offset_;
+  // The scans of the input objects, in the order they were laid out.
+  // Entries before NEXT_MERGE_ have been merged and freed.
+  std::vector<Gdb_index_scan*> scans_;
+  // The index in SCANS_ of the next scan to merge.
+  unsigned int next_merge_;
+  // Lock held while merging scans.
+  Lock merge_lock_;
+  // The .debug_names section data, or NULL.
+  Debug_names* debug_names_;
+};
+
+// This class manages the DWARF 5 .debug_names section.  We write a
+// single name index covering all the compilation units, with one
+// abbreviation for each DIE tag.  The names themselves go into a
+// string table which we add to the end of the .debug_str section.
+
+class Debug_names : public Output_section_data
+{
+ public:
+  Debug_names(Output_section* debug_str_section);
+
+  // Return the string table to add to the .debug_str section.
+  Output_data_strtab*
+  debug_str_data() const
+  { return this->debug_str_data_; }
+
+  // Add a compilation unit at CU_OFFSET in the output .debug_info
+  // section, and return its index.
+  unsigned int
+  add_comp_unit(uint64_t cu_offset)
+  {
+    this->comp_units_.push_back(cu_offset);
+    return this->comp_units_.size() - 1;
+  }
+
+  // Add an entry for NAME: the DIE with tag TAG at DIE_OFFSET within
+  // compilation unit CU_INDEX.
+  void
+  add_entry(const char* name, unsigned int tag, unsigned int cu_index,
+	    uint64_t die_offset);
+
+ protected:
+  // This is called to update the section size prior to assigning
+  // the address and file offset.
+  void
+  update_data_size()
+  { this->set_final_data_size(); }
+
+  // Set the final data size.
+  void
+  set_final_data_size();
+
+  // Write the data to the file.
+  void
+  do_write(Output_file*);
+
+  // Write to a map file.
+  void
+  do_print_to_mapfile(Mapfile* mapfile) const
+  { mapfile->print_output_data(this, _("** debug_names")); }
+
+ private:
+  // An entry in the entry pool.
+  struct Entry
+  {
+    Entry(unsigned int code, unsigned int cu, uint64_t off)
+      : abbrev_code(code), cu_index(cu), die_offset(off)
+    { }
+    unsigned int abbrev_code;
+    unsigned int cu_index;
+    uint64_t die_offset;
+  };
+
+  // A name in the name table.
+  struct Name
+  {
+    Name(Stringpool::Key key, uint32_t hash)
+      : name_key(key), hashval(hash), entries()
+    { }
+    Stringpool::Key name_key;
+    uint32_t hashval;
+    std::vector<Entry> entries;
+  };
+
+  // Sort names by bucket, then by hash value.
+  struct Name_less
+  {
+    Name_less(const std::vector<Name>& names, unsigned int bucket_count)
+      : names_(names), bucket_count_(bucket_count)
+    { }
+
+    bool
+    operator()(unsigned int i, unsigned int j) const;
+
+    const std::vector<Name>& names_;
+    unsigned int bucket_count_;
+  };
+
+  // Write the section for the target endianness.
+  template<bool big_endian>
+  void
+  do_sized_write(Output_file*);
+
+  // The output .debug_str section.
+  Output_section* debug_str_section_;
+  // The names, as added to the .debug_str section.
+  Stringpool stringpool_;
+  Output_data_strtab* debug_str_data_;
+  // The offsets of the compilation units in .debug_info.
+  std::vector<uint64_t> comp_units_;
+  // The names, in the order they were first seen.
+  std::vector<Name> names_;
+  // Map from the name key to the index in NAMES_.
+  Unordered_map<Stringpool::Key, unsigned int> name_map_;
+  // The tag for each abbreviation code, starting with code 1.
+  std::vector<unsigned int> abbrev_tags_;
+  // Map from tag to abbreviation code.
+  Unordered_map<unsigned int, unsigned int> abbrev_codes_;
+  // The following are set by set_final_data_size.
+  // The number of hash buckets.
+  unsigned int bucket_count_;
+  // The indexes in NAMES_, in the order we write them.
+  std::vector<unsigned int> name_order_;
+  // The size of the abbreviation table.
+  unsigned int abbrev_table_size_;
+  // The offset of the entries for each name, in the same order as
+  // NAME_ORDER_, relative to the start of the entry pool.
+  std::vector<uint32_t> entry_offsets_;
+  // The size of the entry pool.
+  unsigned int entry_pool_size_;
 };
 
 } // End namespace gold.
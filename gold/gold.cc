@@ -59,6 +59,16 @@ process_incremental_input(Incremental_binary*, unsigned int, Input_objects*,
 			  Symbol_table*, Layout*, Dirsearch*, Mapfile*,
 			  Task_token*, Task_token*);
 
+static void
+queue_middle_icf_tasks(const General_options&, const Task*,
+		       const Input_objects*, Symbol_table*, Layout*,
+		       Workqueue*, Mapfile*);
+
+static void
+queue_middle_layout_tasks(const General_options&, const Task*,
+			  const Input_objects*, Symbol_table*, Layout*,
+			  Workqueue*, Mapfile*);
+
 void
 gold_exit(Exit_status status)
 {
@@ -134,6 +144,72 @@ Middle_runner::run(Workqueue* workqueue, const Task* task)
 		     this->layout_, workqueue, this->mapfile_);
 }
 
+// This class arranges to run the rest of the middle of the link after
+// the garbage collection marking has been done by tasks.
+
+class Middle_icf_runner : public Task_function_runner
+{
+ public:
+  Middle_icf_runner(const General_options& options,
+		    const Input_objects* input_objects,
+		    Symbol_table* symtab,
+		    Layout* layout, Mapfile* mapfile)
+    : options_(options), input_objects_(input_objects), symtab_(symtab),
+      layout_(layout), mapfile_(mapfile)
+  { }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  const General_options& options_;
+  const Input_objects* input_objects_;
+  Symbol_table* symtab_;
+  Layout* layout_;
+  Mapfile* mapfile_;
+};
+
+void
+Middle_icf_runner::run(Workqueue* workqueue, const Task* task)
+{
+  queue_middle_icf_tasks(this->options_, task, this->input_objects_,
+			 this->symtab_, this->layout_, workqueue,
+			 this->mapfile_);
+}
+
+// This class arranges to run the rest of the middle of the link after
+// identical code folding has been done by tasks.
+
+class Middle_layout_runner : public Task_function_runner
+{
+ public:
+  Middle_layout_runner(const General_options& options,
+		       const Input_objects* input_objects,
+		       Symbol_table* symtab,
+		       Layout* layout, Mapfile* mapfile)
+    : options_(options), input_objects_(input_objects), symtab_(symtab),
+      layout_(layout), mapfile_(mapfile)
+  { }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  const General_options& options_;
+  const Input_objects* input_objects_;
+  Symbol_table* symtab_;
+  Layout* layout_;
+  Mapfile* mapfile_;
+};
+
+void
+Middle_layout_runner::run(Workqueue* workqueue, const Task* task)
+{
+  queue_middle_layout_tasks(this->options_, task, this->input_objects_,
+			    this->symtab_, this->layout_, workqueue,
+			    this->mapfile_);
+}
+
 // This class arranges the tasks to process the relocs for garbage collection.
 
 class Gc_runner : public Task_function_runner
@@ -231,7 +307,16 @@ queue_initial_tasks(const General_options& options,
   if (ibase == NULL)
     {
       // Normal link.  Queue a Read_symbols task for each input file
-      // on the command line.
+      // on the command line.  With --prefetch-inputs, first ask the
+      // system to start reading the files, since the tasks open
+      // them one after another.
+      if (options.prefetch_inputs())
+	for (Command_line::const_iterator p = cmdline.begin();
+	     p != cmdline.end();
+	     ++p)
+	  if (p->is_file())
+	    Input_file::prefetch_argument(&p->file());
+
       for (Command_line::const_iterator p = cmdline.begin();
 	   p != cmdline.end();
 	   ++p)
@@ -283,6 +368,10 @@ queue_initial_tasks(const General_options& options,
       && (options.gc_sections() || options.icf_enabled()))
     gold_error(_("cannot mix -r with --gc-sections or --icf"));
 
+  // Add any symbols which the last input files deferred.
+  this_blocker = Resolve_symbols::queue_if_needed(workqueue, symtab,
+						  this_blocker);
+
   if (options.gc_sections() || options.icf_enabled())
     {
       workqueue->queue(new Task_function(new Gc_runner(options,
@@ -522,17 +611,70 @@ queue_middle_tasks(const General_options& options,
       symtab->gc_mark_undef_symbols(layout);
       gold_assert(symtab->gc() != NULL);
       // Do a transitive closure on all references to determine the worklist.
-      symtab->gc()->do_transitive_closure();
+      // With threads, this is done by tasks, and the rest of the middle
+      // tasks are queued when they are done.
+      if (parameters->options().threads())
+	{
+	  symtab->gc()->queue_transitive_closure(
+	      workqueue, input_objects,
+	      new Middle_icf_runner(options, input_objects, symtab, layout,
+				    mapfile));
+	  return;
+	}
+      symtab->gc()->do_transitive_closure(input_objects);
     }
 
+  queue_middle_icf_tasks(options, task, input_objects, symtab, layout,
+			 workqueue, mapfile);
+}
+
+// Queue up the rest of the middle set of tasks, once garbage
+// collection is done.
+
+static void
+queue_middle_icf_tasks(const General_options& options,
+		       const Task* task,
+		       const Input_objects* input_objects,
+		       Symbol_table* symtab,
+		       Layout* layout,
+		       Workqueue* workqueue,
+		       Mapfile* mapfile)
+{
   // If identical code folding (--icf) is chosen it makes sense to do it
   // only after garbage collection (--gc-sections) as we do not want to
   // be folding sections that will be garbage.
   if (parameters->options().icf_enabled())
     {
+      // With threads, the sections are compared by tasks, and the
+      // rest of the middle tasks are queued when they are done.
+      if (parameters->options().threads())
+	{
+	  symtab->icf()->queue_find_identical_sections(
+	      workqueue, input_objects, symtab,
+	      new Middle_layout_runner(options, input_objects, symtab,
+				       layout, mapfile));
+	  return;
+	}
       symtab->icf()->find_identical_sections(input_objects, symtab);
     }
 
+  queue_middle_layout_tasks(options, task, input_objects, symtab, layout,
+			    workqueue, mapfile);
+}
+
+// Queue up the rest of the middle set of tasks, once garbage
+// collection and identical code folding are done.
+
+static void
+queue_middle_layout_tasks(const General_options& options,
+			  const Task* task,
+			  const Input_objects* input_objects,
+			  Symbol_table* symtab,
+			  Layout* layout,
+			  Workqueue* workqueue,
+			  Mapfile* mapfile)
+{
+
   // Call Object::layout for the second time to determine the
   // output_sections for all referenced input sections.  When
   // --gc-sections or --icf is turned on, or when certain input
@@ -771,6 +913,10 @@ queue_middle_tasks(const General_options& options,
 	}
     }
 
+  // Scan the debug info for the .gdb_index section.  The layout task
+  // waits for these tasks too.
+  layout->queue_gdb_index_tasks(workqueue, this_blocker);
+
   // When all those tasks are complete, we can start laying out the
   // output file.
   workqueue->queue(new Task_function(new Layout_task_runner(options,
@@ -870,17 +1016,26 @@ queue_final_tasks(const General_options& options,
     }
   else
     {
+      // Postprocess the sections, such as compressing debug
+      // sections, in parallel tasks once all the input sections have
+      // been written, and then write them out.
       Task_token* new_final_blocker = new Task_token(true);
       new_final_blocker->add_blocker();
-      Task* t = new Write_after_input_sections_task(layout, of,
-						    final_blocker,
-						    new_final_blocker);
-      workqueue->queue(t);
+      workqueue->queue(new Task_function(
+			 new Postprocessing_task_runner(layout, of,
+							new_final_blocker),
+			 final_blocker,
+			 "Task_function Postprocessing_task_runner"));
       final_blocker = new_final_blocker;
     }
 
-  // Create tasks for tree-style build ID computation, if necessary.
-  if (strcmp(options.build_id(), "tree") == 0)
+  // Create tasks for tree-style, xxhash or chunked build ID
+  // computation, if necessary.
+  if (strcmp(options.build_id(), "tree") == 0
+      || strcmp(options.build_id(), "xxhash") == 0
+      || (options.build_id_chunked()
+	  && (strcmp(options.build_id(), "md5") == 0
+	      || strcmp(options.build_id(), "sha1") == 0)))
     {
       // Queue a task to compute the build id.  This will be blocked by
       // FINAL_BLOCKER, and will in turn schedule the task to close
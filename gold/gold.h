@@ -262,24 +262,51 @@ is_cident(const char* name)
 	  == '\0');
 }
 
+// Compute a hash code for the LENGTH bytes at P.  Computing hash
+// codes of strings is a significant user of CPU time in the linker,
+// so this is a pointer to a function chosen at startup for the
+// processor we are running on.  Every implementation computes the
+// same hash code, so that nothing which depends on the hash codes
+// varies from one host to another.  This is defined in hash.cc.
+extern size_t (*hash_bytes)(const void* p, size_t length);
+
+// The portable implementation of hash_bytes.
+extern size_t
+hash_bytes_portable(const void* p, size_t length);
+
+// Return the name of the implementation of hash_bytes in use.
+extern const char*
+hash_bytes_implementation();
+
+// Compute the SHA-1 digest of the LENGTH bytes at P into the 20 bytes
+// at RESULT.  This computes the same digest as sha1_buffer in
+// libiberty, but uses the SHA instructions when the processor has
+// them, which makes hashing a large output file for --build-id=sha1
+// several times faster.  This is defined in hash.cc.
+extern void
+sha1_digest(const void* p, size_t length, unsigned char* result);
+
+// Return the name of the implementation of sha1_digest in use.
+extern const char*
+sha1_digest_implementation();
+
+// Compute the 128-bit XXH3 hash of the LENGTH bytes at P into the 16
+// bytes at RESULT, in the canonical big endian order used by xxHash.
+// This is a fast non-cryptographic hash used for --build-id=xxhash.
+// This is defined in hash.cc.
+extern void
+xxhash128_digest(const void* p, size_t length, unsigned char* result);
+
 // We sometimes need to hash strings.  Ideally we should use std::tr1::hash or
 // __gnu_cxx::hash on some systems but there is no guarantee that either
-// one is available.  For portability, we define simple string hash functions.
+// one is available, and they are slow for the long mangled names we
+// see.  We use hash_bytes.
 
 template<typename Char_type>
 inline size_t
 string_hash(const Char_type* s, size_t length)
 {
-  // This is the hash function used by the dynamic linker for
-  // DT_GNU_HASH entries.  I compared this to a Fowler/Noll/Vo hash
-  // for a C++ program with 385,775 global symbols.  This hash
-  // function was very slightly worse.  However, it is much faster to
-  // compute.  Overall wall clock time was a win.
-  const unsigned char* p = reinterpret_cast<const unsigned char*>(s);
-  size_t h = 5381;
-  for (size_t i = 0; i < length * sizeof(Char_type); ++i)
-    h = h * 33 + *p++;
-  return h;
+  return hash_bytes(s, length * sizeof(Char_type));
 }
 
 // Same as above except we expect the string to be zero terminated.
@@ -288,15 +315,10 @@ template<typename Char_type>
 inline size_t
 string_hash(const Char_type* s)
 {
-  const unsigned char* p = reinterpret_cast<const unsigned char*>(s);
-  size_t h = 5381;
-  for (size_t i = 0; s[i] != 0; ++i)
-    {
-      for (size_t j = 0; j < sizeof(Char_type); j++)
-	h = h * 33 + *p++;
-    }
-
-  return h;
+  size_t length = 0;
+  while (s[length] != 0)
+    ++length;
+  return string_hash(s, length);
 }
 
 // Return whether STRING contains a wildcard character.  This is used
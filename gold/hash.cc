@@ -0,0 +1,850 @@
+// hash.cc -- compute hash codes for gold
+
+// Copyright (C) 2017 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <cstring>
+
+#include "elfcpp_swap.h"
+#include "sha1.h"
+
+// The hash code is the CRC-32C (Castagnoli) checksum of the bytes.
+// When the processor supports SSE4.2 we use the crc32 instruction,
+// which handles eight bytes at a time.  Otherwise we use a table
+// driven implementation which also handles eight bytes at a time.
+// The two always compute the same value.  We used to use the hash
+// function used by the dynamic linker for DT_GNU_HASH, which handles
+// one byte at a time; for the long mangled names in C++ programs this
+// is much slower.
+
+#if defined(__GNUC__) \
+    && (defined(__i386__) || defined(__x86_64__)) \
+    && GCC_VERSION >= 4009
+#define HAVE_SSE42_CRC32 1
+#endif
+
+// The SHA instructions compute the SHA-1 compression function four
+// rounds at a time.  We use them for sha1_digest when the processor
+// has them.
+
+#if defined(__GNUC__) \
+    && (defined(__i386__) || defined(__x86_64__)) \
+    && GCC_VERSION >= 5000
+#define HAVE_SHA_NI 1
+#endif
+
+// When the processor has AVX2 we use it in the XXH3 loop over long
+// inputs, which then handles 32 bytes at a time.
+
+#if defined(__GNUC__) \
+    && (defined(__i386__) || defined(__x86_64__)) \
+    && GCC_VERSION >= 4009
+#define HAVE_AVX2_XXH3 1
+#endif
+
+#ifdef HAVE_SHA_NI
+#include <cpuid.h>
+#endif
+
+#if defined(HAVE_SHA_NI) || defined(HAVE_AVX2_XXH3)
+#include <immintrin.h>
+#endif
+
+namespace gold
+{
+
+// The CRC-32C polynomial, bit reversed.
+
+static const uint32_t crc32c_poly = 0x82f63b78;
+
+// The tables used by the portable implementation.  Entry I of
+// crc32c_table[0] is the CRC of the single byte I; entry I of
+// crc32c_table[N] is the CRC of the byte I followed by N zero bytes.
+
+static uint32_t crc32c_table[8][256];
+
+static void
+init_crc32c_table()
+{
+  for (unsigned int i = 0; i < 256; ++i)
+    {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; ++j)
+	crc = (crc >> 1) ^ ((crc & 1) ? crc32c_poly : 0);
+      crc32c_table[0][i] = crc;
+    }
+  for (unsigned int i = 0; i < 256; ++i)
+    {
+      uint32_t crc = crc32c_table[0][i];
+      for (int n = 1; n < 8; ++n)
+	{
+	  crc = (crc >> 8) ^ crc32c_table[0][crc & 0xff];
+	  crc32c_table[n][i] = crc;
+	}
+    }
+}
+
+// Return the little endian 32-bit value at P.  We don't use
+// elfcpp::Swap here because P need not be aligned.
+
+static inline uint32_t
+read_le32(const unsigned char* p)
+{
+  return (static_cast<uint32_t>(p[0])
+	  | (static_cast<uint32_t>(p[1]) << 8)
+	  | (static_cast<uint32_t>(p[2]) << 16)
+	  | (static_cast<uint32_t>(p[3]) << 24));
+}
+
+// The portable implementation.  This is the standard "slicing by
+// eight" algorithm.
+
+size_t
+hash_bytes_portable(const void* pv, size_t length)
+{
+  const unsigned char* p = static_cast<const unsigned char*>(pv);
+  uint32_t crc = 0xffffffff;
+  while (length >= 8)
+    {
+      uint32_t lo = crc ^ read_le32(p);
+      uint32_t hi = read_le32(p + 4);
+      crc = (crc32c_table[7][lo & 0xff]
+	     ^ crc32c_table[6][(lo >> 8) & 0xff]
+	     ^ crc32c_table[5][(lo >> 16) & 0xff]
+	     ^ crc32c_table[4][lo >> 24]
+	     ^ crc32c_table[3][hi & 0xff]
+	     ^ crc32c_table[2][(hi >> 8) & 0xff]
+	     ^ crc32c_table[1][(hi >> 16) & 0xff]
+	     ^ crc32c_table[0][hi >> 24]);
+      p += 8;
+      length -= 8;
+    }
+  while (length > 0)
+    {
+      crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *p) & 0xff];
+      ++p;
+      --length;
+    }
+  return ~crc;
+}
+
+#ifdef HAVE_SSE42_CRC32
+
+// The SSE4.2 implementation.  The crc32 instruction reads its operand
+// as a little endian value, which is the order in which the bytes
+// appear in memory, so this matches the portable implementation.
+
+__attribute__ ((target ("sse4.2")))
+static size_t
+hash_bytes_sse42(const void* pv, size_t length)
+{
+  const unsigned char* p = static_cast<const unsigned char*>(pv);
+#ifdef __x86_64__
+  unsigned long long crc64 = 0xffffffff;
+  while (length >= 8)
+    {
+      unsigned long long v;
+      memcpy(&v, p, 8);
+      crc64 = __builtin_ia32_crc32di(crc64, v);
+      p += 8;
+      length -= 8;
+    }
+  unsigned int crc = crc64;
+#else
+  unsigned int crc = 0xffffffff;
+#endif
+  while (length >= 4)
+    {
+      unsigned int v;
+      memcpy(&v, p, 4);
+      crc = __builtin_ia32_crc32si(crc, v);
+      p += 4;
+      length -= 4;
+    }
+  if (length >= 2)
+    {
+      unsigned short v;
+      memcpy(&v, p, 2);
+      crc = __builtin_ia32_crc32hi(crc, v);
+      p += 2;
+      length -= 2;
+    }
+  if (length > 0)
+    crc = __builtin_ia32_crc32qi(crc, *p);
+  return static_cast<uint32_t>(~crc);
+}
+
+#endif // defined(HAVE_SSE42_CRC32)
+
+// The name of the implementation in use.
+
+static const char* hash_bytes_name = "portable";
+
+// Pick the implementation of hash_bytes.  This is normally called by
+// a static constructor, before any threads are started, but
+// hash_bytes_first makes sure it has been called in case a static
+// constructor elsewhere needs a hash code first.
+
+static size_t
+hash_bytes_first(const void*, size_t);
+
+size_t (*hash_bytes)(const void*, size_t) = hash_bytes_first;
+
+static void
+init_hash_bytes()
+{
+  if (hash_bytes != hash_bytes_first)
+    return;
+
+  init_crc32c_table();
+  hash_bytes = hash_bytes_portable;
+
+#ifdef HAVE_SSE42_CRC32
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.2"))
+    {
+      hash_bytes = hash_bytes_sse42;
+      hash_bytes_name = "sse4.2";
+    }
+#endif
+}
+
+static size_t
+hash_bytes_first(const void* p, size_t length)
+{
+  init_hash_bytes();
+  return hash_bytes(p, length);
+}
+
+const char*
+hash_bytes_implementation()
+{
+  init_hash_bytes();
+  return hash_bytes_name;
+}
+
+#ifdef HAVE_SHA_NI
+
+// Whether the processor has the SHA instructions, and the SSSE3 and
+// SSE4.1 instructions which we use with them.
+
+static bool have_sha_ni;
+
+static void
+init_sha_ni()
+{
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)
+      || (ecx & bit_SSSE3) == 0
+      || (ecx & bit_SSE4_1) == 0
+      || __get_cpuid_max(0, NULL) < 7)
+    return;
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  have_sha_ni = (ebx & (1U << 29)) != 0;
+}
+
+// Four rounds of SHA-1 in round group G, which is a constant from 0
+// to 19.  E_CUR holds E for these rounds, and E_NEXT is set to the
+// value from which the next group gets E.  The message schedule for
+// later groups is computed as we go, in MSG[(G + 1) % 4] through
+// MSG[(G + 3) % 4].
+
+#define SHA1_ROUND_GROUP(g, e_cur, e_next)				\
+  do									\
+    {									\
+      if ((g) == 0)							\
+	e_cur = _mm_add_epi32(e_cur, msg[0]);				\
+      else								\
+	e_cur = _mm_sha1nexte_epu32(e_cur, msg[(g) % 4]);		\
+      e_next = abcd;							\
+      if ((g) >= 3 && (g) <= 18)					\
+	msg[((g) + 1) % 4] = _mm_sha1msg2_epu32(msg[((g) + 1) % 4],	\
+						msg[(g) % 4]);		\
+      abcd = _mm_sha1rnds4_epu32(abcd, e_cur, (g) / 5);		\
+      if ((g) >= 1 && (g) <= 16)					\
+	msg[((g) + 3) % 4] = _mm_sha1msg1_epu32(msg[((g) + 3) % 4],	\
+						msg[(g) % 4]);		\
+      if ((g) >= 2 && (g) <= 17)					\
+	msg[((g) + 2) % 4] = _mm_xor_si128(msg[((g) + 2) % 4],		\
+					   msg[(g) % 4]);		\
+    }									\
+  while (0)
+
+// Run the SHA-1 compression function over the COUNT 64-byte blocks
+// at P, updating STATE.
+
+__attribute__ ((target ("sha,sse4.1")))
+static void
+sha1_blocks_sha_ni(uint32_t state[5], const unsigned char* p, size_t count)
+{
+  const __m128i byte_swap = _mm_set_epi64x(0x0001020304050607ULL,
+					   0x08090a0b0c0d0e0fULL);
+  __m128i abcd = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+  abcd = _mm_shuffle_epi32(abcd, 0x1b);
+  __m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+  __m128i e1;
+
+  for (; count > 0; --count, p += 64)
+    {
+      const __m128i abcd_save = abcd;
+      const __m128i e_save = e0;
+
+      __m128i msg[4];
+      for (int i = 0; i < 4; ++i)
+	msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(
+				    reinterpret_cast<const __m128i*>(p + 16 * i)),
+				  byte_swap);
+
+      SHA1_ROUND_GROUP(0, e0, e1);
+      SHA1_ROUND_GROUP(1, e1, e0);
+      SHA1_ROUND_GROUP(2, e0, e1);
+      SHA1_ROUND_GROUP(3, e1, e0);
+      SHA1_ROUND_GROUP(4, e0, e1);
+      SHA1_ROUND_GROUP(5, e1, e0);
+      SHA1_ROUND_GROUP(6, e0, e1);
+      SHA1_ROUND_GROUP(7, e1, e0);
+      SHA1_ROUND_GROUP(8, e0, e1);
+      SHA1_ROUND_GROUP(9, e1, e0);
+      SHA1_ROUND_GROUP(10, e0, e1);
+      SHA1_ROUND_GROUP(11, e1, e0);
+      SHA1_ROUND_GROUP(12, e0, e1);
+      SHA1_ROUND_GROUP(13, e1, e0);
+      SHA1_ROUND_GROUP(14, e0, e1);
+      SHA1_ROUND_GROUP(15, e1, e0);
+      SHA1_ROUND_GROUP(16, e0, e1);
+      SHA1_ROUND_GROUP(17, e1, e0);
+      SHA1_ROUND_GROUP(18, e0, e1);
+      SHA1_ROUND_GROUP(19, e1, e0);
+
+      e0 = _mm_sha1nexte_epu32(e0, e_save);
+      abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+
+  abcd = _mm_shuffle_epi32(abcd, 0x1b);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state), abcd);
+  state[4] = _mm_extract_epi32(e0, 3);
+}
+
+#undef SHA1_ROUND_GROUP
+
+// Compute the SHA-1 digest using the SHA instructions.  This follows
+// the padding in FIPS 180-4: a single 0x80 byte, zero bytes to make
+// the length 56 modulo 64, and the length in bits as a 64-bit big
+// endian number.
+
+static void
+sha1_digest_sha_ni(const void* pv, size_t length, unsigned char* result)
+{
+  const unsigned char* p = static_cast<const unsigned char*>(pv);
+  uint32_t state[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476,
+			0xc3d2e1f0 };
+
+  size_t full = length / 64;
+  sha1_blocks_sha_ni(state, p, full);
+
+  unsigned char tail[128];
+  size_t rest = length - full * 64;
+  memcpy(tail, p + full * 64, rest);
+  tail[rest] = 0x80;
+  size_t tail_len = rest + 1 + 8 <= 64 ? 64 : 128;
+  memset(tail + rest + 1, 0, tail_len - rest - 1);
+  uint64_t bits = static_cast<uint64_t>(length) * 8;
+  for (int i = 0; i < 8; ++i)
+    tail[tail_len - 1 - i] = static_cast<unsigned char>(bits >> (i * 8));
+  sha1_blocks_sha_ni(state, tail, tail_len / 64);
+
+  for (int i = 0; i < 5; ++i)
+    {
+      result[i * 4] = state[i] >> 24;
+      result[i * 4 + 1] = state[i] >> 16;
+      result[i * 4 + 2] = state[i] >> 8;
+      result[i * 4 + 3] = state[i];
+    }
+}
+
+#endif // defined(HAVE_SHA_NI)
+
+// Compute the SHA-1 digest of LENGTH bytes at P.
+
+void
+sha1_digest(const void* p, size_t length, unsigned char* result)
+{
+#ifdef HAVE_SHA_NI
+  if (have_sha_ni)
+    {
+      sha1_digest_sha_ni(p, length, result);
+      return;
+    }
+#endif
+  sha1_buffer(static_cast<const char*>(p), length, result);
+}
+
+// Return the name of the implementation of sha1_digest in use.
+
+const char*
+sha1_digest_implementation()
+{
+#ifdef HAVE_SHA_NI
+  if (have_sha_ni)
+    return "sha";
+#endif
+  return "portable";
+}
+
+// XXH3-128, the 128-bit variant of the third generation xxHash
+// function, with the default secret and a seed of zero.  This is not a
+// cryptographic hash, but it is a good 128-bit hash, and it is many
+// times faster than MD5 or SHA-1.  We use it for --build-id=xxhash.
+// This computes the same value as XXH3_128bits in the xxHash library;
+// see https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md.
+
+static const uint32_t xxh_prime32_1 = 0x9e3779b1U;
+static const uint32_t xxh_prime32_2 = 0x85ebca77U;
+static const uint32_t xxh_prime32_3 = 0xc2b2ae3dU;
+static const uint64_t xxh_prime64_1 = 0x9e3779b185ebca87ULL;
+static const uint64_t xxh_prime64_2 = 0xc2b2ae3d27d4eb4fULL;
+static const uint64_t xxh_prime64_3 = 0x165667b19e3779f9ULL;
+static const uint64_t xxh_prime64_4 = 0x85ebca77c2b2ae63ULL;
+static const uint64_t xxh_prime64_5 = 0x27d4eb2f165667c5ULL;
+static const uint64_t xxh_prime_mx1 = 0x165667919e3779f9ULL;
+static const uint64_t xxh_prime_mx2 = 0x9fb21c651e98df25ULL;
+
+// The default secret.
+
+static const size_t xxh3_secret_size = 192;
+
+static const unsigned char xxh3_secret[xxh3_secret_size] =
+{
+  0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe,
+  0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+  0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+  0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+  0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78,
+  0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+  0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e,
+  0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+  0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+  0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+  0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e,
+  0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+  0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f,
+  0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+  0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+  0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+  0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3,
+  0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+  0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49,
+  0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+  0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+  0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+  0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28,
+  0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+// Long inputs are processed in 64-byte stripes, using 8 more bytes
+// of the secret for each stripe, and the accumulators are scrambled
+// after each block of 16 stripes.
+
+static const size_t xxh3_stripe_len = 64;
+static const size_t xxh3_stripes_per_block = (xxh3_secret_size - 64) / 8;
+static const size_t xxh3_block_len = xxh3_stripe_len * xxh3_stripes_per_block;
+
+// Return the little endian 64-bit value at P.
+
+static inline uint64_t
+read_le64(const unsigned char* p)
+{
+  return (static_cast<uint64_t>(read_le32(p))
+	  | (static_cast<uint64_t>(read_le32(p + 4)) << 32));
+}
+
+// Store V at P as a big endian 64-bit value.
+
+static inline void
+write_be64(unsigned char* p, uint64_t v)
+{
+  for (int i = 7; i >= 0; --i, v >>= 8)
+    p[i] = static_cast<unsigned char>(v);
+}
+
+// Multiply A by B, returning the low 64 bits of the product and
+// setting *HIGH to the high 64 bits.
+
+static inline uint64_t
+mult64to128(uint64_t a, uint64_t b, uint64_t* high)
+{
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+  *high = static_cast<uint64_t>(product >> 64);
+  return static_cast<uint64_t>(product);
+#else
+  uint64_t lo_lo = (a & 0xffffffff) * (b & 0xffffffff);
+  uint64_t hi_lo = (a >> 32) * (b & 0xffffffff);
+  uint64_t lo_hi = (a & 0xffffffff) * (b >> 32);
+  uint64_t hi_hi = (a >> 32) * (b >> 32);
+  uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+  *high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+  return (cross << 32) | (lo_lo & 0xffffffff);
+#endif
+}
+
+// Fold the 128-bit product of A and B into 64 bits.
+
+static inline uint64_t
+mul128_fold64(uint64_t a, uint64_t b)
+{
+  uint64_t high;
+  uint64_t low = mult64to128(a, b, &high);
+  return low ^ high;
+}
+
+static inline uint64_t
+xorshift64(uint64_t v, int shift)
+{ return v ^ (v >> shift); }
+
+static inline uint64_t
+xxh64_avalanche(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= xxh_prime64_2;
+  h ^= h >> 29;
+  h *= xxh_prime64_3;
+  h ^= h >> 32;
+  return h;
+}
+
+static inline uint64_t
+xxh3_avalanche(uint64_t h)
+{
+  h = xorshift64(h, 37);
+  h *= xxh_prime_mx1;
+  return xorshift64(h, 32);
+}
+
+static inline uint64_t
+xxh3_mix16(const unsigned char* p, const unsigned char* secret)
+{
+  return mul128_fold64(read_le64(p) ^ read_le64(secret),
+		       read_le64(p + 8) ^ read_le64(secret + 8));
+}
+
+// Mix 16 bytes at each of P1 and P2 into the accumulator *LOW, *HIGH.
+
+static inline void
+xxh3_mix32(uint64_t* low, uint64_t* high, const unsigned char* p1,
+	   const unsigned char* p2, const unsigned char* secret)
+{
+  *low += xxh3_mix16(p1, secret);
+  *low ^= read_le64(p2) + read_le64(p2 + 8);
+  *high += xxh3_mix16(p2, secret + 16);
+  *high ^= read_le64(p1) + read_le64(p1 + 8);
+}
+
+// Inputs of up to 16 bytes.
+
+static void
+xxh3_128_short(const unsigned char* p, size_t len, uint64_t* low,
+	       uint64_t* high)
+{
+  const unsigned char* secret = xxh3_secret;
+  if (len > 8)
+    {
+      uint64_t bitflipl = read_le64(secret + 32) ^ read_le64(secret + 40);
+      uint64_t bitfliph = read_le64(secret + 48) ^ read_le64(secret + 56);
+      uint64_t input_lo = read_le64(p);
+      uint64_t input_hi = read_le64(p + len - 8);
+      uint64_t m_high;
+      uint64_t m_low = mult64to128(input_lo ^ input_hi ^ bitflipl,
+				   xxh_prime64_1, &m_high);
+      m_low += static_cast<uint64_t>(len - 1) << 54;
+      input_hi ^= bitfliph;
+      m_high += input_hi + ((input_hi & 0xffffffff)
+			    * static_cast<uint64_t>(xxh_prime32_2 - 1));
+      m_low ^= bswap_64(m_high);
+      uint64_t h_high;
+      uint64_t h_low = mult64to128(m_low, xxh_prime64_2, &h_high);
+      h_high += m_high * xxh_prime64_2;
+      *low = xxh3_avalanche(h_low);
+      *high = xxh3_avalanche(h_high);
+    }
+  else if (len >= 4)
+    {
+      uint64_t input64 = (read_le32(p)
+			  + (static_cast<uint64_t>(read_le32(p + len - 4))
+			     << 32));
+      uint64_t bitflip = read_le64(secret + 16) ^ read_le64(secret + 24);
+      uint64_t m_high;
+      uint64_t m_low = mult64to128(input64 ^ bitflip,
+				   xxh_prime64_1 + (len << 2), &m_high);
+      m_high += m_low << 1;
+      m_low ^= m_high >> 3;
+      m_low = xorshift64(m_low, 35);
+      m_low *= xxh_prime_mx2;
+      *low = xorshift64(m_low, 28);
+      *high = xxh3_avalanche(m_high);
+    }
+  else if (len > 0)
+    {
+      uint32_t combinedl = ((static_cast<uint32_t>(p[0]) << 16)
+			    | (static_cast<uint32_t>(p[len >> 1]) << 24)
+			    | static_cast<uint32_t>(p[len - 1])
+			    | (static_cast<uint32_t>(len) << 8));
+      uint32_t swapped = bswap_32(combinedl);
+      uint32_t combinedh = (swapped << 13) | (swapped >> 19);
+      uint64_t bitflipl = read_le32(secret) ^ read_le32(secret + 4);
+      uint64_t bitfliph = read_le32(secret + 8) ^ read_le32(secret + 12);
+      *low = xxh64_avalanche(combinedl ^ bitflipl);
+      *high = xxh64_avalanche(combinedh ^ bitfliph);
+    }
+  else
+    {
+      *low = xxh64_avalanche(read_le64(secret + 64) ^ read_le64(secret + 72));
+      *high = xxh64_avalanche(read_le64(secret + 80) ^ read_le64(secret + 88));
+    }
+}
+
+// Inputs of 17 to 240 bytes.
+
+static void
+xxh3_128_medium(const unsigned char* p, size_t len, uint64_t* low,
+		uint64_t* high)
+{
+  const unsigned char* secret = xxh3_secret;
+  uint64_t acc_low = len * xxh_prime64_1;
+  uint64_t acc_high = 0;
+  if (len <= 128)
+    {
+      if (len > 32)
+	{
+	  if (len > 64)
+	    {
+	      if (len > 96)
+		xxh3_mix32(&acc_low, &acc_high, p + 48, p + len - 64,
+			   secret + 96);
+	      xxh3_mix32(&acc_low, &acc_high, p + 32, p + len - 48,
+			 secret + 64);
+	    }
+	  xxh3_mix32(&acc_low, &acc_high, p + 16, p + len - 32, secret + 32);
+	}
+      xxh3_mix32(&acc_low, &acc_high, p, p + len - 16, secret);
+    }
+  else
+    {
+      for (size_t i = 32; i < 160; i += 32)
+	xxh3_mix32(&acc_low, &acc_high, p + i - 32, p + i - 16,
+		   secret + i - 32);
+      acc_low = xxh3_avalanche(acc_low);
+      acc_high = xxh3_avalanche(acc_high);
+      for (size_t i = 160; i <= len; i += 32)
+	xxh3_mix32(&acc_low, &acc_high, p + i - 32, p + i - 16,
+		   secret + 3 + i - 160);
+      xxh3_mix32(&acc_low, &acc_high, p + len - 16, p + len - 32,
+		 secret + 136 - 17 - 16);
+    }
+  *low = xxh3_avalanche(acc_low + acc_high);
+  *high = -xxh3_avalanche(acc_low * xxh_prime64_1
+			  + acc_high * xxh_prime64_4
+			  + len * xxh_prime64_2);
+}
+
+// Accumulate the COUNT stripes at P into ACC, using the secret
+// starting at SECRET for the first one.  Then, if SCRAMBLE, scramble
+// the accumulators.  The portable implementation.
+
+static void
+xxh3_accumulate_portable(uint64_t* acc, const unsigned char* p,
+			 const unsigned char* secret, size_t count,
+			 bool scramble)
+{
+  for (size_t n = 0; n < count; ++n, p += xxh3_stripe_len, secret += 8)
+    {
+      for (int i = 0; i < 8; ++i)
+	{
+	  uint64_t data_val = read_le64(p + i * 8);
+	  uint64_t data_key = data_val ^ read_le64(secret + i * 8);
+	  acc[i ^ 1] += data_val;
+	  acc[i] += (data_key & 0xffffffff) * (data_key >> 32);
+	}
+    }
+  if (scramble)
+    {
+      const unsigned char* key = xxh3_secret + xxh3_secret_size - 64;
+      for (int i = 0; i < 8; ++i)
+	{
+	  uint64_t a = xorshift64(acc[i], 47) ^ read_le64(key + i * 8);
+	  acc[i] = a * xxh_prime32_1;
+	}
+    }
+}
+
+#ifdef HAVE_AVX2_XXH3
+
+// The AVX2 implementation, which handles half a stripe in each
+// instruction.
+
+__attribute__ ((target ("avx2")))
+static void
+xxh3_accumulate_avx2(uint64_t* acc, const unsigned char* p,
+		     const unsigned char* secret, size_t count,
+		     bool scramble)
+{
+  __m256i acc0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc));
+  __m256i acc1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + 4));
+  for (size_t n = 0; n < count; ++n, p += xxh3_stripe_len, secret += 8)
+    {
+      __m256i data0 =
+	_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      __m256i data1 =
+	_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+      __m256i key0 = _mm256_xor_si256(data0, _mm256_loadu_si256(
+			 reinterpret_cast<const __m256i*>(secret)));
+      __m256i key1 = _mm256_xor_si256(data1, _mm256_loadu_si256(
+			 reinterpret_cast<const __m256i*>(secret + 32)));
+      __m256i product0 = _mm256_mul_epu32(key0, _mm256_srli_epi64(key0, 32));
+      __m256i product1 = _mm256_mul_epu32(key1, _mm256_srli_epi64(key1, 32));
+      acc0 = _mm256_add_epi64(acc0, _mm256_shuffle_epi32(data0, 0x4e));
+      acc1 = _mm256_add_epi64(acc1, _mm256_shuffle_epi32(data1, 0x4e));
+      acc0 = _mm256_add_epi64(acc0, product0);
+      acc1 = _mm256_add_epi64(acc1, product1);
+    }
+  if (scramble)
+    {
+      const unsigned char* key = xxh3_secret + xxh3_secret_size - 64;
+      const __m256i prime = _mm256_set1_epi32(xxh_prime32_1);
+      __m256i* accs[2] = { &acc0, &acc1 };
+      for (int i = 0; i < 2; ++i)
+	{
+	  __m256i a = *accs[i];
+	  a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+	  a = _mm256_xor_si256(a, _mm256_loadu_si256(
+				    reinterpret_cast<const __m256i*>(key
+								     + 32 * i)));
+	  __m256i a_high = _mm256_shuffle_epi32(a, 0x31);
+	  __m256i product_low = _mm256_mul_epu32(a, prime);
+	  __m256i product_high = _mm256_mul_epu32(a_high, prime);
+	  *accs[i] = _mm256_add_epi64(product_low,
+				      _mm256_slli_epi64(product_high, 32));
+	}
+    }
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc), acc0);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + 4), acc1);
+}
+
+#endif // defined(HAVE_AVX2_XXH3)
+
+// The implementation of the long input loop, chosen at startup.
+
+static void (*xxh3_accumulate)(uint64_t*, const unsigned char*,
+			       const unsigned char*, size_t, bool)
+  = xxh3_accumulate_portable;
+
+static uint64_t
+xxh3_merge_accs(const uint64_t* acc, const unsigned char* secret,
+		uint64_t start)
+{
+  uint64_t result = start;
+  for (int i = 0; i < 4; ++i)
+    result += mul128_fold64(acc[2 * i] ^ read_le64(secret + 16 * i),
+			    acc[2 * i + 1] ^ read_le64(secret + 16 * i + 8));
+  return xxh3_avalanche(result);
+}
+
+// Inputs of more than 240 bytes.
+
+static void
+xxh3_128_long(const unsigned char* p, size_t len, uint64_t* low,
+	      uint64_t* high)
+{
+  uint64_t acc[8] =
+  {
+    xxh_prime32_3, xxh_prime64_1, xxh_prime64_2, xxh_prime64_3,
+    xxh_prime64_4, xxh_prime32_2, xxh_prime64_5, xxh_prime32_1
+  };
+
+  size_t blocks = (len - 1) / xxh3_block_len;
+  for (size_t n = 0; n < blocks; ++n)
+    xxh3_accumulate(acc, p + n * xxh3_block_len, xxh3_secret,
+		    xxh3_stripes_per_block, true);
+
+  // The last partial block, and then the last stripe, which may
+  // overlap the stripes before it.
+  size_t stripes = ((len - 1) - blocks * xxh3_block_len) / xxh3_stripe_len;
+  xxh3_accumulate(acc, p + blocks * xxh3_block_len, xxh3_secret, stripes,
+		  false);
+  xxh3_accumulate(acc, p + len - xxh3_stripe_len,
+		  xxh3_secret + xxh3_secret_size - xxh3_stripe_len - 7, 1,
+		  false);
+
+  *low = xxh3_merge_accs(acc, xxh3_secret + 11, len * xxh_prime64_1);
+  *high = xxh3_merge_accs(acc, xxh3_secret + xxh3_secret_size - 64 - 11,
+			  ~(len * xxh_prime64_2));
+}
+
+// Compute the XXH3-128 hash of the LENGTH bytes at P.
+
+void
+xxhash128_digest(const void* pv, size_t length, unsigned char* result)
+{
+  const unsigned char* p = static_cast<const unsigned char*>(pv);
+  uint64_t low;
+  uint64_t high;
+  if (length <= 16)
+    xxh3_128_short(p, length, &low, &high);
+  else if (length <= 240)
+    xxh3_128_medium(p, length, &low, &high);
+  else
+    xxh3_128_long(p, length, &low, &high);
+
+  // This is the canonical representation used by xxHash.
+  write_be64(result, high);
+  write_be64(result + 8, low);
+}
+
+// Pick the implementation of the XXH3 long input loop.
+
+static void
+init_xxh3()
+{
+#ifdef HAVE_AVX2_XXH3
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    xxh3_accumulate = xxh3_accumulate_avx2;
+#endif
+}
+
+// Run init_hash_bytes at startup.
+
+class Init_hash_bytes
+{
+ public:
+  Init_hash_bytes()
+  {
+    init_hash_bytes();
+#ifdef HAVE_SHA_NI
+    init_sha_ni();
+#endif
+    init_xxh3();
+  }
+};
+
+static Init_hash_bytes init_hash_bytes_at_startup;
+
+} // End namespace gold.
@@ -147,72 +147,12 @@
 #include "demangle.h"
 #include "elfcpp.h"
 #include "int_encoding.h"
+#include "md5.h"
+#include "workqueue.h"
 
 namespace gold
 {
 
-// This function determines if a section or a group of identical
-// sections has unique contents.  Such unique sections or groups can be
-// declared final and need not be processed any further.
-// Parameters :
-// ID_SECTION : Vector mapping a section index to a Section_id pair.
-// IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
-//                            sections is already known to be unique.
-// SECTION_CONTENTS : Contains the section's text and relocs to sections
-//                    that cannot be folded.   SECTION_CONTENTS are NULL
-//                    implies that this function is being called for the
-//                    first time before the first iteration of icf.
-
-static void
-preprocess_for_unique_sections(const std::vector<Section_id>& id_section,
-                               std::vector<bool>* is_secn_or_group_unique,
-                               std::vector<std::string>* section_contents)
-{
-  Unordered_map<uint32_t, unsigned int> uniq_map;
-  std::pair<Unordered_map<uint32_t, unsigned int>::iterator, bool>
-    uniq_map_insert;
-
-  for (unsigned int i = 0; i < id_section.size(); i++)
-    {
-      if ((*is_secn_or_group_unique)[i])
-        continue;
-
-      uint32_t cksum;
-      Section_id secn = id_section[i];
-      section_size_type plen;
-      if (section_contents == NULL)
-        {
-          // Lock the object so we can read from it.  This is only called
-          // single-threaded from queue_middle_tasks, so it is OK to lock.
-          // Unfortunately we have no way to pass in a Task token.
-          const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-          Task_lock_obj<Object> tl(dummy_task, secn.first);
-          const unsigned char* contents;
-          contents = secn.first->section_contents(secn.second,
-                                                  &plen,
-                                                  false);
-          cksum = xcrc32(contents, plen, 0xffffffff);
-        }
-      else
-        {
-          const unsigned char* contents_array = reinterpret_cast
-            <const unsigned char*>((*section_contents)[i].c_str());
-          cksum = xcrc32(contents_array, (*section_contents)[i].length(),
-                         0xffffffff);
-        }
-      uniq_map_insert = uniq_map.insert(std::make_pair(cksum, i));
-      if (uniq_map_insert.second)
-        {
-          (*is_secn_or_group_unique)[i] = true;
-        }
-      else
-        {
-          (*is_secn_or_group_unique)[i] = false;
-          (*is_secn_or_group_unique)[uniq_map_insert.first->second] = false;
-        }
-    }
-}
-
 // For SHF_MERGE sections that use REL relocations, the addend is stored in
 // the text section at the relocation offset.  Read  the addend value given
 // the pointer to the addend in the text section and the addend size.
@@ -252,59 +192,484 @@ get_rel_addend(const unsigned char* reloc_addend_ptr,
     }
 }
 
-// This returns the buffer containing the section's contents, both
-// text and relocs.  Relocs are differentiated as those pointing to
-// sections that could be folded and those that cannot.  Only relocs
-// pointing to sections that could be folded are recomputed on
-// subsequent invocations of this function.
-// Parameters  :
-// FIRST_ITERATION    : true if it is the first invocation.
-// SECN               : Section for which contents are desired.
-// SECTION_NUM        : Unique section number of this section.
-// NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
-//                      to ICF sections.
-// KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
-// SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
-//                      sections.
-
-static std::string
-get_section_contents(bool first_iteration,
-                     const Section_id& secn,
-                     unsigned int section_num,
-                     unsigned int* num_tracked_relocs,
-                     Symbol_table* symtab,
-                     const std::vector<unsigned int>& kept_section_id,
-                     std::vector<std::string>* section_contents)
+// During safe icf (--icf=safe), only fold functions that are ctors or dtors.
+// This function returns true if the section name is that of a ctor or a dtor.
+
+static bool
+is_function_ctor_or_dtor(const std::string& section_name)
 {
-  // Lock the object so we can read from it.  This is only called
-  // single-threaded from queue_middle_tasks, so it is OK to lock.
-  // Unfortunately we have no way to pass in a Task token.
-  const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-  Task_lock_obj<Object> tl(dummy_task, secn.first);
+  const char* mangled_func_name = strrchr(section_name.c_str(), '.');
+  gold_assert(mangled_func_name != NULL);
+  if ((is_prefix_of("._ZN", mangled_func_name)
+       || is_prefix_of("._ZZ", mangled_func_name))
+      && (is_gnu_v3_mangled_ctor(mangled_func_name + 1)
+          || is_gnu_v3_mangled_dtor(mangled_func_name + 1)))
+    {
+      return true;
+    }
+  return false;
+}
+
+// The state of one run of find_identical_sections.  The work is done
+// in phases.  The first two phases read the input objects, and may be
+// run in parallel for different objects.  A task only reads the
+// object it has locked: the first phase keeps views of the merge
+// sections of the object, which the relocs of sections in other
+// objects may refer to.  The third phase sorts the sections into
+// classes with identical contents, and may be run in parallel for
+// different buckets of hash codes.  The fourth phase releases the
+// views.  The last phase forms the groups of identical sections.  It
+// only compares the contents classes and the kept sections of the
+// relocs to foldable sections, which are small, but it is not run in
+// parallel: a section is compared using the kept sections as they are
+// when it is visited, so the groups depend on the order in which the
+// sections are visited, and must be the same as when everything is
+// run serially.
+
+class Icf::Section_matcher
+{
+ public:
+  // The number of buckets used to classify the sections.
+  static const unsigned int bucket_count = 64;
+
+  Section_matcher(Icf* icf, const Input_objects* input_objects,
+		  Symbol_table* symtab);
+
+  // The number of relocatable objects.
+  unsigned int
+  object_count() const
+  { return this->objects_.size(); }
+
+  // Return the relocatable object with index OBJECT_INDEX.
+  Relobj*
+  object(unsigned int object_index) const
+  { return this->objects_[object_index].object; }
+
+  // Find the candidate sections in object OBJECT_INDEX, and compute
+  // the checksums of their contents.  Keep views of its merge
+  // sections.  The object must be locked.
+  void
+  find_candidates(unsigned int object_index);
+
+  // Give each candidate section a unique number, and find the
+  // sections whose contents are unique.  This must be called after
+  // find_candidates has been called for every object.
+  void
+  number_candidates();
+
+  // Return whether object OBJECT_INDEX has candidate sections which
+  // summarize_candidates must read.
+  bool
+  object_needs_summary(unsigned int object_index) const;
+
+  // Summarize the contents and relocs of the candidate sections in
+  // object OBJECT_INDEX whose contents are not unique.  The object
+  // must be locked.
+  void
+  summarize_candidates(unsigned int object_index);
+
+  // Release object OBJECT_INDEX at the end of a task which ran
+  // find_candidates, summarize_candidates or release_views.
+  void
+  release_object(unsigned int object_index);
+
+  // Return whether find_candidates or summarize_candidates kept views
+  // of object OBJECT_INDEX.
+  bool
+  object_has_views(unsigned int object_index) const
+  {
+    return (!this->objects_[object_index].views.empty()
+	    || !this->objects_[object_index].merge_sections.empty());
+  }
+
+  // Delete the views of object OBJECT_INDEX which find_candidates and
+  // summarize_candidates kept.  The object must be locked.
+  void
+  release_views(unsigned int object_index);
+
+  // Put the summarized sections into buckets by hash code.
+  void
+  fill_buckets();
+
+  // Sort the sections in BUCKET into classes with identical contents.
+  void
+  classify_bucket(unsigned int bucket);
+
+  // Form the groups of identical sections.  This sets
+  // *NUM_ITERATIONS, and returns whether the groups converged.
+  bool
+  match_sections(unsigned int* num_iterations);
+
+ private:
+  // A view of the contents of a merge section, and its size.
+  typedef std::pair<File_view*, section_size_type> Merge_section;
+
+  // The candidate sections of one relocatable object.
+  struct Object_candidates
+  {
+    Object_candidates(Relobj* objecta)
+      : object(objecta), shndx(), addralign(), cksum(), views(),
+	merge_sections(), first_section(0)
+    { }
+
+    // The object.
+    Relobj* object;
+    // The indexes of the candidate sections.
+    std::vector<unsigned int> shndx;
+    // Their alignments.
+    std::vector<uint64_t> addralign;
+    // The checksums of their contents.
+    std::vector<uint32_t> cksum;
+    // The views of the contents of the sections which
+    // summarize_candidates read.
+    std::vector<File_view*> views;
+    // The merge sections of the object, indexed by section index.
+    // These are read by the tasks which summarize the sections of any
+    // object, so they are only filled in by find_candidates.
+    std::map<unsigned int, Merge_section> merge_sections;
+    // The unique number of the first candidate section.
+    unsigned int first_section;
+  };
+
+  // A reloc of a summarized section, other than the section which is
+  // kept for the target of a reloc to a foldable section.
+  struct Reloc_summary
+  {
+    enum Kind
+    {
+      // A reloc to a symbol which is not in an ordinary section, or
+      // to a symbol in a section which can not be folded.  NAME is
+      // the name of the symbol, or NULL.
+      SYMBOL,
+      // A reloc to the section itself.
+      SELF,
+      // A reloc to a section which might be folded.
+      FOLDABLE,
+      // A reloc to a local symbol in a section which can not be
+      // folded.  OBJECT and SHNDX are the section.
+      LOCAL,
+      // A reloc to a merge section.  LENGTH bytes of the data it
+      // refers to are in the merge_data of the fingerprint.
+      MERGE_DATA
+    };
+
+    Kind kind;
+    // The section index for LOCAL, or the length for MERGE_DATA.
+    unsigned int index;
+    // The symbol name for SYMBOL, or the object for LOCAL.
+    const void* ptr;
+    // The symbol value, addend and offset of the reloc.  These are
+    // zero for MERGE_DATA.
+    uint64_t symvalue;
+    uint64_t addend;
+    uint64_t offset;
+  };
+
+  // What we know about the contents of a summarized section.  The
+  // contents are not copied; CONTENTS points into a view which is kept
+  // until the sections have been classified.  Two sections are only
+  // compared byte for byte when their hash codes are the same.
+  struct Section_fingerprint
+  {
+    Section_fingerprint()
+      : contents(NULL), contents_size(0), relocs(), merge_data()
+    { hash[0] = hash[1] = 0; }
+
+    // The MD5 checksum of the contents and of the reloc summaries.
+    uint64_t hash[2];
+    // The section contents.
+    const unsigned char* contents;
+    section_size_type contents_size;
+    // The relocs, in order.
+    std::vector<Reloc_summary> relocs;
+    // The data referred to by the MERGE_DATA relocs.
+    std::string merge_data;
+  };
+
+  // Summarize the section with unique number SECTION_NUM, whose
+  // contents are in VIEW.
+  void
+  summarize_section(unsigned int section_num, File_view* view,
+		    section_size_type size);
+
+  // Return the contents of merge section SHNDX of OBJECT, and set
+  // *PLEN to its size.
+  const unsigned char*
+  merge_section_contents(const Relobj* object, unsigned int shndx,
+			 section_size_type* plen) const;
+
+  // Return whether sections I and J have the same contents and
+  // reloc summaries.  This is only called if their hash codes are
+  // the same.
+  bool
+  same_contents(unsigned int i, unsigned int j) const;
+
+  // Mark the sections whose contents class has no other member.
+  void
+  preprocess_for_unique_sections();
+
+  // Run iteration ITERATION_NUM of the matching.  Return true if no
+  // section was folded.
+  bool
+  match_iteration(unsigned int iteration_num);
+
+  // The Icf object we are filling in.
+  Icf* icf_;
+  // The symbol table.
+  Symbol_table* symtab_;
+  // The candidate sections of each relocatable object.
+  std::vector<Object_candidates> objects_;
+  // The index in objects_ of each relocatable object.
+  Unordered_map<const Relobj*, unsigned int> object_indexes_;
+  // The remaining vectors are indexed by the unique number of a
+  // section.  The alignment of the section.
+  std::vector<uint64_t> section_addraligns_;
+  // Whether the section, or its group of identical sections, is known
+  // to be unique.  This is not a vector<bool>, since tasks set
+  // different elements at the same time.
+  std::vector<unsigned char> is_secn_or_group_unique_;
+  // The fingerprint of the section's text and relocs, except for the
+  // kept sections of the relocs to foldable sections.  These do not
+  // change from one iteration to the next.
+  std::vector<Section_fingerprint> fingerprints_;
+  // The unique numbers of the foldable sections to which the relocs
+  // of the section refer, in order.
+  std::vector<std::vector<unsigned int> > tracked_relocs_;
+  // The lowest numbered section whose contents are the same as this
+  // section's contents.
+  std::vector<unsigned int> contents_classes_;
+  // The summarized sections in each bucket, in order.
+  std::vector<std::vector<unsigned int> > buckets_;
+};
+
+Icf::Section_matcher::Section_matcher(Icf* icf,
+				      const Input_objects* input_objects,
+				      Symbol_table* symtab)
+  : icf_(icf), symtab_(symtab), objects_(), object_indexes_(),
+    section_addraligns_(), is_secn_or_group_unique_(), fingerprints_(),
+    tracked_relocs_(), contents_classes_(), buckets_()
+{
+  this->objects_.reserve(input_objects->number_of_relobjs());
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      this->object_indexes_[*p] = this->objects_.size();
+      this->objects_.push_back(Object_candidates(*p));
+    }
+}
+
+// Decide which sections of an object are possible candidates, and
+// checksum their contents.  This only reads OBJECT_INDEX itself.  The
+// relocs of a summarized section may refer to a merge section in any
+// object, so this also keeps views of the merge sections, which
+// summarize_section reads without locking their object.
+
+void
+Icf::Section_matcher::find_candidates(unsigned int object_index)
+{
+  Object_candidates& candidates(this->objects_[object_index]);
+  Relobj* object = candidates.object;
+  const Target& target = parameters->target();
+  const bool keep_merge_sections = target.can_icf_inline_merge_sections();
+
+  for (unsigned int i = 0; i < object->shnum(); ++i)
+    {
+      if (keep_merge_sections
+	  && (object->section_flags(i) & elfcpp::SHF_MERGE) != 0)
+	{
+	  section_size_type plen;
+	  File_view* view = object->section_contents_lasting_view(i, &plen);
+	  if (view != NULL)
+	    candidates.merge_sections[i] = Merge_section(view, plen);
+	}
+
+      const std::string section_name = object->section_name(i);
+      if (!is_section_foldable_candidate(section_name))
+	continue;
+      if (!object->is_section_included(i))
+	continue;
+      if (parameters->options().gc_sections()
+	  && this->symtab_->gc()->is_section_garbage(object, i))
+	continue;
+      // With --icf=safe, check if the mangled function name is a ctor
+      // or a dtor.  The mangled function name can be obtained from the
+      // section name by stripping the section prefix.
+      if (parameters->options().icf_safe_folding()
+	  && !is_function_ctor_or_dtor(section_name)
+	  && (!target.can_check_for_function_pointers()
+	      || this->icf_->section_has_function_pointers(object, i)))
+	continue;
+
+      section_size_type plen;
+      const unsigned char* contents = object->section_contents(i, &plen,
+							       false);
+      candidates.shndx.push_back(i);
+      candidates.addralign.push_back(object->section_addralign(i));
+      candidates.cksum.push_back(xcrc32(contents, plen, 0xffffffff));
+    }
+}
+
+// Number the candidate sections in the order of the objects.  A
+// section whose contents have a checksum which no other section has
+// is unique, and need not be processed any further.
+
+void
+Icf::Section_matcher::number_candidates()
+{
+  Unordered_map<uint32_t, unsigned int> uniq_map;
+  std::pair<Unordered_map<uint32_t, unsigned int>::iterator, bool>
+    uniq_map_insert;
+
+  unsigned int section_num = 0;
+  for (std::vector<Object_candidates>::iterator p = this->objects_.begin();
+       p != this->objects_.end();
+       ++p)
+    {
+      p->first_section = section_num;
+      for (unsigned int i = 0; i < p->shndx.size(); ++i)
+	{
+	  Section_id secn(p->object, p->shndx[i]);
+	  this->icf_->id_section_.push_back(secn);
+	  this->icf_->section_id_[secn] = section_num;
+	  this->icf_->kept_section_id_.push_back(section_num);
+	  this->section_addraligns_.push_back(p->addralign[i]);
+
+	  uniq_map_insert = uniq_map.insert(std::make_pair(p->cksum[i],
+							   section_num));
+	  if (uniq_map_insert.second)
+	    this->is_secn_or_group_unique_.push_back(true);
+	  else
+	    {
+	      this->is_secn_or_group_unique_.push_back(false);
+	      this->is_secn_or_group_unique_[uniq_map_insert.first->second] =
+		false;
+	    }
 
-  section_size_type plen;
-  const unsigned char* contents = NULL;
-  if (first_iteration)
-    contents = secn.first->section_contents(secn.second, &plen, false);
+	  ++section_num;
+	}
 
-  // The buffer to hold all the contents including relocs.  A checksum
-  // is then computed on this buffer.
-  std::string buffer;
-  std::string icf_reloc_buffer;
+      // Free the memory, since we no longer need it.
+      std::vector<uint64_t>().swap(p->addralign);
+      std::vector<uint32_t>().swap(p->cksum);
+    }
+
+  this->fingerprints_.resize(section_num);
+  this->tracked_relocs_.resize(section_num);
+  this->contents_classes_.resize(section_num);
+}
 
-  if (num_tracked_relocs)
-    *num_tracked_relocs = 0;
+// Return whether OBJECT_INDEX has candidate sections which are not
+// unique.
+
+bool
+Icf::Section_matcher::object_needs_summary(unsigned int object_index) const
+{
+  const Object_candidates& candidates(this->objects_[object_index]);
+  for (unsigned int i = 0; i < candidates.shndx.size(); ++i)
+    if (!this->is_secn_or_group_unique_[candidates.first_section + i])
+      return true;
+  return false;
+}
+
+// Summarize the sections of OBJECT_INDEX which are not unique.
+
+void
+Icf::Section_matcher::summarize_candidates(unsigned int object_index)
+{
+  Object_candidates& candidates(this->objects_[object_index]);
+  Relobj* object = candidates.object;
+  for (unsigned int i = 0; i < candidates.shndx.size(); ++i)
+    {
+      unsigned int section_num = candidates.first_section + i;
+      if (this->is_secn_or_group_unique_[section_num])
+	continue;
+
+      section_size_type plen;
+      File_view* view =
+	object->section_contents_lasting_view(candidates.shndx[i], &plen);
+      if (view != NULL)
+	candidates.views.push_back(view);
+      this->summarize_section(section_num, view, plen);
+    }
+}
+
+// Release OBJECT_INDEX.  This keeps the lasting views.
+
+void
+Icf::Section_matcher::release_object(unsigned int object_index)
+{
+  this->objects_[object_index].object->release();
+}
+
+// Delete the views of OBJECT_INDEX.
+
+void
+Icf::Section_matcher::release_views(unsigned int object_index)
+{
+  Object_candidates& candidates(this->objects_[object_index]);
+  for (std::vector<File_view*>::iterator p = candidates.views.begin();
+       p != candidates.views.end();
+       ++p)
+    delete *p;
+  std::vector<File_view*>().swap(candidates.views);
+  for (std::map<unsigned int, Merge_section>::iterator p =
+	 candidates.merge_sections.begin();
+       p != candidates.merge_sections.end();
+       ++p)
+    delete p->second.first;
+  candidates.merge_sections.clear();
+}
 
-  Icf::Reloc_info_list& reloc_info_list = 
-    symtab->icf()->reloc_info_list();
+// Return the contents of merge section SHNDX of OBJECT, from the view
+// which find_candidates kept.
+
+const unsigned char*
+Icf::Section_matcher::merge_section_contents(const Relobj* object,
+					     unsigned int shndx,
+					     section_size_type* plen) const
+{
+  Unordered_map<const Relobj*, unsigned int>::const_iterator p =
+    this->object_indexes_.find(object);
+  gold_assert(p != this->object_indexes_.end());
+  const std::map<unsigned int, Merge_section>& merge_sections(
+      this->objects_[p->second].merge_sections);
+  std::map<unsigned int, Merge_section>::const_iterator q =
+    merge_sections.find(shndx);
+  gold_assert(q != merge_sections.end());
+  *plen = q->second.second;
+  return q->second.first->data();
+}
+
+// This computes the fingerprint of the section's contents, both text
+// and relocs.  Relocs are differentiated as those pointing to sections
+// that could be folded and those that cannot.  For a reloc pointing to
+// a section that could be folded, the fingerprint only records where
+// the reloc is; the section it points to is recorded in
+// tracked_relocs_, since the section which is kept for it may change
+// from one iteration to the next.
+
+void
+Icf::Section_matcher::summarize_section(unsigned int section_num,
+					File_view* view,
+					section_size_type plen)
+{
+  const Section_id& secn(this->icf_->id_section_[section_num]);
+  const unsigned char* contents = view != NULL ? view->data() : NULL;
+
+  Section_fingerprint& fingerprint(this->fingerprints_[section_num]);
+  fingerprint.contents = contents;
+  fingerprint.contents_size = plen;
+  std::vector<Reloc_summary>& relocs(fingerprint.relocs);
+  std::vector<unsigned int>& tracked_relocs(
+      this->tracked_relocs_[section_num]);
+
+  Icf::Reloc_info_list& reloc_info_list = this->icf_->reloc_info_list();
 
   Icf::Reloc_info_list::iterator it_reloc_info_list =
     reloc_info_list.find(secn);
 
-  buffer.clear();
-  icf_reloc_buffer.clear();
-
-  // Process relocs and put them into the buffer.
+  // Process relocs and put them into the fingerprint.
 
   if (it_reloc_info_list != reloc_info_list.end())
     {
@@ -325,10 +690,10 @@ get_section_contents(bool first_iteration,
       Icf::Reloc_addend_size_info::const_iterator it_addend_size =
         reloc_addend_size_info.begin();
 
+      relocs.reserve(v.size());
       for (; it_v != v.end(); ++it_v, ++it_s, ++it_a, ++it_o, ++it_addend_size)
         {
-	  if (first_iteration
-	      && it_v->first != NULL)
+	  if (it_v->first != NULL)
 	    {
 	      Symbol_location loc;
 	      loc.object = it_v->first;
@@ -346,53 +711,41 @@ get_section_contents(bool first_iteration,
 		}
 	    }
 
-          // ADDEND_STR stores the symbol value and addend and offset,
-          // each at most 16 hex digits long.  it_a points to a pair
-          // where first is the symbol value and second is the
-          // addend.
-          char addend_str[50];
-
-	  // It would be nice if we could use format macros in inttypes.h
-	  // here but there are not in ISO/IEC C++ 1998.
-          snprintf(addend_str, sizeof(addend_str), "%llx %llx %llux",
-                   static_cast<long long>((*it_a).first),
-		   static_cast<long long>((*it_a).second),
-		   static_cast<unsigned long long>(*it_o));
+	  // it_a points to a pair where first is the symbol value and
+	  // second is the addend.
+	  Reloc_summary reloc;
+	  reloc.kind = Reloc_summary::SYMBOL;
+	  reloc.index = 0;
+	  reloc.ptr = NULL;
+	  reloc.symvalue = it_a->first;
+	  reloc.addend = it_a->second;
+	  reloc.offset = *it_o;
 
 	  // If the symbol pointed to by the reloc is not in an ordinary
 	  // section or if the symbol type is not FROM_OBJECT, then the
 	  // object is NULL.
 	  if (it_v->first == NULL)
             {
-	      if (first_iteration)
-                {
-		  // If the symbol name is available, use it.
-                  if ((*it_s) != NULL)
-                      buffer.append((*it_s)->name());
-                  // Append the addend.
-                  buffer.append(addend_str);
-                  buffer.append("@");
-		}
+	      // If the symbol name is available, use it.
+	      if ((*it_s) != NULL)
+		reloc.ptr = (*it_s)->name();
+	      relocs.push_back(reloc);
 	      continue;
 	    }
 
           Section_id reloc_secn(it_v->first, it_v->second);
 
           // If this reloc turns back and points to the same section,
-          // like a recursive call, use a special symbol to mark this.
+          // like a recursive call, use a special kind to mark this.
           if (reloc_secn.first == secn.first
               && reloc_secn.second == secn.second)
             {
-              if (first_iteration)
-                {
-                  buffer.append("R");
-                  buffer.append(addend_str);
-                  buffer.append("@");
-                }
+	      reloc.kind = Reloc_summary::SELF;
+	      relocs.push_back(reloc);
               continue;
             }
           Icf::Uniq_secn_id_map& section_id_map =
-            symtab->icf()->section_to_int_map();
+            this->icf_->section_to_int_map();
           Icf::Uniq_secn_id_map::iterator section_id_map_it =
             section_id_map.find(reloc_secn);
           bool is_sym_preemptible = (*it_s != NULL
@@ -403,32 +756,19 @@ get_section_contents(bool first_iteration,
               && section_id_map_it != section_id_map.end())
             {
               // This is a reloc to a section that might be folded.
-              if (num_tracked_relocs)
-                (*num_tracked_relocs)++;
-
-              char kept_section_str[10];
-              unsigned int secn_id = section_id_map_it->second;
-              snprintf(kept_section_str, sizeof(kept_section_str), "%u",
-                       kept_section_id[secn_id]);
-              if (first_iteration)
-                {
-                  buffer.append("ICF_R");
-                  buffer.append(addend_str);
-                }
-              icf_reloc_buffer.append(kept_section_str);
-              // Append the addend.
-              icf_reloc_buffer.append(addend_str);
-              icf_reloc_buffer.append("@");
+	      tracked_relocs.push_back(section_id_map_it->second);
+	      reloc.kind = Reloc_summary::FOLDABLE;
+	      relocs.push_back(reloc);
             }
           else
             {
               // This is a reloc to a section that cannot be folded.
-              // Process it only in the first iteration.
-              if (!first_iteration)
-                continue;
-
+	      // The section flags are kept in memory for --icf, and the
+	      // contents of a merge section are read from the view
+	      // which find_candidates kept, so this does not read the
+	      // file of another object.
               uint64_t secn_flags = (it_v->first)->section_flags(it_v->second);
-              // This reloc points to a merge section.  Hash the
+              // This reloc points to a merge section.  Use the
               // contents of this section.
               if ((secn_flags & elfcpp::SHF_MERGE) != 0
 		  && parameters->target().can_icf_inline_merge_sections())
@@ -461,43 +801,40 @@ get_section_contents(bool first_iteration,
                   section_size_type secn_len;
 
                   const unsigned char* str_contents =
-                  (it_v->first)->section_contents(it_v->second,
-                                                  &secn_len,
-                                                  false) + offset;
+		    this->merge_section_contents(it_v->first, it_v->second,
+						 &secn_len) + offset;
 		  gold_assert (offset < (long long) secn_len);
 
+		  size_t len;
                   if ((secn_flags & elfcpp::SHF_STRINGS) != 0)
                     {
                       // String merge section.
-                      const char* str_char =
-                        reinterpret_cast<const char*>(str_contents);
                       switch(entsize)
                         {
                         case 1:
-                          {
-                            buffer.append(str_char);
-                            break;
-                          }
+			  len = strlen(reinterpret_cast<const char*>(
+					 str_contents));
+                          break;
                         case 2:
                           {
                             const uint16_t* ptr_16 =
-                              reinterpret_cast<const uint16_t*>(str_char);
+                              reinterpret_cast<const uint16_t*>(str_contents);
                             unsigned int strlen_16 = 0;
                             // Find the NULL character.
                             while(*(ptr_16 + strlen_16) != 0)
                                 strlen_16++;
-                            buffer.append(str_char, strlen_16 * 2);
+			    len = strlen_16 * 2;
                           }
                           break;
                         case 4:
                           {
                             const uint32_t* ptr_32 =
-                              reinterpret_cast<const uint32_t*>(str_char);
+                              reinterpret_cast<const uint32_t*>(str_contents);
                             unsigned int strlen_32 = 0;
                             // Find the NULL character.
                             while(*(ptr_32 + strlen_32) != 0)
                                 strlen_32++;
-                            buffer.append(str_char, strlen_32 * 4);
+			    len = strlen_32 * 4;
                           }
                           break;
                         default:
@@ -507,216 +844,296 @@ get_section_contents(bool first_iteration,
                   else
                     {
                       // Use the entsize to determine the length to copy.
-		      uint64_t bufsize = entsize;
+		      len = entsize;
 		      // If entsize is too big, copy all the remaining bytes.
 		      if ((offset + entsize) > secn_len)
-			bufsize = secn_len - offset;
-                      buffer.append(reinterpret_cast<const
-                                                     char*>(str_contents),
-                                    bufsize);
+			len = secn_len - offset;
                     }
-		  buffer.append("@");
+
+		  // The data is small, and may be in a section of another
+		  // object, so we copy it.
+		  fingerprint.merge_data.append(
+		      reinterpret_cast<const char*>(str_contents), len);
+		  reloc.kind = Reloc_summary::MERGE_DATA;
+		  reloc.index = len;
+		  reloc.symvalue = 0;
+		  reloc.addend = 0;
+		  reloc.offset = 0;
                 }
               else if ((*it_s) != NULL)
                 {
                   // If symbol name is available use that.
-                  buffer.append((*it_s)->name());
-                  // Append the addend.
-                  buffer.append(addend_str);
-                  buffer.append("@");
+		  reloc.ptr = (*it_s)->name();
                 }
               else
                 {
                   // Symbol name is not available, like for a local symbol,
                   // use object and section id.
-                  buffer.append(it_v->first->name());
-                  char secn_id[10];
-                  snprintf(secn_id, sizeof(secn_id), "%u",it_v->second);
-                  buffer.append(secn_id);
-                  // Append the addend.
-                  buffer.append(addend_str);
-                  buffer.append("@");
+		  reloc.kind = Reloc_summary::LOCAL;
+		  reloc.index = it_v->second;
+		  reloc.ptr = it_v->first;
                 }
+	      relocs.push_back(reloc);
             }
         }
     }
 
-  if (first_iteration)
+  // Compute the hash code.  This hashes the names of symbols and
+  // objects rather than pointers, so that the hash codes do not vary
+  // from one run to the next.
+  md5_ctx ctx;
+  md5_init_ctx(&ctx);
+  md5_process_bytes(&plen, sizeof plen, &ctx);
+  if (plen > 0)
+    md5_process_bytes(contents, plen, &ctx);
+  for (std::vector<Reloc_summary>::const_iterator p = relocs.begin();
+       p != relocs.end();
+       ++p)
     {
-      buffer.append("Contents = ");
-      buffer.append(reinterpret_cast<const char*>(contents), plen);
-      // Store the section contents that don't change to avoid recomputing
-      // during the next call to this function.
-      (*section_contents)[section_num] = buffer;
+      unsigned int kind = p->kind;
+      md5_process_bytes(&kind, sizeof kind, &ctx);
+      md5_process_bytes(&p->index, sizeof p->index, &ctx);
+      md5_process_bytes(&p->symvalue, sizeof p->symvalue, &ctx);
+      md5_process_bytes(&p->addend, sizeof p->addend, &ctx);
+      md5_process_bytes(&p->offset, sizeof p->offset, &ctx);
+      const char* name = NULL;
+      if (p->kind == Reloc_summary::SYMBOL)
+	name = static_cast<const char*>(p->ptr);
+      else if (p->kind == Reloc_summary::LOCAL)
+	name = static_cast<const Relobj*>(p->ptr)->name().c_str();
+      if (name != NULL)
+	md5_process_bytes(name, strlen(name) + 1, &ctx);
     }
-  else
+  md5_process_bytes(fingerprint.merge_data.data(),
+		    fingerprint.merge_data.length(), &ctx);
+  unsigned char md5sum[16];
+  md5_finish_ctx(&ctx, md5sum);
+  memcpy(fingerprint.hash, md5sum, sizeof md5sum);
+}
+
+// Return whether sections I and J are the same, apart from the
+// sections which are kept for their relocs to foldable sections.
+
+bool
+Icf::Section_matcher::same_contents(unsigned int i, unsigned int j) const
+{
+  const Section_fingerprint& fi(this->fingerprints_[i]);
+  const Section_fingerprint& fj(this->fingerprints_[j]);
+
+  if (fi.contents_size != fj.contents_size
+      || fi.relocs.size() != fj.relocs.size()
+      || fi.merge_data != fj.merge_data)
+    return false;
+  if (fi.contents_size > 0
+      && memcmp(fi.contents, fj.contents, fi.contents_size) != 0)
+    return false;
+
+  for (unsigned int k = 0; k < fi.relocs.size(); ++k)
     {
-      gold_assert(buffer.empty());
-      // Reuse the contents computed in the previous iteration.
-      buffer.append((*section_contents)[section_num]);
+      const Reloc_summary& ri(fi.relocs[k]);
+      const Reloc_summary& rj(fj.relocs[k]);
+      if (ri.kind != rj.kind
+	  || ri.index != rj.index
+	  || ri.symvalue != rj.symvalue
+	  || ri.addend != rj.addend
+	  || ri.offset != rj.offset)
+	return false;
+      if (ri.kind == Reloc_summary::SYMBOL)
+	{
+	  const char* ni = static_cast<const char*>(ri.ptr);
+	  const char* nj = static_cast<const char*>(rj.ptr);
+	  if (ni != nj
+	      && (ni == NULL || nj == NULL || strcmp(ni, nj) != 0))
+	    return false;
+	}
+      else if (ri.kind == Reloc_summary::LOCAL && ri.ptr != rj.ptr)
+	return false;
     }
 
-  buffer.append(icf_reloc_buffer);
-  return buffer;
+  return true;
 }
 
-// This function computes a checksum on each section to detect and form
-// groups of identical sections.  The first iteration does this for all 
-// sections.
-// Further iterations do this only for the kept sections from each group to
-// determine if larger groups of identical sections could be formed.  The
-// first section in each group is the kept section for that group.
-//
-// CRC32 is the checksumming algorithm and can have collisions.  That is,
-// two sections with different contents can have the same checksum. Hence,
-// a multimap is used to maintain more than one group of checksum
-// identical sections.  A section is added to a group only after its
-// contents are explicitly compared with the kept section of the group.
-//
-// Parameters  :
-// ITERATION_NUM           : Invocation instance of this function.
-// NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
-//                      to ICF sections.
-// KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
-// ID_SECTION         : Vector mapping a section to an unique integer.
-// IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
-//                            sections is already known to be unique.
-// SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
-//                      sections.
+// Put the sections which summarize_candidates read into buckets.
 
-static bool
-match_sections(unsigned int iteration_num,
-               Symbol_table* symtab,
-               std::vector<unsigned int>* num_tracked_relocs,
-               std::vector<unsigned int>* kept_section_id,
-               const std::vector<Section_id>& id_section,
-	       const std::vector<uint64_t>& section_addraligns,
-               std::vector<bool>* is_secn_or_group_unique,
-               std::vector<std::string>* section_contents)
+void
+Icf::Section_matcher::fill_buckets()
 {
-  Unordered_multimap<uint32_t, unsigned int> section_cksum;
-  std::pair<Unordered_multimap<uint32_t, unsigned int>::iterator,
-            Unordered_multimap<uint32_t, unsigned int>::iterator> key_range;
-  bool converged = true;
+  this->buckets_.resize(bucket_count);
+  for (unsigned int i = 0; i < this->is_secn_or_group_unique_.size(); ++i)
+    {
+      if (this->is_secn_or_group_unique_[i])
+	continue;
+      unsigned int bucket = this->fingerprints_[i].hash[0] % bucket_count;
+      this->buckets_[bucket].push_back(i);
+    }
+}
 
-  if (iteration_num == 1)
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   NULL);
-  else
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   section_contents);
+// Two sections with different contents can have the same hash code,
+// although with a 128-bit hash code that is very unlikely.  Hence, a
+// multimap is used, and a section is only put in a class after its
+// contents are explicitly compared with the first section of the
+// class; that is the only time that the contents are read again.
+// Sections with the same hash code are in the same bucket, and a
+// bucket is processed in order of section number, so the classes do
+// not depend on how the buckets are processed.
 
-  std::vector<std::string> full_section_contents;
+void
+Icf::Section_matcher::classify_bucket(unsigned int bucket)
+{
+  Unordered_multimap<uint64_t, unsigned int> section_hash;
+  std::pair<Unordered_multimap<uint64_t, unsigned int>::iterator,
+            Unordered_multimap<uint64_t, unsigned int>::iterator> key_range;
 
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  const std::vector<unsigned int>& sections(this->buckets_[bucket]);
+  for (std::vector<unsigned int>::const_iterator p = sections.begin();
+       p != sections.end();
+       ++p)
     {
-      full_section_contents.push_back("");
-      if ((*is_secn_or_group_unique)[i])
-        continue;
-
-      Section_id secn = id_section[i];
-      std::string this_secn_contents;
-      uint32_t cksum;
-      if (iteration_num == 1)
-        {
-          unsigned int num_relocs = 0;
-          this_secn_contents = get_section_contents(true, secn, i, &num_relocs,
-                                                    symtab, (*kept_section_id),
-                                                    section_contents);
-          (*num_tracked_relocs)[i] = num_relocs;
-        }
+      unsigned int i = *p;
+      const Section_fingerprint& fingerprint(this->fingerprints_[i]);
+
+      key_range = section_hash.equal_range(fingerprint.hash[0]);
+      Unordered_multimap<uint64_t, unsigned int>::iterator it;
+      for (it = key_range.first; it != key_range.second; ++it)
+	if (this->fingerprints_[it->second].hash[1] == fingerprint.hash[1]
+	    && this->same_contents(it->second, i))
+	  break;
+
+      if (it != key_range.second)
+	this->contents_classes_[i] = it->second;
       else
-        {
-          if ((*kept_section_id)[i] != i)
-            {
-              // This section is already folded into something.
-              continue;
-            }
-          this_secn_contents = get_section_contents(false, secn, i, NULL,
-                                                    symtab, (*kept_section_id),
-                                                    section_contents);
-        }
+	{
+	  // Start a new class with this section.
+	  section_hash.insert(std::make_pair(fingerprint.hash[0], i));
+	  this->contents_classes_[i] = i;
+	}
+    }
 
-      const unsigned char* this_secn_contents_array =
-            reinterpret_cast<const unsigned char*>(this_secn_contents.c_str());
-      cksum = xcrc32(this_secn_contents_array, this_secn_contents.length(),
-                     0xffffffff);
-      size_t count = section_cksum.count(cksum);
+  // The fingerprints are no longer needed.
+  for (std::vector<unsigned int>::const_iterator p = sections.begin();
+       p != sections.end();
+       ++p)
+    {
+      Section_fingerprint& fingerprint(this->fingerprints_[*p]);
+      fingerprint.contents = NULL;
+      std::vector<Reloc_summary>().swap(fingerprint.relocs);
+      std::string().swap(fingerprint.merge_data);
+    }
 
-      if (count == 0)
-        {
-          // Start a group with this cksum.
-          section_cksum.insert(std::make_pair(cksum, i));
-          full_section_contents[i] = this_secn_contents;
-        }
-      else
-        {
-          key_range = section_cksum.equal_range(cksum);
-          Unordered_multimap<uint32_t, unsigned int>::iterator it;
-          // Search all the groups with this cksum for a match.
-          for (it = key_range.first; it != key_range.second; ++it)
-            {
-              unsigned int kept_section = it->second;
-              if (full_section_contents[kept_section].length()
-                  != this_secn_contents.length())
-                  continue;
-              if (memcmp(full_section_contents[kept_section].c_str(),
-                         this_secn_contents.c_str(),
-                         this_secn_contents.length()) != 0)
-                  continue;
-
-	      // Check section alignment here.
-	      // The section with the larger alignment requirement
-	      // should be kept.  We assume alignment can only be 
-	      // zero or positive integral powers of two.
-	      uint64_t align_i = section_addraligns[i];
-	      uint64_t align_kept = section_addraligns[kept_section];
-	      if (align_i <= align_kept)
-		{
-		  (*kept_section_id)[i] = kept_section;
-		}
-	      else
-		{
-		  (*kept_section_id)[kept_section] = i;
-		  it->second = i;
-		  full_section_contents[kept_section].swap(
-		      full_section_contents[i]);
-		}
+  std::vector<unsigned int>().swap(this->buckets_[bucket]);
+}
+
+// A section or a group of identical sections whose contents class has
+// no other member which is not already unique can not be folded any
+// further, and need not be processed any more.
+
+void
+Icf::Section_matcher::preprocess_for_unique_sections()
+{
+  const unsigned int section_count = this->is_secn_or_group_unique_.size();
+  std::vector<unsigned int> class_size(section_count, 0);
+  for (unsigned int i = 0; i < section_count; ++i)
+    if (!this->is_secn_or_group_unique_[i])
+      ++class_size[this->contents_classes_[i]];
+  for (unsigned int i = 0; i < section_count; ++i)
+    if (!this->is_secn_or_group_unique_[i]
+	&& class_size[this->contents_classes_[i]] == 1)
+      this->is_secn_or_group_unique_[i] = true;
+}
+
+// This function forms groups of identical sections.  The first
+// iteration does this for all sections.  Further iterations do this
+// only for the kept sections from each group to determine if larger
+// groups of identical sections could be formed.  The first section in
+// each group is the kept section for that group.
+//
+// Two sections are identical if they are in the same contents class
+// and their relocs to foldable sections point to the same kept
+// sections.  The kept sections are looked up as each section is
+// processed, so a section can be folded into a group in the same
+// iteration as the sections its relocs point to.
+
+bool
+Icf::Section_matcher::match_iteration(unsigned int iteration_num)
+{
+  std::vector<unsigned int>& kept_section_id(this->icf_->kept_section_id_);
+  Unordered_map<std::string, unsigned int> groups;
+  std::pair<Unordered_map<std::string, unsigned int>::iterator, bool>
+    groups_insert;
+  bool converged = true;
+
+  if (iteration_num > 1)
+    this->preprocess_for_unique_sections();
+
+  std::string key;
+  for (unsigned int i = 0; i < kept_section_id.size(); ++i)
+    {
+      if (this->is_secn_or_group_unique_[i])
+	continue;
+      if (iteration_num > 1 && kept_section_id[i] != i)
+	{
+	  // This section is already folded into something.
+	  continue;
+	}
+
+      key.clear();
+      key.append(reinterpret_cast<const char*>(&this->contents_classes_[i]),
+		 sizeof(unsigned int));
+      const std::vector<unsigned int>& tracked_relocs(
+	  this->tracked_relocs_[i]);
+      for (std::vector<unsigned int>::const_iterator p =
+	     tracked_relocs.begin();
+	   p != tracked_relocs.end();
+	   ++p)
+	key.append(reinterpret_cast<const char*>(&kept_section_id[*p]),
+		   sizeof(unsigned int));
+
+      groups_insert = groups.insert(std::make_pair(key, i));
+      if (!groups_insert.second)
+	{
+	  unsigned int kept_section = groups_insert.first->second;
+
+	  // Check section alignment here.
+	  // The section with the larger alignment requirement
+	  // should be kept.  We assume alignment can only be
+	  // zero or positive integral powers of two.
+	  uint64_t align_i = this->section_addraligns_[i];
+	  uint64_t align_kept = this->section_addraligns_[kept_section];
+	  if (align_i <= align_kept)
+	    {
+	      kept_section_id[i] = kept_section;
+	    }
+	  else
+	    {
+	      kept_section_id[kept_section] = i;
+	      groups_insert.first->second = i;
+	    }
+
+	  converged = false;
+	}
 
-              converged = false;
-              break;
-            }
-          if (it == key_range.second)
-            {
-              // Create a new group for this cksum.
-              section_cksum.insert(std::make_pair(cksum, i));
-              full_section_contents[i] = this_secn_contents;
-            }
-        }
       // If there are no relocs to foldable sections do not process
       // this section any further.
-      if (iteration_num == 1 && (*num_tracked_relocs)[i] == 0)
-        (*is_secn_or_group_unique)[i] = true;
+      if (iteration_num == 1 && tracked_relocs.empty())
+	this->is_secn_or_group_unique_[i] = true;
     }
 
   // If a section was folded into another section that was later folded
   // again then the former has to be updated.
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (unsigned int i = 0; i < kept_section_id.size(); i++)
     {
       // Find the end of the folding chain
       unsigned int kept = i;
-      while ((*kept_section_id)[kept] != kept)
+      while (kept_section_id[kept] != kept)
         {
-          kept = (*kept_section_id)[kept];
+          kept = kept_section_id[kept];
         }
       // Update every element of the chain
       unsigned int current = i;
-      while ((*kept_section_id)[current] != kept)
+      while (kept_section_id[current] != kept)
         {
-          unsigned int next = (*kept_section_id)[current];
-          (*kept_section_id)[current] = kept;
+          unsigned int next = kept_section_id[current];
+          kept_section_id[current] = kept;
           current = next;
         }
     }
@@ -724,100 +1141,334 @@ match_sections(unsigned int iteration_num,
   return converged;
 }
 
-// During safe icf (--icf=safe), only fold functions that are ctors or dtors.
-// This function returns true if the section name is that of a ctor or a dtor.
+// Run match_iteration repeatedly (twice by default).
 
-static bool
-is_function_ctor_or_dtor(const std::string& section_name)
+bool
+Icf::Section_matcher::match_sections(unsigned int* num_iterations)
 {
-  const char* mangled_func_name = strrchr(section_name.c_str(), '.');
-  gold_assert(mangled_func_name != NULL);
-  if ((is_prefix_of("._ZN", mangled_func_name)
-       || is_prefix_of("._ZZ", mangled_func_name))
-      && (is_gnu_v3_mangled_ctor(mangled_func_name + 1)
-          || is_gnu_v3_mangled_dtor(mangled_func_name + 1)))
+  // The fingerprints are no longer needed.
+  std::vector<Section_fingerprint>().swap(this->fingerprints_);
+
+  // Default number of iterations to run ICF is 2.
+  unsigned int max_iterations = (parameters->options().icf_iterations() > 0)
+                            ? parameters->options().icf_iterations()
+                            : 2;
+
+  bool converged = false;
+  *num_iterations = 0;
+  while (!converged && (*num_iterations < max_iterations))
     {
-      return true;
+      ++*num_iterations;
+      converged = this->match_iteration(*num_iterations);
     }
-  return false;
+  return converged;
+}
+
+// A task which runs find_candidates, summarize_candidates or
+// release_views for one object.
+
+class Icf::Object_task : public Task
+{
+ public:
+  // What the task does.
+  enum Action
+  {
+    FIND_CANDIDATES,
+    SUMMARIZE_CANDIDATES,
+    RELEASE_VIEWS
+  };
+
+  Object_task(Section_matcher* matcher, unsigned int object_index,
+	      Action action, Task_token* final_blocker)
+    : matcher_(matcher), object_index_(object_index), action_(action),
+      final_blocker_(final_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    Relobj* object = this->matcher_->object(this->object_index_);
+    if (object->is_locked())
+      return object->token();
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  {
+    Task_token* token = this->matcher_->object(this->object_index_)->token();
+    if (token != NULL)
+      tl->add(this, token);
+    tl->add(this, this->final_blocker_);
+  }
+
+  void
+  run(Workqueue*)
+  {
+    switch (this->action_)
+      {
+      case FIND_CANDIDATES:
+	this->matcher_->find_candidates(this->object_index_);
+	break;
+      case SUMMARIZE_CANDIDATES:
+	this->matcher_->summarize_candidates(this->object_index_);
+	break;
+      case RELEASE_VIEWS:
+	this->matcher_->release_views(this->object_index_);
+	break;
+      default:
+	gold_unreachable();
+      }
+    this->matcher_->release_object(this->object_index_);
+  }
+
+  std::string
+  get_name() const
+  {
+    return ("Icf::Object_task "
+	    + this->matcher_->object(this->object_index_)->name());
+  }
+
+ private:
+  Section_matcher* matcher_;
+  unsigned int object_index_;
+  Action action_;
+  Task_token* final_blocker_;
+};
+
+// A task which runs classify_bucket for some buckets.
+
+class Icf::Bucket_task : public Task
+{
+ public:
+  Bucket_task(Section_matcher* matcher, unsigned int first_bucket,
+	      unsigned int last_bucket, Task_token* final_blocker)
+    : matcher_(matcher), first_bucket_(first_bucket),
+      last_bucket_(last_bucket), final_blocker_(final_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  void
+  run(Workqueue*)
+  {
+    for (unsigned int i = this->first_bucket_; i < this->last_bucket_; ++i)
+      this->matcher_->classify_bucket(i);
+  }
+
+  std::string
+  get_name() const
+  { return "Icf::Bucket_task"; }
+
+ private:
+  Section_matcher* matcher_;
+  unsigned int first_bucket_;
+  unsigned int last_bucket_;
+  Task_token* final_blocker_;
+};
+
+// This runs the phases of find_identical_sections.  It queues the
+// tasks for a phase, and then queues itself to run the next phase
+// when they are done.
+
+class Icf::Match_runner : public Task_function_runner
+{
+ public:
+  enum Phase
+  {
+    FIND_CANDIDATES,
+    SUMMARIZE_CANDIDATES,
+    CLASSIFY_SECTIONS,
+    RELEASE_VIEWS,
+    MATCH_SECTIONS
+  };
+
+  Match_runner(Icf* icf, Section_matcher* matcher, Symbol_table* symtab,
+	       Task_function_runner* next, Phase phase)
+    : icf_(icf), matcher_(matcher), symtab_(symtab), next_(next),
+      phase_(phase)
+  { }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  Icf* icf_;
+  Section_matcher* matcher_;
+  Symbol_table* symtab_;
+  Task_function_runner* next_;
+  Phase phase_;
+};
+
+void
+Icf::Match_runner::run(Workqueue* workqueue, const Task* task)
+{
+  Section_matcher* matcher = this->matcher_;
+
+  if (this->phase_ == MATCH_SECTIONS)
+    {
+      unsigned int num_iterations;
+      bool converged = matcher->match_sections(&num_iterations);
+      delete matcher;
+      this->icf_->finish_identical_sections(this->symtab_, num_iterations,
+					    converged);
+      this->next_->run(workqueue, task);
+      delete this->next_;
+      return;
+    }
+
+  Task_token* blocker = new Task_token(true);
+  switch (this->phase_)
+    {
+    case FIND_CANDIDATES:
+      for (unsigned int i = 0; i < matcher->object_count(); ++i)
+	{
+	  blocker->add_blocker();
+	  workqueue->queue(new Object_task(matcher, i,
+					   Object_task::FIND_CANDIDATES,
+					   blocker));
+	}
+      break;
+
+    case SUMMARIZE_CANDIDATES:
+      matcher->number_candidates();
+      for (unsigned int i = 0; i < matcher->object_count(); ++i)
+	{
+	  if (!matcher->object_needs_summary(i))
+	    continue;
+	  blocker->add_blocker();
+	  workqueue->queue(new Object_task(matcher, i,
+					   Object_task::SUMMARIZE_CANDIDATES,
+					   blocker));
+	}
+      break;
+
+    case CLASSIFY_SECTIONS:
+      {
+	matcher->fill_buckets();
+	const unsigned int buckets_per_task = 4;
+	for (unsigned int i = 0;
+	     i < Section_matcher::bucket_count;
+	     i += buckets_per_task)
+	  {
+	    blocker->add_blocker();
+	    workqueue->queue(new Bucket_task(matcher, i, i + buckets_per_task,
+					     blocker));
+	  }
+      }
+      break;
+
+    case RELEASE_VIEWS:
+      for (unsigned int i = 0; i < matcher->object_count(); ++i)
+	{
+	  if (!matcher->object_has_views(i))
+	    continue;
+	  blocker->add_blocker();
+	  workqueue->queue(new Object_task(matcher, i,
+					   Object_task::RELEASE_VIEWS,
+					   blocker));
+	}
+      break;
+
+    default:
+      gold_unreachable();
+    }
+
+  workqueue->queue(new Task_function(new Match_runner(this->icf_, matcher,
+						      this->symtab_,
+						      this->next_,
+						      static_cast<Phase>(
+							this->phase_ + 1)),
+				     blocker,
+				     "Task_function Icf::Match_runner"));
 }
 
 // This is the main ICF function called in gold.cc.  This does the
-// initialization and calls match_sections repeatedly (twice by default)
-// which computes the crc checksums and detects identical functions.
+// initialization and runs the phases of Section_matcher, which
+// computes the hash codes and detects identical functions.
 
 void
 Icf::find_identical_sections(const Input_objects* input_objects,
                              Symbol_table* symtab)
 {
-  unsigned int section_num = 0;
-  std::vector<unsigned int> num_tracked_relocs;
-  std::vector<uint64_t> section_addraligns;
-  std::vector<bool> is_secn_or_group_unique;
-  std::vector<std::string> section_contents;
-  const Target& target = parameters->target();
+  Section_matcher matcher(this, input_objects, symtab);
 
-  // Decide which sections are possible candidates first.
+  // Lock the object so we can read from it.  This is only called
+  // single-threaded from queue_middle_tasks, so it is OK to lock.
+  // Unfortunately we have no way to pass in a Task token.
+  const Task* dummy_task = reinterpret_cast<const Task*>(-1);
 
-  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
-       p != input_objects->relobj_end();
-       ++p)
+  for (unsigned int i = 0; i < matcher.object_count(); ++i)
     {
-      // Lock the object so we can read from it.  This is only called
-      // single-threaded from queue_middle_tasks, so it is OK to lock.
-      // Unfortunately we have no way to pass in a Task token.
-      const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-      Task_lock_obj<Object> tl(dummy_task, *p);
-
-      for (unsigned int i = 0;i < (*p)->shnum(); ++i)
-        {
-	  const std::string section_name = (*p)->section_name(i);
-          if (!is_section_foldable_candidate(section_name))
-            continue;
-          if (!(*p)->is_section_included(i))
-            continue;
-          if (parameters->options().gc_sections()
-              && symtab->gc()->is_section_garbage(*p, i))
-              continue;
-	  // With --icf=safe, check if the mangled function name is a ctor
-	  // or a dtor.  The mangled function name can be obtained from the
-	  // section name by stripping the section prefix.
-	  if (parameters->options().icf_safe_folding()
-              && !is_function_ctor_or_dtor(section_name)
-	      && (!target.can_check_for_function_pointers()
-                  || section_has_function_pointers(*p, i)))
-            {
-	      continue;
-            }
-          this->id_section_.push_back(Section_id(*p, i));
-          this->section_id_[Section_id(*p, i)] = section_num;
-          this->kept_section_id_.push_back(section_num);
-          num_tracked_relocs.push_back(0);
-	  section_addraligns.push_back((*p)->section_addralign(i));
-          is_secn_or_group_unique.push_back(false);
-          section_contents.push_back("");
-          section_num++;
-        }
+      Task_lock_obj<Object> tl(dummy_task, matcher.object(i));
+      matcher.find_candidates(i);
     }
 
-  unsigned int num_iterations = 0;
+  matcher.number_candidates();
 
-  // Default number of iterations to run ICF is 2.
-  unsigned int max_iterations = (parameters->options().icf_iterations() > 0)
-                            ? parameters->options().icf_iterations()
-                            : 2;
+  for (unsigned int i = 0; i < matcher.object_count(); ++i)
+    {
+      if (!matcher.object_needs_summary(i))
+	continue;
+      Task_lock_obj<Object> tl(dummy_task, matcher.object(i));
+      matcher.summarize_candidates(i);
+    }
 
-  bool converged = false;
+  matcher.fill_buckets();
+  for (unsigned int i = 0; i < Section_matcher::bucket_count; ++i)
+    matcher.classify_bucket(i);
 
-  while (!converged && (num_iterations < max_iterations))
+  for (unsigned int i = 0; i < matcher.object_count(); ++i)
     {
-      num_iterations++;
-      converged = match_sections(num_iterations, symtab,
-                                 &num_tracked_relocs, &this->kept_section_id_,
-                                 this->id_section_, section_addraligns,
-                                 &is_secn_or_group_unique, &section_contents);
+      if (!matcher.object_has_views(i))
+	continue;
+      Task_lock_obj<Object> tl(dummy_task, matcher.object(i));
+      matcher.release_views(i);
     }
 
+  unsigned int num_iterations;
+  bool converged = matcher.match_sections(&num_iterations);
+  this->finish_identical_sections(symtab, num_iterations, converged);
+}
+
+// Queue the tasks which read and classify the sections in parallel.
+// The groups of identical sections are then formed serially by the
+// last task, so the sections which are folded are the same as with
+// find_identical_sections.
+
+void
+Icf::queue_find_identical_sections(Workqueue* workqueue,
+				   const Input_objects* input_objects,
+				   Symbol_table* symtab,
+				   Task_function_runner* next)
+{
+  Section_matcher* matcher = new Section_matcher(this, input_objects, symtab);
+  Task_token* blocker = new Task_token(true);
+  workqueue->queue(new Task_function(new Match_runner(this, matcher, symtab,
+						      next,
+						      Match_runner::
+						      FIND_CANDIDATES),
+				     blocker,
+				     "Task_function Icf::Match_runner"));
+}
+
+// Report the result of find_identical_sections, and unfold the
+// sections named by --keep-unique.
+
+void
+Icf::finish_identical_sections(Symbol_table* symtab,
+			       unsigned int num_iterations, bool converged)
+{
   if (parameters->options().print_icf_sections())
     {
       if (converged)
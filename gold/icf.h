@@ -35,6 +35,8 @@ namespace gold
 class Object;
 class Input_objects;
 class Symbol_table;
+class Workqueue;
+class Task_function_runner;
 
 class Icf
 {
@@ -82,6 +84,15 @@ class Icf
   find_identical_sections(const Input_objects* input_objects,
                           Symbol_table* symtab);
 
+  // Like find_identical_sections, but the sections are read and
+  // compared by tasks which may run in parallel.  NEXT is run by the
+  // last task, and then deleted.
+  void
+  queue_find_identical_sections(Workqueue*,
+				const Input_objects* input_objects,
+				Symbol_table* symtab,
+				Task_function_runner* next);
+
   // This is set when ICF has been run and the groups of
   // identical sections have been formed.
   void
@@ -143,6 +154,16 @@ class Icf
   { return this->section_id_; }
 
  private:
+  class Section_matcher;
+  class Object_task;
+  class Bucket_task;
+  class Match_runner;
+
+  // Report the result of find_identical_sections, and handle
+  // --keep-unique.
+  void
+  finish_identical_sections(Symbol_table* symtab,
+			    unsigned int num_iterations, bool converged);
 
   // Maps integers to sections.
   std::vector<Section_id> id_section_;
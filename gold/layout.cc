@@ -33,7 +33,6 @@
 #include <unistd.h>
 #include "libiberty.h"
 #include "md5.h"
-#include "sha1.h"
 #ifdef __MINGW32__
 #include <windows.h>
 #include <rpcdce.h>
@@ -239,17 +238,32 @@ Free_list::print_stats()
 	  program_name, Free_list::num_allocate_visits);
 }
 
-// A Hash_task computes the MD5 checksum of an array of char.
+// Compute the MD5 checksum of LENGTH bytes at P into RESULT.  This
+// has the signature of sha1_digest and xxhash128_digest.
+
+static void
+md5_digest(const void* p, size_t length, unsigned char* result)
+{
+  md5_buffer(static_cast<const char*>(p), length, result);
+}
+
+// A Hash_task computes the checksum of an array of char using
+// HASH_FN, which is md5_digest for --build-id=tree, xxhash128_digest
+// for --build-id=xxhash, and the build ID style's own hash function
+// for --build-id-chunked.
 
 class Hash_task : public Task
 {
  public:
+  typedef void (*Hash_function)(const void*, size_t, unsigned char*);
+
   Hash_task(Output_file* of,
 	    size_t offset,
 	    size_t size,
 	    unsigned char* dst,
+	    Hash_function hash_fn,
 	    Task_token* final_blocker)
-    : of_(of), offset_(offset), size_(size), dst_(dst),
+    : of_(of), offset_(offset), size_(size), dst_(dst), hash_fn_(hash_fn),
       final_blocker_(final_blocker)
   { }
 
@@ -258,7 +272,7 @@ class Hash_task : public Task
   {
     const unsigned char* iv =
 	this->of_->get_input_view(this->offset_, this->size_);
-    md5_buffer(reinterpret_cast<const char*>(iv), this->size_, this->dst_);
+    this->hash_fn_(iv, this->size_, this->dst_);
     this->of_->free_input_view(this->offset_, this->size_, iv);
   }
 
@@ -280,6 +294,7 @@ class Hash_task : public Task
   const size_t offset_;
   const size_t size_;
   unsigned char* const dst_;
+  const Hash_function hash_fn_;
   Task_token* const final_blocker_;
 };
 
@@ -367,11 +382,37 @@ Layout::Relaxation_debug_check::verify_sections(
 void
 Layout_task_runner::run(Workqueue* workqueue, const Task* task)
 {
+  Layout* layout = this->layout_;
+
+  // If the local symbols can be counted, or the strings of merge
+  // sections read, in parallel, queue the tasks to do that, and run
+  // again when they are done.
+  Task_token* blocker = new Task_token(true);
+  bool queued = layout->queue_count_local_symbols(workqueue,
+						  this->input_objects_,
+						  this->symtab_,
+						  this->target_,
+						  blocker);
+  if (layout->queue_deferred_merge_sections(workqueue, blocker))
+    queued = true;
+  if (queued)
+    {
+      workqueue->queue(new Task_function(new Layout_task_runner(
+					   this->options_,
+					   this->input_objects_,
+					   this->symtab_,
+					   this->target_,
+					   layout,
+					   this->mapfile_),
+					 blocker,
+					 "Task_function Layout_task_runner"));
+      return;
+    }
+  delete blocker;
+
   // See if any of the input definitions violate the One Definition Rule.
   // TODO: if this is too slow, do this as a task, rather than inline.
   this->symtab_->detect_odr_violations(task, this->options_.output_file_name());
-
-  Layout* layout = this->layout_;
   off_t file_size = layout->finalize(this->input_objects_,
 				     this->symtab_,
 				     this->target_,
@@ -448,6 +489,7 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     added_eh_frame_data_(false),
     eh_frame_hdr_section_(NULL),
     gdb_index_data_(NULL),
+    debug_names_data_(NULL),
     build_id_note_(NULL),
     debug_abbrev_(NULL),
     debug_info_(NULL),
@@ -461,6 +503,7 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     has_static_tls_(false),
     any_postprocessing_sections_(false),
     resized_signatures_(false),
+    local_symbols_counted_(false),
     have_stabstr_section_(false),
     section_ordering_specified_(false),
     unique_segment_for_sections_specified_(false),
@@ -733,6 +776,15 @@ Layout::include_section(Sized_relobj_file<size, big_endian>*, const char* name,
 	      && is_gdb_fast_lookup_section(name + 8))
 	    return false;
 	}
+      if (parameters->options().debug_names()
+	  && (shdr.get_sh_flags() & elfcpp::SHF_ALLOC) == 0)
+	{
+	  // When building .debug_names, we replace any name indexes
+	  // in the input files.
+	  if (strcmp(name, ".debug_names") == 0
+	      || strcmp(name, ".zdebug_names") == 0)
+	    return false;
+	}
       if (parameters->options().strip_lto_sections()
 	  && !parameters->options().relocatable()
 	  && (shdr.get_sh_flags() & elfcpp::SHF_ALLOC) == 0)
@@ -1582,7 +1634,7 @@ Layout::add_eh_frame_for_plt(Output_data* plt, const unsigned char* cie_data,
 }
 
 // Scan a .debug_info or .debug_types section, and add summary
-// information to the .gdb_index section.
+// information to the .gdb_index and .debug_names sections.
 
 template<int size, bool big_endian>
 void
@@ -1596,16 +1648,54 @@ Layout::add_to_gdb_index(bool is_type_unit,
 {
   if (this->gdb_index_data_ == NULL)
     {
-      Output_section* os = this->choose_output_section(NULL, ".gdb_index",
-						       elfcpp::SHT_PROGBITS, 0,
-						       false, ORDER_INVALID,
-						       false, false, false);
-      if (os == NULL)
-	return;
+      Output_section* os = NULL;
+      if (parameters->options().gdb_index())
+	{
+	  os = this->choose_output_section(NULL, ".gdb_index",
+					   elfcpp::SHT_PROGBITS, 0,
+					   false, ORDER_INVALID,
+					   false, false, false);
+	  if (os == NULL)
+	    return;
+	}
+
+      Output_section* names_os = NULL;
+      Output_section* str_os = NULL;
+      if (parameters->options().debug_names())
+	{
+	  names_os = this->choose_output_section(NULL, ".debug_names",
+						 elfcpp::SHT_PROGBITS, 0,
+						 false, ORDER_INVALID,
+						 false, false, false);
+	  str_os = this->choose_output_section(NULL, ".debug_str",
+					       elfcpp::SHT_PROGBITS, 0,
+					       false, ORDER_INVALID,
+					       false, false, false);
+	  if (names_os == NULL || str_os == NULL)
+	    {
+	      names_os = NULL;
+	      if (os == NULL)
+		return;
+	    }
+	}
 
       this->gdb_index_data_ = new Gdb_index(os);
-      os->add_output_section_data(this->gdb_index_data_);
-      os->set_after_input_sections();
+      if (os != NULL)
+	{
+	  os->add_output_section_data(this->gdb_index_data_);
+	  os->set_after_input_sections();
+	}
+
+      // The names go into a string table at the end of .debug_str.
+      if (names_os != NULL)
+	{
+	  this->debug_names_data_ = new Debug_names(str_os);
+	  str_os->add_output_section_data(
+	      this->debug_names_data_->debug_str_data());
+	  names_os->add_output_section_data(this->debug_names_data_);
+	  names_os->set_after_input_sections();
+	  this->gdb_index_data_->set_debug_names(this->debug_names_data_);
+	}
     }
 
   this->gdb_index_data_->scan_debug_info(is_type_unit, object, symbols,
@@ -1613,6 +1703,15 @@ Layout::add_to_gdb_index(bool is_type_unit,
 					 reloc_type);
 }
 
+// Queue the tasks that scan the sections passed to add_to_gdb_index.
+
+void
+Layout::queue_gdb_index_tasks(Workqueue* workqueue, Task_token* blocker)
+{
+  if (this->gdb_index_data_ != NULL)
+    this->gdb_index_data_->queue_scan_tasks(workqueue, blocker);
+}
+
 // Add POSD to an output section using NAME, TYPE, and FLAGS.  Return
 // the output section.
 
@@ -2699,9 +2798,12 @@ Layout::finalize(const Input_objects* input_objects, Symbol_table* symtab,
   unsigned int local_dynamic_count = 0;
   unsigned int forced_local_dynamic_count = 0;
 
-  target->finalize_sections(this, input_objects, symtab);
+  if (!this->local_symbols_counted_)
+    {
+      target->finalize_sections(this, input_objects, symtab);
 
-  this->count_local_symbols(task, input_objects);
+      this->count_local_symbols(task, input_objects);
+    }
 
   this->link_stabs_sections();
 
@@ -3081,7 +3183,7 @@ Layout::create_build_id()
   // set DESC to the note descriptor contents.
   size_t descsz;
   std::string desc;
-  if (strcmp(style, "md5") == 0)
+  if (strcmp(style, "md5") == 0 || strcmp(style, "xxhash") == 0)
     descsz = 128 / 8;
   else if ((strcmp(style, "sha1") == 0) || (strcmp(style, "tree") == 0))
     descsz = 160 / 8;
@@ -3969,6 +4071,23 @@ Layout::place_orphan_sections_in_script()
 void
 Layout::count_local_symbols(const Task* task,
 			    const Input_objects* input_objects)
+{
+  this->reserve_local_symbols(input_objects);
+
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      Task_lock_obj<Object> tlo(task, *p);
+      (*p)->count_local_symbols(&this->sympool_, &this->dynpool_);
+    }
+}
+
+// Reserve space in the symbol table and dynamic symbol table string
+// pools for the local symbols.
+
+void
+Layout::reserve_local_symbols(const Input_objects* input_objects)
 {
   // First, figure out an upper bound on the number of symbols we'll
   // be inserting into each pool.  This helps us create the pools with
@@ -3988,14 +4107,87 @@ Layout::count_local_symbols(const Task* task,
   // We assume all symbols will go into both the sympool and dynpool.
   this->sympool_.reserve(symbol_count);
   this->dynpool_.reserve(symbol_count);
+}
+
+// Queue a Count_local_symbols task for each relocatable object, if
+// we are resolving symbols in parallel.  The target must finalize its
+// sections first, since that may discard input sections, so we do
+// that here rather than in finalize.  The string pools are made
+// concurrent; a concurrent pool sorts its strings when assigning
+// offsets, so the output does not depend on the order in which the
+// tasks run.
+
+bool
+Layout::queue_count_local_symbols(Workqueue* workqueue,
+				  const Input_objects* input_objects,
+				  Symbol_table* symtab, Target* target,
+				  Task_token* blocker)
+{
+  if (this->local_symbols_counted_
+      || !parameters->options().threads()
+      || !parameters->options().parallel_symbol_resolution()
+      || parameters->incremental()
+      || input_objects->number_of_relobjs() < 2)
+    return false;
+
+#ifndef ENABLE_THREADS
+  return false;
+#else
+  target->finalize_sections(this, input_objects, symtab);
+
+  const unsigned int stripe_count = 32;
+  this->sympool_.set_concurrent(stripe_count);
+  this->dynpool_.set_concurrent(stripe_count);
+  this->reserve_local_symbols(input_objects);
 
   for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
        p != input_objects->relobj_end();
        ++p)
     {
-      Task_lock_obj<Object> tlo(task, *p);
-      (*p)->count_local_symbols(&this->sympool_, &this->dynpool_);
+      blocker->add_blocker();
+      workqueue->queue(new Count_local_symbols(*p, &this->sympool_,
+					       &this->dynpool_, blocker));
+    }
+
+  this->local_symbols_counted_ = true;
+  return true;
+#endif
+}
+
+// Queue tasks to read the strings of the input sections which
+// Output_merge_string deferred for --parallel-string-merge.
+
+bool
+Layout::queue_deferred_merge_sections(Workqueue* workqueue,
+				      Task_token* blocker)
+{
+  bool queued = false;
+  for (Section_list::iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    {
+      if ((*p)->queue_deferred_merge_sections(workqueue, blocker))
+	queued = true;
     }
+  return queued;
+}
+
+// Queue tasks to postprocess the sections which require it.
+
+bool
+Layout::queue_postprocessing_sections(Workqueue* workqueue,
+				      Task_token* blocker)
+{
+  bool queued = false;
+  for (Section_list::iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    {
+      if ((*p)->requires_postprocessing()
+	  && (*p)->queue_postprocessing(workqueue, blocker))
+	queued = true;
+    }
+  return queued;
 }
 
 // Create the symbol table sections.  Here we also set the final
@@ -5465,9 +5657,9 @@ Layout::write_sections_after_input_sections(Output_file* of)
   this->section_headers_->write(of);
 }
 
-// If a tree-style build ID was requested, the parallel part of that computation
-// is already done, and the final hash-of-hashes is computed here.  For other
-// types of build IDs, all the work is done here.
+// If a tree-style, xxhash or chunked build ID was requested, the parallel
+// part of that computation is already done, and the final hash-of-hashes is computed
+// here.  For other types of build IDs, all the work is done here.
 
 void
 Layout::write_build_id(Output_file* of, unsigned char* array_of_hashes,
@@ -5488,9 +5680,11 @@ Layout::write_build_id(Output_file* of, unsigned char* array_of_hashes,
       // If we get here with style == "tree" then the output must be
       // too small for chunking, and we use SHA-1 in that case.
       if ((strcmp(style, "sha1") == 0) || (strcmp(style, "tree") == 0))
-	sha1_buffer(reinterpret_cast<const char*>(iv), output_file_size, ov);
+	sha1_digest(iv, output_file_size, ov);
       else if (strcmp(style, "md5") == 0)
 	md5_buffer(reinterpret_cast<const char*>(iv), output_file_size, ov);
+      else if (strcmp(style, "xxhash") == 0)
+	xxhash128_digest(iv, output_file_size, ov);
       else
 	gold_unreachable();
 
@@ -5499,9 +5693,15 @@ Layout::write_build_id(Output_file* of, unsigned char* array_of_hashes,
   else
     {
       // Non-overlapping substrings of the output file have been hashed.
-      // Compute SHA-1 hash of the hashes.
-      sha1_buffer(reinterpret_cast<const char*>(array_of_hashes),
-		  size_of_hashes, ov);
+      // Compute the hash of the hashes: XXH3-128 for xxhash, MD5 for
+      // md5, SHA-1 for sha1 and tree.
+      const char* style = parameters->options().build_id();
+      if (strcmp(style, "xxhash") == 0)
+	xxhash128_digest(array_of_hashes, size_of_hashes, ov);
+      else if (strcmp(style, "md5") == 0)
+	md5_digest(array_of_hashes, size_of_hashes, ov);
+      else
+	sha1_digest(array_of_hashes, size_of_hashes, ov);
       delete[] array_of_hashes;
     }
 
@@ -5645,6 +5845,38 @@ Write_data_task::run(Workqueue*)
   this->layout_->write_data(this->symtab_, this->of_);
 }
 
+// Count_local_symbols methods.
+
+// We have to wait for the object file to be unlocked.
+
+Task_token*
+Count_local_symbols::is_runnable()
+{
+  if (this->object_->is_locked())
+    return this->object_->token();
+  return NULL;
+}
+
+// We lock the object file, and we unblock FINAL_BLOCKER when done.
+
+void
+Count_local_symbols::locks(Task_locker* tl)
+{
+  Task_token* token = this->object_->token();
+  if (token != NULL)
+    tl->add(this, token);
+  tl->add(this, this->final_blocker_);
+}
+
+// Count the local symbols.
+
+void
+Count_local_symbols::run(Workqueue*)
+{
+  this->object_->count_local_symbols(this->sympool_, this->dynpool_);
+  this->object_->release();
+}
+
 // Write_symbols_task methods.
 
 // We can always run this task.
@@ -5701,10 +5933,33 @@ Write_after_input_sections_task::run(Workqueue*)
   this->layout_->write_sections_after_input_sections(this->of_);
 }
 
+// Postprocessing_task_runner methods.
+
+// Queue the tasks to postprocess sections, and then the task to write
+// the sections which depend on input sections, which waits for them.
+
+void
+Postprocessing_task_runner::run(Workqueue* workqueue, const Task*)
+{
+  Task_token* postprocessing_blocker = new Task_token(true);
+  this->layout_->queue_postprocessing_sections(workqueue,
+					       postprocessing_blocker);
+  workqueue->queue(new Write_after_input_sections_task(this->layout_,
+						       this->of_,
+						       postprocessing_blocker,
+						       this->final_blocker_));
+}
+
 // Build IDs can be computed as a "flat" sha1 or md5 of a string of bytes,
 // or as a "tree" where each chunk of the string is hashed and then those
 // hashes are put into a (much smaller) string which is hashed with sha1.
-// We compute a checksum over the entire file because that is simplest.
+// An "xxhash" build ID is always computed as a tree, where both the
+// chunks and the string of chunk hashes are hashed with XXH3-128; the
+// chunks are hashed in parallel, so for a large file this runs at
+// close to memory bandwidth.  With --build-id-chunked, an md5 or sha1
+// build ID is also computed as a tree, using MD5 or SHA-1 for both
+// levels; this is not the same build ID as the flat one.  We compute
+// a checksum over the entire file because that is simplest.
 
 void
 Build_id_task_runner::run(Workqueue* workqueue, const Task*)
@@ -5717,27 +5972,45 @@ Build_id_task_runner::run(Workqueue* workqueue, const Task*)
   unsigned char* array_of_hashes = NULL;
   size_t size_of_hashes = 0;
 
-  if (strcmp(this->options_->build_id(), "tree") == 0
+  const char* style = this->options_->build_id();
+  const bool is_xxhash = strcmp(style, "xxhash") == 0;
+  const bool is_chunked = (this->options_->build_id_chunked()
+			   && (strcmp(style, "md5") == 0
+			       || strcmp(style, "sha1") == 0));
+  if ((is_xxhash || is_chunked || strcmp(style, "tree") == 0)
       && this->options_->build_id_chunk_size_for_treehash() > 0
       && filesize > 0
-      && (filesize >= this->options_->build_id_min_file_size_for_treehash()))
-    {
-      static const size_t MD5_OUTPUT_SIZE_IN_BYTES = 16;
+      && (is_xxhash
+	  || filesize >= this->options_->build_id_min_file_size_for_treehash()))
+    {
+      // MD5 and XXH3-128 produce 16 bytes, SHA-1 produces 20.
+      Hash_task::Hash_function hash_fn;
+      size_t hash_size = 16;
+      if (is_xxhash)
+	hash_fn = xxhash128_digest;
+      else if (is_chunked && strcmp(style, "sha1") == 0)
+	{
+	  hash_fn = sha1_digest;
+	  hash_size = 20;
+	}
+      else
+	hash_fn = md5_digest;
       const size_t chunk_size =
 	  this->options_->build_id_chunk_size_for_treehash();
       const size_t num_hashes = ((filesize - 1) / chunk_size) + 1;
       post_hash_tasks_blocker->add_blockers(num_hashes);
-      size_of_hashes = num_hashes * MD5_OUTPUT_SIZE_IN_BYTES;
+      size_of_hashes = num_hashes * hash_size;
       array_of_hashes = new unsigned char[size_of_hashes];
       unsigned char *dst = array_of_hashes;
       for (size_t i = 0, src_offset = 0; i < num_hashes;
-	   i++, dst += MD5_OUTPUT_SIZE_IN_BYTES, src_offset += chunk_size)
+	   i++, dst += hash_size, src_offset += chunk_size)
 	{
 	  size_t size = std::min(chunk_size, filesize - src_offset);
 	  workqueue->queue(new Hash_task(of,
 					 src_offset,
 					 size,
 					 dst,
+					 hash_fn,
 					 post_hash_tasks_blocker));
 	}
     }
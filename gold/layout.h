@@ -59,6 +59,7 @@ class Output_reduced_debug_abbrev_section;
 class Output_reduced_debug_info_section;
 class Eh_frame;
 class Gdb_index;
+class Debug_names;
 class Target;
 struct Timespec;
 
@@ -654,7 +655,7 @@ class Layout
 		       size_t fde_length);
 
   // Scan a .debug_info or .debug_types section, and add summary
-  // information to the .gdb_index section.
+  // information to the .gdb_index and .debug_names sections.
   template<int size, bool big_endian>
   void
   add_to_gdb_index(bool is_type_unit,
@@ -665,6 +666,11 @@ class Layout
 		   unsigned int reloc_shndx,
 		   unsigned int reloc_type);
 
+  // Queue the tasks that scan the sections passed to add_to_gdb_index.
+  // BLOCKER is held until they are done.
+  void
+  queue_gdb_index_tasks(Workqueue* workqueue, Task_token* blocker);
+
   // Handle a GNU stack note.  This is called once per input object
   // file.  SEEN_GNU_STACK is true if the object file has a
   // .note.GNU-stack section.  GNU_STACK_FLAGS is the section flags
@@ -792,6 +798,20 @@ class Layout
 			   unsigned int shndx, bool is_comdat,
 			   bool is_group_name, Kept_section** kept_section);
 
+  // Queue tasks to count the local symbols of the relocatable
+  // objects in parallel, before the layout is finalized.  The tasks
+  // unblock BLOCKER, which the finalize task must wait for.  This
+  // returns false if finalize should count the local symbols itself.
+  bool
+  queue_count_local_symbols(Workqueue*, const Input_objects*, Symbol_table*,
+			    Target*, Task_token* blocker);
+
+  // Queue tasks to read the strings of merge sections in parallel,
+  // before the layout is finalized.  The tasks unblock BLOCKER.  This
+  // returns whether any tasks were queued.
+  bool
+  queue_deferred_merge_sections(Workqueue*, Task_token* blocker);
+
   // Finalize the layout after all the input sections have been added.
   off_t
   finalize(const Input_objects*, Symbol_table*, Target*, const Task*);
@@ -801,6 +821,13 @@ class Layout
   any_postprocessing_sections() const
   { return this->any_postprocessing_sections_; }
 
+  // Queue tasks to postprocess the sections which require it, such as
+  // compressing debug sections, once all the input sections have been
+  // written.  BLOCKER is unblocked when they are done.  Return whether
+  // any tasks were queued.
+  bool
+  queue_postprocessing_sections(Workqueue*, Task_token* blocker);
+
   // Return the size of the output file.
   off_t
   output_file_size() const
@@ -1064,6 +1091,10 @@ class Layout
   void
   count_local_symbols(const Task*, const Input_objects*);
 
+  // Reserve space in the string pools for the local symbols.
+  void
+  reserve_local_symbols(const Input_objects*);
+
   // Create the output sections for the symbol table.
   void
   create_symtab_sections(const Input_objects*, Symbol_table*,
@@ -1381,6 +1412,8 @@ class Layout
   Output_section* eh_frame_hdr_section_;
   // The data for the .gdb_index section.
   Gdb_index* gdb_index_data_;
+  // The data for the .debug_names section.
+  Debug_names* debug_names_data_;
   // The space for the build ID checksum if there is one.
   Output_section_data* build_id_note_;
   // The output section containing dwarf abbreviations
@@ -1410,6 +1443,9 @@ class Layout
   bool any_postprocessing_sections_;
   // Whether we have resized the signatures_ hash table.
   bool resized_signatures_;
+  // Whether the local symbols were counted by Count_local_symbols
+  // tasks.
+  bool local_symbols_counted_;
   // Whether we have created a .stab*str output section.
   bool have_stabstr_section_;
   // True if the input sections in the output sections should be sorted
@@ -1599,6 +1635,41 @@ class Write_after_input_sections_task : public Task
   Task_token* final_blocker_;
 };
 
+// This task counts the local symbols of one relocatable object,
+// adding their names to the output string pools.  These tasks run in
+// parallel, so the string pools must be concurrent.
+
+class Count_local_symbols : public Task
+{
+ public:
+  Count_local_symbols(Relobj* object, Stringpool* sympool,
+		      Stringpool* dynpool, Task_token* final_blocker)
+    : object_(object), sympool_(sympool), dynpool_(dynpool),
+      final_blocker_(final_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable();
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const
+  { return "Count_local_symbols " + this->object_->name(); }
+
+ private:
+  Relobj* object_;
+  Stringpool* sympool_;
+  Stringpool* dynpool_;
+  Task_token* final_blocker_;
+};
+
 // This task function handles computation of the build id.
 // When using --build-id=tree, it schedules the tasks that
 // compute the hashes for each chunk of the file. This task
@@ -1623,6 +1694,28 @@ class Build_id_task_runner : public Task_function_runner
   Output_file* of_;
 };
 
+// This task function postprocesses sections, such as compressing
+// debug sections, in parallel, and then queues the
+// Write_after_input_sections_task.
+
+class Postprocessing_task_runner : public Task_function_runner
+{
+ public:
+  Postprocessing_task_runner(Layout* layout, Output_file* of,
+			     Task_token* final_blocker)
+    : layout_(layout), of_(of), final_blocker_(final_blocker)
+  { }
+
+  // Run the operation.
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  Layout* layout_;
+  Output_file* of_;
+  Task_token* final_blocker_;
+};
+
 // This task function handles closing the file.
 
 class Close_task_runner : public Task_function_runner
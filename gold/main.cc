@@ -251,6 +251,9 @@ main(int argc, char** argv)
   // Run the main task processing loop.
   workqueue.process(0);
 
+  if (command_line.options().user_set_trace_tasks())
+    workqueue.write_trace(command_line.options().trace_tasks());
+
   if (command_line.options().print_output_format())
     print_output_format();
 
@@ -301,6 +304,8 @@ main(int argc, char** argv)
       fprintf(stderr, _("%s: output file size: %lld bytes\n"),
 	      program_name, static_cast<long long>(layout.output_file_size()));
       symtab.print_stats();
+      if (symtab.gc() != NULL)
+	symtab.gc()->print_stats();
       layout.print_stats();
       Gdb_index::print_stats();
       Free_list::print_stats();
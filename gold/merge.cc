@@ -25,6 +25,9 @@
 #include <cstdlib>
 #include <algorithm>
 
+#include "parameters.h"
+#include "options.h"
+#include "workqueue.h"
 #include "merge.h"
 #include "compressed_output.h"
 
@@ -170,6 +173,25 @@ Object_merge_map::get_output_offset(unsigned int shndx,
   return true;
 }
 
+// Sort the mappings of each input section.
+
+void
+Object_merge_map::sort_mappings()
+{
+  for (Section_merge_maps::iterator p = this->section_merge_maps_.begin();
+       p != this->section_merge_maps_.end();
+       ++p)
+    {
+      Input_merge_map* map = p->second;
+      if (!map->sorted)
+	{
+	  std::sort(map->entries.begin(), map->entries.end(),
+		    Input_merge_compare());
+	  map->sorted = true;
+	}
+    }
+}
+
 // Return whether this is the merge map for section SHNDX.
 
 const Output_section_data*
@@ -266,27 +288,7 @@ Output_merge_data::Merge_data_hash::operator()(Merge_data_key k) const
   section_size_type entsize =
     convert_to_section_size_type(this->pomd_->entsize());
 
-  // Fowler/Noll/Vo (FNV) hash (type FNV-1a).
-  if (sizeof(size_t) == 8)
-    {
-      size_t result = static_cast<size_t>(14695981039346656037ULL);
-      for (section_size_type i = 0; i < entsize; ++i)
-	{
-	  result &= (size_t) *p++;
-	  result *= 1099511628211ULL;
-	}
-      return result;
-    }
-  else
-    {
-      size_t result = 2166136261UL;
-      for (section_size_type i = 0; i < entsize; ++i)
-	{
-	  result ^= (size_t) *p++;
-	  result *= 16777619UL;
-	}
-      return result;
-    }
+  return hash_bytes(p, entsize);
 }
 
 // Return whether one hash table key equals another.
@@ -431,6 +433,87 @@ Output_merge_data::do_print_merge_stats(const char* section_name)
 
 // Class Output_merge_string.
 
+// Output_merge_string<Char_type>::Add_strings_task.  This task adds
+// the strings of the deferred input sections of one object to the
+// Stringpool.  Tasks for different objects run in parallel, so the
+// Stringpool must be concurrent.
+
+template<typename Char_type>
+class Output_merge_string<Char_type>::Add_strings_task : public Task
+{
+ public:
+  Add_strings_task(Output_merge_string<Char_type>* pomsd,
+		   size_t begin, size_t end, Task_token* final_blocker)
+    : pomsd_(pomsd), object_(pomsd->merged_strings_lists_[begin]->object),
+      begin_(begin), end_(end), final_blocker_(final_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->object_->is_locked())
+      return this->object_->token();
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  {
+    Task_token* token = this->object_->token();
+    if (token != NULL)
+      tl->add(this, token);
+    tl->add(this, this->final_blocker_);
+  }
+
+  void
+  run(Workqueue*)
+  {
+    for (size_t i = this->begin_; i < this->end_; ++i)
+      {
+	Merged_strings_list*& merged_strings_list =
+	  this->pomsd_->merged_strings_lists_[i];
+	if (!this->pomsd_->add_strings(merged_strings_list))
+	  {
+	    // As in do_add_input_section, drop the section.  It is too
+	    // late to add it as an ordinary input section, but
+	    // add_strings has reported an error.
+	    delete merged_strings_list;
+	    merged_strings_list = NULL;
+	  }
+      }
+    this->object_->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Add_strings_task " + this->object_->name(); }
+
+ private:
+  // The merged section.
+  Output_merge_string<Char_type>* pomsd_;
+  // The object which all the input sections in the range belong to.
+  Relobj* object_;
+  // The range of merged_strings_lists_ entries to read.
+  size_t begin_;
+  size_t end_;
+  // The blocker to unblock when done.
+  Task_token* final_blocker_;
+};
+
+// Whether to defer reading the strings in input sections until
+// Layout::finalize, so that they can be read in parallel.
+
+template<typename Char_type>
+bool
+Output_merge_string<Char_type>::defer_input_sections()
+{
+  return (parameters->options().threads()
+	  && parameters->options().parallel_string_merge()
+	  && !parameters->incremental());
+}
+
 // Add an input section to a merged string section.
 
 template<typename Char_type>
@@ -438,6 +521,54 @@ bool
 Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 						     unsigned int shndx)
 {
+  if (defer_input_sections())
+    {
+      // Just check the size and record the section.  The strings are
+      // read by an Add_strings_task.
+      section_size_type sec_len =
+	convert_to_section_size_type(object->section_size(shndx));
+      section_size_type uncompressed_size;
+      if (object->section_is_compressed(shndx, &uncompressed_size))
+	sec_len = uncompressed_size;
+      if (sec_len % sizeof(Char_type) != 0)
+	{
+	  object->error(_("mergeable string section length not multiple of "
+			  "character size"));
+	  return false;
+	}
+      this->merged_strings_lists_.push_back(new Merged_strings_list(object,
+								    shndx));
+      this->has_deferred_sections_ = true;
+    }
+  else
+    {
+      Merged_strings_list* merged_strings_list =
+	new Merged_strings_list(object, shndx);
+      if (!this->add_strings(merged_strings_list))
+	{
+	  delete merged_strings_list;
+	  return false;
+	}
+      this->merged_strings_lists_.push_back(merged_strings_list);
+    }
+
+  // For script processing, we keep the input sections.
+  if (this->keeps_input_sections())
+    record_input_section(object, shndx);
+
+  return true;
+}
+
+// Add the strings in an input section to the Stringpool, and record
+// where they came from in MERGED_STRINGS_LIST.
+
+template<typename Char_type>
+bool
+Output_merge_string<Char_type>::add_strings(
+    Merged_strings_list* merged_strings_list)
+{
+  Relobj* object = merged_strings_list->object;
+  unsigned int shndx = merged_strings_list->shndx;
   section_size_type sec_len;
   bool is_new;
   const unsigned char* pdata = object->decompressed_section_contents(shndx,
@@ -468,9 +599,6 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 	--pend0;
     }
 
-  Merged_strings_list* merged_strings_list =
-      new Merged_strings_list(object, shndx);
-  this->merged_strings_lists_.push_back(merged_strings_list);
   Merged_strings& merged_strings = merged_strings_list->merged_strings;
 
   // Count the number of non-null strings in the section and size the list.
@@ -519,8 +647,8 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
   // compute the length of the last string.
   merged_strings.push_back(Merged_string(i, 0));
 
-  this->input_count_ += count;
-  this->input_size_ += i;
+  merged_strings_list->input_count = count;
+  merged_strings_list->input_size = i;
 
   if (has_misaligned_strings)
     gold_warning(_("%s: section %s contains incorrectly aligned strings;"
@@ -528,16 +656,48 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 		 object->name().c_str(),
 		 object->section_name(shndx).c_str());
 
-  // For script processing, we keep the input sections.
-  if (this->keeps_input_sections())
-    record_input_section(object, shndx);
-
   if (is_new)
     delete[] pdata;
 
   return true;
 }
 
+// Queue an Add_strings_task for each object with deferred input
+// sections.  The Stringpool is split into stripes by hash code, so
+// that the tasks only contend when they add strings with the same
+// stripe at the same time.  A concurrent Stringpool sorts its strings
+// when assigning offsets, so the output does not depend on the order
+// in which the tasks run.
+
+template<typename Char_type>
+bool
+Output_merge_string<Char_type>::do_queue_deferred_input_sections(
+    Workqueue* workqueue,
+    Task_token* final_blocker)
+{
+  if (!this->has_deferred_sections_)
+    return false;
+  this->has_deferred_sections_ = false;
+
+  const unsigned int stripe_count = 32;
+  this->stringpool_.set_concurrent(stripe_count);
+
+  const size_t count = this->merged_strings_lists_.size();
+  size_t begin = 0;
+  while (begin < count)
+    {
+      Relobj* object = this->merged_strings_lists_[begin]->object;
+      size_t end = begin + 1;
+      while (end < count && this->merged_strings_lists_[end]->object == object)
+	++end;
+      final_blocker->add_blocker();
+      workqueue->queue(new Add_strings_task(this, begin, end, final_blocker));
+      begin = end;
+    }
+
+  return true;
+}
+
 // Finalize the mappings from the input sections to the output
 // section, and return the final data size.
 
@@ -545,6 +705,9 @@ template<typename Char_type>
 section_size_type
 Output_merge_string<Char_type>::finalize_merged_data()
 {
+  // The deferred input sections must have been read.
+  gold_assert(!this->has_deferred_sections_);
+
   this->stringpool_.set_string_offsets();
 
   for (typename Merged_strings_lists::const_iterator l =
@@ -552,6 +715,10 @@ Output_merge_string<Char_type>::finalize_merged_data()
        l != this->merged_strings_lists_.end();
        ++l)
     {
+      // A deferred input section whose strings could not be read.
+      if (*l == NULL)
+	continue;
+
       section_offset_type last_input_offset = 0;
       section_offset_type last_output_offset = 0;
       Relobj *object = (*l)->object;
@@ -573,6 +740,8 @@ Output_merge_string<Char_type>::finalize_merged_data()
 	    last_output_offset =
 	        this->stringpool_.get_offset_from_key(p->stringpool_key);
 	}
+      this->input_count_ += (*l)->input_count;
+      this->input_size_ += (*l)->input_size;
       delete *l;
     }
 
@@ -33,6 +33,9 @@
 namespace gold
 {
 
+class Workqueue;
+class Task_token;
+
 // For each object with merge sections, we store an Object_merge_map.
 // This is used to map locations in input sections to a merged output
 // section.  The output section itself is not recorded here--it can be
@@ -72,6 +75,12 @@ class Object_merge_map
   const Output_section_data*
   find_merge_section(unsigned int shndx) const;
 
+  // Sort the mappings of each input section, so that later calls to
+  // get_output_offset change nothing and may be made by several
+  // threads at once.
+  void
+  sort_mappings();
+
   // Initialize an mapping from input offsets to output addresses for
   // section SHNDX.  STARTING_ADDRESS is the output address of the
   // merged section.
@@ -201,6 +210,15 @@ class Output_merge_base : public Output_section_data
   set_keeps_input_sections()
   { this->do_set_keeps_input_sections(); }
 
+  // Queue tasks to read the contents of input sections which
+  // add_input_section recorded but did not read.  FINAL_BLOCKER is
+  // unblocked when they are done.  This returns whether any tasks
+  // were queued.
+  bool
+  queue_deferred_input_sections(Workqueue* workqueue,
+				Task_token* final_blocker)
+  { return this->do_queue_deferred_input_sections(workqueue, final_blocker); }
+
   // Return the object of the first merged input section.  This used
   // for script processing.  This is NULL if merge section is empty.
   Relobj*
@@ -253,6 +271,11 @@ class Output_merge_base : public Output_section_data
   do_set_keeps_input_sections()
   { this->keeps_input_sections_ = true; }
 
+  // This may be overridden by the child class.
+  virtual bool
+  do_queue_deferred_input_sections(Workqueue*, Task_token*)
+  { return false; }
+
   // Record the merged input section for script processing.
   void
   record_input_section(Relobj* relobj, unsigned int shndx);
@@ -402,7 +425,8 @@ class Output_merge_string : public Output_merge_base
  public:
   Output_merge_string(uint64_t addralign)
     : Output_merge_base(sizeof(Char_type), addralign), stringpool_(addralign),
-      merged_strings_lists_(), input_count_(0), input_size_(0)
+      merged_strings_lists_(), input_count_(0), input_size_(0),
+      has_deferred_sections_(false)
   {
     this->stringpool_.set_no_zero_null();
   }
@@ -457,15 +481,33 @@ class Output_merge_string : public Output_merge_base
   void
   do_set_keeps_input_sections()
   {
-    gold_assert(this->input_count_ == 0);
+    gold_assert(this->merged_strings_lists_.empty());
     Output_merge_base::do_set_keeps_input_sections();
   }
 
+  // Queue Add_strings_task tasks for the deferred input sections.
+  bool
+  do_queue_deferred_input_sections(Workqueue*, Task_token*);
+
  private:
+  class Add_strings_task;
+
+  struct Merged_strings_list;
+
   // The name of the string type, for stats.
   const char*
   string_name();
 
+  // Whether to defer reading the strings in input sections, so that
+  // they can be added to the Stringpool in parallel.
+  static bool
+  defer_input_sections();
+
+  // Add the strings in the input section described by
+  // MERGED_STRINGS_LIST to the Stringpool.
+  bool
+  add_strings(Merged_strings_list* merged_strings_list);
+
   // As we see input sections, we build a mapping from object, section
   // index and offset to strings.
   struct Merged_string
@@ -490,9 +532,14 @@ class Output_merge_string : public Output_merge_base
     unsigned int shndx;
     // The list of merged strings.
     Merged_strings merged_strings;
+    // The number of non-null strings in the input section.
+    size_t input_count;
+    // The size of the input section.
+    size_t input_size;
 
     Merged_strings_list(Relobj* objecta, unsigned int shndxa)
-      : object(objecta), shndx(shndxa), merged_strings()
+      : object(objecta), shndx(shndxa), merged_strings(), input_count(0),
+	input_size(0)
     { }
   };
 
@@ -507,6 +554,9 @@ class Output_merge_string : public Output_merge_base
   size_t input_count_;
   // The total size of input sections.
   size_t input_size_;
+  // Whether there are entries in merged_strings_lists_ whose strings
+  // have not been read yet.
+  bool has_deferred_sections_;
 };
 
 } // End namespace gold.
@@ -29,6 +29,7 @@
 #include "libiberty.h"
 
 #include "gc.h"
+#include "gold-threads.h"
 #include "target-select.h"
 #include "dwarf_reader.h"
 #include "layout.h"
@@ -298,6 +299,13 @@ Relobj::merge_output_offset(unsigned int shndx, section_offset_type offset,
   return object_merge_map->get_output_offset(shndx, offset, poutput);
 }
 
+void
+Relobj::sort_merge_maps()
+{
+  if (this->object_merge_map_ != NULL)
+    this->object_merge_map_->sort_mappings();
+}
+
 const Output_section_data*
 Relobj::find_merge_section(unsigned int shndx) const {
   Object_merge_map* object_merge_map = this->object_merge_map_;
@@ -480,7 +488,8 @@ Sized_relobj_file<size, big_endian>::Sized_relobj_file(
     is_deferred_layout_(false),
     deferred_layout_(),
     deferred_layout_relocs_(),
-    output_views_(NULL)
+    output_views_(NULL),
+    relocate_parts_(NULL)
 {
   this->e_type_ = ehdr.get_e_type();
 }
@@ -663,55 +672,44 @@ Sized_relobj_file<size, big_endian>::find_eh_frame(
     }
 }
 
-// Return TRUE if this is a section whose contents will be needed in the
-// Add_symbols task.  This function is only called for sections that have
-// already passed the test in is_compressed_debug_section() and the debug
-// section name prefix, ".debug"/".zdebug", has been skipped.
+// Return TRUE if this is a section whose contents will be needed more
+// than once in the Add_symbols task, so that they should be kept once
+// they have been decompressed.  This function is only called for
+// sections that have already passed the test in
+// is_compressed_debug_section() and the debug section name prefix,
+// ".debug"/".zdebug", has been skipped.
 
 static bool
-need_decompressed_section(const char* name)
+cache_decompressed_section(const char* name)
 {
   if (*name++ != '_')
     return false;
 
-#ifdef ENABLE_THREADS
-  // Decompressing these sections now will help only if we're
-  // multithreaded.
-  if (parameters->options().threads())
-    {
-      // We will need .zdebug_str if this is not an incremental link
-      // (i.e., we are processing string merge sections) or if we need
-      // to build a gdb index.
-      if ((!parameters->incremental() || parameters->options().gdb_index())
-	  && strcmp(name, "str") == 0)
-	return true;
-
-      // We will need these other sections when building a gdb index.
-      if (parameters->options().gdb_index()
-	  && (strcmp(name, "info") == 0
-	      || strcmp(name, "types") == 0
-	      || strcmp(name, "pubnames") == 0
-	      || strcmp(name, "pubtypes") == 0
-	      || strcmp(name, "ranges") == 0
-	      || strcmp(name, "abbrev") == 0))
-	return true;
-    }
-#endif
-
-  // Even when single-threaded, we will need .zdebug_str if this is
-  // not an incremental link and we are building a gdb index.
-  // Otherwise, we would decompress the section twice: once for
-  // string merge processing, and once for building the gdb index.
-  if (!parameters->incremental()
-      && parameters->options().gdb_index()
-      && strcmp(name, "str") == 0)
+  // Building a gdb index or .debug_names reads these sections, and
+  // reads .debug_abbrev once for each compilation unit.  .debug_str
+  // is also read for string merge processing, if this is not an
+  // incremental link.
+  if ((parameters->options().gdb_index()
+       || parameters->options().debug_names())
+      && (strcmp(name, "str") == 0
+	  || strcmp(name, "info") == 0
+	  || strcmp(name, "types") == 0
+	  || strcmp(name, "pubnames") == 0
+	  || strcmp(name, "pubtypes") == 0
+	  || strcmp(name, "ranges") == 0
+	  || strcmp(name, "abbrev") == 0))
     return true;
 
   return false;
 }
 
 // Build a table for any compressed debug sections, mapping each section index
-// to the uncompressed size and (if needed) the decompressed contents.
+// to the uncompressed size.  Nothing is decompressed here: this runs
+// when the object is read, and the objects are read well ahead of the
+// Add_symbols tasks which use the contents, so decompressing here
+// could hold the debug info of every input file in memory at once.
+// If CACHE_IF_NEEDED, mark the sections whose contents should be
+// cached once decompressed.
 
 template<int size, bool big_endian>
 Compressed_section_map*
@@ -721,7 +719,7 @@ build_compressed_section_map(
     const char* names,
     section_size_type names_size,
     Object* obj,
-    bool decompress_if_needed)
+    bool cache_if_needed)
 {
   Compressed_section_map* uncompressed_map = new Compressed_section_map();
   const unsigned int shdr_size = elfcpp::Elf_sizes<size>::shdr_size;
@@ -752,6 +750,7 @@ build_compressed_section_map(
 	      const unsigned char* contents =
 		  obj->section_contents(i, &len, false);
 	      uint64_t uncompressed_size;
+	      uint64_t addralign = shdr.get_sh_addralign();
 	      if (is_zcompressed)
 		{
 		  // Skip over the ".zdebug" prefix.
@@ -764,28 +763,19 @@ build_compressed_section_map(
 		  name += 6;
 		  elfcpp::Chdr<size, big_endian> chdr(contents);
 		  uncompressed_size = chdr.get_ch_size();
+		  // sh_addralign is the alignment of the compression
+		  // header; the contents have their own.
+		  addralign = chdr.get_ch_addralign();
 		}
 	      Compressed_section_info info;
 	      info.size = convert_to_section_size_type(uncompressed_size);
 	      info.flag = shdr.get_sh_flags();
+	      info.addralign = addralign;
 	      info.contents = NULL;
+	      info.cache = (cache_if_needed
+			    && cache_decompressed_section(name));
 	      if (uncompressed_size != -1ULL)
-		{
-		  unsigned char* uncompressed_data = NULL;
-		  if (decompress_if_needed && need_decompressed_section(name))
-		    {
-		      uncompressed_data = new unsigned char[uncompressed_size];
-		      if (decompress_input_section(contents, len,
-						   uncompressed_data,
-						   uncompressed_size,
-						   size, big_endian,
-						   shdr.get_sh_flags()))
-			info.contents = uncompressed_data;
-		      else
-			delete[] uncompressed_data;
-		    }
-		  (*uncompressed_map)[i] = info;
-		}
+		(*uncompressed_map)[i] = info;
 	    }
 	}
     }
@@ -815,7 +805,8 @@ Sized_relobj_file<size, big_endian>::do_find_special_sections(
 
   return (this->has_eh_frame_
 	  || (!parameters->options().relocatable()
-	      && parameters->options().gdb_index()
+	      && (parameters->options().gdb_index()
+		  || parameters->options().debug_names())
 	      && (memmem(names, sd->section_names_size, "debug_info", 11) == 0
 		  || memmem(names, sd->section_names_size,
 			    "debug_types", 12) == 0)));
@@ -1770,11 +1761,13 @@ Sized_relobj_file<size, big_endian>::do_layout(Symbol_table* symtab,
 	  this->layout_section(layout, i, name, shdr, reloc_shndx[i],
 			       reloc_type[i]);
 
-	  // When generating a .gdb_index section, we do additional
-	  // processing of .debug_info and .debug_types sections after all
-	  // the other sections for the same reason as above.
+	  // When generating a .gdb_index or .debug_names section, we do
+	  // additional processing of .debug_info and .debug_types
+	  // sections after all the other sections for the same reason
+	  // as above.
 	  if (!relocatable
-	      && parameters->options().gdb_index()
+	      && (parameters->options().gdb_index()
+		  || parameters->options().debug_names())
 	      && !(shdr.get_sh_flags() & elfcpp::SHF_ALLOC))
 	    {
 	      if (strcmp(name, ".debug_info") == 0
@@ -2033,6 +2026,71 @@ Sized_relobj_file<size, big_endian>::do_add_symbols(Symbol_table* symtab,
   sd->symbol_names = NULL;
 }
 
+// Arrange to add the symbols to the symbol table later, when
+// resolving symbols in parallel.  The symbol table takes over the
+// views of the symbols and their names.
+
+template<int size, bool big_endian>
+bool
+Sized_relobj_file<size, big_endian>::do_defer_symbols(Symbol_table* symtab,
+						      Read_symbols_data* sd,
+						      Deferred_relobj** pdeferred)
+{
+  *pdeferred = NULL;
+
+  if (!symtab->parallel_resolution() || this->just_symbols())
+    return false;
+
+  if (sd->symbols == NULL)
+    {
+      gold_assert(sd->symbol_names == NULL);
+      return true;
+    }
+
+  const int sym_size = This::sym_size;
+  size_t symcount = ((sd->symbols_size - sd->external_symbols_offset)
+		     / sym_size);
+  if (symcount * sym_size != sd->symbols_size - sd->external_symbols_offset)
+    {
+      this->error(_("size of symbols is not multiple of symbol size"));
+      return true;
+    }
+
+  this->symbols_.resize(symcount);
+
+  // The extended section indexes are read on demand, but the file
+  // will not be locked when the symbols are added.  Read them now.
+  const unsigned char* syms = (sd->symbols->data()
+			       + sd->external_symbols_offset);
+  const unsigned char* p = syms;
+  for (size_t i = 0; i < symcount; ++i, p += sym_size)
+    {
+      elfcpp::Sym<size, big_endian> sym(p);
+      if (sym.get_st_shndx() == elfcpp::SHN_XINDEX)
+	{
+	  bool is_ordinary;
+	  this->adjust_sym_shndx(i + this->local_symbol_count_,
+				 sym.get_st_shndx(), &is_ordinary);
+	  break;
+	}
+    }
+
+  const char* sym_names =
+    reinterpret_cast<const char*>(sd->symbol_names->data());
+  *pdeferred = symtab->defer_relobj_symbols(this, sd->symbols,
+					    sd->symbol_names, syms,
+					    symcount,
+					    this->local_symbol_count_,
+					    sym_names,
+					    sd->symbol_names_size,
+					    &this->symbols_,
+					    &this->defined_count_);
+
+  sd->symbols = NULL;
+  sd->symbol_names = NULL;
+  return true;
+}
+
 // Find out if this object, that is a member of a lib group, should be included
 // in the link. We check every symbol defined by this object. If the symbol
 // table has a strong undefined reference to that symbol, we have to include
@@ -2901,7 +2959,7 @@ Object::decompressed_section_contents(
       return buffer;
     }
 
-  Compressed_section_map::const_iterator p =
+  Compressed_section_map::iterator p =
       this->compressed_sections_->find(shndx);
   if (p == this->compressed_sections_->end())
     {
@@ -2929,13 +2987,17 @@ Object::decompressed_section_contents(
     this->error(_("could not decompress section %s"),
 		this->do_section_name(shndx).c_str());
 
-  // We could cache the results in p->second.contents and store
-  // false in *IS_NEW, but build_compressed_section_map() would
-  // have done so if it had expected it to be profitable.  If
-  // we reach this point, we expect to need the contents only
-  // once in this pass.
+  // Keep the contents if build_compressed_section_map expected them
+  // to be needed again.  Otherwise we expect to need the contents
+  // only once in this pass.
   *plen = uncompressed_size;
-  *is_new = true;
+  if (p->second.cache)
+    {
+      p->second.contents = uncompressed_data;
+      *is_new = false;
+    }
+  else
+    *is_new = true;
   return uncompressed_data;
 }
 
@@ -2957,6 +3019,7 @@ Object::discard_decompressed_sections()
 	  delete[] p->second.contents;
 	  p->second.contents = NULL;
 	}
+      p->second.cache = false;
     }
 }
 
@@ -3102,6 +3165,14 @@ Input_objects::print_cref(const Symbol_table* symtab, FILE* f) const
 
 // Relocate_info methods.
 
+// The relocations of one object may be applied by several tasks at
+// once, so we use a lock when reading the debugging information to
+// describe a location.
+
+static Lock* relocate_location_lock;
+static Initialize_lock
+relocate_location_initialize_lock(&relocate_location_lock);
+
 // Return a string describing the location of a relocation when file
 // and lineno information is not available.  This is only used in
 // error messages.
@@ -3110,6 +3181,9 @@ template<int size, bool big_endian>
 std::string
 Relocate_info<size, big_endian>::location(size_t, off_t offset) const
 {
+  relocate_location_initialize_lock.initialize();
+  Hold_optional_lock hl(relocate_location_lock);
+
   Sized_dwarf_line_info<size, big_endian> line_info(this->object);
   std::string ret = line_info.addr2line(this->data_shndx, offset, NULL);
   if (!ret.empty())
@@ -37,6 +37,7 @@ namespace gold
 
 class General_options;
 class Task;
+class Lock;
 class Cref;
 class Layout;
 class Output_data;
@@ -49,6 +50,7 @@ class Dynobj;
 class Object_merge_map;
 class Relocatable_relocs;
 struct Symbols_data;
+struct Deferred_relobj;
 
 template<typename Stringpool_char>
 class Stringpool_template;
@@ -367,12 +369,16 @@ class Local_got_entry_key
 };
 
 // Type for mapping section index to uncompressed size and contents.
+// The contents are decompressed on demand.  If CACHE is set, they are
+// kept once decompressed, until discard_decompressed_sections.
 
 struct Compressed_section_info
 {
   section_size_type size;
   elfcpp::Elf_Xword flag;
+  uint64_t addralign;
   const unsigned char* contents;
+  bool cache;
 };
 typedef std::map<unsigned int, Compressed_section_info> Compressed_section_map;
 
@@ -380,7 +386,7 @@ template<int size, bool big_endian>
 Compressed_section_map*
 build_compressed_section_map(const unsigned char* pshdrs, unsigned int shnum,
 			     const char* names, section_size_type names_size,
-			     Object* obj, bool decompress_if_needed);
+			     Object* obj, bool cache_if_needed);
 
 // Object is an abstract base class which represents either a 32-bit
 // or a 64-bit input object.  This can be a regular object file
@@ -552,6 +558,13 @@ class Object
   const unsigned char*
   section_contents(unsigned int shndx, section_size_type* plen, bool cache);
 
+  // Return a lasting view of the contents of a section, or NULL if
+  // the section is empty.  Set *PLEN to the size.  The caller must
+  // delete the view while the object is locked.
+  File_view*
+  section_contents_lasting_view(unsigned int shndx, section_size_type* plen)
+  { return this->do_section_contents_lasting_view(shndx, plen); }
+
   // Adjust a symbol's section index as needed.  SYMNDX is the index
   // of the symbol and SHNDX is the symbol's section from
   // get_st_shndx.  This returns the section index.  It sets
@@ -655,6 +668,16 @@ class Object
   add_symbols(Symbol_table* symtab, Read_symbols_data* sd, Layout *layout)
   { this->do_add_symbols(symtab, sd, layout); }
 
+  // Arrange to add symbol information to the global symbol table
+  // later, in parallel with other objects.  This returns false if
+  // that is not possible, in which case add_symbols must be called.
+  // Otherwise, if it sets *PDEFERRED to a value other than NULL,
+  // SYMTAB->prepare_deferred_symbols must be called with that value.
+  bool
+  defer_symbols(Symbol_table* symtab, Read_symbols_data* sd,
+		Deferred_relobj** pdeferred)
+  { return this->do_defer_symbols(symtab, sd, pdeferred); }
+
   // Add symbol information to the global symbol table.
   Archive::Should_include
   should_include_member(Symbol_table* symtab, Layout* layout,
@@ -805,9 +828,13 @@ class Object
   set_no_export(bool value)
   { this->no_export_ = value; }
 
+  // Return whether section SHNDX is compressed.  If it is, set
+  // *UNCOMPRESSED_SIZE and, if it is not NULL, *UNCOMPRESSED_ADDRALIGN
+  // to the size and alignment of the uncompressed contents.
   bool
   section_is_compressed(unsigned int shndx,
-			section_size_type* uncompressed_size) const
+			section_size_type* uncompressed_size,
+			elfcpp::Elf_Xword* uncompressed_addralign = NULL) const
   {
     if (this->compressed_sections_ == NULL)
       return false;
@@ -817,6 +844,8 @@ class Object
       {
 	if (uncompressed_size != NULL)
 	  *uncompressed_size = p->second.size;
+	if (uncompressed_addralign != NULL)
+	  *uncompressed_addralign = p->second.addralign;
 	return true;
       }
     return false;
@@ -824,13 +853,14 @@ class Object
 
   // Return a view of the decompressed contents of a section.  Set *PLEN
   // to the size.  Set *IS_NEW to true if the contents need to be freed
-  // by the caller.
+  // by the caller.  A compressed section is decompressed here, when
+  // its contents are first needed.
   const unsigned char*
   decompressed_section_contents(unsigned int shndx, section_size_type* plen,
 				bool* is_cached);
 
-  // Discard any buffers of decompressed sections.  This is done
-  // at the end of the Add_symbols task.
+  // Discard any buffers of decompressed sections, and stop caching
+  // them.  This is done at the end of the Add_symbols task.
   void
   discard_decompressed_sections();
 
@@ -889,6 +919,12 @@ class Object
   virtual void
   do_add_symbols(Symbol_table*, Read_symbols_data*, Layout*) = 0;
 
+  // Arrange to add symbol information to the global symbol table
+  // later.  Most objects can not do this.
+  virtual bool
+  do_defer_symbols(Symbol_table*, Read_symbols_data*, Deferred_relobj**)
+  { return false; }
+
   virtual Archive::Should_include
   do_should_include_member(Symbol_table* symtab, Layout*, Read_symbols_data*,
                            std::string* why) = 0;
@@ -909,6 +945,12 @@ class Object
   do_section_contents(unsigned int shndx, section_size_type* plen,
 		      bool cache) = 0;
 
+  // Return a lasting view of the contents of a section--implemented
+  // by child class.
+  virtual File_view*
+  do_section_contents_lasting_view(unsigned int, section_size_type*)
+  { gold_unreachable(); }
+
   // Get the size of a section--implemented by child class.
   virtual uint64_t
   do_section_size(unsigned int shndx) = 0;
@@ -1279,6 +1321,27 @@ class Relobj : public Object
   relocate(const Symbol_table* symtab, const Layout* layout, Output_file* of)
   { return this->do_relocate(symtab, layout, of); }
 
+  // Start relocating the input sections, splitting the relocations
+  // into parts which may be applied by different tasks at the same
+  // time.  Return the number of parts, or 0 if the object should be
+  // relocated by relocate instead.
+  unsigned int
+  start_relocate(const Symbol_table* symtab, const Layout* layout,
+		 Output_file* of)
+  { return this->do_start_relocate(symtab, layout, of); }
+
+  // Apply the relocations in part PART, after start_relocate.
+  void
+  relocate_part(const Symbol_table* symtab, const Layout* layout,
+		Output_file* of, unsigned int part)
+  { this->do_relocate_part(symtab, layout, of, part); }
+
+  // Finish relocating after all the parts have been relocated, and
+  // write out the local symbols.
+  void
+  finish_relocate(const Layout* layout, Output_file* of)
+  { this->do_finish_relocate(layout, of); }
+
   // Return whether an input section is being included in the link.
   bool
   is_section_included(unsigned int shndx) const
@@ -1333,6 +1396,11 @@ class Relobj : public Object
   const Output_section_data*
   find_merge_section(unsigned int shndx) const;
 
+  // Sort the merge mappings, so that merge_output_offset may be
+  // called by several threads at once.
+  void
+  sort_merge_maps();
+
   // Record the relocatable reloc info for an input reloc section.
   void
   set_relocatable_relocs(unsigned int reloc_shndx, Relocatable_relocs* rr)
@@ -1457,6 +1525,25 @@ class Relobj : public Object
   virtual void
   do_relocate(const Symbol_table* symtab, const Layout*, Output_file* of) = 0;
 
+  // Start relocating in parts.  By default objects are relocated all
+  // at once.
+  virtual unsigned int
+  do_start_relocate(const Symbol_table*, const Layout*, Output_file*)
+  { return 0; }
+
+  // Relocate one part--implemented by a child class which implements
+  // do_start_relocate.
+  virtual void
+  do_relocate_part(const Symbol_table*, const Layout*, Output_file*,
+		   unsigned int)
+  { gold_unreachable(); }
+
+  // Finish relocating in parts--implemented by a child class which
+  // implements do_start_relocate.
+  virtual void
+  do_finish_relocate(const Layout*, Output_file*)
+  { gold_unreachable(); }
+
   // Set the offset of a section--implemented by child class.
   virtual void
   do_set_section_offset(unsigned int shndx, uint64_t off) = 0;
@@ -2389,6 +2476,10 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   void
   do_add_symbols(Symbol_table*, Read_symbols_data*, Layout*);
 
+  // Arrange to add the symbols to the symbol table later.
+  bool
+  do_defer_symbols(Symbol_table*, Read_symbols_data*, Deferred_relobj**);
+
   Archive::Should_include
   do_should_include_member(Symbol_table* symtab, Layout*, Read_symbols_data*,
                            std::string* why);
@@ -2432,6 +2523,20 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   void
   do_relocate(const Symbol_table* symtab, const Layout*, Output_file* of);
 
+  // Start relocating the input sections in parts.
+  unsigned int
+  do_start_relocate(const Symbol_table* symtab, const Layout*,
+		    Output_file* of);
+
+  // Relocate one part.
+  void
+  do_relocate_part(const Symbol_table* symtab, const Layout*,
+		   Output_file* of, unsigned int part);
+
+  // Finish relocating in parts, and write out the local symbols.
+  void
+  do_finish_relocate(const Layout*, Output_file* of);
+
   // Get the size of a section.
   uint64_t
   do_section_size(unsigned int shndx)
@@ -2457,6 +2562,18 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
     return this->get_view(loc.file_offset, *plen, true, cache);
   }
 
+  // Return a lasting view of the contents of a section.
+  File_view*
+  do_section_contents_lasting_view(unsigned int shndx,
+				   section_size_type* plen)
+  {
+    Object::Location loc(this->elf_file_.section_contents(shndx));
+    *plen = convert_to_section_size_type(loc.data_size);
+    if (*plen == 0)
+      return NULL;
+    return this->get_lasting_view(loc.file_offset, *plen, true, false);
+  }
+
   // Return section flags.
   uint64_t
   do_section_flags(unsigned int shndx);
@@ -2562,6 +2679,14 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
 		       const unsigned char* pshdrs, Output_file* of,
 		       Views* pviews);
 
+  // Return whether the relocations may be applied in parts by calling
+  // relocate_section_range for separate ranges of sections at the
+  // same time.  A child class which overrides do_relocate_sections
+  // should override this to return false.
+  virtual bool
+  do_can_relocate_in_parts() const
+  { return true; }
+
   // Relocate section data for a range of sections.
   void
   relocate_section_range(const Symbol_table* symtab, const Layout* layout,
@@ -2734,6 +2859,10 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   find_functions(const unsigned char* pshdrs, unsigned int shndx,
 		 Function_offsets*);
 
+  // Write out the views of the output file after relocating.
+  void
+  write_relocated_views(Output_file*, Views*);
+
   // Write out the local symbols.
   void
   write_local_symbols(Output_file*,
@@ -2852,8 +2981,21 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   std::vector<Deferred_layout> deferred_layout_;
   // The list of relocation sections whose layout was deferred.
   std::vector<Deferred_layout> deferred_layout_relocs_;
-  // Pointer to the list of output views; valid only during do_relocate().
+  // Pointer to the list of output views; valid only during do_relocate(),
+  // or from do_start_relocate() to do_finish_relocate().
   const Views* output_views_;
+  // The state of relocating in parts, from do_start_relocate() to
+  // do_finish_relocate().
+  struct Relocate_parts
+  {
+    // The views of the output file.
+    Views views;
+    // The first and last relocation section of each part.
+    std::vector<std::pair<unsigned int, unsigned int> > ranges;
+    // The lock for the views of the input file.
+    Lock* lock;
+  };
+  Relocate_parts* relocate_parts_;
 };
 
 // A class to manage the list of all objects.
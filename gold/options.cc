@@ -1208,6 +1208,13 @@ General_options::finalize()
 		 program_name);
 #endif
 
+#ifndef HAVE_ZSTD
+  if (strcmp(this->compress_debug_sections(), "zstd") == 0)
+    gold_fatal(_("--compress-debug-sections=zstd: "
+		 "%s was compiled without zstd support"),
+	       program_name);
+#endif
+
   std::string libpath;
   if (this->user_set_Y())
     {
@@ -1359,6 +1366,11 @@ General_options::finalize()
 			 "incremental link"));
 	  this->set_compress_debug_sections("none");
 	}
+      if (this->debug_names())
+	{
+	  gold_warning(_("ignoring --debug-names for an incremental link"));
+	  this->set_debug_names(false);
+	}
     }
 
   // --rosegment-gap implies --rosegment.
@@ -676,6 +676,11 @@ class General_options
 
   // a
 
+  DEFINE_bool(adaptive_threads, options::TWO_DASHES, '\0', false,
+	      N_("With --threads, use as many threads as the available CPUs "
+		 "and the waiting tasks need, up to the thread counts"),
+	      N_("With --threads, use the thread counts"));
+
   DEFINE_bool(add_needed, options::TWO_DASHES, '\0', false,
 	      N_("Not supported"),
 	      N_("Do not copy DT_NEEDED tags from shared libraries"));
@@ -694,6 +699,10 @@ class General_options
 	      N_("(aarch64 only) Do not apply link-time values "
 		 "for dynamic relocations"));
 
+  DEFINE_string(archive_index_cache, options::TWO_DASHES, '\0', NULL,
+		N_("Cache archive symbol maps in DIRECTORY"),
+		N_("DIRECTORY"));
+
   DEFINE_bool(as_needed, options::TWO_DASHES, '\0', false,
 	      N_("Use DT_NEEDED only for shared libraries that are used"),
 	      N_("Use DT_NEEDED for all shared libraries"));
@@ -718,14 +727,21 @@ class General_options
 			 N_("Generate build ID note"),
 			 N_("[=STYLE]"));
 
+  DEFINE_bool(build_id_chunked, options::TWO_DASHES, '\0', false,
+	      N_("Compute '--build-id=md5' and '--build-id=sha1' in parallel,"
+		 " as a hash of chunk hashes (changes the build ID)"),
+	      N_("Compute '--build-id=md5' and '--build-id=sha1' over the"
+		 " whole file"));
+
   DEFINE_uint64(build_id_chunk_size_for_treehash,
 		options::TWO_DASHES, '\0', 2 << 20,
-		N_("Chunk size for '--build-id=tree'"), N_("SIZE"));
+		N_("Chunk size for '--build-id=tree', '--build-id=xxhash'"
+		   " and '--build-id-chunked'"), N_("SIZE"));
 
   DEFINE_uint64(build_id_min_file_size_for_treehash, options::TWO_DASHES,
 		'\0', 40 << 20,
-		N_("Minimum output file size for '--build-id=tree' to work"
-		   " differently than '--build-id=sha1'"), N_("SIZE"));
+		N_("Minimum output file size for '--build-id=tree' and"
+		   " '--build-id-chunked' to hash chunks"), N_("SIZE"));
 
   DEFINE_bool(Bdynamic, options::ONE_DASH, '\0', true,
 	      N_("-l searches for shared libraries"), NULL);
@@ -757,8 +773,8 @@ class General_options
 
   DEFINE_enum(compress_debug_sections, options::TWO_DASHES, '\0', "none",
 	      N_("Compress .debug_* sections in the output file"),
-	      ("[none,zlib,zlib-gnu,zlib-gabi]"),
-	      {"none", "zlib", "zlib-gnu", "zlib-gabi"});
+	      ("[none,zlib,zlib-gnu,zlib-gabi,zstd]"),
+	      {"none", "zlib", "zlib-gnu", "zlib-gabi", "zstd"});
 
   DEFINE_bool(copy_dt_needed_entries, options::TWO_DASHES, '\0', false,
 	      N_("Not supported"),
@@ -786,6 +802,10 @@ class General_options
 		N_("Turn on debugging"),
 		N_("[all,files,script,task][,...]"));
 
+  DEFINE_bool(debug_names, options::TWO_DASHES, '\0', false,
+	      N_("Generate DWARF 5 .debug_names section"),
+	      N_("Do not generate .debug_names section"));
+
   DEFINE_special(defsym, options::TWO_DASHES, '\0',
 		 N_("Define a symbol"), N_("SYMBOL=EXPRESSION"));
 
@@ -1089,6 +1109,17 @@ class General_options
 		    N_("Do not create a position independent executable"),
 		    false);
 
+  DEFINE_bool(parallel_symbol_resolution, options::TWO_DASHES, '\0', false,
+	      N_("Add symbols from object files to the symbol and string "
+		 "tables in parallel when multi-threaded"),
+	      N_("Add symbols to the symbol and string tables serially "
+		 "(default)"));
+
+  DEFINE_bool(parallel_string_merge, options::TWO_DASHES, '\0', false,
+	      N_("Merge strings in SHF_MERGE|SHF_STRINGS sections in "
+		 "parallel when multi-threaded"),
+	      N_("Merge strings serially as sections are laid out (default)"));
+
   DEFINE_bool(pic_veneer, options::TWO_DASHES, '\0', false,
 	      N_("Force PIC sequences for ARM/Thumb interworking veneers"),
 	      NULL);
@@ -1119,6 +1150,10 @@ class General_options
 	      N_("Use posix_fallocate to reserve space in the output file"),
 	      N_("Use fallocate or ftruncate to reserve space"));
 
+  DEFINE_bool(prefetch_inputs, options::TWO_DASHES, '\0', false,
+	      N_("Ask the system to start reading input files early"),
+	      N_("Do not ask the system to start reading input files early"));
+
   DEFINE_bool(preread_archive_symbols, options::TWO_DASHES, '\0', false,
 	      N_("Preread archive symbols when multi-threaded"), NULL);
 
@@ -1158,6 +1193,11 @@ class General_options
   DEFINE_bool(relax, options::TWO_DASHES, '\0', false,
 	      N_("Relax branches on certain targets"), NULL);
 
+  DEFINE_uint(relocate_part_size, options::TWO_DASHES, '\0', 32768,
+	      N_("When multi-threaded, relocate objects with at least twice "
+		 "COUNT relocations in parts of about COUNT relocations"),
+	      N_("COUNT"));
+
   DEFINE_string(retain_symbols_file, options::TWO_DASHES, '\0', NULL,
 		N_("keep only symbols listed in this file"), N_("FILE"));
 
@@ -1255,6 +1295,11 @@ class General_options
   DEFINE_bool(trace, options::TWO_DASHES, 't', false,
 	      N_("Print the name of each input file"), NULL);
 
+  DEFINE_string(trace_tasks, options::TWO_DASHES, '\0', NULL,
+		N_("Write the time and thread of each task run to FILE, "
+		   "in Chrome trace event format"),
+		N_("FILE"));
+
   DEFINE_bool(target1_abs, options::TWO_DASHES, '\0', false,
 	      N_("(ARM only) Force R_ARM_TARGET1 type to R_ARM_ABS32"),
 	      NULL);
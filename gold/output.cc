@@ -2436,6 +2436,11 @@ Output_section::add_input_section(Layout* layout,
 				  bool have_sections_script)
 {
   elfcpp::Elf_Xword addralign = shdr.get_sh_addralign();
+  section_size_type input_section_size = shdr.get_sh_size();
+  section_size_type uncompressed_size;
+  if (object->section_is_compressed(shndx, &uncompressed_size, &addralign))
+    input_section_size = uncompressed_size;
+
   if ((addralign & (addralign - 1)) != 0)
     {
       object->error(_("invalid alignment %lu for section \"%s\""),
@@ -2485,11 +2490,6 @@ Output_section::add_input_section(Layout* layout,
 	}
     }
 
-  section_size_type input_section_size = shdr.get_sh_size();
-  section_size_type uncompressed_size;
-  if (object->section_is_compressed(shndx, &uncompressed_size))
-    input_section_size = uncompressed_size;
-
   off_t offset_in_section;
 
   if (this->has_fixed_layout())
@@ -2776,6 +2776,26 @@ Output_section::add_merge_input_section(Relobj* object, unsigned int shndx,
     }
 }
 
+// Queue tasks to read the deferred input sections of the merge
+// sections.
+
+bool
+Output_section::queue_deferred_merge_sections(Workqueue* workqueue,
+					      Task_token* final_blocker)
+{
+  bool queued = false;
+  for (Input_section_list::iterator p = this->input_sections_.begin();
+       p != this->input_sections_.end();
+       ++p)
+    {
+      if (p->is_merge_section()
+	  && p->output_merge_base()->queue_deferred_input_sections(
+	       workqueue, final_blocker))
+	queued = true;
+    }
+  return queued;
+}
+
 // Build a relaxation map to speed up relaxation of existing input sections.
 // Look up to the first LIMIT elements in INPUT_SECTIONS.
 
@@ -3280,6 +3280,44 @@ class Output_section : public Output_data
 			    Output_relaxed_input_section* poris,
 			    const std::string& name);
 
+  // Queue tasks to read the input sections which the merge sections
+  // of this output section deferred.  FINAL_BLOCKER is unblocked when
+  // they are done.  Return whether any tasks were queued.
+  bool
+  queue_deferred_merge_sections(Workqueue*, Task_token* final_blocker);
+
+  // Queue tasks to postprocess the contents of this section, such as
+  // compressing them, once all the input sections have been written
+  // to the postprocessing buffer.  FINAL_BLOCKER is unblocked when
+  // they are done.  Return whether any tasks were queued.
+  bool
+  queue_postprocessing(Workqueue* workqueue, Task_token* final_blocker)
+  {
+    if (this->postprocessing_buffer_ == NULL)
+      return false;
+    return this->do_queue_postprocessing(workqueue, final_blocker);
+  }
+
+  // An input section is still compressed in the input file.  It
+  // would be decompressed to UNCOMPRESSED_SIZE bytes at OFFSET in the
+  // postprocessing buffer; its compressed contents, including the
+  // compression header, are CONTENTS of size LEN, and its flags are
+  // SH_FLAGS.  Return true if the output section will use the
+  // compressed contents as they are, in which case the caller need
+  // not decompress them.  This is only called for input sections to
+  // which no relocations apply, and may be called by several threads
+  // at once.
+  bool
+  add_compressed_input_section(section_offset_type offset,
+			       section_size_type uncompressed_size,
+			       elfcpp::Elf_Xword sh_flags,
+			       const unsigned char* contents,
+			       section_size_type len)
+  {
+    return this->do_add_compressed_input_section(offset, uncompressed_size,
+						 sh_flags, contents, len);
+  }
+
   // Return the section name.
   const char*
   name() const
@@ -4176,6 +4214,20 @@ class Output_section : public Output_data
   virtual void
   set_final_data_size();
 
+  // Queue tasks to postprocess the section contents.  By default
+  // there is nothing to do in parallel.
+  virtual bool
+  do_queue_postprocessing(Workqueue*, Task_token*)
+  { return false; }
+
+  // Take compressed input section contents as they are.  By default
+  // they must be decompressed.
+  virtual bool
+  do_add_compressed_input_section(section_offset_type, section_size_type,
+				  elfcpp::Elf_Xword, const unsigned char*,
+				  section_size_type)
+  { return false; }
+
   // Reset the address and file offset.
   void
   do_reset_address_and_file_offset();
@@ -114,6 +114,11 @@ public:
       const unsigned char* pshdrs, Output_file* of,
       typename Sized_relobj_file<size, big_endian>::Views* pviews);
 
+  // The .toc section must be relocated before the other sections.
+  virtual bool
+  do_can_relocate_in_parts() const
+  { return false; }
+
   // The .toc section index.
   unsigned int
   toc_shndx() const
@@ -250,7 +250,10 @@ Read_symbols::do_lib_group(Workqueue* workqueue)
 					     m, NULL, next_blocker));
     }
 
-  add_lib_group_symbols->set_blocker(next_blocker, this->this_blocker_);
+  Task_token* this_blocker =
+    Resolve_symbols::queue_if_needed(workqueue, this->symtab_,
+				     this->this_blocker_);
+  add_lib_group_symbols->set_blocker(next_blocker, this_blocker);
   workqueue->queue_soon(add_lib_group_symbols);
 
   return true;
@@ -307,6 +310,9 @@ Read_symbols::do_read_symbols(Workqueue* workqueue)
 	  // Unlock the archive so it can be used in the next task.
 	  arch->unlock(this);
 
+	  Task_token* this_blocker =
+	    Resolve_symbols::queue_if_needed(workqueue, this->symtab_,
+					     this->this_blocker_);
 	  workqueue->queue_next(new Add_archive_symbols(this->symtab_,
 							this->layout_,
 							this->input_objects_,
@@ -316,7 +322,7 @@ Read_symbols::do_read_symbols(Workqueue* workqueue)
 							this->input_argument_,
 							arch,
 							this->input_group_,
-							this->this_blocker_,
+							this_blocker,
 							this->next_blocker_));
 	  return true;
 	}
@@ -419,6 +425,16 @@ Read_symbols::do_read_symbols(Workqueue* workqueue)
           return true;
         }
 
+      // The symbols from a relocatable object may be added in
+      // parallel with those of other objects.  Any other kind of
+      // object must wait until those have been added.
+
+      Task_token* this_blocker = this->this_blocker_;
+      if (elf_obj->is_dynamic() || input_file->just_symbols())
+	this_blocker = Resolve_symbols::queue_if_needed(workqueue,
+							this->symtab_,
+							this_blocker);
+
       // We use queue_next because everything is cached for this
       // task to run right away if possible.
 
@@ -431,7 +447,7 @@ Read_symbols::do_read_symbols(Workqueue* workqueue)
 					    elf_obj,
 					    NULL,
 					    sd,
-					    this->this_blocker_,
+					    this_blocker,
 					    this->next_blocker_));
 
       return true;
@@ -443,6 +459,9 @@ Read_symbols::do_read_symbols(Workqueue* workqueue)
   // read multiple scripts simultaneously, which could lead to
   // unpredictable changes to the General_options structure.
 
+  Task_token* this_blocker =
+    Resolve_symbols::queue_if_needed(workqueue, this->symtab_,
+				     this->this_blocker_);
   workqueue->queue_soon(new Read_script(this->symtab_,
 					this->layout_,
 					this->dirpath_,
@@ -452,7 +471,7 @@ Read_symbols::do_read_symbols(Workqueue* workqueue)
 					this->input_group_,
 					this->input_argument_,
 					input_file,
-					this->this_blocker_,
+					this_blocker,
 					this->next_blocker_));
   return true;
 }
@@ -479,6 +498,8 @@ Read_symbols::do_group(Workqueue* workqueue)
 						input_group,
 						this->next_blocker_);
 
+  this_blocker = Resolve_symbols::queue_if_needed(workqueue, this->symtab_,
+						  this_blocker);
   Task_token* next_blocker = new Task_token(true);
   next_blocker->add_blocker();
   workqueue->queue_soon(new Start_group(this->symtab_, finish_group,
@@ -502,6 +523,8 @@ Read_symbols::do_group(Workqueue* workqueue)
       this_blocker = next_blocker;
     }
 
+  this_blocker = Resolve_symbols::queue_if_needed(workqueue, this->symtab_,
+						  this_blocker);
   finish_group->set_blocker(this_blocker);
 
   workqueue->queue_soon(finish_group);
@@ -591,7 +614,7 @@ Add_symbols::locks(Task_locker* tl)
 // Add the symbols in the object to the symbol table.
 
 void
-Add_symbols::run(Workqueue*)
+Add_symbols::run(Workqueue* workqueue)
 {
   Pluginobj* pluginobj = this->object_->pluginobj();
   if (pluginobj != NULL)
@@ -632,7 +655,25 @@ Add_symbols::run(Workqueue*)
 					    this->library_, script_info);
 	}
       this->object_->layout(this->symtab_, this->layout_, this->sd_);
-      this->object_->add_symbols(this->symtab_, this->sd_, this->layout_);
+      Deferred_relobj* deferred;
+      if (this->object_->defer_symbols(this->symtab_, this->sd_, &deferred))
+	{
+	  if (deferred != NULL)
+	    {
+	      Task_token* blocker = this->symtab_->deferred_blocker();
+	      workqueue->add_blocker(blocker);
+	      workqueue->queue_soon(new Prepare_deferred_symbols(this->symtab_,
+								 deferred,
+								 blocker));
+	    }
+	}
+      else
+	{
+	  // Read_symbols queues a Resolve_symbols task ahead of any
+	  // object which can not be deferred.
+	  gold_assert(!this->symtab_->has_deferred_symbols());
+	  this->object_->add_symbols(this->symtab_, this->sd_, this->layout_);
+	}
       this->object_->discard_decompressed_sections();
       delete this->sd_;
       this->sd_ = NULL;
@@ -640,6 +681,138 @@ Add_symbols::run(Workqueue*)
     }
 }
 
+// Class Prepare_deferred_symbols.
+
+void
+Prepare_deferred_symbols::locks(Task_locker* tl)
+{
+  tl->add(this, this->blocker_);
+}
+
+void
+Prepare_deferred_symbols::run(Workqueue*)
+{
+  this->symtab_->prepare_deferred_symbols(this->deferred_);
+}
+
+// Class Resolve_symbols.
+
+Resolve_symbols::~Resolve_symbols()
+{
+  if (this->this_blocker_ != NULL)
+    delete this->this_blocker_;
+  // next_blocker_ is deleted by the task associated with the next
+  // input file.
+}
+
+// Queue a Resolve_symbols task if we are adding symbols in parallel.
+
+Task_token*
+Resolve_symbols::queue_if_needed(Workqueue* workqueue, Symbol_table* symtab,
+				 Task_token* this_blocker)
+{
+  if (!symtab->parallel_resolution())
+    return this_blocker;
+
+  Task_token* next_blocker = new Task_token(true);
+  next_blocker->add_blocker();
+  workqueue->queue_soon(new Resolve_symbols(symtab, this_blocker,
+					    next_blocker));
+  return next_blocker;
+}
+
+// We must wait for the previous input file, and for all the
+// Prepare_deferred_symbols tasks it queued.
+
+Task_token*
+Resolve_symbols::is_runnable()
+{
+  if (this->this_blocker_ != NULL && this->this_blocker_->is_blocked())
+    return this->this_blocker_;
+  Task_token* deferred_blocker = this->symtab_->deferred_blocker();
+  if (deferred_blocker->is_blocked())
+    return deferred_blocker;
+  return NULL;
+}
+
+void
+Resolve_symbols::locks(Task_locker* tl)
+{
+  tl->add(this, this->next_blocker_);
+}
+
+// Add the deferred symbols.  If we can add them in parallel, we queue
+// a task for each shard and keep the next input file blocked until
+// they are done.
+
+void
+Resolve_symbols::run(Workqueue* workqueue)
+{
+  if (!this->symtab_->has_deferred_symbols())
+    return;
+
+  if (!this->symtab_->can_resolve_deferred_in_parallel())
+    {
+      this->symtab_->resolve_deferred_symbols(this);
+      return;
+    }
+
+  unsigned int shard_count = this->symtab_->shard_count();
+  Task_token* shards_blocker = new Task_token(true);
+  shards_blocker->add_blockers(shard_count);
+  for (unsigned int i = 0; i < shard_count; ++i)
+    workqueue->queue_soon(new Resolve_symbols_shard(this->symtab_, i,
+						    shards_blocker));
+
+  workqueue->add_blocker(this->next_blocker_);
+  workqueue->queue_soon(new Finish_resolve_symbols(this->symtab_,
+						   shards_blocker,
+						   this->next_blocker_));
+}
+
+// Class Resolve_symbols_shard.
+
+void
+Resolve_symbols_shard::locks(Task_locker* tl)
+{
+  tl->add(this, this->blocker_);
+}
+
+void
+Resolve_symbols_shard::run(Workqueue*)
+{
+  this->symtab_->resolve_deferred_shard(this->shard_);
+}
+
+// Class Finish_resolve_symbols.
+
+Finish_resolve_symbols::~Finish_resolve_symbols()
+{
+  delete this->this_blocker_;
+}
+
+// We wait for all the Resolve_symbols_shard tasks.
+
+Task_token*
+Finish_resolve_symbols::is_runnable()
+{
+  if (this->this_blocker_->is_blocked())
+    return this->this_blocker_;
+  return NULL;
+}
+
+void
+Finish_resolve_symbols::locks(Task_locker* tl)
+{
+  tl->add(this, this->next_blocker_);
+}
+
+void
+Finish_resolve_symbols::run(Workqueue*)
+{
+  this->symtab_->finish_deferred_symbols(this);
+}
+
 // Class Read_member.
 
 Read_member::~Read_member()
@@ -176,6 +176,155 @@ private:
   Task_token* next_blocker_;
 };
 
+// With --parallel-symbol-resolution, Add_symbols does not add the
+// symbols from a relocatable object to the symbol table.  Instead it
+// defers them, and queues this Task to sort them by symbol table
+// shard while the following input files are processed.
+
+class Prepare_deferred_symbols : public Task
+{
+ public:
+  // DEFERRED is the object returned by Object::defer_symbols.
+  // BLOCKER is released when this task completes.
+  Prepare_deferred_symbols(Symbol_table* symtab, Deferred_relobj* deferred,
+			   Task_token* blocker)
+    : symtab_(symtab), deferred_(deferred), blocker_(blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const
+  { return "Prepare_deferred_symbols"; }
+
+ private:
+  Symbol_table* symtab_;
+  Deferred_relobj* deferred_;
+  Task_token* blocker_;
+};
+
+// This Task adds any deferred symbols to the symbol table.  It is
+// queued in the chain of input files before any task which needs to
+// see the symbols from all the preceding files.  It queues a
+// Resolve_symbols_shard task for each shard of the symbol table, and
+// a Finish_resolve_symbols task to unblock the next input file.
+
+class Resolve_symbols : public Task
+{
+ public:
+  Resolve_symbols(Symbol_table* symtab, Task_token* this_blocker,
+		  Task_token* next_blocker)
+    : symtab_(symtab), this_blocker_(this_blocker),
+      next_blocker_(next_blocker)
+  { }
+
+  ~Resolve_symbols();
+
+  // If symbols are being added in parallel, queue a Resolve_symbols
+  // task which waits for THIS_BLOCKER, and return a new blocker for
+  // the next task.  Otherwise just return THIS_BLOCKER.
+  static Task_token*
+  queue_if_needed(Workqueue*, Symbol_table*, Task_token* this_blocker);
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable();
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const
+  { return "Resolve_symbols"; }
+
+ private:
+  Symbol_table* symtab_;
+  Task_token* this_blocker_;
+  Task_token* next_blocker_;
+};
+
+// This Task adds the deferred symbols whose names fall in one shard
+// of the symbol table.
+
+class Resolve_symbols_shard : public Task
+{
+ public:
+  Resolve_symbols_shard(Symbol_table* symtab, unsigned int shard,
+			Task_token* blocker)
+    : symtab_(symtab), shard_(shard), blocker_(blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const
+  { return "Resolve_symbols_shard"; }
+
+ private:
+  Symbol_table* symtab_;
+  unsigned int shard_;
+  Task_token* blocker_;
+};
+
+// This Task runs after all the Resolve_symbols_shard tasks, and
+// unblocks the next input file.
+
+class Finish_resolve_symbols : public Task
+{
+ public:
+  Finish_resolve_symbols(Symbol_table* symtab, Task_token* this_blocker,
+			 Task_token* next_blocker)
+    : symtab_(symtab), this_blocker_(this_blocker),
+      next_blocker_(next_blocker)
+  { }
+
+  ~Finish_resolve_symbols();
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable();
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const
+  { return "Finish_resolve_symbols"; }
+
+ private:
+  Symbol_table* symtab_;
+  Task_token* this_blocker_;
+  Task_token* next_blocker_;
+};
+
 // This Task is responsible for reading the symbols from an archive
 // member that has changed since the last incremental link.
 
@@ -25,6 +25,7 @@
 #include <algorithm>
 
 #include "workqueue.h"
+#include "gold-threads.h"
 #include "layout.h"
 #include "symtab.h"
 #include "output.h"
@@ -234,15 +235,41 @@ Relocate_task::locks(Task_locker* tl)
 // Run the task.
 
 void
-Relocate_task::run(Workqueue*)
+Relocate_task::run(Workqueue* workqueue)
 {
-  this->object_->relocate(this->symtab_, this->layout_, this->of_);
+  unsigned int parts = this->object_->start_relocate(this->symtab_,
+						     this->layout_, this->of_);
+  if (parts == 0)
+    {
+      this->object_->relocate(this->symtab_, this->layout_, this->of_);
 
-  // This is normally the last thing we will do with an object, so
-  // uncache all views.
-  this->object_->clear_view_cache_marks();
+      // This is normally the last thing we will do with an object, so
+      // uncache all views.
+      this->object_->clear_view_cache_marks();
+
+      this->object_->release();
+      return;
+    }
 
   this->object_->release();
+
+  // Queue a task for each part, and a task to finish up once they
+  // are all done.  The finishing task unblocks INPUT_SECTIONS_BLOCKER
+  // and FINAL_BLOCKER in our place.
+  Task_token* parts_blocker = new Task_token(true);
+  parts_blocker->add_blockers(parts);
+  if (this->input_sections_blocker_ != NULL)
+    workqueue->add_blocker(this->input_sections_blocker_);
+  workqueue->add_blocker(this->final_blocker_);
+
+  for (unsigned int i = 0; i < parts; ++i)
+    workqueue->queue_soon(new Relocate_part_task(this->symtab_, this->layout_,
+						 this->object_, this->of_, i,
+						 parts_blocker));
+  workqueue->queue(new Relocate_finish_task(this->layout_, this->object_,
+					    this->of_, parts_blocker,
+					    this->input_sections_blocker_,
+					    this->final_blocker_));
 }
 
 // Return a debugging name for the task.
@@ -253,6 +280,97 @@ Relocate_task::get_name() const
   return "Relocate_task " + this->object_->name();
 }
 
+// Relocate_part_task methods.
+
+// A part can always run; it does not lock the object.
+
+Task_token*
+Relocate_part_task::is_runnable()
+{
+  return NULL;
+}
+
+// We unblock PARTS_BLOCKER when we are done.
+
+void
+Relocate_part_task::locks(Task_locker* tl)
+{
+  tl->add(this, this->parts_blocker_);
+}
+
+// Run the task.
+
+void
+Relocate_part_task::run(Workqueue*)
+{
+  this->object_->relocate_part(this->symtab_, this->layout_, this->of_,
+			       this->part_);
+}
+
+// Return a debugging name for the task.
+
+std::string
+Relocate_part_task::get_name() const
+{
+  char buf[30];
+  snprintf(buf, sizeof buf, " part %u", this->part_);
+  return "Relocate_part_task " + this->object_->name() + buf;
+}
+
+// Relocate_finish_task methods.
+
+Relocate_finish_task::~Relocate_finish_task()
+{
+  delete this->parts_blocker_;
+}
+
+// We have to wait for all the parts, and for the object.
+
+Task_token*
+Relocate_finish_task::is_runnable()
+{
+  if (this->parts_blocker_->is_blocked())
+    return this->parts_blocker_;
+
+  if (this->object_->is_locked())
+    return this->object_->token();
+
+  return NULL;
+}
+
+// We lock the file while we run, and unblock INPUT_SECTIONS_BLOCKER
+// and FINAL_BLOCKER when we are done.  INPUT_SECTIONS_BLOCKER may be
+// NULL.
+
+void
+Relocate_finish_task::locks(Task_locker* tl)
+{
+  if (this->input_sections_blocker_ != NULL)
+    tl->add(this, this->input_sections_blocker_);
+  tl->add(this, this->final_blocker_);
+  Task_token* token = this->object_->token();
+  if (token != NULL)
+    tl->add(this, token);
+}
+
+// Run the task.
+
+void
+Relocate_finish_task::run(Workqueue*)
+{
+  this->object_->finish_relocate(this->layout_, this->of_);
+  this->object_->clear_view_cache_marks();
+  this->object_->release();
+}
+
+// Return a debugging name for the task.
+
+std::string
+Relocate_finish_task::get_name() const
+{
+  return "Relocate_finish_task " + this->object_->name();
+}
+
 // Read the relocs and local symbols from the object file and store
 // the information in RD.
 
@@ -635,7 +753,164 @@ Sized_relobj_file<size, big_endian>::do_relocate(const Symbol_table* symtab,
   this->free_input_to_output_maps();
 
   // Write out the accumulated views.
-  for (unsigned int i = 1; i < shnum; ++i)
+  this->write_relocated_views(of, &views);
+
+  // Write out the local symbols.
+  this->write_local_symbols(of, layout->sympool(), layout->dynpool(),
+			    layout->symtab_xindex(), layout->dynsym_xindex(),
+			    layout->symtab_section_offset());
+}
+
+// Start relocating the input sections in parts, so that a very large
+// object does not hold up the end of the link.  We copy the section
+// data to the output file now, and each part applies the relocations
+// for a range of relocation sections of about --relocate-part-size
+// relocations.  An object with fewer than twice that many is
+// relocated all at once.  Return the number of parts, or 0 if we
+// should relocate the object all at once.
+
+template<int size, bool big_endian>
+unsigned int
+Sized_relobj_file<size, big_endian>::do_start_relocate(
+    const Symbol_table*,
+    const Layout* layout,
+    Output_file* of)
+{
+  // The parts read the input file without holding the lock on it,
+  // which we can only allow if no other object uses the file.  We
+  // don't try to split the work of a relocatable link, or of the
+  // relocations which need more than relocate_section_range.
+  if (!parameters->options().threads()
+      || this->offset() != 0
+      || parameters->options().relocatable()
+      || parameters->options().emit_relocs()
+      || parameters->incremental()
+      || this->uses_split_stack()
+      || !this->do_can_relocate_in_parts())
+    return 0;
+
+  const size_t relocate_part_size = parameters->options().relocate_part_size();
+  if (relocate_part_size == 0)
+    return 0;
+
+  unsigned int shnum = this->shnum();
+  const unsigned char* pshdrs = this->get_view(this->elf_file_.shoff(),
+					       shnum * This::shdr_size,
+					       true, true);
+
+  // Divide the relocation sections into ranges with about
+  // relocate_part_size relocations each.
+  std::vector<std::pair<unsigned int, unsigned int> > ranges;
+  unsigned int start_shndx = 1;
+  size_t count = 0;
+  size_t total = 0;
+  const unsigned char* p = pshdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
+    {
+      typename This::Shdr shdr(p);
+      unsigned int sh_type = shdr.get_sh_type();
+      if ((sh_type != elfcpp::SHT_REL && sh_type != elfcpp::SHT_RELA)
+	  || shdr.get_sh_entsize() == 0)
+	continue;
+      size_t n = shdr.get_sh_size() / shdr.get_sh_entsize();
+      count += n;
+      total += n;
+      if (count >= relocate_part_size)
+	{
+	  ranges.push_back(std::make_pair(start_shndx, i));
+	  start_shndx = i + 1;
+	  count = 0;
+	}
+    }
+  if (count > 0)
+    ranges.push_back(std::make_pair(start_shndx, shnum - 1));
+
+  if (total < 2 * relocate_part_size || ranges.size() < 2)
+    return 0;
+
+  Relocate_parts* parts = new Relocate_parts();
+  parts->views.resize(shnum);
+  parts->ranges.swap(ranges);
+  parts->lock = new Lock();
+  this->relocate_parts_ = parts;
+
+  this->write_sections(layout, pshdrs, of, &parts->views);
+
+  this->initialize_input_to_output_maps();
+
+  // Looking up an offset in a merged section may sort the mappings
+  // first; do it now, rather than in several parts at once.
+  this->sort_merge_maps();
+
+  this->output_views_ = &parts->views;
+
+  // From now until we finish, the parts may read the input file
+  // while the file is not locked.
+  this->input_file()->file().set_view_lock(parts->lock);
+
+  return parts->ranges.size();
+}
+
+// Apply the relocations in part PART.  This may run at the same time
+// as the other parts.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_relocate_part(
+    const Symbol_table* symtab,
+    const Layout* layout,
+    Output_file* of,
+    unsigned int part)
+{
+  Relocate_parts* parts = this->relocate_parts_;
+  gold_assert(parts != NULL && part < parts->ranges.size());
+
+  // The view of the section headers which do_start_relocate used may
+  // have been cleared when the file was released.
+  const unsigned char* pshdrs = this->get_view(this->elf_file_.shoff(),
+					       this->shnum() * This::shdr_size,
+					       true, true);
+
+  this->relocate_section_range(symtab, layout, pshdrs, of, &parts->views,
+			       parts->ranges[part].first,
+			       parts->ranges[part].second);
+}
+
+// Finish relocating in parts, once all the parts are done.  This
+// runs with the input file locked again.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_finish_relocate(const Layout* layout,
+							Output_file* of)
+{
+  Relocate_parts* parts = this->relocate_parts_;
+  gold_assert(parts != NULL);
+
+  this->input_file()->file().set_view_lock(NULL);
+  this->free_input_to_output_maps();
+  this->output_views_ = NULL;
+
+  this->write_relocated_views(of, &parts->views);
+
+  this->write_local_symbols(of, layout->sympool(), layout->dynpool(),
+			    layout->symtab_xindex(), layout->dynsym_xindex(),
+			    layout->symtab_section_offset());
+
+  delete parts->lock;
+  delete parts;
+  this->relocate_parts_ = NULL;
+}
+
+// Write out the views of the output file after applying relocations.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::write_relocated_views(Output_file* of,
+							   Views* pviews)
+{
+  Views& views(*pviews);
+  for (unsigned int i = 1; i < views.size(); ++i)
     {
       if (views[i].view != NULL)
 	{
@@ -653,11 +928,6 @@ Sized_relobj_file<size, big_endian>::do_relocate(const Symbol_table* symtab,
 	    }
 	}
     }
-
-  // Write out the local symbols.
-  this->write_local_symbols(of, layout->sympool(), layout->dynpool(),
-			    layout->symtab_xindex(), layout->dynsym_xindex(),
-			    layout->symtab_section_offset());
 }
 
 // Sort a Read_multiple vector by file offset.
@@ -669,6 +939,39 @@ struct Read_multiple_compare
   { return rme1.file_offset < rme2.file_offset; }
 };
 
+// Set (*HAS_RELOCS)[I] for each section I to which one of the SHNUM
+// section headers in PSHDRS is a reloc section which applies.
+
+template<int size>
+static void
+find_relocated_sections(const unsigned char* pshdrs, unsigned int shnum,
+			bool big_endian, std::vector<bool>* has_relocs)
+{
+  has_relocs->assign(shnum, false);
+  const int shdr_size = elfcpp::Elf_sizes<size>::shdr_size;
+  const unsigned char* p = pshdrs + shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, p += shdr_size)
+    {
+      elfcpp::Elf_Word sh_type;
+      elfcpp::Elf_Word sh_info;
+      if (big_endian)
+	{
+	  elfcpp::Shdr<size, true> shdr(p);
+	  sh_type = shdr.get_sh_type();
+	  sh_info = shdr.get_sh_info();
+	}
+      else
+	{
+	  elfcpp::Shdr<size, false> shdr(p);
+	  sh_type = shdr.get_sh_type();
+	  sh_info = shdr.get_sh_info();
+	}
+      if ((sh_type == elfcpp::SHT_REL || sh_type == elfcpp::SHT_RELA)
+	  && sh_info < shnum)
+	(*has_relocs)[sh_info] = true;
+    }
+}
+
 // Write section data to the output file.  PSHDRS points to the
 // section headers.  Record the views in *PVIEWS for use when
 // relocating.
@@ -687,6 +990,10 @@ Sized_relobj_file<size, big_endian>::write_sections(const Layout* layout,
   File_read::Read_multiple rm;
   bool is_sorted = true;
 
+  // The sections to which relocations apply, computed when first
+  // needed.
+  std::vector<bool> has_relocs;
+
   const unsigned char* p = pshdrs + This::shdr_size;
   for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
     {
@@ -824,12 +1131,26 @@ Sized_relobj_file<size, big_endian>::write_sections(const Layout* layout,
 
       if (must_decompress)
         {
-	  // Read and decompress the section.
+	  // Read and decompress the section.  If no relocations apply
+	  // to it, the output section may be able to use the
+	  // compressed contents as they are.
           section_size_type len;
 	  const unsigned char* p = this->section_contents(i, &len, false);
-	  if (!decompress_input_section(p, len, view, view_size,
-					size, big_endian,
-					shdr.get_sh_flags()))
+	  bool passed_through = false;
+	  if (os->requires_postprocessing())
+	    {
+	      if (has_relocs.empty())
+		find_relocated_sections<size>(pshdrs, shnum, big_endian,
+					      &has_relocs);
+	      if (!has_relocs[i])
+		passed_through =
+		  out_sections[i]->add_compressed_input_section(
+		      view_start, view_size, shdr.get_sh_flags(), p, len);
+	    }
+	  if (!passed_through
+	      && !decompress_input_section(p, len, view, view_size,
+					   size, big_endian,
+					   shdr.get_sh_flags()))
 	    this->error(_("could not decompress section %s"),
 			this->section_name(i).c_str());
         }
@@ -1704,6 +2025,24 @@ void
 Sized_relobj_file<32, false>::do_relocate(const Symbol_table* symtab,
 					  const Layout* layout,
 					  Output_file* of);
+
+template
+unsigned int
+Sized_relobj_file<32, false>::do_start_relocate(const Symbol_table* symtab,
+						const Layout* layout,
+						Output_file* of);
+
+template
+void
+Sized_relobj_file<32, false>::do_relocate_part(const Symbol_table* symtab,
+					       const Layout* layout,
+					       Output_file* of,
+					       unsigned int part);
+
+template
+void
+Sized_relobj_file<32, false>::do_finish_relocate(const Layout* layout,
+						 Output_file* of);
 #endif
 
 #ifdef HAVE_TARGET_32_BIG
@@ -1712,6 +2051,24 @@ void
 Sized_relobj_file<32, true>::do_relocate(const Symbol_table* symtab,
 					 const Layout* layout,
 					 Output_file* of);
+
+template
+unsigned int
+Sized_relobj_file<32, true>::do_start_relocate(const Symbol_table* symtab,
+					       const Layout* layout,
+					       Output_file* of);
+
+template
+void
+Sized_relobj_file<32, true>::do_relocate_part(const Symbol_table* symtab,
+					      const Layout* layout,
+					      Output_file* of,
+					      unsigned int part);
+
+template
+void
+Sized_relobj_file<32, true>::do_finish_relocate(const Layout* layout,
+						Output_file* of);
 #endif
 
 #ifdef HAVE_TARGET_64_LITTLE
@@ -1720,6 +2077,24 @@ void
 Sized_relobj_file<64, false>::do_relocate(const Symbol_table* symtab,
 					  const Layout* layout,
 					  Output_file* of);
+
+template
+unsigned int
+Sized_relobj_file<64, false>::do_start_relocate(const Symbol_table* symtab,
+						const Layout* layout,
+						Output_file* of);
+
+template
+void
+Sized_relobj_file<64, false>::do_relocate_part(const Symbol_table* symtab,
+					       const Layout* layout,
+					       Output_file* of,
+					       unsigned int part);
+
+template
+void
+Sized_relobj_file<64, false>::do_finish_relocate(const Layout* layout,
+						 Output_file* of);
 #endif
 
 #ifdef HAVE_TARGET_64_BIG
@@ -1728,6 +2103,24 @@ void
 Sized_relobj_file<64, true>::do_relocate(const Symbol_table* symtab,
 					 const Layout* layout,
 					 Output_file* of);
+
+template
+unsigned int
+Sized_relobj_file<64, true>::do_start_relocate(const Symbol_table* symtab,
+					       const Layout* layout,
+					       Output_file* of);
+
+template
+void
+Sized_relobj_file<64, true>::do_relocate_part(const Symbol_table* symtab,
+					      const Layout* layout,
+					      Output_file* of,
+					      unsigned int part);
+
+template
+void
+Sized_relobj_file<64, true>::do_finish_relocate(const Layout* layout,
+						Output_file* of);
 #endif
 
 #ifdef HAVE_TARGET_32_LITTLE
@@ -214,6 +214,83 @@ class Relocate_task : public Task
   Task_token* final_blocker_;
 };
 
+// A class to apply one part of the relocations of an object which is
+// relocated in parts.  The parts of an object run at the same time.
+
+class Relocate_part_task : public Task
+{
+ public:
+  Relocate_part_task(const Symbol_table* symtab, const Layout* layout,
+		     Relobj* object, Output_file* of, unsigned int part,
+		     Task_token* parts_blocker)
+    : symtab_(symtab), layout_(layout), object_(object), of_(of),
+      part_(part), parts_blocker_(parts_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable();
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const;
+
+ private:
+  const Symbol_table* symtab_;
+  const Layout* layout_;
+  Relobj* object_;
+  Output_file* of_;
+  unsigned int part_;
+  Task_token* parts_blocker_;
+};
+
+// A class to finish relocating an object which is relocated in parts,
+// once all the parts are done.
+
+class Relocate_finish_task : public Task
+{
+ public:
+  Relocate_finish_task(const Layout* layout, Relobj* object, Output_file* of,
+		       Task_token* parts_blocker,
+		       Task_token* input_sections_blocker,
+		       Task_token* final_blocker)
+    : layout_(layout), object_(object), of_(of),
+      parts_blocker_(parts_blocker),
+      input_sections_blocker_(input_sections_blocker),
+      final_blocker_(final_blocker)
+  { }
+
+  ~Relocate_finish_task();
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable();
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const;
+
+ private:
+  const Layout* layout_;
+  Relobj* object_;
+  Output_file* of_;
+  Task_token* parts_blocker_;
+  Task_token* input_sections_blocker_;
+  Task_token* final_blocker_;
+};
+
 // During a relocatable link, this class records how relocations
 // should be handled for a single input reloc section.  An instance of
 // this class is created while scanning relocs, and it is used while
@@ -28,6 +28,7 @@
 
 #include "output.h"
 #include "parameters.h"
+#include "gold-threads.h"
 #include "stringpool.h"
 
 namespace gold
@@ -35,33 +36,78 @@ namespace gold
 
 template<typename Stringpool_char>
 Stringpool_template<Stringpool_char>::Stringpool_template(uint64_t addralign)
-  : string_set_(), key_to_offset_(), strings_(), strtab_size_(0),
-    zero_null_(true), optimize_(false), offset_(sizeof(Stringpool_char)),
-    addralign_(addralign)
+  : stripes_(), strtab_size_(0), zero_null_(true), optimize_(false),
+    offset_(sizeof(Stringpool_char)), addralign_(addralign)
 {
   if (parameters->options_valid()
       && parameters->options().optimize() >= 2
       && addralign <= sizeof(Stringpool_char))
     this->optimize_ = true;
+  this->stripes_.push_back(new Stringpool_stripe());
 }
 
 template<typename Stringpool_char>
 void
 Stringpool_template<Stringpool_char>::clear()
 {
-  for (typename std::list<Stringdata*>::iterator p = this->strings_.begin();
-       p != this->strings_.end();
-       ++p)
-    delete[] reinterpret_cast<char*>(*p);
-  this->strings_.clear();
-  this->key_to_offset_.clear();
-  this->string_set_.clear();
+  for (typename Stripes::iterator ps = this->stripes_.begin();
+       ps != this->stripes_.end();
+       ++ps)
+    {
+      Stringpool_stripe* stripe = *ps;
+      for (typename std::list<Stringdata*>::iterator p =
+	     stripe->strings.begin();
+	   p != stripe->strings.end();
+	   ++p)
+	delete[] reinterpret_cast<char*>(*p);
+      stripe->strings.clear();
+      stripe->key_to_offset.clear();
+      stripe->string_set.clear();
+    }
 }
 
 template<typename Stringpool_char>
 Stringpool_template<Stringpool_char>::~Stringpool_template()
 {
   this->clear();
+  for (typename Stripes::iterator p = this->stripes_.begin();
+       p != this->stripes_.end();
+       ++p)
+    {
+      delete (*p)->lock;
+      delete *p;
+    }
+}
+
+// Split the pool into STRIPE_COUNT stripes, each with its own lock.
+
+template<typename Stringpool_char>
+void
+Stringpool_template<Stringpool_char>::set_concurrent(unsigned int stripe_count)
+{
+  gold_assert(this->count() == 0 && this->strtab_size_ == 0);
+  if (stripe_count <= 1 || stripe_count == this->stripes_.size())
+    return;
+
+  gold_assert(this->stripes_.size() == 1 && this->stripes_[0]->lock == NULL);
+  for (unsigned int i = 1; i < stripe_count; ++i)
+    this->stripes_.push_back(new Stringpool_stripe());
+  for (unsigned int i = 0; i < stripe_count; ++i)
+    this->stripes_[i]->lock = new Lock();
+}
+
+// Return the number of strings in the pool.
+
+template<typename Stringpool_char>
+size_t
+Stringpool_template<Stringpool_char>::count() const
+{
+  size_t ret = 0;
+  for (typename Stripes::const_iterator p = this->stripes_.begin();
+       p != this->stripes_.end();
+       ++p)
+    ret += (*p)->string_set.size();
+  return ret;
 }
 
 // Resize the internal hashtable with the expectation we'll get n new
@@ -73,24 +119,39 @@ template<typename Stringpool_char>
 void
 Stringpool_template<Stringpool_char>::reserve(unsigned int n)
 {
-  this->key_to_offset_.reserve(n);
+  // Assume that the strings will be spread evenly over the stripes.
+  const unsigned int stripe_count = this->stripes_.size();
+  n = (n + stripe_count - 1) / stripe_count;
+  for (typename Stripes::iterator p = this->stripes_.begin();
+       p != this->stripes_.end();
+       ++p)
+    this->reserve_stripe(*p, n);
+}
+
+template<typename Stringpool_char>
+void
+Stringpool_template<Stringpool_char>::reserve_stripe(Stringpool_stripe* stripe,
+						     unsigned int n)
+{
+  stripe->key_to_offset.reserve(n);
 
 #if defined(HAVE_UNORDERED_MAP)
-  this->string_set_.rehash(this->string_set_.size() + n);
+  stripe->string_set.rehash(stripe->string_set.size() + n);
   return;
 #elif defined(HAVE_TR1_UNORDERED_MAP)
   // rehash() implementation is broken in gcc 4.0.3's stl
-  //this->string_set_.rehash(this->string_set_.size() + n);
+  //stripe->string_set.rehash(stripe->string_set.size() + n);
   //return;
 #elif defined(HAVE_EXT_HASH_MAP)
-  this->string_set_.resize(this->string_set_.size() + n);
+  stripe->string_set.resize(stripe->string_set.size() + n);
   return;
 #endif
 
   // This is the generic "reserve" code, if no #ifdef above triggers.
-  String_set_type new_string_set(this->string_set_.size() + n);
-  new_string_set.insert(this->string_set_.begin(), this->string_set_.end());
-  this->string_set_.swap(new_string_set);
+  String_set_type new_string_set(stripe->string_set.size() + n);
+  new_string_set.insert(stripe->string_set.begin(),
+			stripe->string_set.end());
+  stripe->string_set.swap(new_string_set);
 }
 
 // Compare two strings of arbitrary character type for equality.
@@ -147,7 +208,8 @@ Stringpool_template<Stringpool_char>::string_hash(const Stringpool_char* s,
 
 template<typename Stringpool_char>
 const Stringpool_char*
-Stringpool_template<Stringpool_char>::add_string(const Stringpool_char* s,
+Stringpool_template<Stringpool_char>::add_string(Stringpool_stripe* stripe,
+						 const Stringpool_char* s,
 						 size_t len)
 {
   // We are in trouble if we've already computed the string offsets.
@@ -171,11 +233,11 @@ Stringpool_template<Stringpool_char>::add_string(const Stringpool_char* s,
       alc = sizeof(Stringdata) + len;
       front = false;
     }
-  else if (this->strings_.empty())
+  else if (stripe->strings.empty())
     alc = sizeof(Stringdata) + buffer_size;
   else
     {
-      Stringdata* psd = this->strings_.front();
+      Stringdata* psd = stripe->strings.front();
       if (len > psd->alc - psd->len)
 	alc = sizeof(Stringdata) + buffer_size;
       else
@@ -199,9 +261,9 @@ Stringpool_template<Stringpool_char>::add_string(const Stringpool_char* s,
   psd->len = len;
 
   if (front)
-    this->strings_.push_front(psd);
+    stripe->strings.push_front(psd);
   else
-    this->strings_.push_back(psd);
+    stripe->strings.push_back(psd);
 
   return reinterpret_cast<const Stringpool_char*>(psd->data);
 }
@@ -216,14 +278,16 @@ Stringpool_template<Stringpool_char>::add(const Stringpool_char* s, bool copy,
   return this->add_with_length(s, string_length(s), copy, pkey);
 }
 
-// Add a new key offset entry.
+// Add a new key offset entry.  In a concurrent pool the offsets are
+// not known until set_string_offsets.
 
 template<typename Stringpool_char>
 void
-Stringpool_template<Stringpool_char>::new_key_offset(size_t length)
+Stringpool_template<Stringpool_char>::new_key_offset(Stringpool_stripe* stripe,
+						     size_t length)
 {
   section_offset_type offset;
-  if (this->zero_null_ && length == 0)
+  if ((this->zero_null_ && length == 0) || this->stripes_.size() > 1)
     offset = 0;
   else
     {
@@ -232,7 +296,7 @@ Stringpool_template<Stringpool_char>::new_key_offset(size_t length)
       offset = align_address(offset, this->addralign_);
       this->offset_ = offset + (length + 1) * sizeof(Stringpool_char);
     }
-  this->key_to_offset_.push_back(offset);
+  stripe->key_to_offset.push_back(offset);
 }
 
 template<typename Stringpool_char>
@@ -244,17 +308,24 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
 {
   typedef std::pair<typename String_set_type::iterator, bool> Insert_type;
 
+  // The hash code is computed before taking the lock of the stripe.
+  Hashkey hk(s, length);
+  const unsigned int stripe_index = this->stripe_for_hash(hk.hash_code);
+  Stringpool_stripe* stripe = this->stripes_[stripe_index];
+  Hold_optional_lock hl(stripe->lock);
+
   // We add 1 so that 0 is always invalid.
-  const Key k = this->key_to_offset_.size() + 1;
+  const Key k = (stripe->key_to_offset.size() * this->stripes_.size()
+		 + stripe_index + 1);
 
   if (!copy)
     {
       // When we don't need to copy the string, we can call insert
       // directly.
 
-      std::pair<Hashkey, Hashval> element(Hashkey(s, length), k);
+      std::pair<Hashkey, Hashval> element(hk, k);
 
-      Insert_type ins = this->string_set_.insert(element);
+      Insert_type ins = stripe->string_set.insert(element);
 
       typename String_set_type::const_iterator p = ins.first;
 
@@ -262,7 +333,7 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
 	{
 	  // We just added the string.  The key value has now been
 	  // used.
-	  this->new_key_offset(length);
+	  this->new_key_offset(stripe, length);
 	}
       else
 	{
@@ -279,24 +350,23 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
   // canonicalize it by copying it into the canonical list. The hash
   // code will only be computed once.
 
-  Hashkey hk(s, length);
-  typename String_set_type::const_iterator p = this->string_set_.find(hk);
-  if (p != this->string_set_.end())
+  typename String_set_type::const_iterator p = stripe->string_set.find(hk);
+  if (p != stripe->string_set.end())
     {
       if (pkey != NULL)
 	*pkey = p->second;
       return p->first.string;
     }
 
-  this->new_key_offset(length);
+  this->new_key_offset(stripe, length);
 
-  hk.string = this->add_string(s, length);
+  hk.string = this->add_string(stripe, s, length);
   // The contents of the string stay the same, so we don't need to
   // adjust hk.hash_code or hk.length.
 
   std::pair<Hashkey, Hashval> element(hk, k);
 
-  Insert_type ins = this->string_set_.insert(element);
+  Insert_type ins = stripe->string_set.insert(element);
   gold_assert(ins.second);
 
   if (pkey != NULL)
@@ -310,8 +380,11 @@ Stringpool_template<Stringpool_char>::find(const Stringpool_char* s,
 					   Key* pkey) const
 {
   Hashkey hk(s);
-  typename String_set_type::const_iterator p = this->string_set_.find(hk);
-  if (p == this->string_set_.end())
+  Stringpool_stripe* stripe =
+    this->stripes_[this->stripe_for_hash(hk.hash_code)];
+  Hold_optional_lock hl(stripe->lock);
+  typename String_set_type::const_iterator p = stripe->string_set.find(hk);
+  if (p == stripe->string_set.end())
     return NULL;
 
   if (pkey != NULL)
@@ -354,6 +427,26 @@ Stringpool_template<Stringpool_char>::Stringpool_sort_comparison::operator()(
   return len1 > len2;
 }
 
+// Comparison routine used to put the strings of a concurrent pool in
+// a repeatable order.  Any total order on the string contents will
+// do.
+
+template<typename Stringpool_char>
+bool
+Stringpool_template<Stringpool_char>::Stringpool_hash_comparison::operator()(
+  const Stringpool_sort_info& sort_info1,
+  const Stringpool_sort_info& sort_info2) const
+{
+  const Hashkey& h1(sort_info1->first);
+  const Hashkey& h2(sort_info2->first);
+  if (h1.hash_code != h2.hash_code)
+    return h1.hash_code < h2.hash_code;
+  if (h1.length != h2.length)
+    return h1.length < h2.length;
+  return memcmp(h1.string, h2.string,
+		h1.length * sizeof(Stringpool_char)) < 0;
+}
+
 // Return whether s1 is a suffix of s2.
 
 template<typename Stringpool_char>
@@ -391,24 +484,35 @@ Stringpool_template<Stringpool_char>::set_string_offsets()
   // the strtab size, and gives a relatively small benefit (it's
   // typically rare for a symbol to be a suffix of another), we only
   // take the time to sort when the user asks for heavy optimization.
-  if (!this->optimize_)
+  // A concurrent pool must always be sorted, but when not optimizing
+  // we use a cheaper sort which does not find suffixes.
+  if (!this->optimize_ && this->stripes_.size() == 1)
     {
       // If we are not optimizing, the offsets are already assigned.
       offset = this->offset_;
     }
   else
     {
-      size_t count = this->string_set_.size();
+      size_t count = this->count();
 
       std::vector<Stringpool_sort_info> v;
       v.reserve(count);
 
-      for (typename String_set_type::iterator p = this->string_set_.begin();
-           p != this->string_set_.end();
-           ++p)
-        v.push_back(Stringpool_sort_info(p));
+      for (typename Stripes::iterator ps = this->stripes_.begin();
+	   ps != this->stripes_.end();
+	   ++ps)
+	{
+	  String_set_type& string_set((*ps)->string_set);
+	  for (typename String_set_type::iterator p = string_set.begin();
+	       p != string_set.end();
+	       ++p)
+	    v.push_back(Stringpool_sort_info(p));
+	}
 
-      std::sort(v.begin(), v.end(), Stringpool_sort_comparison());
+      if (this->optimize_)
+	std::sort(v.begin(), v.end(), Stringpool_sort_comparison());
+      else
+	std::sort(v.begin(), v.end(), Stringpool_hash_comparison());
 
       section_offset_type last_offset = -1;
       for (typename std::vector<Stringpool_sort_info>::iterator last = v.end(),
@@ -419,7 +523,8 @@ Stringpool_template<Stringpool_char>::set_string_offsets()
 	  section_offset_type this_offset;
           if (this->zero_null_ && (*curr)->first.string[0] == 0)
             this_offset = 0;
-          else if (last != v.end()
+          else if (this->optimize_
+		   && last != v.end()
                    && ((((*curr)->first.length - (*last)->first.length)
 			% this->addralign_) == 0)
                    && is_suffix((*curr)->first.string,
@@ -434,7 +539,7 @@ Stringpool_template<Stringpool_char>::set_string_offsets()
               this_offset = align_address(offset, this->addralign_);
               offset = this_offset + ((*curr)->first.length + 1) * charsize;
             }
-	  this->key_to_offset_[(*curr)->second - 1] = this_offset;
+	  this->key_offset((*curr)->second) = this_offset;
 	  last_offset = this_offset;
         }
     }
@@ -461,9 +566,11 @@ Stringpool_template<Stringpool_char>::get_offset_with_length(
 {
   gold_assert(this->strtab_size_ != 0);
   Hashkey hk(s, length);
-  typename String_set_type::const_iterator p = this->string_set_.find(hk);
-  if (p != this->string_set_.end())
-    return this->key_to_offset_[p->second - 1];
+  const Stringpool_stripe* stripe =
+    this->stripes_[this->stripe_for_hash(hk.hash_code)];
+  typename String_set_type::const_iterator p = stripe->string_set.find(hk);
+  if (p != stripe->string_set.end())
+    return this->get_offset_from_key(p->second);
   gold_unreachable();
 }
 
@@ -479,15 +586,22 @@ Stringpool_template<Stringpool_char>::write_to_buffer(
   gold_assert(bufsize >= this->strtab_size_);
   if (this->zero_null_)
     buffer[0] = '\0';
-  for (typename String_set_type::const_iterator p = this->string_set_.begin();
-       p != this->string_set_.end();
-       ++p)
+  for (typename Stripes::const_iterator ps = this->stripes_.begin();
+       ps != this->stripes_.end();
+       ++ps)
     {
-      const int len = (p->first.length + 1) * sizeof(Stringpool_char);
-      const section_offset_type offset = this->key_to_offset_[p->second - 1];
-      gold_assert(static_cast<section_size_type>(offset) + len
-		  <= this->strtab_size_);
-      memcpy(buffer + offset, p->first.string, len);
+      const String_set_type& string_set((*ps)->string_set);
+      for (typename String_set_type::const_iterator p = string_set.begin();
+	   p != string_set.end();
+	   ++p)
+	{
+	  const int len = (p->first.length + 1) * sizeof(Stringpool_char);
+	  const section_offset_type offset =
+	    this->get_offset_from_key(p->second);
+	  gold_assert(static_cast<section_size_type>(offset) + len
+		      <= this->strtab_size_);
+	  memcpy(buffer + offset, p->first.string, len);
+	}
     }
 }
 
@@ -509,16 +623,29 @@ template<typename Stringpool_char>
 void
 Stringpool_template<Stringpool_char>::print_stats(const char* name) const
 {
+  size_t buckets = 0;
+  size_t strings = 0;
+  for (typename Stripes::const_iterator p = this->stripes_.begin();
+       p != this->stripes_.end();
+       ++p)
+    {
+#if defined(HAVE_UNORDERED_MAP) || defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
+      buckets += (*p)->string_set.bucket_count();
+#endif
+      strings += (*p)->strings.size();
+    }
 #if defined(HAVE_UNORDERED_MAP) || defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
   fprintf(stderr, _("%s: %s entries: %zu; buckets: %zu\n"),
-	  program_name, name, this->string_set_.size(),
-	  this->string_set_.bucket_count());
+	  program_name, name, this->count(), buckets);
 #else
   fprintf(stderr, _("%s: %s entries: %zu\n"),
-	  program_name, name, this->table_.size());
+	  program_name, name, this->count());
 #endif
+  if (this->stripes_.size() > 1)
+    fprintf(stderr, _("%s: %s stripes: %zu\n"),
+	    program_name, name, this->stripes_.size());
   fprintf(stderr, _("%s: %s Stringdata structures: %zu\n"),
-	  program_name, name, this->strings_.size());
+	  program_name, name, strings);
 }
 
 // Instantiate the templates we need.
@@ -31,6 +31,7 @@ namespace gold
 {
 
 class Output_file;
+class Lock;
 
 // Return the length of a string in units of Char_type.
 
@@ -89,6 +90,17 @@ string_length(const char* p)
 // string "abc" will be stored, and "bc" will be represented by an
 // offset into the middle of the string "abc".
 
+// A Stringpool may be made concurrent, so that several threads can
+// add strings at the same time.  The hash table is then split into
+// stripes by the hash code of the string, and each stripe has its own
+// lock.  The key for a string is still unique, and still depends only
+// on the order in which strings are added to each stripe.  When
+// threads race to add strings, the keys are not repeatable, so a
+// concurrent Stringpool does not assign string table offsets in key
+// order; instead set_string_offsets sorts the strings, which gives
+// the same string table no matter what order the strings were added
+// in.
+
 
 // A simple chunked vector class--this is a subset of std::vector
 // which stores memory in chunks.  We don't provide iterators, because
@@ -200,12 +212,32 @@ class Stringpool_template
   void
   set_no_zero_null()
   {
-    gold_assert(this->string_set_.empty()
+    gold_assert(this->count() == 0
 		&& this->offset_ == sizeof(Stringpool_char));
     this->zero_null_ = false;
     this->offset_ = 0;
   }
 
+  // Split the hash table into STRIPE_COUNT stripes, each with its own
+  // lock, so that strings may be added by several threads at once.
+  // This may only be called before any strings are added.
+  void
+  set_concurrent(unsigned int stripe_count);
+
+  // Return the number of stripes.  This is 1 unless set_concurrent
+  // has been called.
+  unsigned int
+  stripe_count() const
+  { return this->stripes_.size(); }
+
+  // Return the stripe which holds, or would hold, the string S of
+  // length LEN characters.  The key of a string in stripe N is always
+  // N + 1 modulo stripe_count, so a caller which partitions its own
+  // data the same way can find the stripe from the key alone.
+  unsigned int
+  stripe_index(const Stringpool_char* s, size_t len) const
+  { return this->stripe_for_hash(string_hash(s, len)); }
+
   // Indicate that this string pool should be optimized, even if not
   // running with -O2.
   void
@@ -261,8 +293,11 @@ class Stringpool_template
   section_offset_type
   get_offset_from_key(Key k) const
   {
-    gold_assert(k <= this->key_to_offset_.size());
-    return this->key_to_offset_[k - 1];
+    const size_t n = this->stripes_.size();
+    const Key_to_offset& key_to_offset(this->stripes_[(k - 1) % n]
+				       ->key_to_offset);
+    gold_assert((k - 1) / n < key_to_offset.size());
+    return key_to_offset[(k - 1) / n];
   }
 
   // Get the size of the string table.  This returns the number of
@@ -313,13 +348,32 @@ class Stringpool_template
     char data[1];
   };
 
+  struct Stringpool_stripe;
+
+  // Return the total number of strings in the pool.
+  size_t
+  count() const;
+
+  // Return the index of the stripe for a string with hash code H.
+  unsigned int
+  stripe_for_hash(size_t h) const
+  {
+    if (this->stripes_.size() == 1)
+      return 0;
+    return (h ^ (h >> 16)) % this->stripes_.size();
+  }
+
+  // Resize the hash table of a stripe for N new elements.
+  void
+  reserve_stripe(Stringpool_stripe*, unsigned int n);
+
   // Add a new key offset entry.
   void
-  new_key_offset(size_t);
+  new_key_offset(Stringpool_stripe*, size_t);
 
   // Copy a string into the buffers, returning a canonical string.
   const Stringpool_char*
-  add_string(const Stringpool_char*, size_t);
+  add_string(Stringpool_stripe*, const Stringpool_char*, size_t);
 
   // Return whether s1 is a suffix of s2.
   static bool
@@ -388,6 +442,16 @@ class Stringpool_template
     operator()(const Stringpool_sort_info&, const Stringpool_sort_info&) const;
   };
 
+  // Comparison routine used to put the strings of a concurrent pool
+  // into a repeatable order when we are not optimizing.  This is
+  // cheaper than Stringpool_sort_comparison since it usually only
+  // looks at the hash codes.
+  struct Stringpool_hash_comparison
+  {
+    bool
+    operator()(const Stringpool_sort_info&, const Stringpool_sort_info&) const;
+  };
+
   // Keys map to offsets via a Chunked_vector.  We only use the
   // offsets if we turn this into an string table section.
   typedef Chunked_vector<section_offset_type> Key_to_offset;
@@ -395,12 +459,37 @@ class Stringpool_template
   // List of Stringdata structures.
   typedef std::list<Stringdata*> Stringdata_list;
 
-  // Mapping from const char* to namepool entry.
-  String_set_type string_set_;
-  // Mapping from Key to string table offset.
-  Key_to_offset key_to_offset_;
-  // List of buffers.
-  Stringdata_list strings_;
+  // One stripe of the pool.  A pool which is not concurrent has a
+  // single stripe with no lock.
+  struct Stringpool_stripe
+  {
+    Stringpool_stripe()
+      : string_set(), key_to_offset(), strings(), lock(NULL)
+    { }
+
+    // Mapping from const char* to namepool entry.
+    String_set_type string_set;
+    // Mapping from Key to string table offset.  The entry for key K
+    // is at index (K - 1) / stripe_count.
+    Key_to_offset key_to_offset;
+    // List of buffers.
+    Stringdata_list strings;
+    // Lock held while adding a string, or NULL.
+    Lock* lock;
+  };
+
+  typedef std::vector<Stringpool_stripe*> Stripes;
+
+  // Return the offset entry for key K.
+  section_offset_type&
+  key_offset(Key k)
+  {
+    const size_t n = this->stripes_.size();
+    return this->stripes_[(k - 1) % n]->key_to_offset[(k - 1) / n];
+  }
+
+  // The stripes.
+  Stripes stripes_;
   // Size of string table.
   section_size_type strtab_size_;
   // Whether to reserve offset 0 to hold the null string.
@@ -562,19 +562,62 @@ Symbol::set_undefined()
 
 // Class Symbol_table.
 
+// Return the number of shards to use for the symbol table.  We only
+// use more than one if we are going to add symbols in parallel.
+
+static unsigned int
+symbol_table_shard_count(const Version_script_info& version_script)
+{
+  const General_options& options(parameters->options());
+  if (!options.threads() || !options.parallel_symbol_resolution())
+    return 1;
+#ifndef ENABLE_THREADS
+  return 1;
+#else
+  // Plugins, --wrap, version scripts, dynamic lists, incremental
+  // links and ODR violation detection all examine or modify state
+  // which is shared between symbols with different names.
+  if (options.has_plugins()
+      || options.any_wrap()
+      || !version_script.empty()
+      || options.have_dynamic_list()
+      || parameters->incremental()
+      || options.detect_odr_violations())
+    return 1;
+  return 32;
+#endif
+}
+
 Symbol_table::Symbol_table(unsigned int count,
                            const Version_script_info& version_script)
-  : saw_undefined_(0), offset_(0), table_(count), namepool_(),
+  : saw_undefined_(0), undefined_references_(NULL), offset_(0), shards_(),
+    namepool_(), deferred_(),
+    deferred_blocker_(NULL),
     forwarders_(), commons_(), tls_commons_(), small_commons_(),
     large_commons_(), forced_locals_(), warnings_(),
     version_script_(version_script), gc_(NULL), icf_(NULL),
     target_symbols_()
 {
-  namepool_.reserve(count);
+  // The name pool is split into stripes in the same way as the table
+  // is split into shards, so that each shard only adds names to its
+  // own stripe.
+  unsigned int shard_count = symbol_table_shard_count(version_script);
+  this->namepool_.set_concurrent(shard_count);
+  this->namepool_.reserve(count);
+  count /= shard_count;
+  for (unsigned int i = 0; i < shard_count; ++i)
+    this->shards_.push_back(new Symbol_table_shard(count));
+  if (shard_count > 1)
+    this->deferred_blocker_ = new Task_token(true);
 }
 
 Symbol_table::~Symbol_table()
 {
+  for (Shards::iterator p = this->shards_.begin();
+       p != this->shards_.end();
+       ++p)
+    delete *p;
+  delete this->deferred_blocker_;
 }
 
 // The symbol table key equality function.  This is called with
@@ -662,6 +705,29 @@ Symbol_table::gc_mark_symbol(Symbol* sym)
   parameters->target().gc_mark_symbol(this, sym);
 }
 
+// Likewise, but if DEFERRED_SHARD is not NULL we are adding deferred
+// symbols in parallel, so just record the section and symbol in the
+// shard for finish_deferred_symbols.
+
+void
+Symbol_table::gc_mark_symbol(Symbol* sym, Symbol_table_shard* deferred_shard)
+{
+  if (deferred_shard == NULL)
+    {
+      this->gc_mark_symbol(sym);
+      return;
+    }
+
+  bool is_ordinary;
+  unsigned int shndx = sym->shndx(&is_ordinary);
+  if (is_ordinary && shndx != elfcpp::SHN_UNDEF && !sym->object()->is_dynamic())
+    {
+      Relobj* relobj = static_cast<Relobj*>(sym->object());
+      deferred_shard->gc_sections.push_back(Section_id(relobj, shndx));
+    }
+  deferred_shard->gc_symbols.push_back(sym);
+}
+
 // When doing garbage collection, keep symbols that have been seen in
 // dynamic objects.
 inline void 
@@ -672,6 +738,14 @@ Symbol_table::gc_mark_dyn_syms(Symbol* sym)
     this->gc_mark_symbol(sym);
 }
 
+inline void
+Symbol_table::gc_mark_dyn_syms(Symbol* sym, Symbol_table_shard* deferred_shard)
+{
+  if (sym->in_dyn() && sym->source() == Symbol::FROM_OBJECT
+      && !sym->object()->is_dynamic())
+    this->gc_mark_symbol(sym, deferred_shard);
+}
+
 // Make TO a symbol which forwards to FROM.
 
 void
@@ -713,9 +787,10 @@ Symbol_table::lookup(const char* name, const char* version) const
 	return NULL;
     }
 
+  const Symbol_table_type& table(this->table_for_key(name_key));
   Symbol_table_key key(name_key, version_key);
-  Symbol_table::Symbol_table_type::const_iterator p = this->table_.find(key);
-  if (p == this->table_.end())
+  Symbol_table::Symbol_table_type::const_iterator p = table.find(key);
+  if (p == table.end())
     return NULL;
   return p->second;
 }
@@ -753,7 +828,7 @@ Symbol_table::resolve(Sized_symbol<size>* to, const Sized_symbol<size>* from)
 // by visibility.
 
 void
-Symbol_table::force_local(Symbol* sym)
+Symbol_table::force_local(Symbol* sym, Symbol_table_shard* deferred_shard)
 {
   if (!sym->is_defined() && !sym->is_common())
     return;
@@ -763,7 +838,40 @@ Symbol_table::force_local(Symbol* sym)
       return;
     }
   sym->set_is_forced_local();
-  this->forced_locals_.push_back(sym);
+  if (deferred_shard == NULL)
+    this->forced_locals_.push_back(sym);
+  else
+    deferred_shard->forced_locals.push_back(sym);
+}
+
+// Record a new common symbol SYM, to speed up common symbol
+// allocation.
+
+void
+Symbol_table::add_common(Symbol* sym, bool is_ordinary,
+			 unsigned int st_shndx,
+			 Symbol_table_shard* deferred_shard)
+{
+  Commons_type* commons;
+  if (sym->type() == elfcpp::STT_TLS)
+    commons = (deferred_shard == NULL
+	       ? &this->tls_commons_
+	       : &deferred_shard->tls_commons);
+  else if (!is_ordinary
+	   && st_shndx == parameters->target().small_common_shndx())
+    commons = (deferred_shard == NULL
+	       ? &this->small_commons_
+	       : &deferred_shard->small_commons);
+  else if (!is_ordinary
+	   && st_shndx == parameters->target().large_common_shndx())
+    commons = (deferred_shard == NULL
+	       ? &this->large_commons_
+	       : &deferred_shard->large_commons);
+  else
+    commons = (deferred_shard == NULL
+	       ? &this->commons_
+	       : &deferred_shard->commons);
+  commons->push_back(sym);
 }
 
 // Adjust NAME for wrapping, and update *NAME_KEY if necessary.  This
@@ -938,7 +1046,8 @@ Symbol_table::add_from_object(Object* object,
 			      const elfcpp::Sym<size, big_endian>& sym,
 			      unsigned int st_shndx,
 			      bool is_ordinary,
-			      unsigned int orig_st_shndx)
+			      unsigned int orig_st_shndx,
+			      Symbol_table_shard* deferred_shard)
 {
   // Print a message if this symbol is being traced.
   if (parameters->options().is_trace_symbol(name))
@@ -968,19 +1077,21 @@ Symbol_table::add_from_object(Object* object,
 	}
     }
 
+  Symbol_table_type& table(this->table_for_key(name_key));
+
   Symbol* const snull = NULL;
   std::pair<typename Symbol_table_type::iterator, bool> ins =
-    this->table_.insert(std::make_pair(std::make_pair(name_key, version_key),
-				       snull));
+    table.insert(std::make_pair(std::make_pair(name_key, version_key),
+				snull));
 
   std::pair<typename Symbol_table_type::iterator, bool> insdefault =
-    std::make_pair(this->table_.end(), false);
+    std::make_pair(table.end(), false);
   if (is_default_version)
     {
       const Stringpool::Key vnull_key = 0;
-      insdefault = this->table_.insert(std::make_pair(std::make_pair(name_key,
-								     vnull_key),
-						      snull));
+      insdefault = table.insert(std::make_pair(std::make_pair(name_key,
+							      vnull_key),
+					       snull));
     }
 
   // ins.first: an iterator, which is a pointer to a pair.
@@ -1004,7 +1115,7 @@ Symbol_table::add_from_object(Object* object,
       this->resolve(ret, sym, st_shndx, is_ordinary, orig_st_shndx, object,
 		    version, is_default_version);
       if (parameters->options().gc_sections())
-        this->gc_mark_dyn_syms(ret);
+        this->gc_mark_dyn_syms(ret, deferred_shard);
 
       if (is_default_version)
 	this->define_default_version<size, big_endian>(ret, insdefault.second,
@@ -1033,7 +1144,7 @@ Symbol_table::add_from_object(Object* object,
 	      // (See PR gold/18703.)
 	      ret->set_is_not_default();
 	      const Stringpool::Key vnull_key = 0;
-	      this->table_.erase(std::make_pair(name_key, vnull_key));
+	      table.erase(std::make_pair(name_key, vnull_key));
 	    }
 	}
     }
@@ -1055,7 +1166,7 @@ Symbol_table::add_from_object(Object* object,
 	  this->resolve(ret, sym, st_shndx, is_ordinary, orig_st_shndx, object,
 			version, is_default_version);
           if (parameters->options().gc_sections())
-            this->gc_mark_dyn_syms(ret);
+            this->gc_mark_dyn_syms(ret, deferred_shard);
 	  ins.first->second = ret;
 	}
       else
@@ -1076,13 +1187,12 @@ Symbol_table::add_from_object(Object* object,
 		  // This means that we don't want a symbol table
 		  // entry after all.
 		  if (!is_default_version)
-		    this->table_.erase(ins.first);
+		    table.erase(ins.first);
 		  else
 		    {
-		      this->table_.erase(insdefault.first);
+		      table.erase(insdefault.first);
 		      // Inserting INSDEFAULT invalidated INS.
-		      this->table_.erase(std::make_pair(name_key,
-							version_key));
+		      table.erase(std::make_pair(name_key, version_key));
 		    }
 		  return NULL;
 		}
@@ -1108,28 +1218,32 @@ Symbol_table::add_from_object(Object* object,
   // archive groups.
   if (!was_undefined && ret->is_undefined())
     {
-      ++this->saw_undefined_;
-      if (parameters->options().has_plugins())
-	parameters->options().plugins()->new_undefined_symbol(ret);
+      if (deferred_shard != NULL)
+	++deferred_shard->saw_undefined;
+      else
+	{
+	  ++this->saw_undefined_;
+	  if (parameters->options().has_plugins())
+	    parameters->options().plugins()->new_undefined_symbol(ret);
+	}
     }
 
+  // Record a strong undefined reference for the archive we are
+  // adding, which may define the symbol.  This includes a reference
+  // which turns a weak undefined symbol into a strong one.
+  if (this->undefined_references_ != NULL
+      && deferred_shard == NULL
+      && orig_st_shndx == elfcpp::SHN_UNDEF
+      && ret->is_undefined()
+      && ret->binding() != elfcpp::STB_WEAK)
+    this->undefined_references_->push_back(ret->name());
+
   // Keep track of common symbols, to speed up common symbol
   // allocation.  Don't record commons from plugin objects;
   // we need to wait until we see the real symbol in the
   // replacement file.
   if (!was_common && ret->is_common() && ret->object()->pluginobj() == NULL)
-    {
-      if (ret->type() == elfcpp::STT_TLS)
-	this->tls_commons_.push_back(ret);
-      else if (!is_ordinary
-	       && st_shndx == parameters->target().small_common_shndx())
-	this->small_commons_.push_back(ret);
-      else if (!is_ordinary
-	       && st_shndx == parameters->target().large_common_shndx())
-	this->large_commons_.push_back(ret);
-      else
-	this->commons_.push_back(ret);
-    }
+    this->add_common(ret, is_ordinary, st_shndx, deferred_shard);
 
   // If we're not doing a relocatable link, then any symbol with
   // hidden or internal visibility is local.
@@ -1139,7 +1253,7 @@ Symbol_table::add_from_object(Object* object,
 	  || ret->binding() == elfcpp::STB_GNU_UNIQUE
 	  || ret->binding() == elfcpp::STB_WEAK)
       && !parameters->options().relocatable())
-    this->force_local(ret);
+    this->force_local(ret, deferred_shard);
 
   return ret;
 }
@@ -1662,174 +1776,598 @@ Symbol_table::add_from_incrobj(
   return res;
 }
 
-// This is used to sort weak aliases.  We sort them first by section
-// index, then by offset, then by weak ahead of strong.
+// Record that the symbols from RELOBJ should be added to the symbol
+// table later, by resolve_deferred_symbols or resolve_deferred_shard.
 
-template<int size>
-class Weak_alias_sorter
+template<int size, bool big_endian>
+Deferred_relobj*
+Symbol_table::defer_relobj_symbols(
+    Sized_relobj_file<size, big_endian>* relobj,
+    File_view* symbols,
+    File_view* symbol_names,
+    const unsigned char* syms,
+    size_t count,
+    size_t symndx_offset,
+    const char* sym_names,
+    size_t sym_name_size,
+    typename Sized_relobj_file<size, big_endian>::Symbols* sympointers,
+    size_t* defined)
 {
- public:
-  bool operator()(const Sized_symbol<size>*, const Sized_symbol<size>*) const;
-};
+  gold_assert(this->parallel_resolution());
+
+  Deferred_relobj* d = new Deferred_relobj();
+  d->relobj = relobj;
+  d->symbols = symbols;
+  d->symbol_names = symbol_names;
+  d->syms = syms;
+  d->count = count;
+  d->symndx_offset = symndx_offset;
+  d->sym_names = sym_names;
+  d->sym_name_size = sym_name_size;
+  d->sympointers = sympointers;
+  d->defined = defined;
+  d->has_version = false;
+  this->deferred_.push_back(d);
+  return d;
+}
 
-template<int size>
-bool
-Weak_alias_sorter<size>::operator()(const Sized_symbol<size>* s1,
-				    const Sized_symbol<size>* s2) const
-{
-  bool is_ordinary;
-  unsigned int s1_shndx = s1->shndx(&is_ordinary);
-  gold_assert(is_ordinary);
-  unsigned int s2_shndx = s2->shndx(&is_ordinary);
-  gold_assert(is_ordinary);
-  if (s1_shndx != s2_shndx)
-    return s1_shndx < s2_shndx;
+// Sort the symbols of the deferred object D by shard.  This runs in
+// parallel with the Add_symbols tasks which append to deferred_, so
+// it must not look at deferred_.
 
-  if (s1->value() != s2->value())
-    return s1->value() < s2->value();
-  if (s1->binding() != s2->binding())
+void
+Symbol_table::prepare_deferred_symbols(Deferred_relobj* d)
+{
+  switch (parameters->size_and_endianness())
     {
-      if (s1->binding() == elfcpp::STB_WEAK)
-	return true;
-      if (s2->binding() == elfcpp::STB_WEAK)
-	return false;
+#ifdef HAVE_TARGET_32_LITTLE
+    case Parameters::TARGET_32_LITTLE:
+      this->sized_prepare_deferred_symbols<32, false>(d);
+      break;
+#endif
+#ifdef HAVE_TARGET_32_BIG
+    case Parameters::TARGET_32_BIG:
+      this->sized_prepare_deferred_symbols<32, true>(d);
+      break;
+#endif
+#ifdef HAVE_TARGET_64_LITTLE
+    case Parameters::TARGET_64_LITTLE:
+      this->sized_prepare_deferred_symbols<64, false>(d);
+      break;
+#endif
+#ifdef HAVE_TARGET_64_BIG
+    case Parameters::TARGET_64_BIG:
+      this->sized_prepare_deferred_symbols<64, true>(d);
+      break;
+#endif
+    default:
+      gold_unreachable();
     }
-  return std::string(s1->name()) < std::string(s2->name());
 }
 
-// SYMBOLS is a list of object symbols from a dynamic object.  Look
-// for any weak aliases, and record them so that if we add the weak
-// alias to the dynamic symbol table, we also add the corresponding
-// strong symbol.
+// Sort the symbols of a deferred object by shard, keeping the symbols
+// in each shard in symbol table order.  This also counts the defined
+// symbols, and notes any versioned symbol names.  Bad symbol names
+// are put in the first shard and reported when the shard is resolved.
 
-template<int size>
+template<int size, bool big_endian>
 void
-Symbol_table::record_weak_aliases(std::vector<Sized_symbol<size>*>* symbols)
+Symbol_table::sized_prepare_deferred_symbols(Deferred_relobj* d)
 {
-  // Sort the vector by section index, then by offset, then by weak
-  // ahead of strong.
-  std::sort(symbols->begin(), symbols->end(), Weak_alias_sorter<size>());
+  Sized_relobj_file<size, big_endian>* relobj =
+    static_cast<Sized_relobj_file<size, big_endian>*>(d->relobj);
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+  const unsigned int shard_count = this->shards_.size();
 
-  // Walk through the vector.  For each weak definition, record
-  // aliases.
-  for (typename std::vector<Sized_symbol<size>*>::const_iterator p =
-	 symbols->begin();
-       p != symbols->end();
-       ++p)
-    {
-      if ((*p)->binding() != elfcpp::STB_WEAK)
-	continue;
+  std::vector<unsigned int> sym_shards(d->count);
+  d->shard_start.assign(shard_count + 1, 0);
+  size_t defined = 0;
 
-      // Build a circular list of weak aliases.  Each symbol points to
-      // the next one in the circular list.
+  const unsigned char* p = d->syms;
+  for (size_t i = 0; i < d->count; ++i, p += sym_size)
+    {
+      elfcpp::Sym<size, big_endian> sym(p);
 
-      Sized_symbol<size>* from_sym = *p;
-      typename std::vector<Sized_symbol<size>*>::const_iterator q;
-      for (q = p + 1; q != symbols->end(); ++q)
+      unsigned int shard = 0;
+      unsigned int st_name = sym.get_st_name();
+      if (st_name < d->sym_name_size)
 	{
-	  bool dummy;
-	  if ((*q)->shndx(&dummy) != from_sym->shndx(&dummy)
-	      || (*q)->value() != from_sym->value())
-	    break;
-
-	  this->weak_aliases_[from_sym] = *q;
-	  from_sym->set_has_alias();
-	  from_sym = *q;
+	  const char* name = d->sym_names + st_name;
+	  size_t namelen = strlen(name);
+	  if (memchr(name, '@', namelen) != NULL)
+	    d->has_version = true;
+	  shard = this->shard_index(name, namelen);
+
+	  bool is_ordinary;
+	  if (relobj->adjust_sym_shndx(i + d->symndx_offset,
+				       sym.get_st_shndx(),
+				       &is_ordinary) != elfcpp::SHN_UNDEF)
+	    ++defined;
 	}
 
-      if (from_sym != *p)
+      sym_shards[i] = shard;
+      ++d->shard_start[shard + 1];
+    }
+
+  for (unsigned int i = 0; i < shard_count; ++i)
+    d->shard_start[i + 1] += d->shard_start[i];
+
+  std::vector<unsigned int> next(d->shard_start.begin(),
+				 d->shard_start.end() - 1);
+  d->order.resize(d->count);
+  for (size_t i = 0; i < d->count; ++i)
+    d->order[next[sym_shards[i]]++] = i;
+
+  *d->defined = defined;
+}
+
+// Return whether the deferred symbols may be added in parallel.
+
+bool
+Symbol_table::can_resolve_deferred_in_parallel() const
+{
+  // Resolving a symbol with weak aliases from a dynamic object
+  // updates the aliases too, which may be in other shards.
+  if (!this->weak_aliases_.empty())
+    return false;
+
+  // The target may keep its own state about symbols.
+  const Target* target = &parameters->target();
+  if (target->has_make_symbol() || target->has_resolve())
+    return false;
+
+  // Symbol versions would be added to other stripes of the name
+  // pool, so their keys would depend on the order of the threads.
+  for (Deferred_relobjs::const_iterator p = this->deferred_.begin();
+       p != this->deferred_.end();
+       ++p)
+    if ((*p)->has_version)
+      return false;
+
+  return true;
+}
+
+// Add all the deferred symbols, one object at a time.
+
+void
+Symbol_table::resolve_deferred_symbols(const Task* task)
+{
+  for (Deferred_relobjs::iterator p = this->deferred_.begin();
+       p != this->deferred_.end();
+       ++p)
+    {
+      switch (parameters->size_and_endianness())
 	{
-	  this->weak_aliases_[from_sym] = *p;
-	  from_sym->set_has_alias();
+#ifdef HAVE_TARGET_32_LITTLE
+	case Parameters::TARGET_32_LITTLE:
+	  this->sized_resolve_deferred_relobj<32, false>(*p);
+	  break;
+#endif
+#ifdef HAVE_TARGET_32_BIG
+	case Parameters::TARGET_32_BIG:
+	  this->sized_resolve_deferred_relobj<32, true>(*p);
+	  break;
+#endif
+#ifdef HAVE_TARGET_64_LITTLE
+	case Parameters::TARGET_64_LITTLE:
+	  this->sized_resolve_deferred_relobj<64, false>(*p);
+	  break;
+#endif
+#ifdef HAVE_TARGET_64_BIG
+	case Parameters::TARGET_64_BIG:
+	  this->sized_resolve_deferred_relobj<64, true>(*p);
+	  break;
+#endif
+	default:
+	  gold_unreachable();
 	}
-
-      p = q - 1;
     }
+
+  this->free_deferred_symbols(task);
 }
 
-// Create and return a specially defined symbol.  If ONLY_IF_REF is
-// true, then only create the symbol if there is a reference to it.
-// If this does not return NULL, it sets *POLDSYM to the existing
-// symbol if there is one.  This sets *RESOLVE_OLDSYM if we should
-// resolve the newly created symbol to the old one.  This
-// canonicalizes *PNAME and *PVERSION.
+// Add the symbols from a deferred object, just as though they had not
+// been deferred.
 
 template<int size, bool big_endian>
-Sized_symbol<size>*
-Symbol_table::define_special_symbol(const char** pname, const char** pversion,
-				    bool only_if_ref,
-                                    Sized_symbol<size>** poldsym,
-				    bool* resolve_oldsym, bool is_forced_local)
+void
+Symbol_table::sized_resolve_deferred_relobj(Deferred_relobj* d)
 {
-  *resolve_oldsym = false;
-  *poldsym = NULL;
+  Sized_relobj_file<size, big_endian>* relobj =
+    static_cast<Sized_relobj_file<size, big_endian>*>(d->relobj);
+  this->add_from_relobj(relobj, d->syms, d->count, d->symndx_offset,
+			d->sym_names, d->sym_name_size, d->sympointers,
+			d->defined);
+}
 
-  // If the caller didn't give us a version, see if we get one from
-  // the version script.
-  std::string v;
-  bool is_default_version = false;
-  if (!is_forced_local && *pversion == NULL)
+// Add the deferred symbols which fall in shard SHARD, working through
+// the objects in order.  This runs in parallel with the other shards,
+// so everything it changes must be in the shard, or in the symbols
+// themselves, which all have names in the shard.
+
+void
+Symbol_table::resolve_deferred_shard(unsigned int shard)
+{
+  for (Deferred_relobjs::iterator p = this->deferred_.begin();
+       p != this->deferred_.end();
+       ++p)
     {
-      bool is_global;
-      if (this->version_script_.get_symbol_version(*pname, &v, &is_global))
+      switch (parameters->size_and_endianness())
 	{
-	  if (is_global && !v.empty())
-	    {
-	      *pversion = v.c_str();
-	      // If we get the version from a version script, then we
-	      // are also the default version.
-	      is_default_version = true;
-	    }
+#ifdef HAVE_TARGET_32_LITTLE
+	case Parameters::TARGET_32_LITTLE:
+	  this->sized_resolve_deferred_shard<32, false>(*p, shard);
+	  break;
+#endif
+#ifdef HAVE_TARGET_32_BIG
+	case Parameters::TARGET_32_BIG:
+	  this->sized_resolve_deferred_shard<32, true>(*p, shard);
+	  break;
+#endif
+#ifdef HAVE_TARGET_64_LITTLE
+	case Parameters::TARGET_64_LITTLE:
+	  this->sized_resolve_deferred_shard<64, false>(*p, shard);
+	  break;
+#endif
+#ifdef HAVE_TARGET_64_BIG
+	case Parameters::TARGET_64_BIG:
+	  this->sized_resolve_deferred_shard<64, true>(*p, shard);
+	  break;
+#endif
+	default:
+	  gold_unreachable();
 	}
     }
+}
 
-  Symbol* oldsym;
-  Sized_symbol<size>* sym;
+// Add the symbols from a deferred object which fall in shard SHARD.
+// This is add_from_relobj for an object with no symbol versions,
+// when there is no version script and the object is not
+// --just-symbols.
 
-  bool add_to_table = false;
-  typename Symbol_table_type::iterator add_loc = this->table_.end();
-  bool add_def_to_table = false;
-  typename Symbol_table_type::iterator add_def_loc = this->table_.end();
+template<int size, bool big_endian>
+void
+Symbol_table::sized_resolve_deferred_shard(Deferred_relobj* d,
+					   unsigned int shard)
+{
+  Sized_relobj_file<size, big_endian>* relobj =
+    static_cast<Sized_relobj_file<size, big_endian>*>(d->relobj);
+  Symbol_table_shard* deferred_shard = this->shards_[shard];
+  typename Sized_relobj_file<size, big_endian>::Symbols* sympointers =
+    d->sympointers;
 
-  if (only_if_ref)
-    {
-      oldsym = this->lookup(*pname, *pversion);
-      if (oldsym == NULL && is_default_version)
-	oldsym = this->lookup(*pname, NULL);
-      if (oldsym == NULL || !oldsym->is_undefined())
-	return NULL;
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
 
-      *pname = oldsym->name();
-      if (is_default_version)
-	*pversion = this->namepool_.add(*pversion, true, NULL);
-      else
-	*pversion = oldsym->version();
-    }
-  else
+  for (unsigned int j = d->shard_start[shard];
+       j < d->shard_start[shard + 1];
+       ++j)
     {
-      // Canonicalize NAME and VERSION.
-      Stringpool::Key name_key;
-      *pname = this->namepool_.add(*pname, true, &name_key);
+      const unsigned int i = d->order[j];
+      const unsigned char* p = d->syms + i * sym_size;
+      elfcpp::Sym<size, big_endian> sym(p);
+
+      unsigned int st_name = sym.get_st_name();
+      if (st_name >= d->sym_name_size)
+	{
+	  relobj->error(_("bad global symbol name offset %u at %zu"),
+			st_name, static_cast<size_t>(i));
+	  continue;
+	}
+
+      const char* name = d->sym_names + st_name;
+
+      if (!parameters->options().relocatable()
+	  && strcmp (name, "__gnu_lto_slim") == 0)
+        gold_info(_("%s: plugin needed to handle lto object"),
+		  relobj->name().c_str());
+
+      bool is_ordinary;
+      unsigned int st_shndx = relobj->adjust_sym_shndx(i + d->symndx_offset,
+						       sym.get_st_shndx(),
+						       &is_ordinary);
+      unsigned int orig_st_shndx = st_shndx;
+      if (!is_ordinary)
+	orig_st_shndx = elfcpp::SHN_UNDEF;
+
+      // A symbol defined in a section which we are not including must
+      // be treated as an undefined symbol.
+      bool is_defined_in_discarded_section = false;
+      if (st_shndx != elfcpp::SHN_UNDEF
+	  && is_ordinary
+	  && !relobj->is_section_included(st_shndx)
+          && !this->is_section_folded(relobj, st_shndx))
+	{
+	  st_shndx = elfcpp::SHN_UNDEF;
+	  is_defined_in_discarded_section = true;
+	}
+
+      elfcpp::Sym<size, big_endian>* psym = &sym;
+      unsigned char symbuf[sym_size];
+      elfcpp::Sym<size, big_endian> sym2(symbuf);
+
+      // Fix up visibility if object has no-export set.
+      if (relobj->no_export()
+	  && (orig_st_shndx != elfcpp::SHN_UNDEF || !is_ordinary))
+        {
+	  memcpy(symbuf, p, sym_size);
+	  psym = &sym2;
+
+	  elfcpp::STV visibility = sym2.get_st_visibility();
+	  if (visibility == elfcpp::STV_DEFAULT
+	      || visibility == elfcpp::STV_PROTECTED)
+	    {
+	      elfcpp::Sym_write<size, big_endian> sw(symbuf);
+	      unsigned char nonvis = sym2.get_st_nonvis();
+	      sw.put_st_other(elfcpp::STV_HIDDEN, nonvis);
+	    }
+        }
+
+      Stringpool::Key name_key;
+      name = this->namepool_.add(name, true, &name_key);
+
+      Sized_symbol<size>* res;
+      res = this->add_from_object(relobj, name, name_key, NULL, 0, false,
+				  *psym, st_shndx, is_ordinary, orig_st_shndx,
+				  deferred_shard);
+
+      if (res == NULL)
+	continue;
+
+      // Do not treat this symbol as garbage if this symbol will be
+      // exported to the dynamic symbol table.
+      if (parameters->options().gc_sections()
+	  && res->is_externally_visible()
+	  && !res->is_from_dynobj()
+          && (parameters->options().shared()
+	      || parameters->options().export_dynamic()))
+        this->gc_mark_symbol(res, deferred_shard);
+
+      if (is_defined_in_discarded_section)
+	res->set_is_defined_in_discarded_section();
+
+      (*sympointers)[i] = res;
+    }
+}
+
+// Finish adding deferred symbols in parallel: merge the changes which
+// were collected in the shards, in shard order, so that the result
+// does not depend on the order in which the shards were resolved.
+
+void
+Symbol_table::finish_deferred_symbols(const Task* task)
+{
+  for (Shards::iterator p = this->shards_.begin();
+       p != this->shards_.end();
+       ++p)
+    {
+      Symbol_table_shard* shard = *p;
+
+      this->saw_undefined_ += shard->saw_undefined;
+      shard->saw_undefined = 0;
+
+      this->commons_.insert(this->commons_.end(), shard->commons.begin(),
+			    shard->commons.end());
+      shard->commons.clear();
+      this->tls_commons_.insert(this->tls_commons_.end(),
+				shard->tls_commons.begin(),
+				shard->tls_commons.end());
+      shard->tls_commons.clear();
+      this->small_commons_.insert(this->small_commons_.end(),
+				  shard->small_commons.begin(),
+				  shard->small_commons.end());
+      shard->small_commons.clear();
+      this->large_commons_.insert(this->large_commons_.end(),
+				  shard->large_commons.begin(),
+				  shard->large_commons.end());
+      shard->large_commons.clear();
+
+      this->forced_locals_.insert(this->forced_locals_.end(),
+				  shard->forced_locals.begin(),
+				  shard->forced_locals.end());
+      shard->forced_locals.clear();
+
+      for (std::vector<Section_id>::const_iterator q =
+	     shard->gc_sections.begin();
+	   q != shard->gc_sections.end();
+	   ++q)
+	this->gc_->worklist().push_back(*q);
+      shard->gc_sections.clear();
+      for (std::vector<Symbol*>::const_iterator q = shard->gc_symbols.begin();
+	   q != shard->gc_symbols.end();
+	   ++q)
+	parameters->target().gc_mark_symbol(this, *q);
+      shard->gc_symbols.clear();
+    }
+
+  this->free_deferred_symbols(task);
+}
+
+// Free the deferred objects, and the views of their symbols.  The
+// files must be locked while the views are deleted.
+
+void
+Symbol_table::free_deferred_symbols(const Task* task)
+{
+  for (Deferred_relobjs::iterator p = this->deferred_.begin();
+       p != this->deferred_.end();
+       ++p)
+    {
+      Task_lock_obj<Object> tl(task, (*p)->relobj);
+      delete (*p)->symbols;
+      delete (*p)->symbol_names;
+      delete *p;
+    }
+  this->deferred_.clear();
+}
+
+// This is used to sort weak aliases.  We sort them first by section
+// index, then by offset, then by weak ahead of strong.
+
+template<int size>
+class Weak_alias_sorter
+{
+ public:
+  bool operator()(const Sized_symbol<size>*, const Sized_symbol<size>*) const;
+};
+
+template<int size>
+bool
+Weak_alias_sorter<size>::operator()(const Sized_symbol<size>* s1,
+				    const Sized_symbol<size>* s2) const
+{
+  bool is_ordinary;
+  unsigned int s1_shndx = s1->shndx(&is_ordinary);
+  gold_assert(is_ordinary);
+  unsigned int s2_shndx = s2->shndx(&is_ordinary);
+  gold_assert(is_ordinary);
+  if (s1_shndx != s2_shndx)
+    return s1_shndx < s2_shndx;
+
+  if (s1->value() != s2->value())
+    return s1->value() < s2->value();
+  if (s1->binding() != s2->binding())
+    {
+      if (s1->binding() == elfcpp::STB_WEAK)
+	return true;
+      if (s2->binding() == elfcpp::STB_WEAK)
+	return false;
+    }
+  return std::string(s1->name()) < std::string(s2->name());
+}
+
+// SYMBOLS is a list of object symbols from a dynamic object.  Look
+// for any weak aliases, and record them so that if we add the weak
+// alias to the dynamic symbol table, we also add the corresponding
+// strong symbol.
+
+template<int size>
+void
+Symbol_table::record_weak_aliases(std::vector<Sized_symbol<size>*>* symbols)
+{
+  // Sort the vector by section index, then by offset, then by weak
+  // ahead of strong.
+  std::sort(symbols->begin(), symbols->end(), Weak_alias_sorter<size>());
+
+  // Walk through the vector.  For each weak definition, record
+  // aliases.
+  for (typename std::vector<Sized_symbol<size>*>::const_iterator p =
+	 symbols->begin();
+       p != symbols->end();
+       ++p)
+    {
+      if ((*p)->binding() != elfcpp::STB_WEAK)
+	continue;
+
+      // Build a circular list of weak aliases.  Each symbol points to
+      // the next one in the circular list.
+
+      Sized_symbol<size>* from_sym = *p;
+      typename std::vector<Sized_symbol<size>*>::const_iterator q;
+      for (q = p + 1; q != symbols->end(); ++q)
+	{
+	  bool dummy;
+	  if ((*q)->shndx(&dummy) != from_sym->shndx(&dummy)
+	      || (*q)->value() != from_sym->value())
+	    break;
+
+	  this->weak_aliases_[from_sym] = *q;
+	  from_sym->set_has_alias();
+	  from_sym = *q;
+	}
+
+      if (from_sym != *p)
+	{
+	  this->weak_aliases_[from_sym] = *p;
+	  from_sym->set_has_alias();
+	}
+
+      p = q - 1;
+    }
+}
+
+// Create and return a specially defined symbol.  If ONLY_IF_REF is
+// true, then only create the symbol if there is a reference to it.
+// If this does not return NULL, it sets *POLDSYM to the existing
+// symbol if there is one.  This sets *RESOLVE_OLDSYM if we should
+// resolve the newly created symbol to the old one.  This
+// canonicalizes *PNAME and *PVERSION.
+
+template<int size, bool big_endian>
+Sized_symbol<size>*
+Symbol_table::define_special_symbol(const char** pname, const char** pversion,
+				    bool only_if_ref,
+                                    Sized_symbol<size>** poldsym,
+				    bool* resolve_oldsym, bool is_forced_local)
+{
+  *resolve_oldsym = false;
+  *poldsym = NULL;
+
+  // If the caller didn't give us a version, see if we get one from
+  // the version script.
+  std::string v;
+  bool is_default_version = false;
+  if (!is_forced_local && *pversion == NULL)
+    {
+      bool is_global;
+      if (this->version_script_.get_symbol_version(*pname, &v, &is_global))
+	{
+	  if (is_global && !v.empty())
+	    {
+	      *pversion = v.c_str();
+	      // If we get the version from a version script, then we
+	      // are also the default version.
+	      is_default_version = true;
+	    }
+	}
+    }
+
+  Symbol* oldsym;
+  Sized_symbol<size>* sym;
+
+  bool add_to_table = false;
+  typename Symbol_table_type::iterator add_loc;
+  bool add_def_to_table = false;
+  typename Symbol_table_type::iterator add_def_loc;
+
+  if (only_if_ref)
+    {
+      oldsym = this->lookup(*pname, *pversion);
+      if (oldsym == NULL && is_default_version)
+	oldsym = this->lookup(*pname, NULL);
+      if (oldsym == NULL || !oldsym->is_undefined())
+	return NULL;
+
+      *pname = oldsym->name();
+      if (is_default_version)
+	*pversion = this->namepool_.add(*pversion, true, NULL);
+      else
+	*pversion = oldsym->version();
+    }
+  else
+    {
+      // Canonicalize NAME and VERSION.
+      Stringpool::Key name_key;
+      *pname = this->namepool_.add(*pname, true, &name_key);
 
       Stringpool::Key version_key = 0;
       if (*pversion != NULL)
 	*pversion = this->namepool_.add(*pversion, true, &version_key);
 
+      Symbol_table_type& table(this->table_for_key(name_key));
+
       Symbol* const snull = NULL;
       std::pair<typename Symbol_table_type::iterator, bool> ins =
-	this->table_.insert(std::make_pair(std::make_pair(name_key,
-							  version_key),
-					   snull));
+	table.insert(std::make_pair(std::make_pair(name_key, version_key),
+				    snull));
 
       std::pair<typename Symbol_table_type::iterator, bool> insdefault =
-	std::make_pair(this->table_.end(), false);
+	std::make_pair(table.end(), false);
       if (is_default_version)
 	{
 	  const Stringpool::Key vnull = 0;
 	  insdefault =
-	    this->table_.insert(std::make_pair(std::make_pair(name_key,
-							      vnull),
-					       snull));
+	    table.insert(std::make_pair(std::make_pair(name_key, vnull),
+					snull));
 	}
 
       if (!ins.second)
@@ -2472,6 +3010,101 @@ Symbol_table::add_undefined_symbol_from_command_line(const char* name)
   ++this->saw_undefined_;
 }
 
+// Visitor for Symbol_table::set_dynsym_indexes when the target sets
+// the dynamic symbol indexes.  Collect the symbols which need an
+// entry in the dynamic symbol table.
+
+class Gather_dynsyms_visitor
+{
+ public:
+  Gather_dynsyms_visitor(Symbol_table* symtab,
+			 std::vector<Symbol*>* dyn_symbols)
+    : symtab_(symtab), dyn_symbols_(dyn_symbols)
+  { }
+
+  void
+  operator()(Symbol* sym)
+  {
+    if (sym->is_forced_local())
+      return;
+    if (!sym->should_add_dynsym_entry(this->symtab_))
+      sym->set_dynsym_index(-1U);
+    else
+      this->dyn_symbols_->push_back(sym);
+  }
+
+ private:
+  Symbol_table* symtab_;
+  std::vector<Symbol*>* dyn_symbols_;
+};
+
+// Visitor for Symbol_table::set_dynsym_indexes.  Give each global
+// symbol which needs one the next dynamic symbol index in *PINDEX.
+
+class Set_dynsym_index_visitor
+{
+ public:
+  Set_dynsym_index_visitor(Symbol_table* symtab, unsigned int* pindex,
+			   std::vector<Symbol*>* syms, Stringpool* dynpool,
+			   Versions* versions,
+			   std::vector<Symbol*>* as_needed_sym)
+    : symtab_(symtab), pindex_(pindex), syms_(syms), dynpool_(dynpool),
+      versions_(versions), as_needed_sym_(as_needed_sym)
+  { }
+
+  void
+  operator()(Symbol* sym)
+  {
+    if (sym->is_forced_local())
+      return;
+
+    // Note that SYM may already have a dynamic symbol index, since
+    // some symbols appear more than once in the symbol table, with
+    // and without a version.
+
+    if (!sym->should_add_dynsym_entry(this->symtab_))
+      sym->set_dynsym_index(-1U);
+    else if (!sym->has_dynsym_index())
+      {
+	sym->set_dynsym_index(*this->pindex_);
+	++*this->pindex_;
+	this->syms_->push_back(sym);
+	this->dynpool_->add(sym->name(), false, NULL);
+
+	// If the symbol is defined in a dynamic object and is
+	// referenced strongly in a regular object, then mark the
+	// dynamic object as needed.  This is used to implement
+	// --as-needed.
+	if (sym->is_from_dynobj()
+	    && sym->in_reg()
+	    && !sym->is_undef_binding_weak())
+	  sym->object()->set_is_needed();
+
+	// Record any version information, except those from
+	// as-needed libraries not seen to be needed.  Note that the
+	// is_needed state for such libraries can change in this loop.
+	if (sym->version() != NULL)
+	  {
+	    if (!sym->is_from_dynobj()
+		|| !sym->object()->as_needed()
+		|| sym->object()->is_needed())
+	      this->versions_->record_version(this->symtab_, this->dynpool_,
+					      sym);
+	    else
+	      this->as_needed_sym_->push_back(sym);
+	  }
+      }
+  }
+
+ private:
+  Symbol_table* symtab_;
+  unsigned int* pindex_;
+  std::vector<Symbol*>* syms_;
+  Stringpool* dynpool_;
+  Versions* versions_;
+  std::vector<Symbol*>* as_needed_sym_;
+};
+
 // Set the dynamic symbol indexes.  INDEX is the index of the first
 // global dynamic symbol.  Pointers to the global symbols are stored
 // into the vector SYMS.  The names are added to DYNPOOL.
@@ -2513,68 +3146,14 @@ Symbol_table::set_dynsym_indexes(unsigned int index,
   if (parameters->target().has_custom_set_dynsym_indexes())
     {
       std::vector<Symbol*> dyn_symbols;
-      for (Symbol_table_type::iterator p = this->table_.begin();
-           p != this->table_.end();
-           ++p)
-        {
-          Symbol* sym = p->second;
-          if (sym->is_forced_local())
-	    continue;
-          if (!sym->should_add_dynsym_entry(this))
-            sym->set_dynsym_index(-1U);
-          else
-            dyn_symbols.push_back(sym);
-        }
+      this->for_all_symbols(Gather_dynsyms_visitor(this, &dyn_symbols));
 
       return parameters->target().set_dynsym_indexes(&dyn_symbols, index, syms,
                                                      dynpool, versions, this);
     }
 
-  for (Symbol_table_type::iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
-    {
-      Symbol* sym = p->second;
-
-      if (sym->is_forced_local())
-        continue;
-
-      // Note that SYM may already have a dynamic symbol index, since
-      // some symbols appear more than once in the symbol table, with
-      // and without a version.
-
-      if (!sym->should_add_dynsym_entry(this))
-	sym->set_dynsym_index(-1U);
-      else if (!sym->has_dynsym_index())
-	{
-	  sym->set_dynsym_index(index);
-	  ++index;
-	  syms->push_back(sym);
-	  dynpool->add(sym->name(), false, NULL);
-
-	  // If the symbol is defined in a dynamic object and is
-	  // referenced strongly in a regular object, then mark the
-	  // dynamic object as needed.  This is used to implement
-	  // --as-needed.
-	  if (sym->is_from_dynobj()
-	      && sym->in_reg()
-	      && !sym->is_undef_binding_weak())
-	    sym->object()->set_is_needed();
-
-	  // Record any version information, except those from
-	  // as-needed libraries not seen to be needed.  Note that the
-	  // is_needed state for such libraries can change in this loop.
-	  if (sym->version() != NULL)
-	    {
-	      if (!sym->is_from_dynobj()
-		  || !sym->object()->as_needed()
-		  || sym->object()->is_needed())
-		versions->record_version(this, dynpool, sym);
-	      else
-		as_needed_sym.push_back(sym);
-	    }
-	}
-    }
+  this->for_all_symbols(Set_dynsym_index_visitor(this, &index, syms, dynpool,
+						 versions, &as_needed_sym));
 
   // Process version information for symbols from as-needed libraries.
   for (std::vector<Symbol*>::iterator p = as_needed_sym.begin();
@@ -2705,13 +3284,18 @@ Symbol_table::sized_finalize(off_t off, Stringpool* pool,
     }
 
   // Now do all the remaining symbols.
-  for (Symbol_table_type::iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
+  for (Shards::iterator s = this->shards_.begin();
+       s != this->shards_.end();
+       ++s)
     {
-      Symbol* sym = p->second;
-      if (this->sized_finalize_symbol<size>(sym))
-	this->add_to_final_symtab<size>(sym, pool, &index, &off);
+      for (Symbol_table_type::iterator p = (*s)->table.begin();
+	   p != (*s)->table.end();
+	   ++p)
+	{
+	  Symbol* sym = p->second;
+	  if (this->sized_finalize_symbol<size>(sym))
+	    this->add_to_final_symtab<size>(sym, pool, &index, &off);
+	}
     }
 
   // Now do target-specific symbols.
@@ -2988,6 +3572,44 @@ Symbol_table::write_globals(const Stringpool* sympool,
     }
 }
 
+// Visitor for Symbol_table::sized_write_globals.  Write out each
+// global symbol.
+
+template<int size, bool big_endian>
+class Symbol_table::Write_global_visitor
+{
+ public:
+  Write_global_visitor(const Symbol_table* symtab, const Stringpool* sympool,
+		       const Stringpool* dynpool,
+		       Output_symtab_xindex* symtab_xindex,
+		       Output_symtab_xindex* dynsym_xindex,
+		       unsigned char* psyms, unsigned char* dynamic_view)
+    : symtab_(symtab), sympool_(sympool), dynpool_(dynpool),
+      symtab_xindex_(symtab_xindex), dynsym_xindex_(dynsym_xindex),
+      psyms_(psyms), dynamic_view_(dynamic_view)
+  { }
+
+  void
+  operator()(Sized_symbol<size>* sym)
+  {
+    this->symtab_->sized_write_global<size, big_endian>(sym, this->sympool_,
+							 this->dynpool_,
+							 this->symtab_xindex_,
+							 this->dynsym_xindex_,
+							 this->psyms_,
+							 this->dynamic_view_);
+  }
+
+ private:
+  const Symbol_table* symtab_;
+  const Stringpool* sympool_;
+  const Stringpool* dynpool_;
+  Output_symtab_xindex* symtab_xindex_;
+  Output_symtab_xindex* dynsym_xindex_;
+  unsigned char* psyms_;
+  unsigned char* dynamic_view_;
+};
+
 // Write out the global symbols.
 
 template<int size, bool big_endian>
@@ -2998,8 +3620,6 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
 				  Output_symtab_xindex* dynsym_xindex,
 				  Output_file* of) const
 {
-  const Target& target = parameters->target();
-
   const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
 
   const unsigned int output_count = this->output_count_;
@@ -3021,186 +3641,10 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
   else
     dynamic_view = of->get_output_view(this->dynamic_offset_, dynamic_size);
 
-  for (Symbol_table_type::const_iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
-    {
-      Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(p->second);
-
-      // Possibly warn about unresolved symbols in shared libraries.
-      this->warn_about_undefined_dynobj_symbol(sym);
-
-      unsigned int sym_index = sym->symtab_index();
-      unsigned int dynsym_index;
-      if (dynamic_view == NULL)
-	dynsym_index = -1U;
-      else
-	dynsym_index = sym->dynsym_index();
-
-      if (sym_index == -1U && dynsym_index == -1U)
-	{
-	  // This symbol is not included in the output file.
-	  continue;
-	}
-
-      unsigned int shndx;
-      typename elfcpp::Elf_types<size>::Elf_Addr sym_value = sym->value();
-      typename elfcpp::Elf_types<size>::Elf_Addr dynsym_value = sym_value;
-      elfcpp::STB binding = sym->binding();
-
-      // If --weak-unresolved-symbols is set, change binding of unresolved
-      // global symbols to STB_WEAK.
-      if (parameters->options().weak_unresolved_symbols()
-	  && binding == elfcpp::STB_GLOBAL
-	  && sym->is_undefined())
-	binding = elfcpp::STB_WEAK;
-
-      // If --no-gnu-unique is set, change STB_GNU_UNIQUE to STB_GLOBAL.
-      if (binding == elfcpp::STB_GNU_UNIQUE
-	  && !parameters->options().gnu_unique())
-	binding = elfcpp::STB_GLOBAL;
-
-      switch (sym->source())
-	{
-	case Symbol::FROM_OBJECT:
-	  {
-	    bool is_ordinary;
-	    unsigned int in_shndx = sym->shndx(&is_ordinary);
-
-	    if (!is_ordinary
-		&& in_shndx != elfcpp::SHN_ABS
-		&& !Symbol::is_common_shndx(in_shndx))
-	      {
-		gold_error(_("%s: unsupported symbol section 0x%x"),
-			   sym->demangled_name().c_str(), in_shndx);
-		shndx = in_shndx;
-	      }
-	    else
-	      {
-		Object* symobj = sym->object();
-		if (symobj->is_dynamic())
-		  {
-		    if (sym->needs_dynsym_value())
-		      dynsym_value = target.dynsym_value(sym);
-		    shndx = elfcpp::SHN_UNDEF;
-		    if (sym->is_undef_binding_weak())
-		      binding = elfcpp::STB_WEAK;
-		    else
-		      binding = elfcpp::STB_GLOBAL;
-		  }
-		else if (symobj->pluginobj() != NULL)
-		  shndx = elfcpp::SHN_UNDEF;
-		else if (in_shndx == elfcpp::SHN_UNDEF
-			 || (!is_ordinary
-			     && (in_shndx == elfcpp::SHN_ABS
-				 || Symbol::is_common_shndx(in_shndx))))
-		  shndx = in_shndx;
-		else
-		  {
-		    Relobj* relobj = static_cast<Relobj*>(symobj);
-		    Output_section* os = relobj->output_section(in_shndx);
-                    if (this->is_section_folded(relobj, in_shndx))
-                      {
-                        // This global symbol must be written out even though
-                        // it is folded.
-                        // Get the os of the section it is folded onto.
-                        Section_id folded =
-                             this->icf_->get_folded_section(relobj, in_shndx);
-                        gold_assert(folded.first !=NULL);
-                        Relobj* folded_obj = 
-                          reinterpret_cast<Relobj*>(folded.first);
-                        os = folded_obj->output_section(folded.second);  
-                        gold_assert(os != NULL);
-                      }
-		    gold_assert(os != NULL);
-		    shndx = os->out_shndx();
-
-		    if (shndx >= elfcpp::SHN_LORESERVE)
-		      {
-			if (sym_index != -1U)
-			  symtab_xindex->add(sym_index, shndx);
-			if (dynsym_index != -1U)
-			  dynsym_xindex->add(dynsym_index, shndx);
-			shndx = elfcpp::SHN_XINDEX;
-		      }
-
-		    // In object files symbol values are section
-		    // relative.
-		    if (parameters->options().relocatable())
-		      sym_value -= os->address();
-		  }
-	      }
-	  }
-	  break;
-
-	case Symbol::IN_OUTPUT_DATA:
-	  {
-	    Output_data* od = sym->output_data();
-
-	    shndx = od->out_shndx();
-	    if (shndx >= elfcpp::SHN_LORESERVE)
-	      {
-		if (sym_index != -1U)
-		  symtab_xindex->add(sym_index, shndx);
-		if (dynsym_index != -1U)
-		  dynsym_xindex->add(dynsym_index, shndx);
-		shndx = elfcpp::SHN_XINDEX;
-	      }
-
-	    // In object files symbol values are section
-	    // relative.
-	    if (parameters->options().relocatable())
-	      {
-		Output_section* os = od->output_section();
-		gold_assert(os != NULL);
-		sym_value -= os->address();
-	      }
-	  }
-	  break;
-
-	case Symbol::IN_OUTPUT_SEGMENT:
-	  {
-	    Output_segment* oseg = sym->output_segment();
-	    Output_section* osect = oseg->first_section();
-	    if (osect == NULL)
-	      shndx = elfcpp::SHN_ABS;
-	    else
-	      shndx = osect->out_shndx();
-	  }
-	  break;
-
-	case Symbol::IS_CONSTANT:
-	  shndx = elfcpp::SHN_ABS;
-	  break;
-
-	case Symbol::IS_UNDEFINED:
-	  shndx = elfcpp::SHN_UNDEF;
-	  break;
-
-	default:
-	  gold_unreachable();
-	}
-
-      if (sym_index != -1U)
-	{
-	  sym_index -= first_global_index;
-	  gold_assert(sym_index < output_count);
-	  unsigned char* ps = psyms + (sym_index * sym_size);
-	  this->sized_write_symbol<size, big_endian>(sym, sym_value, shndx,
-						     binding, sympool, ps);
-	}
-
-      if (dynsym_index != -1U)
-	{
-	  dynsym_index -= first_dynamic_global_index;
-	  gold_assert(dynsym_index < dynamic_count);
-	  unsigned char* pd = dynamic_view + (dynsym_index * sym_size);
-	  this->sized_write_symbol<size, big_endian>(sym, dynsym_value, shndx,
-						     binding, dynpool, pd);
-          // Allow a target to adjust dynamic symbol value.
-          parameters->target().adjust_dyn_symbol(sym, pd);
-	}
-    }
+  this->for_all_symbols<size>(
+      Write_global_visitor<size, big_endian>(this, sympool, dynpool,
+					     symtab_xindex, dynsym_xindex,
+					     psyms, dynamic_view));
 
   // Write the target-specific symbols.
   for (std::vector<Symbol*>::const_iterator p = this->target_symbols_.begin();
@@ -3255,6 +3699,206 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
     of->write_output_view(this->dynamic_offset_, dynamic_size, dynamic_view);
 }
 
+// Write out the global symbol SYM for sized_write_globals.  PSYMS and
+// DYNAMIC_VIEW are the views of the symbol tables, or NULL.
+
+template<int size, bool big_endian>
+void
+Symbol_table::sized_write_global(Sized_symbol<size>* sym,
+				 const Stringpool* sympool,
+				 const Stringpool* dynpool,
+				 Output_symtab_xindex* symtab_xindex,
+				 Output_symtab_xindex* dynsym_xindex,
+				 unsigned char* psyms,
+				 unsigned char* dynamic_view) const
+{
+  const Target& target = parameters->target();
+
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+
+  const unsigned int output_count = this->output_count_;
+  const unsigned int first_global_index = this->first_global_index_;
+  const unsigned int dynamic_count = this->dynamic_count_;
+  const unsigned int first_dynamic_global_index =
+    this->first_dynamic_global_index_;
+
+  // Possibly warn about unresolved symbols in shared libraries.
+  this->warn_about_undefined_dynobj_symbol(sym);
+
+  unsigned int sym_index = sym->symtab_index();
+  unsigned int dynsym_index;
+  if (dynamic_view == NULL)
+    dynsym_index = -1U;
+  else
+    dynsym_index = sym->dynsym_index();
+
+  if (sym_index == -1U && dynsym_index == -1U)
+    {
+      // This symbol is not included in the output file.
+      return;
+    }
+
+  unsigned int shndx;
+  typename elfcpp::Elf_types<size>::Elf_Addr sym_value = sym->value();
+  typename elfcpp::Elf_types<size>::Elf_Addr dynsym_value = sym_value;
+  elfcpp::STB binding = sym->binding();
+
+  // If --weak-unresolved-symbols is set, change binding of unresolved
+  // global symbols to STB_WEAK.
+  if (parameters->options().weak_unresolved_symbols()
+      && binding == elfcpp::STB_GLOBAL
+      && sym->is_undefined())
+    binding = elfcpp::STB_WEAK;
+
+  // If --no-gnu-unique is set, change STB_GNU_UNIQUE to STB_GLOBAL.
+  if (binding == elfcpp::STB_GNU_UNIQUE
+      && !parameters->options().gnu_unique())
+    binding = elfcpp::STB_GLOBAL;
+
+  switch (sym->source())
+    {
+    case Symbol::FROM_OBJECT:
+      {
+	bool is_ordinary;
+	unsigned int in_shndx = sym->shndx(&is_ordinary);
+
+	if (!is_ordinary
+	    && in_shndx != elfcpp::SHN_ABS
+	    && !Symbol::is_common_shndx(in_shndx))
+	  {
+	    gold_error(_("%s: unsupported symbol section 0x%x"),
+		       sym->demangled_name().c_str(), in_shndx);
+	    shndx = in_shndx;
+	  }
+	else
+	  {
+	    Object* symobj = sym->object();
+	    if (symobj->is_dynamic())
+	      {
+		if (sym->needs_dynsym_value())
+		  dynsym_value = target.dynsym_value(sym);
+		shndx = elfcpp::SHN_UNDEF;
+		if (sym->is_undef_binding_weak())
+		  binding = elfcpp::STB_WEAK;
+		else
+		  binding = elfcpp::STB_GLOBAL;
+	      }
+	    else if (symobj->pluginobj() != NULL)
+	      shndx = elfcpp::SHN_UNDEF;
+	    else if (in_shndx == elfcpp::SHN_UNDEF
+		     || (!is_ordinary
+			 && (in_shndx == elfcpp::SHN_ABS
+			     || Symbol::is_common_shndx(in_shndx))))
+	      shndx = in_shndx;
+	    else
+	      {
+		Relobj* relobj = static_cast<Relobj*>(symobj);
+		Output_section* os = relobj->output_section(in_shndx);
+		if (this->is_section_folded(relobj, in_shndx))
+		  {
+		    // This global symbol must be written out even
+		    // though it is folded.
+		    // Get the os of the section it is folded onto.
+		    Section_id folded =
+		      this->icf_->get_folded_section(relobj,
+						     in_shndx);
+		    gold_assert(folded.first !=NULL);
+		    Relobj* folded_obj = 
+		      reinterpret_cast<Relobj*>(folded.first);
+		    os = folded_obj->output_section(folded.second);  
+		    gold_assert(os != NULL);
+		  }
+		gold_assert(os != NULL);
+		shndx = os->out_shndx();
+
+		if (shndx >= elfcpp::SHN_LORESERVE)
+		  {
+		    if (sym_index != -1U)
+		      symtab_xindex->add(sym_index, shndx);
+		    if (dynsym_index != -1U)
+		      dynsym_xindex->add(dynsym_index, shndx);
+		    shndx = elfcpp::SHN_XINDEX;
+		  }
+
+		// In object files symbol values are section
+		// relative.
+		if (parameters->options().relocatable())
+		  sym_value -= os->address();
+	      }
+	  }
+      }
+      break;
+
+    case Symbol::IN_OUTPUT_DATA:
+      {
+	Output_data* od = sym->output_data();
+
+	shndx = od->out_shndx();
+	if (shndx >= elfcpp::SHN_LORESERVE)
+	  {
+	    if (sym_index != -1U)
+	      symtab_xindex->add(sym_index, shndx);
+	    if (dynsym_index != -1U)
+	      dynsym_xindex->add(dynsym_index, shndx);
+	    shndx = elfcpp::SHN_XINDEX;
+	  }
+
+	// In object files symbol values are section
+	// relative.
+	if (parameters->options().relocatable())
+	  {
+	    Output_section* os = od->output_section();
+	    gold_assert(os != NULL);
+	    sym_value -= os->address();
+	  }
+      }
+      break;
+
+    case Symbol::IN_OUTPUT_SEGMENT:
+      {
+	Output_segment* oseg = sym->output_segment();
+	Output_section* osect = oseg->first_section();
+	if (osect == NULL)
+	  shndx = elfcpp::SHN_ABS;
+	else
+	  shndx = osect->out_shndx();
+      }
+      break;
+
+    case Symbol::IS_CONSTANT:
+      shndx = elfcpp::SHN_ABS;
+      break;
+
+    case Symbol::IS_UNDEFINED:
+      shndx = elfcpp::SHN_UNDEF;
+      break;
+
+    default:
+      gold_unreachable();
+    }
+
+  if (sym_index != -1U)
+    {
+      sym_index -= first_global_index;
+      gold_assert(sym_index < output_count);
+      unsigned char* ps = psyms + (sym_index * sym_size);
+      this->sized_write_symbol<size, big_endian>(sym, sym_value, shndx,
+						 binding, sympool, ps);
+    }
+
+  if (dynsym_index != -1U)
+    {
+      dynsym_index -= first_dynamic_global_index;
+      gold_assert(dynsym_index < dynamic_count);
+      unsigned char* pd = dynamic_view + (dynsym_index * sym_size);
+      this->sized_write_symbol<size, big_endian>(sym, dynsym_value,
+						 shndx, binding,
+						 dynpool, pd);
+      // Allow a target to adjust dynamic symbol value.
+      parameters->target().adjust_dyn_symbol(sym, pd);
+    }
+}
+
 // Write out the symbol SYM, in section SHNDX, to P.  POOL is the
 // strtab holding the name.
 
@@ -3402,13 +4046,29 @@ Symbol_table::sized_write_section_symbol(const Output_section* os,
 void
 Symbol_table::print_stats() const
 {
+  size_t entries = 0;
+#if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
+  size_t buckets = 0;
+#endif
+  for (Shards::const_iterator p = this->shards_.begin();
+       p != this->shards_.end();
+       ++p)
+    {
+      entries += (*p)->table.size();
+#if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
+      buckets += (*p)->table.bucket_count();
+#endif
+    }
 #if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
   fprintf(stderr, _("%s: symbol table entries: %zu; buckets: %zu\n"),
-	  program_name, this->table_.size(), this->table_.bucket_count());
+	  program_name, entries, buckets);
 #else
   fprintf(stderr, _("%s: symbol table entries: %zu\n"),
-	  program_name, this->table_.size());
+	  program_name, entries);
 #endif
+  if (this->shards_.size() > 1)
+    fprintf(stderr, _("%s: symbol table shards: %zu\n"),
+	    program_name, this->shards_.size());
   this->namepool_.print_stats("symbol table stringpool");
 }
 
@@ -3715,6 +4375,70 @@ Symbol_table::add_from_relobj<64, true>(
     size_t* defined);
 #endif
 
+#ifdef HAVE_TARGET_32_LITTLE
+template
+Deferred_relobj*
+Symbol_table::defer_relobj_symbols<32, false>(
+    Sized_relobj_file<32, false>* relobj,
+    File_view* symbols,
+    File_view* symbol_names,
+    const unsigned char* syms,
+    size_t count,
+    size_t symndx_offset,
+    const char* sym_names,
+    size_t sym_name_size,
+    Sized_relobj_file<32, false>::Symbols* sympointers,
+    size_t* defined);
+#endif
+
+#ifdef HAVE_TARGET_32_BIG
+template
+Deferred_relobj*
+Symbol_table::defer_relobj_symbols<32, true>(
+    Sized_relobj_file<32, true>* relobj,
+    File_view* symbols,
+    File_view* symbol_names,
+    const unsigned char* syms,
+    size_t count,
+    size_t symndx_offset,
+    const char* sym_names,
+    size_t sym_name_size,
+    Sized_relobj_file<32, true>::Symbols* sympointers,
+    size_t* defined);
+#endif
+
+#ifdef HAVE_TARGET_64_LITTLE
+template
+Deferred_relobj*
+Symbol_table::defer_relobj_symbols<64, false>(
+    Sized_relobj_file<64, false>* relobj,
+    File_view* symbols,
+    File_view* symbol_names,
+    const unsigned char* syms,
+    size_t count,
+    size_t symndx_offset,
+    const char* sym_names,
+    size_t sym_name_size,
+    Sized_relobj_file<64, false>::Symbols* sympointers,
+    size_t* defined);
+#endif
+
+#ifdef HAVE_TARGET_64_BIG
+template
+Deferred_relobj*
+Symbol_table::defer_relobj_symbols<64, true>(
+    Sized_relobj_file<64, true>* relobj,
+    File_view* symbols,
+    File_view* symbol_names,
+    const unsigned char* syms,
+    size_t count,
+    size_t symndx_offset,
+    const char* sym_names,
+    size_t sym_name_size,
+    Sized_relobj_file<64, true>::Symbols* sympointers,
+    size_t* defined);
+#endif
+
 #ifdef HAVE_TARGET_32_LITTLE
 template
 Symbol*
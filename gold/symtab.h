@@ -60,6 +60,7 @@ class Output_file;
 class Output_symtab_xindex;
 class Garbage_collection;
 class Icf;
+class Task_token;
 
 // The base class of an entry in the symbol table.  The symbol table
 // can have a lot of entries, so we don't want this class too big.
@@ -1342,6 +1343,33 @@ class Warnings
   Warning_table warnings_;
 };
 
+// The symbols from a relocatable object which will be added to the
+// symbol table later.
+struct Deferred_relobj
+{
+  // The object.
+  Relobj* relobj;
+  // The views holding the symbols and their names.
+  File_view* symbols;
+  File_view* symbol_names;
+  // The arguments to pass to add_from_relobj.
+  const unsigned char* syms;
+  size_t count;
+  size_t symndx_offset;
+  const char* sym_names;
+  size_t sym_name_size;
+  std::vector<Symbol*>* sympointers;
+  size_t* defined;
+  // The indexes of the symbols, sorted by shard.
+  std::vector<unsigned int> order;
+  // The index in ORDER of the first symbol for each shard, with a
+  // final entry holding the number of symbols.
+  std::vector<unsigned int> shard_start;
+  // Whether some symbol has a version, and must be added by
+  // add_from_relobj.
+  bool has_version;
+};
+
 // The main linker symbol table.
 
 class Symbol_table
@@ -1430,6 +1458,72 @@ class Symbol_table
 		  typename Sized_relobj_file<size, big_endian>::Symbols*,
 		  size_t* defined);
 
+  // Return the number of shards.  There is more than one shard if we
+  // are adding symbols from relocatable objects in parallel.
+  unsigned int
+  shard_count() const
+  { return this->shards_.size(); }
+
+  // Return whether symbols from relocatable objects are added to the
+  // symbol table in parallel.
+  bool
+  parallel_resolution() const
+  { return this->shards_.size() > 1; }
+
+  // Record that the COUNT external symbols from the relocatable
+  // object RELOBJ are to be added to the symbol table later.  The
+  // other arguments are as for add_from_relobj, except that the
+  // symbol table takes ownership of the views SYMBOLS and
+  // SYMBOL_NAMES, which hold SYMS and SYM_NAMES.  This returns the
+  // deferred object to pass to prepare_deferred_symbols.
+  template<int size, bool big_endian>
+  Deferred_relobj*
+  defer_relobj_symbols(Sized_relobj_file<size, big_endian>* relobj,
+		       File_view* symbols, File_view* symbol_names,
+		       const unsigned char* syms, size_t count,
+		       size_t symndx_offset, const char* sym_names,
+		       size_t sym_name_size,
+		       typename Sized_relobj_file<size, big_endian>::Symbols*,
+		       size_t* defined);
+
+  // Sort the symbols of the deferred object D by shard.  This may be
+  // run in parallel for different objects.
+  void
+  prepare_deferred_symbols(Deferred_relobj* d);
+
+  // Return whether any symbols have been deferred.
+  bool
+  has_deferred_symbols() const
+  { return !this->deferred_.empty(); }
+
+  // Return the blocker which is held by the tasks which call
+  // prepare_deferred_symbols.
+  Task_token*
+  deferred_blocker() const
+  { return this->deferred_blocker_; }
+
+  // Return whether the deferred symbols may be added to the shards in
+  // parallel.  This may only be called after all the deferred objects
+  // have been prepared.
+  bool
+  can_resolve_deferred_in_parallel() const;
+
+  // Add all the deferred symbols to the symbol table, one object at a
+  // time, in order.  TASK is the running task, used to lock the
+  // objects while freeing the views of their symbols.
+  void
+  resolve_deferred_symbols(const Task* task);
+
+  // Add the deferred symbols whose names fall in shard SHARD.  This
+  // is run in parallel for different shards.
+  void
+  resolve_deferred_shard(unsigned int shard);
+
+  // Finish adding deferred symbols after resolve_deferred_shard has
+  // been run for each shard.  TASK is the running task.
+  void
+  finish_deferred_symbols(const Task* task);
+
   // Add one external symbol from the plugin object OBJ to the symbol table.
   // Returns a pointer to the resolved symbol in the symbol table.
   template<int size, bool big_endian>
@@ -1534,6 +1628,15 @@ class Symbol_table
   saw_undefined() const
   { return this->saw_undefined_; }
 
+  // Start or stop recording the names of symbols which get a new
+  // strong undefined reference.  While NAMES is not NULL, we add
+  // such a name to it each time an object adds an undefined
+  // reference to a symbol which is not yet defined.  This is used to
+  // find the archive map entries which may now be needed.
+  void
+  set_undefined_references(std::vector<const char*>* names)
+  { this->undefined_references_ = names; }
+
   // Allocate the common symbols
   void
   allocate_commons(Layout*, Mapfile*);
@@ -1642,17 +1745,44 @@ class Symbol_table
   write_section_symbol(const Output_section*, Output_symtab_xindex*,
 		       Output_file*, off_t) const;
 
-  // Loop over all symbols, applying the function F to each.
+  // Loop over all symbols, applying the function F to each.  The
+  // symbols are visited shard by shard.  With
+  // --parallel-symbol-resolution there is more than one shard, so the
+  // order differs from a serial link, and so does the order of the
+  // global symbols in .symtab and .dynsym.  It still does not depend
+  // on the number of threads.
+  template<typename F>
+  void
+  for_all_symbols(F f) const
+  {
+    for (Shards::const_iterator s = this->shards_.begin();
+	 s != this->shards_.end();
+	 ++s)
+      {
+	for (Symbol_table_type::const_iterator p = (*s)->table.begin();
+	     p != (*s)->table.end();
+	     ++p)
+	  f(p->second);
+      }
+  }
+
+  // Likewise, passing each symbol to F as a Sized_symbol<size>.
   template<int size, typename F>
   void
   for_all_symbols(F f) const
   {
-    for (Symbol_table_type::const_iterator p = this->table_.begin();
-         p != this->table_.end();
-         ++p)
+    for (Shards::const_iterator s = this->shards_.begin();
+	 s != this->shards_.end();
+	 ++s)
       {
-	Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(p->second);
-	f(sym);
+	for (Symbol_table_type::const_iterator p = (*s)->table.begin();
+	     p != (*s)->table.end();
+	     ++p)
+	  {
+	    Sized_symbol<size>* sym =
+	      static_cast<Sized_symbol<size>*>(p->second);
+	    f(sym);
+	  }
       }
   }
 
@@ -1695,6 +1825,9 @@ class Symbol_table
   typedef Unordered_map<Symbol_table_key, Symbol*, Symbol_table_hash,
 			Symbol_table_eq> Symbol_table_type;
 
+  // A shard of the symbol table, defined below.
+  struct Symbol_table_shard;
+
   // A map from symbol name (as a pointer into the namepool) to all
   // the locations the symbols is (weakly) defined (and certain other
   // conditions are met).  This map will be used later to detect
@@ -1720,7 +1853,58 @@ class Symbol_table
 		  const char* version, Stringpool::Key version_key,
 		  bool def, const elfcpp::Sym<size, big_endian>& sym,
 		  unsigned int st_shndx, bool is_ordinary,
-		  unsigned int orig_st_shndx);
+		  unsigned int orig_st_shndx,
+		  Symbol_table_shard* deferred_shard = NULL);
+
+  // Return the index of the shard which holds the name NAME of
+  // length LEN.  This is the stripe of the name pool which holds the
+  // name.
+  unsigned int
+  shard_index(const char* name, size_t len) const
+  { return this->namepool_.stripe_index(name, len); }
+
+  // Return the hash table holding the symbols named by NAME_KEY.
+  // The name pool key encodes the stripe, which is also the shard.
+  Symbol_table_type&
+  table_for_key(Stringpool::Key name_key)
+  { return this->shards_[(name_key - 1) % this->shards_.size()]->table; }
+
+  const Symbol_table_type&
+  table_for_key(Stringpool::Key name_key) const
+  { return this->shards_[(name_key - 1) % this->shards_.size()]->table; }
+
+  // Free the list of deferred objects.
+  void
+  free_deferred_symbols(const Task*);
+
+  // Add the symbols of a deferred object to the table serially.
+  template<int size, bool big_endian>
+  void
+  sized_resolve_deferred_relobj(Deferred_relobj*);
+
+  // Sort the symbols of a deferred object by shard.
+  template<int size, bool big_endian>
+  void
+  sized_prepare_deferred_symbols(Deferred_relobj*);
+
+  // Add the symbols of a deferred object which fall in a shard.
+  template<int size, bool big_endian>
+  void
+  sized_resolve_deferred_shard(Deferred_relobj*, unsigned int shard);
+
+  // Record that a symbol should not be garbage collected.  If
+  // DEFERRED_SHARD is not NULL, record this in the shard.
+  void
+  gc_mark_symbol(Symbol*, Symbol_table_shard* deferred_shard);
+
+  // Keep a symbol seen in a dynamic object.
+  void
+  gc_mark_dyn_syms(Symbol*, Symbol_table_shard* deferred_shard);
+
+  // Record a new common symbol.
+  void
+  add_common(Symbol*, bool is_ordinary, unsigned int st_shndx,
+	     Symbol_table_shard* deferred_shard);
 
   // Define a default symbol.
   template<int size, bool big_endian>
@@ -1745,7 +1929,7 @@ class Symbol_table
   // Record that a symbol is forced to be local by a version script or
   // by visibility.
   void
-  force_local(Symbol*);
+  force_local(Symbol*, Symbol_table_shard* deferred_shard = NULL);
 
   // Adjust NAME and *NAME_KEY for wrapping.
   const char*
@@ -1892,6 +2076,18 @@ class Symbol_table
 		      Output_symtab_xindex*, Output_symtab_xindex*,
 		      Output_file*) const;
 
+  // Write out one global symbol for sized_write_globals.
+  template<int size, bool big_endian>
+  void
+  sized_write_global(Sized_symbol<size>*, const Stringpool*,
+		     const Stringpool*, Output_symtab_xindex*,
+		     Output_symtab_xindex*, unsigned char* psyms,
+		     unsigned char* dynamic_view) const;
+
+  // The visitor which calls sized_write_global.
+  template<int size, bool big_endian>
+  class Write_global_visitor;
+
   // Write out a symbol to P.
   template<int size, bool big_endian>
   void
@@ -1913,6 +2109,42 @@ class Symbol_table
   // The type of the list of symbols which have been forced local.
   typedef std::vector<Symbol*> Forced_locals;
 
+  // The symbol table is divided into shards by the hash code of the
+  // symbol name.  Each shard has its own hash table, and its own
+  // stripe of the name pool.  Normally there is just one shard.  When
+  // there is more than one, each shard may be updated by a different
+  // thread while resolving deferred symbols, and changes which would
+  // otherwise go to the lists in Symbol_table are collected in the
+  // shard until finish_deferred_symbols.
+  struct Symbol_table_shard
+  {
+    Symbol_table_shard(unsigned int count)
+      : table(count), saw_undefined(0), commons(), tls_commons(),
+	small_commons(), large_commons(), forced_locals(), gc_sections(),
+	gc_symbols()
+    { }
+
+    // The symbol hash table.
+    Symbol_table_type table;
+    // The number of new undefined symbols.
+    size_t saw_undefined;
+    // New common symbols.
+    Commons_type commons;
+    Commons_type tls_commons;
+    Commons_type small_commons;
+    Commons_type large_commons;
+    // Symbols forced to be local.
+    Forced_locals forced_locals;
+    // Sections to add to the garbage collection work list.
+    std::vector<Section_id> gc_sections;
+    // Symbols to pass to the target for garbage collection.
+    std::vector<Symbol*> gc_symbols;
+  };
+
+  typedef std::vector<Symbol_table_shard*> Shards;
+
+  typedef std::vector<Deferred_relobj*> Deferred_relobjs;
+
   // A map from symbols with COPY relocs to the dynamic objects where
   // they are defined.
   typedef Unordered_map<const Symbol*, Dynobj*> Copied_symbol_dynobjs;
@@ -1920,6 +2152,9 @@ class Symbol_table
   // We increment this every time we see a new undefined symbol, for
   // use in archive groups.
   size_t saw_undefined_;
+  // If not NULL, we add the names of symbols with new strong
+  // undefined references here.
+  std::vector<const char*>* undefined_references_;
   // The index of the first global symbol in the output file.
   unsigned int first_global_index_;
   // The file offset within the output symtab section where we should
@@ -1935,11 +2170,15 @@ class Symbol_table
   // The number of global dynamic symbols (including forced-local symbols),
   // or 0 if none.
   unsigned int dynamic_count_;
-  // The symbol hash table.
-  Symbol_table_type table_;
+  // The symbol hash tables.
+  Shards shards_;
   // A pool of symbol names.  This is used for all global symbols.
-  // Entries in the hash table point into this pool.
+  // Entries in the hash tables point into this pool.
   Stringpool namepool_;
+  // Relocatable objects whose symbols have not yet been added.
+  Deferred_relobjs deferred_;
+  // Blocker for preparing the deferred objects.
+  Task_token* deferred_blocker_;
   // Forwarding symbols.
   Unordered_map<const Symbol*, Symbol*> forwarders_;
   // Weak aliases.  A symbol in this list points to the next alias.
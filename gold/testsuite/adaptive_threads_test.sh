@@ -0,0 +1,59 @@
+#!/bin/sh
+
+# adaptive_threads_test.sh -- test --adaptive-threads.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# adaptive_threads_test is linked with --threads --adaptive-threads
+# and --debug=task, which reports each change to the number of
+# threads.  The output must be the same as relocate_parts_test_1, the
+# same link without threads.  The workqueue must have reported the
+# number of threads it started with, which is at most the 8 threads
+# asked for.
+
+check_same()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$2 differs from $1"
+	exit 1
+    fi
+}
+
+check_same relocate_parts_test_1 adaptive_threads_test
+
+if ! grep -q "using [1-8] of 8 threads on [0-9]* CPUs" adaptive_threads_test.err
+then
+    echo "Did not find expected thread count in adaptive_threads_test.err:"
+    grep "threads on" adaptive_threads_test.err
+    exit 1
+fi
+
+if grep "using [0-9]* of 8 threads" adaptive_threads_test.err \
+    | grep -v -q "using [1-8] of 8 threads"
+then
+    echo "Found more threads than asked for in adaptive_threads_test.err:"
+    grep "threads on" adaptive_threads_test.err
+    exit 1
+fi
+
+./adaptive_threads_test || exit 1
+
+exit 0
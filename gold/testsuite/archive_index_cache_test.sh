@@ -0,0 +1,40 @@
+#!/bin/sh
+
+# archive_index_cache_test.sh -- test --archive-index-cache.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The first link writes the archive index cache, and the second link
+# reads it.  Both links must produce the same output.
+
+if ! grep -q "archive index cache hits: [1-9]" archive_index_cache_test.stdout
+then
+    echo "archive index cache was not used:"
+    cat archive_index_cache_test.stdout
+    exit 1
+fi
+
+if ! cmp archive_index_cache_test_1 archive_index_cache_test_2
+then
+    echo "output differs when using the archive index cache"
+    exit 1
+fi
+
+exit 0
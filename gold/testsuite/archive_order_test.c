@@ -0,0 +1,44 @@
+/* archive_order_test.c -- test the order of archive member inclusion.
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* libarchive_order_test.a holds archive_order_test_1.o to
+   archive_order_test_6.o in that order.  Each of members 3, 4 and 5
+   calls a function in the member before it, so the members must be
+   included in the reverse of the archive map order.  Member 1 is only
+   referenced weakly here, but strongly by member 3, so it must be
+   included after member 3.  Member 6 is only referenced weakly, so it
+   must not be included.  */
+
+extern int archive_order_f4 (void);
+extern int archive_order_w (void) __attribute__ ((weak));
+extern int archive_order_weak_only (void) __attribute__ ((weak));
+
+int
+main (void)
+{
+  if (archive_order_f4 () != 4)
+    return 1;
+  if (archive_order_w == 0)
+    return 2;
+  if (archive_order_weak_only != 0)
+    return 3;
+  return 0;
+}
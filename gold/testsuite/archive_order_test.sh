@@ -0,0 +1,69 @@
+#!/bin/sh
+
+# archive_order_test.sh -- test the order of archive member inclusion.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The members of libarchive_order_test.a depend on each other in the
+# reverse of the archive map order, and one member is first referenced
+# weakly and later strongly.  See archive_order_test.c.  Check which
+# members are included, and in what order, in the map file and in the
+# symbol table.
+
+check_order()
+{
+    file=$1
+    expected=$2
+    actual=$3
+    if test "$expected" != "$actual"; then
+	echo "Wrong archive member order in $file"
+	echo "expected:"
+	echo "$expected"
+	echo "actual:"
+	echo "$actual"
+	exit 1
+    fi
+}
+
+map_expected="libarchive_order_test.a(archive_order_test_5.o) archive_order_test.o (archive_order_f4)
+libarchive_order_test.a(archive_order_test_4.o) libarchive_order_test.a(archive_order_test_5.o) (archive_order_f3)
+libarchive_order_test.a(archive_order_test_3.o) libarchive_order_test.a(archive_order_test_4.o) (archive_order_f2)
+libarchive_order_test.a(archive_order_test_1.o) libarchive_order_test.a(archive_order_test_3.o) (archive_order_w)
+libarchive_order_test.a(archive_order_test_2.o) libarchive_order_test.a(archive_order_test_3.o) (archive_order_f1)"
+
+# Join each member line with the reason on the following line.
+map_actual=`sed -n -e '/^libarchive_order_test\.a(/{N;s/\n */ /;p;}' \
+    archive_order_test.map`
+
+check_order archive_order_test.map "$map_expected" "$map_actual"
+
+syms_expected="w archive_order_weak_only
+T archive_order_f4
+T archive_order_f3
+T archive_order_f2
+T archive_order_w
+T archive_order_f1"
+
+syms_actual=`grep ' archive_order_' archive_order_test.syms \
+    | awk '{ print $(NF-1), $NF }'`
+
+check_order archive_order_test.syms "$syms_expected" "$syms_actual"
+
+exit 0
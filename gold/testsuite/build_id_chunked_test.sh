@@ -0,0 +1,64 @@
+#!/bin/sh
+
+# build_id_chunked_test.sh -- test --build-id-chunked.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# With --build-id-chunked, the md5 and sha1 build IDs are computed
+# from the hashes of the chunks of the output file, so they must not
+# depend on the number of threads, but they are not the same as the
+# flat build IDs.
+
+build_id()
+{
+    awk -v file="$1" '
+/^File: / { this = $2 }
+/Build ID:/ && this == file { print $3 }
+' build_id_chunked_test.stdout
+}
+
+id1=`build_id build_id_chunked_test_1`
+id2=`build_id build_id_chunked_test_2`
+id3=`build_id build_id_chunked_test_3`
+id4=`build_id build_id_chunked_test_4`
+
+if test `echo "$id1" | wc -c` -ne 41; then
+    echo "bad chunked sha1 build ID '$id1'"
+    exit 1
+fi
+
+if test "$id1" != "$id2"; then
+    echo "chunked build ID depends on the number of threads"
+    echo "  --no-threads: $id1"
+    echo "  --threads:    $id2"
+    exit 1
+fi
+
+if test "$id1" = "$id3"; then
+    echo "chunked sha1 build ID is the same as the flat one: $id1"
+    exit 1
+fi
+
+if test `echo "$id4" | wc -c` -ne 33; then
+    echo "bad chunked md5 build ID '$id4'"
+    exit 1
+fi
+
+exit 0
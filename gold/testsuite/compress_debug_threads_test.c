@@ -0,0 +1,38 @@
+/* compress_debug_threads_test.c -- test compressing large debug sections
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   Emit a debug section of about 4MB, so that gold compresses it in
+   several chunks.  The contents vary enough that no chunk compresses
+   to nothing.  */
+
+__asm__ (".pushsection .debug_gold_chunks,\"\",%progbits\n"
+	 ".set chunk_i, 0\n"
+	 ".rept 1000000\n"
+	 ".long (chunk_i * 40503) % 65521\n"
+	 ".set chunk_i, chunk_i + 1\n"
+	 ".endr\n"
+	 ".popsection\n");
+
+int
+main (void)
+{
+  return 0;
+}
@@ -0,0 +1,65 @@
+#!/bin/sh
+
+# compress_debug_threads_test.sh -- test --compress-debug-sections
+# with --threads.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The .debug_gold_chunks section is large enough to be compressed in
+# several chunks by parallel tasks.  Check that the section is
+# compressed, and that it decompresses to the original contents.
+# With zlib the section has SHF_COMPRESSED set; with zlib-gnu it is
+# renamed to .zdebug_gold_chunks.
+
+check_compressed()
+{
+    if ! grep -q "$2" "$1"; then
+	echo "Section $3 not compressed in $1"
+	exit 1
+    fi
+}
+
+contents()
+{
+    sed -n '/^Hex dump/,$p' "$1" | sed 1d
+}
+
+check_same()
+{
+    if ! contents "$1" > "$1.hex" || ! contents "$2" > "$2.hex"; then
+	exit 1
+    fi
+    if ! cmp -s "$1.hex" "$2.hex"; then
+	echo "Decompressed contents in $2 differ from $1"
+	exit 1
+    fi
+}
+
+check_compressed compress_debug_threads_test_zlib.stdout \
+  "\.debug_gold_chunks .* C " .debug_gold_chunks
+check_compressed compress_debug_threads_test_gnu.stdout \
+  "\.zdebug_gold_chunks " .debug_gold_chunks
+
+check_same compress_debug_threads_test_none.stdout \
+  compress_debug_threads_test_zlib.stdout
+check_same compress_debug_threads_test_none.stdout \
+  compress_debug_threads_test_gnu.stdout
+
+exit 0
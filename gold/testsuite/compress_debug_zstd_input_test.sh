@@ -0,0 +1,90 @@
+#!/bin/sh
+
+# compress_debug_zstd_input_test.sh -- test linking zstd compressed
+# debug sections.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# compress_debug_zstd_input_test.o is flagstest_debug.o with its debug
+# sections compressed with zstd.  Whatever the output compression,
+# the debug info must be the same as for the uncompressed link of
+# flagstest_debug.o.
+
+check_same()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$2 differs from $1"
+	exit 1
+    fi
+}
+
+check_same compress_debug_zstd_input_test_ref.stdout \
+    compress_debug_zstd_input_test_none.stdout
+check_same compress_debug_zstd_input_test_ref.stdout \
+    compress_debug_zstd_input_test_zstd.stdout
+check_same compress_debug_zstd_input_test_ref.stdout \
+    compress_debug_zstd_input_test_zlib.stdout
+
+# Print the zstd frames of section $2 in the readelf -x output $1, as
+# a string of hex digits.  This skips the 24 byte compression header.
+
+frames()
+{
+    awk -v section="$2" -v q="'" '
+/^Hex dump of section / { in_section = ($5 == q section q ":"); next; }
+in_section && /^  0x/ { hex = hex substr($0, 14, 35); }
+END { gsub(/ /, "", hex); print substr(hex, 49); }
+' "$1"
+}
+
+# .debug_abbrev has no relocations, so when writing zstd its frames
+# are copied into the output.
+
+in=`frames compress_debug_zstd_input_test.o.hex .debug_abbrev`
+out=`frames compress_debug_zstd_input_test_zstd.hex .debug_abbrev`
+if test -z "$in"; then
+    echo "no .debug_abbrev frames in compress_debug_zstd_input_test.o"
+    exit 1
+fi
+case "$out" in
+*"$in"*) ;;
+*)
+    echo ".debug_abbrev was not copied into compress_debug_zstd_input_test_zstd"
+    exit 1
+    ;;
+esac
+
+# .debug_info has relocations, so it is compressed again.
+
+in=`frames compress_debug_zstd_input_test.o.hex .debug_info`
+out=`frames compress_debug_zstd_input_test_zstd.hex .debug_info`
+if test -z "$in"; then
+    echo "no .debug_info frames in compress_debug_zstd_input_test.o"
+    exit 1
+fi
+case "$out" in
+*"$in"*)
+    echo ".debug_info was copied into compress_debug_zstd_input_test_zstd"
+    exit 1
+    ;;
+esac
+
+exit 0
@@ -0,0 +1,99 @@
+#!/bin/sh
+
+# debug_names_test.sh -- a test case for the --debug-names option.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The output must have a .debug_names section whose header is for
+# version 5, with one compilation unit and no type units.  The name
+# index must pass the checks of llvm-dwarfdump --verify, and the
+# entries for some of the names in gdb_index_test.cc must have the
+# right tag and point at the right DIE.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check debug_names_test.stdout '\] \.debug_names  *PROGBITS'
+
+# The header is written in the byte order of the target.
+if grep -q "^  0x00000000 [0-9a-f]* 00050000 " debug_names_test.stdout
+then
+    check debug_names_test.stdout '^  0x00000000 [0-9a-f]* 00050000 00000001 00000000'
+else
+    check debug_names_test.stdout '^  0x00000000 [0-9a-f]* 05000000 01000000 00000000'
+fi
+
+if sed -n 1p debug_names_test.dump | grep -q " not found$"
+then
+    cat debug_names_test.dump
+    exit 77
+fi
+
+check debug_names_test.dump '^No errors\.'
+
+# Check that NAME has an entry with tag TAG in the name index, and
+# that the entry points at a DIE with that tag and name.  The DIE
+# offsets are relative to the only compilation unit, which is at the
+# start of .debug_info.
+check_entry()
+{
+    name=$1
+    tag=$2
+    offset=`awk -v name="$name" -v tag="$tag" '
+	/^\.debug_names contents:/ { in_names = 1 }
+	in_names && /String:/ { found = ($NF == "\"" name "\"") }
+	found && /Tag:/ { entry_tag = $2 }
+	found && entry_tag == tag && /DW_IDX_die_offset:/ { print $2; exit }
+	' debug_names_test.dump`
+    if test -z "$offset"
+    then
+	echo "No $tag entry for $name in the name index"
+	exit 1
+    fi
+
+    die=`awk -v offset="$offset:" '
+	$1 == offset { in_die = 1; die_tag = $2; next }
+	in_die && NF == 0 { exit }
+	in_die && $1 == "DW_AT_name" { print die_tag, $2; exit }
+	' debug_names_test.dump`
+    if test "$die" != "$tag (\"$name\")"
+    then
+	echo "Entry for $name points at the wrong DIE at $offset:"
+	echo "   $die"
+	exit 1
+    fi
+}
+
+check_entry main DW_TAG_subprogram
+check_entry c1 DW_TAG_class_type
+check_entry anonymous_union_container DW_TAG_structure_type
+check_entry one DW_TAG_namespace
+
+exit 0
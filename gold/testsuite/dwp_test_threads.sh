@@ -0,0 +1,44 @@
+#!/bin/sh
+
+# dwp_test_threads.sh -- Test the dwp tool with --threads.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The input files are read in parallel, but they must be added to the
+# output file in order, so the output must be the same as when they
+# are read one at a time.
+
+if ! cmp dwp_test_1.dwp dwp_test_threads.dwp
+then
+    echo "dwp --threads output differs from dwp output"
+    exit 1
+fi
+
+# With -e, dwp opens the executable to find the list of .dwo files
+# before it opens any of them, so the thread options must already be
+# in effect by then.
+
+if ! cmp dwp_test_1.dwp dwp_test_threads_exe.dwp
+then
+    echo "dwp --threads -e output differs from dwp output"
+    exit 1
+fi
+
+exit 0
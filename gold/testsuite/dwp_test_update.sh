@@ -0,0 +1,34 @@
+#!/bin/sh
+
+# dwp_test_update.sh -- Test the dwp tool with --update.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# Adding the rest of the .dwo files to a package of the first two
+# keeps the units of the package where they were, so the units should
+# be laid out as in a package built from all of the .dwo files.
+
+if ! cmp dwp_test_1.stdout dwp_test_update.stdout
+then
+    echo "dwp --update output differs from dwp output"
+    exit 1
+fi
+
+exit 0
@@ -0,0 +1,57 @@
+#!/bin/sh
+
+# dwp_test_update_replace.sh -- Test replacing a CU with dwp --update.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# dwp_test_1_changed.dwo has the same DWO ID as dwp_test_1.dwo, which
+# is in dwp_test_2a.dwp, but a different producer string.  Updating
+# the package with it should replace the CU without a warning, and the
+# CU index should point at the new contribution.
+
+dwo_id=0x52f9c6092fdc3727
+
+if test -s dwp_test_update_replace.err
+then
+    echo "dwp --update printed warnings:"
+    cat dwp_test_update_replace.err
+    exit 1
+fi
+
+# The first row for the DWO ID is in the offset table, the second in
+# the size table.  The first column is .debug_info.dwo.
+offset=`grep "$dwo_id" dwp_test_update_replace.stdout | sed -n 1p | awk '{ print $4 }'`
+size=`grep "$dwo_id" dwp_test_update_replace.stdout | sed -n 2p | awk '{ print $4 }'`
+if test -z "$offset" || test -z "$size"
+then
+    echo "No CU index entry for dwo_id $dwo_id"
+    cat dwp_test_update_replace.stdout
+    exit 1
+fi
+
+if ! dd if=dwp_test_update_replace.info bs=1 skip="$offset" count="$size" \
+	2>/dev/null | grep -a -q "GNU C++ 4.7.y-google"
+then
+    echo "CU index entry for dwo_id $dwo_id does not point at the new CU"
+    cat dwp_test_update_replace.stdout
+    exit 1
+fi
+
+exit 0
@@ -0,0 +1,47 @@
+#!/bin/sh
+
+# gc_threads_test.sh -- test --gc-sections with --threads.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# With --threads the referenced sections are marked by parallel tasks.
+# The same sections must be collected as by gc_comdat_test, which is
+# linked from the same objects without --threads.
+
+check()
+{
+    if grep -q "$2" "$1"
+    then
+        echo "Garbage collection failed to collect :"
+        echo "   $2"
+	exit 1
+    fi
+}
+
+check gc_threads_test.stdout "foo()"
+check gc_threads_test.stdout "bar()"
+check gc_threads_test.stdout "int GetMax<int>(int, int)"
+
+if ! cmp -s gc_comdat_test.stdout gc_threads_test.stdout; then
+  echo "Garbage collection with --threads collected different sections"
+  exit 1
+fi
+
+exit 0
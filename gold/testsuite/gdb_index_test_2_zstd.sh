@@ -0,0 +1,45 @@
+#!/bin/sh
+
+# gdb_index_test_2_zstd.sh -- a test case for the --gdb-index option.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# gdb_index_test_2_zstd is linked from gdb_index_test_cdebug_zstd.o,
+# whose debug sections are compressed with zstd, and
+# gdb_index_test_2_zstd_ref from the same object uncompressed.  Check
+# the index as for the other gdb_index tests, then check that the
+# index and the debug info gold built from the compressed sections are
+# the same as from the uncompressed ones.
+
+check_same()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$2 differs from $1"
+	exit 1
+    fi
+}
+
+${srcdir}/gdb_index_test_comm.sh gdb_index_test_2_zstd.stdout || exit 1
+
+check_same gdb_index_test_2_zstd_ref.stdout gdb_index_test_2_zstd.stdout
+check_same gdb_index_test_2_zstd_ref.wi gdb_index_test_2_zstd.wi
+
+exit 0
@@ -0,0 +1,44 @@
+#!/bin/sh
+
+# gdb_index_threads_test.sh -- test --gdb-index with --threads.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# gdb_index_threads_test_1 is linked without threads, and
+# gdb_index_threads_test_2 with several.  With threads the debug info
+# of gdb_index_threads_test.o is scanned in a task, while that of
+# gdb_index_threads_test_nosym.o, which has no symbol table, is scanned
+# during layout and must wait for the task to be merged.  The
+# .gdb_index sections must be the same.
+
+if ! cmp -s gdb_index_threads_test_1.stdout gdb_index_threads_test_2.stdout
+then
+    echo ".gdb_index differs with --threads:"
+    diff gdb_index_threads_test_1.stdout gdb_index_threads_test_2.stdout
+    exit 1
+fi
+
+if ! grep -q "Hex dump of section '.gdb_index'" gdb_index_threads_test_1.stdout
+then
+    echo "Missing .gdb_index section"
+    exit 1
+fi
+
+exit 0
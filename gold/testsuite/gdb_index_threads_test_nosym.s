@@ -0,0 +1,56 @@
+# gdb_index_threads_test_nosym.s -- debug info with no symbol table.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# A DWARF 4 compilation unit that needs no relocations, so that the
+# assembler writes no symbol table.  With --threads, gold scans the
+# debug info of such an object during layout rather than in a task.
+
+	.section .debug_abbrev,"",%progbits
+	.uleb128 1	/* Abbrev 1.  */
+	.uleb128 0x11	/* DW_TAG_compile_unit.  */
+	.byte 1		/* DW_CHILDREN_yes.  */
+	.uleb128 0x3	/* DW_AT_name.  */
+	.uleb128 0x8	/* DW_FORM_string.  */
+	.byte 0
+	.byte 0
+	.uleb128 2	/* Abbrev 2.  */
+	.uleb128 0x2e	/* DW_TAG_subprogram.  */
+	.byte 0		/* DW_CHILDREN_no.  */
+	.uleb128 0x3f	/* DW_AT_external.  */
+	.uleb128 0x19	/* DW_FORM_flag_present.  */
+	.uleb128 0x3	/* DW_AT_name.  */
+	.uleb128 0x8	/* DW_FORM_string.  */
+	.byte 0
+	.byte 0
+	.byte 0
+
+	.section .debug_info,"",%progbits
+	.4byte 2f - 1f	/* Unit length.  */
+1:
+	.2byte 4	/* DWARF version.  */
+	.4byte 0	/* Abbrev offset.  */
+	.byte 8		/* Address size.  */
+	.uleb128 1	/* DW_TAG_compile_unit.  */
+	.asciz "gdb_index_threads_test_nosym.c"
+	.uleb128 2	/* DW_TAG_subprogram.  */
+	.asciz "nosym_function"
+	.byte 0
+2:
@@ -0,0 +1,168 @@
+// hash_benchmark.cc -- compare the speed of gold's string hash functions.
+
+// Copyright (C) 2017 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+// This is not run by "make check".  Build it with
+// "make hash_benchmark", and run it on files holding one symbol name
+// per line, such as the output of "nm ../ld-new | awk '{print $NF}'".
+// It hashes every name many times with the hash function gold used
+// to use, which handles one byte at a time, with the portable
+// hash_bytes, and with the hash_bytes chosen for this processor.
+
+#include "gold.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "libiberty.h"
+#include "sha1.h"
+
+using namespace gold;
+
+// The hash function gold used before hash_bytes, which is the hash
+// function used by the dynamic linker for DT_GNU_HASH.
+
+static size_t
+old_hash_bytes(const void* pv, size_t length)
+{
+  const unsigned char* p = static_cast<const unsigned char*>(pv);
+  size_t h = 5381;
+  for (size_t i = 0; i < length; ++i)
+    h = h * 33 + *p++;
+  return h;
+}
+
+// Hash every name ITERATIONS times with HASH, and report the time.
+
+static void
+run(const char* name, size_t (*hash)(const void*, size_t),
+    const std::vector<std::string>& names, size_t bytes, int iterations)
+{
+  size_t sum = 0;
+  long start = get_run_time();
+  for (int i = 0; i < iterations; ++i)
+    for (std::vector<std::string>::const_iterator p = names.begin();
+	 p != names.end();
+	 ++p)
+      sum += hash(p->data(), p->length());
+  long usecs = get_run_time() - start;
+  if (usecs == 0)
+    usecs = 1;
+
+  double total = static_cast<double>(names.size()) * iterations;
+  printf("%-10s %8.2f ns/name %10.1f MB/s  (checksum %zx)\n", name,
+	 usecs * 1000.0 / total,
+	 static_cast<double>(bytes) * iterations / usecs, sum);
+}
+
+// Compute a digest of DATA ITERATIONS times with DIGEST, and
+// report the time.
+
+static void
+run_digest(const char* name,
+	   void (*digest)(const void*, size_t, unsigned char*),
+	   const std::string& data, int iterations)
+{
+  unsigned char result[20];
+  long start = get_run_time();
+  for (int i = 0; i < iterations; ++i)
+    digest(data.data(), data.length(), result);
+  long usecs = get_run_time() - start;
+  if (usecs == 0)
+    usecs = 1;
+
+  printf("%-10s %10.1f MB/s  (digest %02x%02x%02x%02x...)\n", name,
+	 static_cast<double>(data.length()) * iterations / usecs,
+	 result[0], result[1], result[2], result[3]);
+}
+
+static void
+libiberty_sha1(const void* p, size_t length, unsigned char* result)
+{
+  sha1_buffer(static_cast<const char*>(p), length, result);
+}
+
+int
+main(int argc, char** argv)
+{
+  program_name = argv[0];
+
+  if (argc < 2)
+    {
+      fprintf(stderr, "usage: %s FILE...\n", argv[0]);
+      return 2;
+    }
+
+  std::vector<std::string> names;
+  size_t bytes = 0;
+  for (int i = 1; i < argc; ++i)
+    {
+      FILE* f = fopen(argv[i], "r");
+      if (f == NULL)
+	{
+	  perror(argv[i]);
+	  return 1;
+	}
+      char line[8192];
+      while (fgets(line, sizeof line, f) != NULL)
+	{
+	  size_t len = strlen(line);
+	  while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+	    --len;
+	  if (len == 0)
+	    continue;
+	  names.push_back(std::string(line, len));
+	  bytes += len;
+	}
+      fclose(f);
+    }
+
+  if (names.empty())
+    {
+      fprintf(stderr, "%s: no names\n", argv[0]);
+      return 1;
+    }
+
+  // Hash about 256 MB in each run.
+  int iterations = (256 << 20) / bytes + 1;
+
+  printf("%zu names, %.1f bytes/name, %d iterations, hash_bytes is %s\n",
+	 names.size(), static_cast<double>(bytes) / names.size(),
+	 iterations, hash_bytes_implementation());
+  run("old", old_hash_bytes, names, bytes, iterations);
+  run("portable", hash_bytes_portable, names, bytes, iterations);
+  run("hash_bytes", hash_bytes, names, bytes, iterations);
+
+  std::string all;
+  for (std::vector<std::string>::const_iterator p = names.begin();
+       p != names.end();
+       ++p)
+    all += *p;
+  iterations = (256 << 20) / all.length() + 1;
+  printf("sha1_digest is %s\n", sha1_digest_implementation());
+  run_digest("libiberty", libiberty_sha1, all, iterations);
+  run_digest("sha1", sha1_digest, all, iterations);
+  run_digest("xxhash128", xxhash128_digest, all, iterations);
+
+  return 0;
+}
@@ -0,0 +1,164 @@
+// hash_unittest.cc -- test hash_bytes and string_hash.
+
+// Copyright (C) 2017 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "sha1.h"
+
+#include "test.h"
+
+namespace gold_testsuite
+{
+
+using namespace gold;
+
+bool
+Hash_test(Test_report*)
+{
+  // The standard CRC-32C check values.
+  CHECK(hash_bytes_portable("", 0) == 0);
+  CHECK(hash_bytes_portable("123456789", 9) == 0xe3069283);
+  CHECK(hash_bytes("123456789", 9) == 0xe3069283);
+
+  // Whatever implementation is in use must agree with the portable
+  // one for every length and alignment.
+  unsigned char buf[256];
+  for (unsigned int i = 0; i < sizeof buf; ++i)
+    buf[i] = (i * 131 + 7) & 0xff;
+  for (size_t offset = 0; offset < 8; ++offset)
+    for (size_t len = 0; len + offset <= sizeof buf; ++len)
+      CHECK(hash_bytes(buf + offset, len)
+	    == hash_bytes_portable(buf + offset, len));
+
+  // The two forms of string_hash must agree.
+  const char* s = "_ZNSt6vectorIiSaIiEE9push_backERKi";
+  CHECK(string_hash(s) == string_hash(s, strlen(s)));
+  const uint16_t s16[] = { 'a', 'b', 0x1234, 0 };
+  CHECK(string_hash(s16) == string_hash(s16, 3));
+  CHECK(string_hash(s16, 3) == hash_bytes(s16, sizeof s16 - 2));
+  const uint32_t s32[] = { 'a', 0x12345678, 0 };
+  CHECK(string_hash(s32) == string_hash(s32, 2));
+
+  // Strings which differ in one byte must hash differently.
+  CHECK(string_hash("foo", 3) != string_hash("fop", 3));
+  CHECK(string_hash("foo", 3) != string_hash("foo", 2));
+
+  return true;
+}
+
+bool
+Sha1_test(Test_report*)
+{
+  // The FIPS 180 example.
+  static const unsigned char abc_digest[20] =
+  {
+    0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+    0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d
+  };
+  unsigned char digest[20];
+  sha1_digest("abc", 3, digest);
+  CHECK(memcmp(digest, abc_digest, 20) == 0);
+
+  // Whatever implementation is in use must agree with libiberty for
+  // every length, which covers each way the padding can fall.
+  unsigned char buf[300];
+  for (unsigned int i = 0; i < sizeof buf; ++i)
+    buf[i] = (i * 37 + 11) & 0xff;
+  for (size_t offset = 0; offset < 4; ++offset)
+    for (size_t len = 0; len + offset <= sizeof buf; ++len)
+      {
+	unsigned char expected[20];
+	sha1_buffer(reinterpret_cast<const char*>(buf + offset), len,
+		    expected);
+	sha1_digest(buf + offset, len, digest);
+	CHECK(memcmp(digest, expected, 20) == 0);
+      }
+
+  return true;
+}
+
+bool
+Xxhash128_test(Test_report*)
+{
+  // Values from the xxHash library's XXH3_128bits, for lengths which
+  // reach each of its code paths, including the long input loop with
+  // and without a partial last block.
+  static const struct
+  {
+    size_t len;
+    const char* hex;
+  } expected[] =
+  {
+    { 0, "99aa06d3014798d86001c324468d497f" },
+    { 1, "885f487031a569684a4139caf4136257" },
+    { 2, "6949c57b72d09b06571a2ebb238829bb" },
+    { 3, "d2f76a3b5388f28b505118c313121c0e" },
+    { 4, "b89f1314ee265fbdad17cf6483bb4f31" },
+    { 7, "1101dd2196779ec25d3f07a75d9ad05c" },
+    { 8, "acabfc73a36cbcfb2f685e863b34edb1" },
+    { 9, "428f8225bc32ed204d47bbb9821d4d08" },
+    { 16, "465d964535f22d7aaf8b52bc8abd84af" },
+    { 17, "e0b749d9e42a6e14261ec05370486e62" },
+    { 32, "9c925523a19f36393744a5456b09b5e9" },
+    { 33, "c2a0ecece9e843300b29275e96e57a7f" },
+    { 64, "ed537e7017e31effda39cd24c80e650a" },
+    { 65, "5c522e1ae7a1213a7104c285fbec785b" },
+    { 96, "5fd323872e47fae5f738dbf9d827a493" },
+    { 97, "fbae68f4804ae723c0f8bce904f170f8" },
+    { 128, "b0adb160b0d7e62efc7e5a4d38ed3773" },
+    { 129, "ca19d202aba3e00afd5fb995ce889f09" },
+    { 160, "54c031747340b13b4650f4e318f262bd" },
+    { 200, "2b6ef094620d5a883d4c3b7e86bc6958" },
+    { 240, "60776a21568c1469e3382cc948003965" },
+    { 241, "8fe4da37d29ec7b9859dc8ab6dd85c7c" },
+    { 255, "99ffa1a29c6bfdcba7654c5988d34927" },
+    { 1024, "02e7aa13471474567df7f049c0c1ad73" },
+    { 1025, "b845e98c00ea0dd129adcfcac5492652" },
+    { 1088, "027469bcf5c9bfcfb166cf327feec952" },
+    { 2048, "d92fc85281eb78e3f8c1eaac9b715dda" },
+    { 2999, "c166dc069f409ef15fc00f02b9984897" },
+    { 3000, "fac9183ed828ec491319ce9bcc3d4650" },
+  };
+
+  unsigned char buf[3000];
+  for (unsigned int i = 0; i < sizeof buf; ++i)
+    buf[i] = (i * 37 + 11) & 0xff;
+  for (size_t i = 0; i < sizeof expected / sizeof expected[0]; ++i)
+    {
+      unsigned char digest[16];
+      xxhash128_digest(buf, expected[i].len, digest);
+      char hex[33];
+      for (int j = 0; j < 16; ++j)
+	snprintf(hex + j * 2, 3, "%02x", digest[j]);
+      CHECK(strcmp(hex, expected[i].hex) == 0);
+    }
+
+  return true;
+}
+
+Register_test hash_register("Hash", Hash_test);
+Register_test sha1_register("Sha1", Sha1_test);
+Register_test xxhash128_register("Xxhash128", Xxhash128_test);
+
+} // End namespace gold_testsuite.
@@ -0,0 +1,51 @@
+#!/bin/sh
+
+# icf_threads_test.sh -- test --icf with --threads.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# With --threads the sections are compared by parallel tasks.  The
+# same sections must be folded as by icf_test, which is linked without
+# --threads, so the output must be identical.
+
+check()
+{
+    awk "
+BEGIN { discard = 0; }
+/^Discarded input/ { discard = 1; }
+/^Memory map/ { discard = 0; }
+/.*\\.text\\..*($2|$3).*/ { act[discard] = act[discard] \" \" \$0; }
+END {
+      if (length(act[0]) == 0 || length(act[1]) == 0)
+	{
+	  printf \"Identical Code Folding did not fold $2 and $3\\n\"
+	  exit 1;
+	}
+    }" $1
+}
+
+check icf_threads_test.map "folded_func" "kept_func"
+
+if ! cmp -s icf_test icf_threads_test; then
+  echo "Identical Code Folding with --threads changed the output"
+  exit 1
+fi
+
+exit 0
@@ -0,0 +1,46 @@
+#!/bin/sh
+
+# parallel_string_merge_test.sh -- test --parallel-string-merge.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The program linked serially by parallel_symbol_resolution_test is
+# linked twice more with its merged strings read in parallel, using
+# different numbers of threads.  Both links must define the same
+# symbols at the same addresses as the serial link, which means the
+# merged string sections have the same size, and must produce
+# identical output regardless of the number of threads.
+
+if ! cmp -s parallel_symbol_resolution_test_1.syms \
+	    parallel_string_merge_test_1.syms; then
+  echo "Parallel string merging changed the symbols:"
+  diff parallel_symbol_resolution_test_1.syms \
+       parallel_string_merge_test_1.syms
+  exit 1
+fi
+
+if ! cmp -s parallel_string_merge_test_1 parallel_string_merge_test_2; then
+  echo "Parallel string merging output depends on the thread count"
+  exit 1
+fi
+
+./parallel_string_merge_test_1 || exit 1
+
+exit 0
@@ -0,0 +1,46 @@
+#!/bin/sh
+
+# parallel_symbol_resolution_test.sh -- test --parallel-symbol-resolution.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The same program is linked serially, and twice with the symbol
+# table sharded, using different numbers of threads.  The sharded
+# links must define the same symbols at the same addresses as the
+# serial link, and must produce identical output regardless of the
+# number of threads.
+
+if ! cmp -s parallel_symbol_resolution_test_1.syms \
+	    parallel_symbol_resolution_test_2.syms; then
+  echo "Parallel symbol resolution changed the symbols:"
+  diff parallel_symbol_resolution_test_1.syms \
+       parallel_symbol_resolution_test_2.syms
+  exit 1
+fi
+
+if ! cmp -s parallel_symbol_resolution_test_2 \
+	    parallel_symbol_resolution_test_3; then
+  echo "Parallel symbol resolution output depends on the thread count"
+  exit 1
+fi
+
+./parallel_symbol_resolution_test_2 || exit 1
+
+exit 0
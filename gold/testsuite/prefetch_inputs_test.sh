@@ -0,0 +1,79 @@
+#!/bin/sh
+
+# prefetch_inputs_test.sh -- test --prefetch-inputs.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# prefetch_inputs_test_2 is linked with --prefetch-inputs and
+# --debug=files, which reports each region of a file which gold asks
+# the system to prefetch.  The output must be the same as without
+# --prefetch-inputs.  The start of each file named on the command line
+# is prefetched before any file is opened.  When the large object is
+# opened, its end, which holds its symbols, is prefetched too.  The
+# end of the large archive is not, since the archive members are only
+# read when they are needed.
+
+check_same()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$2 differs from $1"
+	exit 1
+    fi
+}
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected prefetch in $1:"
+	echo "   $2"
+	exit 1
+    fi
+}
+
+check_missing()
+{
+    if grep -q "$2" "$1"
+    then
+	echo "Found unexpected prefetch in $1:"
+	echo "   $2"
+	exit 1
+    fi
+}
+
+check_same prefetch_inputs_test_1 prefetch_inputs_test_2
+
+# Nothing is prefetched if the system does not support it.
+if grep -q "Prefetch" prefetch_inputs_test.err
+then
+    check prefetch_inputs_test.err \
+	'Prefetch 1048576 bytes at 0 of "prefetch_inputs_test.o"'
+    check prefetch_inputs_test.err \
+	'Prefetch 1048576 bytes at 0 of "libprefetch_inputs_test.a"'
+    check prefetch_inputs_test.err \
+	'Prefetch 1048576 bytes at [1-9][0-9]* of "prefetch_inputs_test.o"'
+    check_missing prefetch_inputs_test.err \
+	'Prefetch [0-9]* bytes at [1-9][0-9]* of "libprefetch_inputs_test.a"'
+fi
+
+./prefetch_inputs_test_2 || exit 1
+
+exit 0
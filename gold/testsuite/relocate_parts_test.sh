@@ -0,0 +1,75 @@
+#!/bin/sh
+
+# relocate_parts_test.sh -- test relocating objects in parts.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The even numbered tests are linked with --threads and a small
+# --relocate-part-size, so that the objects are relocated in parts by
+# parallel tasks; the odd numbered tests are the same links without
+# threads.  The output must be the same.  An archive member is always
+# relocated in one task, as is every object with --emit-relocs.
+
+check_same()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$2 differs from $1"
+	exit 1
+    fi
+}
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected task in $1:"
+	echo "   $2"
+	exit 1
+    fi
+}
+
+check_missing()
+{
+    if grep -q "$2" "$1"
+    then
+	echo "Found unexpected task in $1:"
+	echo "   $2"
+	exit 1
+    fi
+}
+
+check_same relocate_parts_test_1 relocate_parts_test_2
+check_same relocate_parts_test_3 relocate_parts_test_4
+check_same relocate_parts_test_5 relocate_parts_test_6
+
+check relocate_parts_test_2.json '"name":"Relocate_part_task two_file_test_1.o part 1"'
+check relocate_parts_test_2.json '"name":"Relocate_part_task two_file_test_2.o part 1"'
+
+check relocate_parts_test_4.json '"name":"Relocate_part_task two_file_test_1.o part 1"'
+check relocate_parts_test_4.json '"name":"Relocate_task librelocate_parts_test.a(two_file_test_2.o)"'
+check_missing relocate_parts_test_4.json '"name":"Relocate_part_task librelocate_parts_test.a'
+
+check relocate_parts_test_6.json '"name":"Relocate_task two_file_test_1.o"'
+check_missing relocate_parts_test_6.json '"name":"Relocate_part_task'
+
+./relocate_parts_test_2 || exit 1
+
+exit 0
@@ -0,0 +1,47 @@
+#!/bin/sh
+
+# trace_tasks_test.sh -- test --trace-tasks.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The trace must be in the Chrome trace event format, with a complete
+# event for each task run.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check trace_tasks_test.json '^{"traceEvents":\['
+check trace_tasks_test.json '"name":"Read_symbols [^"]*gc_comdat_test_1.o","cat":"task","ph":"X","ts":[0-9]*,"dur":[0-9]*'
+check trace_tasks_test.json '"name":"Relocate_task [^"]*gc_comdat_test_2.o","cat":"task","ph":"X"'
+check trace_tasks_test.json '"name":"Write_sections_task"'
+check trace_tasks_test.json '"name":"thread_name","ph":"M"'
+check trace_tasks_test.json '"displayTimeUnit":"ms"}$'
+
+exit 0
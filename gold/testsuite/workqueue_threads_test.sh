@@ -0,0 +1,43 @@
+#!/bin/sh
+
+# workqueue_threads_test.sh -- test running many workqueue threads.
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# These tests are linked with many more threads than tasks, so that
+# threads take tasks from the queues of other threads.  The second
+# one also relocates objects in many small parts.  The output must be
+# the same as relocate_parts_test_1, the same link without threads.
+
+check_same()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$2 differs from $1"
+	exit 1
+    fi
+}
+
+check_same relocate_parts_test_1 workqueue_threads_test_1
+check_same relocate_parts_test_1 workqueue_threads_test_2
+
+./workqueue_threads_test_1 || exit 1
+
+exit 0
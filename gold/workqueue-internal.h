@@ -37,6 +37,77 @@ namespace gold
 
 class Workqueue_thread;
 
+// The tasks queued by one thread while it runs tasks.  Queuing a task
+// here, or taking one, only takes the lock of this queue, not the
+// Workqueue lock, so threads do not contend when they queue tasks or
+// look for them.  A thread takes tasks from its own queue first, and
+// steals them from the queues of other threads when it has nothing
+// else to do.  Whether a task is runnable is only checked after it
+// is taken, with the Workqueue lock held, so Task::is_runnable is
+// still only called with that lock held.
+
+class Workqueue_thread_queue
+{
+ public:
+  Workqueue_thread_queue(int thread_number, Workqueue_thread_queue* next)
+    : thread_number_(thread_number), next_(next), lock_(), tasks_()
+  { }
+
+  // The number of the thread which queues tasks here.
+  int
+  thread_number() const
+  { return this->thread_number_; }
+
+  // The next queue in the list of all queues.
+  Workqueue_thread_queue*
+  next() const
+  { return this->next_; }
+
+  // Add a task to the end of the queue.  Return whether some thread
+  // may be waiting for a task, in which case the caller must wake it
+  // up.  SLEEPING is the Workqueue count of waiting threads; reading
+  // it with our lock held is enough, because a thread increments it
+  // before it checks this queue for the last time before it waits.
+  bool
+  push_back(Task* t, const volatile int& sleeping)
+  {
+    Hold_lock hl(this->lock_);
+    this->tasks_.push_back(t);
+    return sleeping > 0;
+  }
+
+  // Add a task to the front of the queue.  This is used to put back
+  // a task which was taken but not run; the caller holds the
+  // Workqueue lock, and wakes up a waiting thread itself.
+  void
+  push_front(Task* t)
+  {
+    Hold_lock hl(this->lock_);
+    this->tasks_.push_front(t);
+  }
+
+  // Remove and return the first task, or NULL.
+  Task*
+  pop_front()
+  {
+    Hold_lock hl(this->lock_);
+    return this->tasks_.pop_front();
+  }
+
+ private:
+  Workqueue_thread_queue(const Workqueue_thread_queue&);
+  Workqueue_thread_queue& operator=(const Workqueue_thread_queue&);
+
+  // The thread number.
+  int thread_number_;
+  // The next queue.
+  Workqueue_thread_queue* next_;
+  // Lock for tasks_.
+  Lock lock_;
+  // The tasks.
+  Task_list tasks_;
+};
+
 // The Workqueue_threader abstract class.  This is the interface used
 // by the general workqueue code to manage threads.
 
@@ -58,6 +129,15 @@ class Workqueue_threader
   virtual bool
   should_cancel_thread(int thread_number) = 0;
 
+  // Return the task queue of the current thread, or NULL if it does
+  // not have one.
+  virtual Workqueue_thread_queue*
+  current_queue() = 0;
+
+  // Set the task queue of the current thread.
+  virtual void
+  set_current_queue(Workqueue_thread_queue*) = 0;
+
  protected:
   // Get the Workqueue.
   Workqueue*
@@ -86,6 +166,14 @@ class Workqueue_threader_threadpool : public Workqueue_threader
   bool
   should_cancel_thread(int thread_number);
 
+  // Return the task queue of the current thread.
+  Workqueue_thread_queue*
+  current_queue();
+
+  // Set the task queue of the current thread.
+  void
+  set_current_queue(Workqueue_thread_queue*);
+
   // Process all tasks.  This keeps running until told to cancel.
   void
   process(int thread_number)
@@ -124,6 +124,25 @@ Workqueue_thread::thread_body(void* arg)
 
 // Class Workqueue_threader_threadpool.
 
+// The key for the task queue of each thread.  This is shared by all
+// Workqueues, but there is only ever one.
+
+static pthread_key_t current_queue_key;
+static pthread_once_t current_queue_key_once = PTHREAD_ONCE_INIT;
+
+extern "C"
+{
+
+static void
+create_current_queue_key()
+{
+  int err = pthread_key_create(&current_queue_key, NULL);
+  if (err != 0)
+    gold_fatal(_("pthread_key_create failed: %s"), strerror(err));
+}
+
+}
+
 // Constructor.
 
 Workqueue_threader_threadpool::Workqueue_threader_threadpool(
@@ -134,6 +153,9 @@ Workqueue_threader_threadpool::Workqueue_threader_threadpool(
     desired_thread_count_(1),
     threads_(1)
 {
+  int err = pthread_once(&current_queue_key_once, create_current_queue_key);
+  if (err != 0)
+    gold_fatal(_("pthread_once failed: %s"), strerror(err));
 }
 
 // Destructor.
@@ -194,6 +216,25 @@ Workqueue_threader_threadpool::should_cancel_thread(int thread_number)
   return false;
 }
 
+// Return the task queue of the current thread.
+
+Workqueue_thread_queue*
+Workqueue_threader_threadpool::current_queue()
+{
+  return static_cast<Workqueue_thread_queue*>(
+      pthread_getspecific(current_queue_key));
+}
+
+// Set the task queue of the current thread.
+
+void
+Workqueue_threader_threadpool::set_current_queue(Workqueue_thread_queue* q)
+{
+  int err = pthread_setspecific(current_queue_key, q);
+  if (err != 0)
+    gold_fatal(_("pthread_setspecific failed: %s"), strerror(err));
+}
+
 } // End namespace gold.
 
 #endif // defined(ENABLE_THREADS)
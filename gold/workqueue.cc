@@ -22,6 +22,15 @@
 
 #include "gold.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/time.h>
+
 #include "debug.h"
 #include "options.h"
 #include "timer.h"
@@ -112,8 +121,108 @@ class Workqueue_threader_single : public Workqueue_threader
   bool
   should_cancel_thread(int)
   { return false; }
+
+  Workqueue_thread_queue*
+  current_queue()
+  { return NULL; }
+
+  void
+  set_current_queue(Workqueue_thread_queue*)
+  { gold_unreachable(); }
 };
 
+// Read the CPU quota of the cgroup we are in, as *QUOTA microseconds
+// of CPU time in each *PERIOD microseconds.  Return false if there
+// is no quota.  This only looks at the root of the cgroup file
+// system, which in a container is the container's own cgroup.
+
+static bool
+read_cgroup_cpu_quota(long long* quota, long long* period)
+{
+  // cgroup v2.
+  FILE* f = fopen("/sys/fs/cgroup/cpu.max", "r");
+  if (f != NULL)
+    {
+      char buf[32];
+      bool ok = (fscanf(f, "%31s %lld", buf, period) == 2
+		 && strcmp(buf, "max") != 0);
+      fclose(f);
+      if (!ok)
+	return false;
+      *quota = strtoll(buf, NULL, 10);
+      return *quota > 0 && *period > 0;
+    }
+
+  // cgroup v1.
+  f = fopen("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "r");
+  if (f == NULL)
+    return false;
+  bool ok = fscanf(f, "%lld", quota) == 1 && *quota > 0;
+  fclose(f);
+  if (!ok)
+    return false;
+  f = fopen("/sys/fs/cgroup/cpu/cpu.cfs_period_us", "r");
+  if (f == NULL)
+    return false;
+  ok = fscanf(f, "%lld", period) == 1 && *period > 0;
+  fclose(f);
+  return ok;
+}
+
+// Return the number of CPUs we may use: the CPUs we may run on,
+// limited by the CPU quota of our cgroup, rounded up.
+
+static int
+available_cpus()
+{
+  int cpus = 1;
+#if defined(HAVE_SYSCONF) && defined(_SC_NPROCESSORS_ONLN)
+  long online = sysconf(_SC_NPROCESSORS_ONLN);
+  if (online > 0)
+    cpus = online;
+#endif
+#if defined(HAVE_SCHED_GETAFFINITY) && defined(CPU_COUNT)
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof set, &set) == 0 && CPU_COUNT(&set) > 0)
+    cpus = CPU_COUNT(&set);
+#endif
+
+  long long quota;
+  long long period;
+  if (read_cgroup_cpu_quota(&quota, &period))
+    {
+      long long quota_cpus = (quota + period - 1) / period;
+      if (quota_cpus < cpus)
+	cpus = quota_cpus;
+    }
+
+  return cpus;
+}
+
+// Return the wall clock time in microseconds.
+
+static long long
+wall_time()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return static_cast<long long>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+// Return the CPU time used by the current thread in microseconds, or
+// -1 if we can't tell.
+
+static long long
+thread_cpu_time()
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_THREAD_CPUTIME_ID)
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return static_cast<long long>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#endif
+  return -1;
+}
+
 // Workqueue methods.
 
 Workqueue::Workqueue(const General_options& options)
@@ -122,9 +231,26 @@ Workqueue::Workqueue(const General_options& options)
     tasks_(),
     running_(0),
     waiting_(0),
+    sleeping_(0),
+    queued_(0),
+    taken_(0),
     condvar_(this->lock_),
-    threader_(NULL)
+    use_thread_queues_(false),
+    thread_queues_(NULL),
+    threader_(NULL),
+    adaptive_(false),
+    cpus_(1),
+    requested_threads_(1),
+    adaptive_threads_(1),
+    task_wall_time_(0),
+    task_cpu_time_(0),
+    trace_(options.trace_tasks() != NULL),
+    trace_start_(0),
+    trace_entries_()
 {
+  if (this->trace_)
+    this->trace_start_ = this->trace_time();
+
   bool threads = options.threads();
 #ifndef ENABLE_THREADS
   threads = false;
@@ -135,6 +261,12 @@ Workqueue::Workqueue(const General_options& options)
     {
 #ifdef ENABLE_THREADS
       this->threader_ = new Workqueue_threader_threadpool(this);
+      this->use_thread_queues_ = true;
+      if (options.adaptive_threads())
+	{
+	  this->adaptive_ = true;
+	  this->cpus_ = available_cpus();
+	}
 #else
       gold_unreachable();
 #endif
@@ -143,6 +275,12 @@ Workqueue::Workqueue(const General_options& options)
 
 Workqueue::~Workqueue()
 {
+  while (this->thread_queues_ != NULL)
+    {
+      Workqueue_thread_queue* q = this->thread_queues_;
+      this->thread_queues_ = q->next();
+      delete q;
+    }
 }
 
 // Add a task to the end of a specific queue, or put it on the list
@@ -178,7 +316,21 @@ Workqueue::add_to_queue(Task_list* queue, Task* t, bool front)
 void
 Workqueue::queue(Task* t)
 {
-  this->add_to_queue(&this->tasks_, t, false);
+  Workqueue_thread_queue* q = this->threader_->current_queue();
+  if (q == NULL)
+    this->add_to_queue(&this->tasks_, t, false);
+  else
+    {
+      // Count the task before a thread can see it.  This is also a
+      // full barrier, which find_runnable_or_wait relies on.
+      __sync_fetch_and_add(&this->queued_, 1);
+      if (q->push_back(t, this->sleeping_))
+	{
+	  // Tell any waiting thread that there is work to do.
+	  Hold_lock hl(this->lock_);
+	  this->condvar_.signal();
+	}
+    }
 }
 
 // Queue a task which should run soon.
@@ -199,6 +351,14 @@ Workqueue::queue_next(Task* t)
   this->add_to_queue(&this->first_tasks_, t, true);
 }
 
+// Return the current time in microseconds.
+
+long long
+Workqueue::trace_time() const
+{
+  return wall_time() - this->trace_start_;
+}
+
 // Return whether to cancel the current thread.
 
 inline bool
@@ -230,32 +390,126 @@ Workqueue::find_runnable_in_list(Task_list* tasks)
   return NULL;
 }
 
-// Find a runnable task.  Return NULL if none could be found.  The
+// Take a task from the thread queues, first from the queue of the
+// current thread, then from the others.  Return NULL if we could not
+// find one.  This is called without the workqueue lock, so that
+// threads do not contend for it while they look for tasks.  The
+// caller must pass the task to find_runnable.
+
+Task*
+Workqueue::take_from_thread_queues()
+{
+  if (this->queued_ == 0)
+    return NULL;
+
+  // Count the task as taken before it leaves its queue, so that
+  // find_runnable_or_wait never sees it in neither count.
+  __sync_fetch_and_add(&this->taken_, 1);
+
+  Workqueue_thread_queue* current = this->threader_->current_queue();
+  Task* t = NULL;
+  if (current != NULL)
+    t = current->pop_front();
+
+  for (Workqueue_thread_queue* q = this->thread_queues_;
+       t == NULL && q != NULL;
+       q = q->next())
+    if (q != current)
+      t = q->pop_front();
+
+  if (t != NULL)
+    __sync_fetch_and_sub(&this->queued_, 1);
+  else
+    __sync_fetch_and_sub(&this->taken_, 1);
+  return t;
+}
+
+// Put back T, which was taken from the thread queues but which we are
+// not going to run now, at the front of the queue of the current
+// thread.  The workqueue lock must be held when this is called.
+
+void
+Workqueue::put_back_taken_task(Task* t)
+{
+  __sync_fetch_and_add(&this->queued_, 1);
+  this->threader_->current_queue()->push_front(t);
+  __sync_fetch_and_sub(&this->taken_, 1);
+  this->condvar_.signal();
+}
+
+// Return the thread queue for THREAD_NUMBER.  A thread which is
+// cancelled and later recreated gets the same queue back.  The
 // workqueue lock must be held when this is called.
 
+Workqueue_thread_queue*
+Workqueue::get_thread_queue(int thread_number)
+{
+  for (Workqueue_thread_queue* q = this->thread_queues_;
+       q != NULL;
+       q = q->next())
+    if (q->thread_number() == thread_number)
+      return q;
+
+  Workqueue_thread_queue* q = new Workqueue_thread_queue(thread_number,
+							 this->thread_queues_);
+  // Make sure the queue is complete before other threads, which walk
+  // the list without the workqueue lock, can see it.
+  __sync_synchronize();
+  this->thread_queues_ = q;
+  return q;
+}
+
+// Find a runnable task.  TAKEN is a task which we took from the
+// thread queues, or NULL.  Tasks queued to run soon come first, then
+// TAKEN, then the tasks on the shared list.  Return NULL if none
+// could be found.  The workqueue lock must be held when this is
+// called.
+
 Task*
-Workqueue::find_runnable()
+Workqueue::find_runnable(Task* taken)
 {
   Task* t = this->find_runnable_in_list(&this->first_tasks_);
+  if (taken != NULL)
+    {
+      if (t != NULL)
+	this->put_back_taken_task(taken);
+      else
+	{
+	  Task_token* token = taken->is_runnable();
+	  if (token == NULL)
+	    t = taken;
+	  else
+	    {
+	      token->add_waiting(taken);
+	      ++this->waiting_;
+	    }
+	  __sync_fetch_and_sub(&this->taken_, 1);
+	}
+    }
   if (t == NULL)
     t = this->find_runnable_in_list(&this->tasks_);
   return t;
 }
 
-// Find a runnable a task, and wait until we find one.  Return NULL if
+// Find a runnable a task, and wait until we find one.  TAKEN is a
+// task which we took from the thread queues, or NULL.  Return NULL if
 // we should exit.  The workqueue lock must be held when this is
-// called.
+// called.  It is released while we look at the thread queues.
 
 Task*
-Workqueue::find_runnable_or_wait(int thread_number)
+Workqueue::find_runnable_or_wait(int thread_number, Task* taken)
 {
-  Task* t = this->find_runnable();
+  Task* t = this->find_runnable(taken);
 
   while (t == NULL)
     {
+      // A task is counted in taken_ before it leaves queued_, so
+      // read queued_ first.
       if (this->running_ == 0
 	  && this->first_tasks_.empty()
-	  && this->tasks_.empty())
+	  && this->tasks_.empty()
+	  && this->queued_ == 0
+	  && this->taken_ == 0)
 	{
 	  // Kick all the threads to make them exit.
 	  this->condvar_.broadcast();
@@ -267,13 +521,35 @@ Workqueue::find_runnable_or_wait(int thread_number)
       if (this->should_cancel_thread(thread_number))
 	return NULL;
 
-      gold_debug(DEBUG_TASK, "%3d sleeping", thread_number);
+      if (this->queued_ > 0)
+	{
+	  // Another thread queued a task.  Steal it without holding
+	  // the workqueue lock.
+	  this->lock_.release();
+	  taken = this->take_from_thread_queues();
+	  this->lock_.acquire();
+	  t = this->find_runnable(taken);
+	  continue;
+	}
+
+      // Tasks are added to the thread queues without the workqueue
+      // lock, so say that we are going to wait before we look at
+      // queued_ for the last time.  A thread which queues a task
+      // counts it in queued_ before it looks at sleeping_, so either
+      // we see the task here or that thread will signal us.
+      ++this->sleeping_;
+      __sync_synchronize();
+      if (this->queued_ == 0)
+	{
+	  gold_debug(DEBUG_TASK, "%3d sleeping", thread_number);
 
-      this->condvar_.wait();
+	  this->condvar_.wait();
 
-      gold_debug(DEBUG_TASK, "%3d awake", thread_number);
+	  gold_debug(DEBUG_TASK, "%3d awake", thread_number);
+	}
+      --this->sleeping_;
 
-      t = this->find_runnable();
+      t = this->find_runnable(NULL);
     }
 
   return t;
@@ -290,12 +566,22 @@ Workqueue::find_and_run_task(int thread_number)
 {
   Task* t;
   Task_locker tl;
+  // Whether to measure the time the task waits for I/O, for
+  // --adaptive-threads.
+  bool sample = false;
 
   {
+    // Take a task from the thread queues before we get the workqueue
+    // lock, so that we only hold that lock to check whether the task
+    // is runnable.
+    Task* taken = NULL;
+    if (this->use_thread_queues_)
+      taken = this->take_from_thread_queues();
+
     Hold_lock hl(this->lock_);
 
     // Find a runnable task.
-    t = this->find_runnable_or_wait(thread_number);
+    t = this->find_runnable_or_wait(thread_number, taken);
 
     if (t == NULL)
       return false;
@@ -305,6 +591,7 @@ Workqueue::find_and_run_task(int thread_number)
     t->locks(&tl);
 
     ++this->running_;
+    sample = this->adaptive_ && this->running_ <= this->cpus_;
   }
 
   while (t != NULL)
@@ -316,8 +603,36 @@ Workqueue::find_and_run_task(int thread_number)
       if (is_debugging_enabled(DEBUG_TASK))
         timer.start();
 
+      long long trace_start = 0;
+      if (this->trace_)
+	{
+	  // Compute the name now, rather than with the lock held.
+	  t->name();
+	  trace_start = this->trace_time();
+	}
+
+      long long sample_wall = 0;
+      long long sample_cpu = 0;
+      if (sample)
+	{
+	  sample_wall = wall_time();
+	  sample_cpu = thread_cpu_time();
+	}
+
       t->run(this);
 
+      long long trace_end = 0;
+      if (this->trace_)
+	trace_end = this->trace_time();
+
+      if (sample && sample_cpu >= 0)
+	{
+	  sample_wall = wall_time() - sample_wall;
+	  sample_cpu = thread_cpu_time() - sample_cpu;
+	}
+      else
+	sample = false;
+
       if (is_debugging_enabled(DEBUG_TASK))
         {
           Timer::TimeStats elapsed = timer.get_elapsed_time();
@@ -337,12 +652,27 @@ Workqueue::find_and_run_task(int thread_number)
 
 	--this->running_;
 
+	if (sample)
+	  {
+	    this->task_wall_time_ += sample_wall;
+	    this->task_cpu_time_ += sample_cpu;
+	  }
+	if (this->adaptive_)
+	  this->adapt_thread_count();
+
+	if (this->trace_)
+	  this->trace_entries_.push_back(Trace_entry(t->name(), thread_number,
+						     trace_start, trace_end));
+
 	// Release the locks for the task.  This must be done with the
 	// workqueue lock held.  Get the next Task to run if any.
 	next = this->release_locks(t, &tl);
 
-	if (next == NULL)
-	  next = this->find_runnable();
+	// With thread queues, we look for the next task in
+	// find_and_run_task, where we can take one from the thread
+	// queues without the workqueue lock.
+	if (next == NULL && !this->use_thread_queues_)
+	  next = this->find_runnable(NULL);
 
 	// If we have another Task to run, get the Locks.  This must
 	// be called while we are still holding the Workqueue lock.
@@ -352,6 +682,7 @@ Workqueue::find_and_run_task(int thread_number)
 	    next->locks(&tl);
 
 	    ++this->running_;
+	    sample = this->adaptive_ && this->running_ <= this->cpus_;
 	  }
       }
 
@@ -492,8 +823,18 @@ Workqueue::release_locks(Task* t, Task_locker* tl)
 void
 Workqueue::process(int thread_number)
 {
+  if (this->use_thread_queues_)
+    {
+      Hold_lock hl(this->lock_);
+      Workqueue_thread_queue* q = this->get_thread_queue(thread_number);
+      this->threader_->set_current_queue(q);
+    }
+
   while (this->find_and_run_task(thread_number))
     ;
+
+  if (this->use_thread_queues_)
+    this->threader_->set_current_queue(NULL);
 }
 
 // Set the number of threads to use for the workqueue, if we are using
@@ -504,11 +845,72 @@ Workqueue::set_thread_count(int threads)
 {
   Hold_lock hl(this->lock_);
 
+  if (this->adaptive_ && threads > 0)
+    {
+      this->requested_threads_ = threads;
+      threads = this->adaptive_thread_limit();
+      this->adaptive_threads_ = threads;
+      gold_debug(DEBUG_TASK, "using %d of %d threads on %d CPUs",
+		 threads, this->requested_threads_, this->cpus_);
+    }
+
   this->threader_->set_thread_count(threads);
   // Wake up all the threads, since something has changed.
   this->condvar_.broadcast();
 }
 
+// Return the number of threads to use with --adaptive-threads.  We
+// want one thread running on each CPU we may use.  While tasks wait
+// for I/O they don't use their CPU, so when tasks spend much of their
+// time waiting we use more threads to keep the CPUs busy.  We never
+// use more threads than set_thread_count asked for.  This must be
+// called with the Workqueue lock held.
+
+int
+Workqueue::adaptive_thread_limit() const
+{
+  long long limit = this->cpus_;
+
+  // Don't trust the ratio until we have seen a useful amount of work.
+  if (this->task_wall_time_ >= 100000 && this->task_cpu_time_ > 0)
+    {
+      limit = ((limit * this->task_wall_time_ + this->task_cpu_time_ - 1)
+	       / this->task_cpu_time_);
+      limit = std::min(limit, 4LL * this->cpus_);
+    }
+
+  limit = std::min(limit, static_cast<long long>(this->requested_threads_));
+  return std::max(limit, 1LL);
+}
+
+// Adjust the number of threads with --adaptive-threads after a task
+// completes.  Drop threads we no longer want, and add a thread if
+// there are tasks waiting to run and no thread is free to run them.
+// This must be called with the Workqueue lock held.
+
+void
+Workqueue::adapt_thread_count()
+{
+  int limit = this->adaptive_thread_limit();
+  int threads = this->adaptive_threads_;
+  if (threads > limit)
+    threads = limit;
+  else if (threads < limit
+	   && this->sleeping_ == 0
+	   && (!this->first_tasks_.empty()
+	       || !this->tasks_.empty()
+	       || this->queued_ > 0))
+    ++threads;
+
+  if (threads != this->adaptive_threads_)
+    {
+      gold_debug(DEBUG_TASK, "using %d of %d threads on %d CPUs",
+		 threads, this->requested_threads_, this->cpus_);
+      this->adaptive_threads_ = threads;
+      this->threader_->set_thread_count(threads);
+    }
+}
+
 // Add a new blocker to an existing Task_token.
 
 void
@@ -518,4 +920,68 @@ Workqueue::add_blocker(Task_token* token)
   token->add_blocker();
 }
 
+// Write S to F as a JSON string.
+
+static void
+write_json_string(FILE* f, const std::string& s)
+{
+  putc('"', f);
+  for (std::string::const_iterator p = s.begin(); p != s.end(); ++p)
+    {
+      unsigned char c = *p;
+      if (c == '"' || c == '\\')
+	fprintf(f, "\\%c", c);
+      else if (c < 0x20)
+	fprintf(f, "\\u%04x", c);
+      else
+	putc(c, f);
+    }
+  putc('"', f);
+}
+
+// Write the tasks which were run to FILENAME in the Chrome trace
+// event format, which may be viewed with chrome://tracing or
+// Perfetto.  Each task is a complete event on the track of the
+// thread which ran it.
+
+void
+Workqueue::write_trace(const char* filename)
+{
+  FILE* f = fopen(filename, "w");
+  if (f == NULL)
+    {
+      gold_error(_("cannot open task trace file %s: %s"), filename,
+		 strerror(errno));
+      return;
+    }
+
+  int pid = getpid();
+  int max_thread = -1;
+  fprintf(f, "{\"traceEvents\":[\n");
+  for (std::vector<Trace_entry>::const_iterator p =
+	 this->trace_entries_.begin();
+       p != this->trace_entries_.end();
+       ++p)
+    {
+      fprintf(f, "{\"name\":");
+      write_json_string(f, p->name);
+      fprintf(f, ",\"cat\":\"task\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,"
+	      "\"pid\":%d,\"tid\":%d},\n",
+	      p->start, p->end - p->start, pid, p->thread_number);
+      if (p->thread_number > max_thread)
+	max_thread = p->thread_number;
+    }
+  for (int i = 0; i <= max_thread; ++i)
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+	    "\"tid\":%d,\"args\":{\"name\":\"thread %d\"}},\n",
+	    pid, i, i);
+  fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+	  "\"args\":{\"name\":", pid);
+  write_json_string(f, program_name);
+  fprintf(f, "}}\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  if (fclose(f) != 0)
+    gold_error(_("%s: close: %s"), filename, strerror(errno));
+}
+
 } // End namespace gold.
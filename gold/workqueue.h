@@ -28,6 +28,7 @@
 #define GOLD_WORKQUEUE_H
 
 #include <string>
+#include <vector>
 
 #include "gold-threads.h"
 #include "token.h"
@@ -194,6 +195,7 @@ class Task_function : public Task
 // The workqueue itself.
 
 class Workqueue_threader;
+class Workqueue_thread_queue;
 
 class Workqueue
 {
@@ -201,7 +203,8 @@ class Workqueue
   Workqueue(const General_options&);
   ~Workqueue();
 
-  // Add a new task to the work queue.
+  // Add a new task to the work queue.  When using threads, a task
+  // queued by a running task goes on a queue for the current thread.
   void
   queue(Task*);
 
@@ -223,7 +226,8 @@ class Workqueue
   process(int);
 
   // Set the desired thread count--the number of threads we want to
-  // have running.
+  // have running.  With --adaptive-threads this is the most threads
+  // we will use.
   void
   set_thread_count(int);
 
@@ -233,7 +237,31 @@ class Workqueue
   void
   add_blocker(Task_token*);
 
+  // Write the tasks which were run to FILENAME, for --trace-tasks.
+  // This must be called after process.
+  void
+  write_trace(const char* filename);
+
  private:
+  // A task which was run, for --trace-tasks.
+  struct Trace_entry
+  {
+    Trace_entry(const std::string& a_name, int a_thread_number,
+		long long a_start, long long a_end)
+      : name(a_name), thread_number(a_thread_number), start(a_start),
+	end(a_end)
+    { }
+
+    // The name of the task.
+    std::string name;
+    // The thread which ran it.
+    int thread_number;
+    // The times it started and finished, in microseconds since the
+    // Workqueue was created.
+    long long start;
+    long long end;
+  };
+
   // This class can not be copied.
   Workqueue(const Workqueue&);
   Workqueue& operator=(const Workqueue&);
@@ -242,18 +270,33 @@ class Workqueue
   void
   add_to_queue(Task_list* queue, Task* t, bool front);
 
-  // Find a runnable task, or wait for one.
+  // Find a runnable task, or wait for one.  The argument is a task
+  // taken from the thread queues, or NULL.
   Task*
-  find_runnable_or_wait(int thread_number);
+  find_runnable_or_wait(int thread_number, Task*);
 
-  // Find a runnable task.
+  // Find a runnable task.  The argument is a task taken from the
+  // thread queues, or NULL.
   Task*
-  find_runnable();
+  find_runnable(Task*);
 
   // Find a runnable task in a list.
   Task*
   find_runnable_in_list(Task_list*);
 
+  // Take a task from the thread queues, starting with the queue of
+  // the current thread.  This does not need the Workqueue lock.
+  Task*
+  take_from_thread_queues();
+
+  // Put back a task taken from the thread queues.
+  void
+  put_back_taken_task(Task*);
+
+  // Return the queue for THREAD_NUMBER, creating it if necessary.
+  Workqueue_thread_queue*
+  get_thread_queue(int thread_number);
+
   // Find an run a task.
   bool
   find_and_run_task(int);
@@ -270,6 +313,18 @@ class Workqueue
   bool
   should_cancel_thread(int thread_number);
 
+  // Return the time for --trace-tasks.
+  long long
+  trace_time() const;
+
+  // Return the number of threads to use with --adaptive-threads.
+  int
+  adaptive_thread_limit() const;
+
+  // Adjust the number of threads with --adaptive-threads.
+  void
+  adapt_thread_count();
+
   // Master Workqueue lock.  This controls access to the following
   // member variables.
   Lock lock_;
@@ -281,13 +336,52 @@ class Workqueue
   int running_;
   // Number of tasks waiting for a lock to release.
   int waiting_;
+  // Number of threads which are about to wait on condvar_, or are
+  // waiting.  This is only changed with lock_ held, but is read
+  // without it when queuing a task on a thread queue.
+  volatile int sleeping_;
+  // Number of tasks on the thread queues.  This and taken_ are
+  // changed with atomic operations, without lock_.
+  volatile int queued_;
+  // Number of tasks taken from the thread queues which have not yet
+  // been looked at with lock_ held.  Such a task will be run, or
+  // parked on its token, by the thread which took it.
+  volatile int taken_;
   // Condition variable associated with lock_.  This is signalled when
   // there may be a new Task to execute.
   Condvar condvar_;
+  // Whether to use thread queues.
+  bool use_thread_queues_;
+  // The list of thread queues, linked through
+  // Workqueue_thread_queue::next.  New queues are added at the front,
+  // with lock_ held.  Queues are never removed, so the list may be
+  // walked without lock_.
+  Workqueue_thread_queue* volatile thread_queues_;
 
   // The threading implementation.  This is set at construction time
   // and not changed thereafter.
   Workqueue_threader* threader_;
+  // Whether to adjust the number of threads to the load, for
+  // --adaptive-threads.
+  bool adaptive_;
+  // The number of CPUs we may use, if adaptive_.
+  int cpus_;
+  // The thread count passed to set_thread_count, if adaptive_.
+  int requested_threads_;
+  // The number of threads we are using, if adaptive_.
+  int adaptive_threads_;
+  // The total wall clock and CPU time of tasks which ran while no
+  // more tasks were running than there are CPUs, in microseconds, if
+  // adaptive_.  The difference is mostly time spent waiting for I/O.
+  long long task_wall_time_;
+  long long task_cpu_time_;
+  // Whether to record the tasks which are run, for --trace-tasks.
+  bool trace_;
+  // The time the Workqueue was created, in microseconds, if trace_.
+  long long trace_start_;
+  // The tasks which were run, if trace_.  This is controlled by
+  // lock_.
+  std::vector<Trace_entry> trace_entries_;
 };
 
 } // End namespace gold.